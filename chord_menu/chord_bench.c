@@ -0,0 +1,1171 @@
+//**************************************************************************************************
+// File:   chord_bench.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Benchmarks that drive the DHT from the menu process and measure how it behaves under load. The
+// state of the ring is observed through the reports that nodes send back to the menu process.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "chord_bench.h"
+#include "chord_commands.h"
+#include "chord_config.h"
+#include "chord_load.h"
+#include "chord_message.h"
+#include "chord_trace.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Time allowed for every node to answer a single report request, in milliseconds
+#define REPORT_TIMEOUT_MS               200
+
+// Time allowed for the ring to converge before a benchmark gives up, in milliseconds
+#define CONVERGENCE_TIMEOUT_MS          10000
+
+// Maximum number of operations tracked by the churn benchmark
+#define CHURN_MAX_OPS                   ( 1 << 20 )
+
+// Time after which an unanswered operation is counted as lost, in milliseconds
+#define CHURN_OP_TIMEOUT_MS             1000
+
+// Width of the intervals that churn results are reported in, in milliseconds
+#define CHURN_INTERVAL_MS               250
+
+// Latency value of operations that are outstanding or were never answered
+#define CHURN_NO_LATENCY                ( -1.0 )
+
+// Time to wait for the last answers at the end of a replay, in milliseconds
+#define REPLAY_DRAIN_TIMEOUT_MS         1000
+
+// The state of the ring, as observed by polling every node for a report
+typedef struct
+{
+    bool converged;              // Flag: "every node reported and every key is on its owner"
+    int nodes_reported;          // The number of nodes that answered the poll
+    int misplaced_keys;          // The number of keys that were not found on their owner
+    int stray_keys;              // The number of keys that were found on a node not owning them
+    long msgs_sent;              // Total messages sent by the nodes that answered the poll
+} ring_poll_t;
+
+// An operation sent by the churn benchmark
+typedef struct
+{
+    chord_cmd_t cmd;             // The command sent (add key, delete key or lookup)
+    int key;                     // The key operated on
+    int owner;                   // The owner of the key when the operation was sent
+    bool expect_found;           // Flag: "a lookup should find the key"
+    double sent_ms;              // The time the operation was sent, from the start of the workload
+    double latency_ms;           // The time taken to answer the operation
+} churn_op_t;
+
+// Local prototypes
+static void bench_churn_issue_op( churn_op_t *op, int tag, double now_ms );
+static void bench_churn_print_intervals( const churn_op_t *ops, int op_count, 
+                                         const double *joins_ms, int join_count, 
+                                         int duration_s );
+static int bench_replay_collect( double *sent_ms, int tag_count, double *latencies, 
+                                 int *answered, int timeout_ms, const struct timespec *start );
+static void bench_free_records( trace_record_t *records, int record_count );
+static double bench_percentile( double *values, int count, double percentile );
+static int bench_compare_doubles( const void *a, const void *b );
+static void bench_print_shares( const char *name, const double *shares, int count );
+static ring_poll_t bench_poll_ring();
+static int bench_wait_for_convergence( ring_poll_t *result );
+static void bench_preload_keys();
+static int bench_key_owner( uint64_t nodes, int key );
+static bool bench_is_replica( uint64_t nodes, int owner, int node_id );
+static double bench_elapsed_ms( const struct timespec *start );
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// Tag of the most recent report request; reports carrying an older tag are discarded
+static int report_tag = 0;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: bench_join_storm
+ * 
+ * Ring-build benchmark. The full key range is loaded into the DHT, then the given number of nodes
+ * are added as fast as possible. The ring is polled until every key sits on its correct owner,
+ * and the convergence time and number of messages exchanged (total and per join) are printed to
+ * the standard output.
+ * 
+ * param:  The number of nodes to add
+ * return: void
+ **************************************************************************************************/
+void bench_join_storm( int join_count )
+{
+    // Local variables
+    ring_poll_t baseline;             // State of the ring before the joins
+    ring_poll_t result;               // State of the ring after the joins
+    struct timespec start;            // The time at which the first join was sent
+    double elapsed_ms;                // Time taken by the ring to converge
+    long msgs_exchanged;              // Messages exchanged between nodes because of the joins
+    int free_ids;                     // The number of node IDs not yet assigned
+    int joined;                       // The number of joins sent so far
+    int polls;                        // The number of polls until the ring converged
+
+    // Only as many nodes as there are free IDs can join
+    free_ids = MAX_NODE_COUNT - __builtin_popcountll( cmd_get_nodes() );
+
+    if( join_count > free_ids )
+    {
+        printf( "Only %i node IDs are free; adding %i nodes instead\n", free_ids, free_ids );
+        join_count = free_ids;
+    }
+
+    if( join_count <= 0 )
+    {
+        return;
+    }
+
+    // Load the full key range, so that every join has keys to redistribute, and let it settle
+    bench_preload_keys();
+    bench_wait_for_convergence( &baseline );
+
+    if( baseline.converged == false )
+    {
+        printf( "Benchmark aborted: the ring did not settle before the joins were sent\n" );
+        return;
+    }
+
+    printf( "Join storm: adding %i nodes to a ring of %i nodes holding %i keys\n", join_count,
+            baseline.nodes_reported, __builtin_popcountll( cmd_get_keys() ) );
+
+    // Send every join back to back, at free IDs drawn at random
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    joined = 0;
+
+    while( joined < join_count )
+    {
+        if( cmd_add_node_id( load_random_id( cmd_get_nodes() ), 0 ) == CHORD_ERR_NONE )
+        {
+            joined++;
+        }
+    }
+
+    // Poll until every key sits on its owner
+    polls = bench_wait_for_convergence( &result );
+    elapsed_ms = bench_elapsed_ms( &start );
+
+    if( result.converged == true )
+    {
+        msgs_exchanged = result.msgs_sent - baseline.msgs_sent;
+
+        printf( "  Converged in %.3f ms (%i polls)\n", elapsed_ms, polls );
+        printf( "  Node-to-node messages exchanged: %li (%.1f per join)\n", msgs_exchanged,
+                (double)msgs_exchanged / join_count );
+        printf( "  Time per join: %.3f ms\n", elapsed_ms / join_count );
+    }
+    else
+    {
+        printf( "  Ring did not converge within %i ms: %i of %i nodes reported, %i keys missing "
+                "from their owner, %i keys on the wrong node\n", CONVERGENCE_TIMEOUT_MS,
+                result.nodes_reported, __builtin_popcountll( cmd_get_nodes() ),
+                result.misplaced_keys, result.stray_keys );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: bench_churn
+ * 
+ * Churn workload benchmark. A steady load of key additions, deletions and lookups is sent to the
+ * DHT at the given rate, while new nodes join at the given interval. Throughput and latency are
+ * printed per reporting interval (so that dips and spikes around joins can be seen), along with
+ * operations that were answered by the wrong node, lookups that gave the wrong answer and
+ * operations that were never answered.
+ * 
+ * param:  The duration of the workload, in seconds
+ * param:  The rate at which operations are sent, in operations per second
+ * param:  The interval between node joins, in milliseconds (zero for no joins)
+ * return: void
+ **************************************************************************************************/
+void bench_churn( int duration_s, int op_rate, int join_interval_ms )
+{
+    // Local variables
+    churn_op_t *ops;                  // Every operation sent
+    double *latencies;                // Latencies of answered operations (for percentiles)
+    double joins_ms[MAX_NODE_COUNT];  // The times at which nodes joined
+    int key_op[MAX_KEY_VALUE];        // The operation outstanding on each key
+    uint64_t busy_keys;               // The keys that have an operation outstanding
+    chord_msg_t reply;                // A reply received from a node
+    churn_op_t *op;                   // An operation being answered
+    struct timespec start;            // The time at which the workload started
+    double now_ms;                    // The time since the workload started
+    double next_join_ms;              // The time at which the next node joins
+    double duration_ms;               // The duration of the workload
+    int max_ops;                      // The number of operations the workload sends
+    int op_count;                     // The number of operations sent
+    int join_count;                   // The number of nodes that joined
+    int answered;                     // The number of operations answered
+    int misrouted;                    // Operations answered by a node not owning the key
+    int replica_answers;              // Lookups answered by a replica of the owner
+    int wrong_answers;                // Lookups that did not find a present key (or vice versa)
+    int lost;                         // Operations that were never answered
+    int skipped;                      // Operations not sent because every key was busy
+    int key;                          // A key to operate on
+    int new_node_id;                  // The ID of a joining node
+    
+    // Initialization
+    duration_ms = duration_s * 1000.0;
+    max_ops = (int)( (double)duration_s * op_rate );
+    max_ops = ( max_ops > CHURN_MAX_OPS ) ? CHURN_MAX_OPS : max_ops;
+    ops = malloc( max_ops * sizeof( churn_op_t ) );
+    latencies = malloc( max_ops * sizeof( double ) );
+    busy_keys = 0;
+    op_count = 0;
+    join_count = 0;
+    answered = 0;
+    misrouted = 0;
+    replica_answers = 0;
+    wrong_answers = 0;
+    lost = 0;
+    skipped = 0;
+    next_join_ms = ( join_interval_ms > 0 ) ? join_interval_ms : duration_ms;
+    
+    if( ( ops == NULL ) || ( latencies == NULL ) )
+    {
+        printf( "Benchmark aborted: unable to allocate memory for %i operations\n", max_ops );
+        free( ops );
+        free( latencies );
+        return;
+    }
+    
+    printf( "Churn: %i ops/s for %i s, ", op_rate, duration_s );
+    
+    if( join_interval_ms > 0 )
+    {
+        printf( "one node joining every %i ms\n", join_interval_ms );
+    }
+    else
+    {
+        printf( "no joins\n" );
+    }
+    
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    now_ms = 0.0;
+    
+    // Run until the workload ends and every operation is answered or has timed out
+    while( ( now_ms < duration_ms ) || ( busy_keys != 0 ) )
+    {
+        // Send the operations that are due, on keys that have no operation outstanding
+        while( ( now_ms < duration_ms ) && ( op_count < max_ops ) && 
+               ( op_count + skipped < now_ms * op_rate / 1000.0 ) )
+        {
+            if( busy_keys == UINT64_MAX )
+            {
+                skipped++;
+            }
+            else
+            {
+                do
+                {
+                    key = rand() % MAX_KEY_VALUE;
+                }
+                while( busy_keys & ( 1UL << key ) );
+                
+                ops[op_count].key = key;
+                bench_churn_issue_op( &ops[op_count], op_count + 1, now_ms );
+                busy_keys |= ( 1UL << key );
+                key_op[key] = op_count;
+                op_count++;
+            }
+        }
+        
+        // Add a node when one is due
+        if( ( now_ms >= next_join_ms ) && ( now_ms < duration_ms ) )
+        {
+            next_join_ms += join_interval_ms;
+            
+            new_node_id = load_random_id( cmd_get_nodes() );
+            
+            if( cmd_add_node_id( new_node_id, 0 ) == CHORD_ERR_NONE )
+            {
+                joins_ms[join_count++] = now_ms;
+            }
+        }
+        
+        // Collect a reply, waiting briefly only if nothing else is due
+        if( cmd_read_report( &reply, ( op_count + skipped < now_ms * op_rate / 1000.0 ) ? 0 : 1 ) 
+            == CHORD_ERR_NONE )
+        {
+            now_ms = bench_elapsed_ms( &start );
+            
+            if( ( reply.tag > 0 ) && ( reply.tag <= op_count ) && 
+                ( busy_keys & ( 1UL << ops[reply.tag - 1].key ) ) &&
+                ( key_op[ops[reply.tag - 1].key] == reply.tag - 1 ) )
+            {
+                op = &ops[reply.tag - 1];
+                op->latency_ms = now_ms - op->sent_ms;
+                latencies[answered++] = op->latency_ms;
+                busy_keys &= ~( 1UL << op->key );
+                
+                // The key may have moved to a newly joined node while the operation was routed,
+                // busy owners may hand lookups to their replicas, and lookups of absent keys may
+                // be answered by the main node
+                if( ( reply.sender != op->owner ) && ( reply.hops != SUMMARY_ANSWER_HOPS ) &&
+                    ( reply.sender != bench_key_owner( cmd_get_nodes(), op->key ) ) )
+                {
+                    if( ( op->cmd == LOOKUP ) && 
+                        ( bench_is_replica( cmd_get_nodes(), op->owner, reply.sender ) == true ) )
+                    {
+                        replica_answers++;
+                    }
+                    else
+                    {
+                        misrouted++;
+                    }
+                }
+                
+                if( ( op->cmd == LOOKUP ) && ( ( reply.data != 0 ) != op->expect_found ) )
+                {
+                    wrong_answers++;
+                }
+            }
+        }
+        
+        now_ms = bench_elapsed_ms( &start );
+        
+        // Give up on operations that have not been answered in time
+        for( key = 0; key < MAX_KEY_VALUE; key++ )
+        {
+            if( ( busy_keys & ( 1UL << key ) ) && 
+                ( now_ms - ops[key_op[key]].sent_ms > CHURN_OP_TIMEOUT_MS ) )
+            {
+                busy_keys &= ~( 1UL << key );
+                lost++;
+            }
+        }
+    }
+    
+    // Print results
+    printf( "  Operations: %i sent, %i answered (%.0f ops/s), %i not sent (every key busy)\n", 
+            op_count, answered, answered / ( duration_ms / 1000.0 ), skipped );
+    
+    if( answered > 0 )
+    {
+        printf( "  Latency: p50 %.3f ms, p99 %.3f ms, p99.9 %.3f ms, max %.3f ms\n",
+                bench_percentile( latencies, answered, 50.0 ), 
+                bench_percentile( latencies, answered, 99.0 ),
+                bench_percentile( latencies, answered, 99.9 ),
+                bench_percentile( latencies, answered, 100.0 ) );
+    }
+    
+    printf( "  Misrouted: %i, wrong lookup answers: %i, lost (no answer in %i ms): %i\n",
+            misrouted, wrong_answers, CHURN_OP_TIMEOUT_MS, lost );
+    
+    if( cmd_get_replication() > 0 )
+    {
+        printf( "  Lookups answered by replicas (replication factor %i): %i\n", 
+                cmd_get_replication(), replica_answers );
+    }
+    
+    bench_churn_print_intervals( ops, op_count, joins_ms, join_count, duration_s );
+    
+    free( ops );
+    free( latencies );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_churn_issue_op
+ * 
+ * Send a churn operation on the key held by the operation. Half of the operations are lookups;
+ * the other half add the key if it is absent, or delete it if it is present, which keeps the
+ * key population steady.
+ * 
+ * param:  The operation to send (the key is already set)
+ * param:  The tag to send the operation with
+ * param:  The current time, from the start of the workload
+ * return: void
+ **************************************************************************************************/
+static void bench_churn_issue_op( churn_op_t *op, int tag, double now_ms )
+{
+    // Local variables
+    bool present;                 // Flag: "the key is in the DHT"
+    
+    // Initialization
+    present = ( ( cmd_get_keys() & ( 1UL << op->key ) ) != 0 );
+    op->owner = bench_key_owner( cmd_get_nodes(), op->key );
+    op->expect_found = present;
+    op->sent_ms = now_ms;
+    op->latency_ms = CHURN_NO_LATENCY;
+    
+    if( rand() % 2 == 0 )
+    {
+        op->cmd = LOOKUP;
+        cmd_lookup_key( op->key, tag );
+    }
+    else if( present == true )
+    {
+        op->cmd = DELETE_KEY;
+        cmd_delete_key( op->key, tag );
+    }
+    else
+    {
+        op->cmd = ADD_KEY;
+        cmd_add_key( op->key, tag );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: bench_churn_print_intervals
+ * 
+ * Print the throughput and latency of a churn workload per reporting interval, marking the
+ * intervals in which nodes joined, followed by the worst throughput dip.
+ * 
+ * param:  The operations sent
+ * param:  The number of operations sent
+ * param:  The times at which nodes joined
+ * param:  The number of nodes that joined
+ * param:  The duration of the workload, in seconds
+ * return: void
+ **************************************************************************************************/
+static void bench_churn_print_intervals( const churn_op_t *ops, int op_count, 
+                                         const double *joins_ms, int join_count, 
+                                         int duration_s )
+{
+    // Local variables
+    double *latencies;                // Latencies of operations answered in an interval
+    double *rates;                    // Throughput of each interval
+    double interval_start;            // The start time of an interval
+    double completed_ms;              // The time an operation was answered
+    int interval_count;               // The number of reporting intervals
+    int count;                        // The number of operations answered in an interval
+    int joins;                        // The number of nodes that joined in an interval
+    int worst;                        // The interval with the lowest throughput
+    
+    // Initialization
+    interval_count = ( duration_s * 1000 ) / CHURN_INTERVAL_MS;
+    latencies = malloc( ( op_count + 1 ) * sizeof( double ) );
+    rates = malloc( interval_count * sizeof( double ) );
+    worst = 0;
+    
+    if( ( latencies == NULL ) || ( rates == NULL ) || ( interval_count == 0 ) )
+    {
+        free( latencies );
+        free( rates );
+        return;
+    }
+    
+    printf( "  %10s %10s %10s %10s %6s\n", "time (ms)", "ops/s", "p99 (ms)", "max (ms)", 
+            "joins" );
+    
+    for( int interval = 0; interval < interval_count; interval++ )
+    {
+        interval_start = (double)interval * CHURN_INTERVAL_MS;
+        count = 0;
+        joins = 0;
+        
+        for( int index = 0; index < op_count; index++ )
+        {
+            completed_ms = ops[index].sent_ms + ops[index].latency_ms;
+            
+            if( ( ops[index].latency_ms != CHURN_NO_LATENCY ) && 
+                ( completed_ms >= interval_start ) && 
+                ( completed_ms < interval_start + CHURN_INTERVAL_MS ) )
+            {
+                latencies[count++] = ops[index].latency_ms;
+            }
+        }
+        
+        for( int index = 0; index < join_count; index++ )
+        {
+            if( ( joins_ms[index] >= interval_start ) && 
+                ( joins_ms[index] < interval_start + CHURN_INTERVAL_MS ) )
+            {
+                joins++;
+            }
+        }
+        
+        rates[interval] = count * ( 1000.0 / CHURN_INTERVAL_MS );
+        worst = ( rates[interval] < rates[worst] ) ? interval : worst;
+        
+        printf( "  %10.0f %10.0f %10.3f %10.3f %6i\n", interval_start, rates[interval],
+                bench_percentile( latencies, count, 99.0 ), 
+                bench_percentile( latencies, count, 100.0 ), joins );
+    }
+    
+    // Note: the worst rate is printed first, since finding the median sorts the rates
+    printf( "  Worst interval: %.0f ops/s at %i ms", rates[worst], worst * CHURN_INTERVAL_MS );
+    printf( " (median interval %.0f ops/s)\n", bench_percentile( rates, interval_count, 50.0 ) );
+    
+    free( latencies );
+    free( rates );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_replay
+ * 
+ * Replay a workload trace captured with the trace module against the DHT, either at the pacing
+ * it was recorded with or as fast as possible. Keys are tagged so that the time taken to answer
+ * each operation can be measured; the replay rate and latency are printed to the standard output.
+ * 
+ * param:  The path of the trace file
+ * param:  True to keep the recorded pacing, false to replay as fast as possible
+ * return: void
+ **************************************************************************************************/
+void bench_replay( const char *path, bool paced )
+{
+    // Local variables
+    trace_record_t *records;          // Every command in the trace
+    trace_record_t *resized;          // The command list after growing it
+    double *sent_ms;                  // Send time of each command (negative once answered)
+    double *latencies;                // Latencies of answered commands
+    struct timespec start;            // The time at which the replay started
+    double due_ms;                    // The time at which the next command is due
+    double issue_ms;                  // The time taken to send every command
+    chord_err_t err;                  // An error code returned by a command
+    int capacity;                     // The number of commands the list can hold
+    int record_count;                 // The number of commands in the trace
+    int outstanding;                  // The number of tagged commands not yet answered
+    int answered;                     // The number of tagged commands answered
+    int tagged;                       // The number of tagged commands sent
+    int rejected;                     // Commands rejected by the menu (ring state differs)
+    int tag;                          // The tag of a command
+    
+    // Initialization
+    capacity = 1024;
+    record_count = 0;
+    records = malloc( capacity * sizeof( trace_record_t ) );
+    
+    if( ( records == NULL ) || ( trace_open( path ) != CHORD_ERR_NONE ) )
+    {
+        printf( "Unable to replay: %s could not be read as a trace file\n", path );
+        free( records );
+        return;
+    }
+    
+    // Load the whole trace up front, so that file access does not disturb the pacing
+    while( ( records != NULL ) && ( trace_read( &records[record_count] ) == true ) )
+    {
+        record_count++;
+        
+        if( record_count == capacity )
+        {
+            capacity *= 2;
+            resized = realloc( records, capacity * sizeof( trace_record_t ) );
+            
+            if( resized == NULL )
+            {
+                bench_free_records( records, record_count );
+            }
+            
+            records = resized;
+        }
+    }
+    
+    trace_close();
+    sent_ms = malloc( ( record_count + 1 ) * sizeof( double ) );
+    latencies = malloc( ( record_count + 1 ) * sizeof( double ) );
+    
+    if( ( records == NULL ) || ( sent_ms == NULL ) || ( latencies == NULL ) )
+    {
+        printf( "Unable to replay: not enough memory for %i commands\n", record_count );
+        bench_free_records( records, record_count );
+        free( sent_ms );
+        free( latencies );
+        return;
+    }
+    
+    printf( "Replaying %i commands from %s (%s)\n", record_count, path, 
+            ( paced == true ) ? "recorded pacing" : "as fast as possible" );
+    
+    // Initialization
+    outstanding = 0;
+    answered = 0;
+    tagged = 0;
+    rejected = 0;
+    due_ms = 0.0;
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    
+    for( int index = 0; index < record_count; index++ )
+    {
+        due_ms += records[index].delta_us / 1000.0;
+        tag = index + 1;
+        sent_ms[index] = CHURN_NO_LATENCY;
+        
+        // Wait for the command to be due, collecting answers in the meantime
+        while( ( paced == true ) && ( bench_elapsed_ms( &start ) < due_ms ) )
+        {
+            outstanding -= bench_replay_collect( sent_ms, record_count, latencies, &answered, 1, 
+                                                 &start );
+        }
+        
+        switch( records[index].cmd )
+        {
+            case( ADD_NODE ):
+                err = cmd_add_node_id( records[index].id, 0 );
+                tag = 0;
+                break;
+                
+            case( ADD_KEY ):
+                err = cmd_add_key( records[index].id, tag );
+                break;
+                
+            case( DELETE_KEY ):
+                err = cmd_delete_key( records[index].id, tag );
+                break;
+                
+            case( LOOKUP ):
+                err = cmd_lookup_key( records[index].id, tag );
+                break;
+                
+            case( PUT ):
+                err = cmd_put_key( records[index].id, records[index].value, 
+                                   records[index].length, tag );
+                break;
+                
+            case( GET ):
+                err = cmd_get_key( records[index].id, tag );
+                break;
+                
+            case( MGET ):
+                err = cmd_multi_get( records[index].data, tag );
+                break;
+                
+            case( SCAN ):
+                err = cmd_scan_range( records[index].id, (int)records[index].data, tag );
+                break;
+                
+            case( COUNT ):
+                err = cmd_count_range( records[index].id, (int)records[index].data, tag );
+                break;
+                
+            case( DELETE_RANGE ):
+                err = cmd_delete_range( records[index].id, (int)records[index].data, tag );
+                break;
+                
+            case( LEAVE ):
+                err = cmd_remove_node( records[index].id, 0 );
+                tag = 0;
+                break;
+                
+            case( CRASH ):
+                err = cmd_crash_node( records[index].id );
+                tag = 0;
+                break;
+                
+            case( DUMP ):
+                cmd_dump( 0 );
+                err = CHORD_ERR_NONE;
+                tag = 0;
+                break;
+                
+            default:
+                err = CHORD_ERR_TRACE_FILE;
+                break;
+        }
+        
+        if( err != CHORD_ERR_NONE )
+        {
+            rejected++;
+        }
+        else if( tag != 0 )
+        {
+            sent_ms[index] = bench_elapsed_ms( &start );
+            outstanding++;
+            tagged++;
+        }
+        
+        outstanding -= bench_replay_collect( sent_ms, record_count, latencies, &answered, 0, 
+                                             &start );
+    }
+    
+    issue_ms = bench_elapsed_ms( &start );
+    
+    // Collect the remaining answers, until none arrive for a while
+    while( ( outstanding > 0 ) && 
+           ( bench_replay_collect( sent_ms, record_count, latencies, &answered, 
+                                   REPLAY_DRAIN_TIMEOUT_MS, &start ) > 0 ) )
+    {
+        outstanding = tagged - answered;
+    }
+    
+    printf( "  Sent %i commands in %.3f ms (%.0f commands/s)\n", record_count - rejected, 
+            issue_ms, ( record_count - rejected ) / ( issue_ms / 1000.0 ) );
+    printf( "  Answered %i of %i key operations, %i unanswered\n", answered, tagged, 
+            tagged - answered );
+    
+    if( answered > 0 )
+    {
+        printf( "  Latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n", 
+                bench_percentile( latencies, answered, 50.0 ), 
+                bench_percentile( latencies, answered, 99.0 ),
+                bench_percentile( latencies, answered, 100.0 ) );
+    }
+    
+    if( rejected > 0 )
+    {
+        printf( "  Rejected %i commands (the ring state differs from the recording)\n", 
+                rejected );
+    }
+    
+    bench_free_records( records, record_count );
+    free( sent_ms );
+    free( latencies );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_load_balance
+ * 
+ * Report how evenly the load is spread over the node processes. Every node is asked for a report,
+ * which names the node whose process hosts it; for each process, the share of the ID space owned
+ * by its nodes (each owns the IDs from just after its predecessor up to its own) and the share of
+ * the keys they hold are printed, followed by the mean, variance and maximum of the shares.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void bench_load_balance()
+{
+    // Local variables
+    chord_msg_t report;                    // A report received from a node
+    struct timespec start;                 // The time at which the report request was sent
+    uint64_t nodes;                        // The nodes that should answer
+    uint64_t reported = 0;                 // The nodes that have answered
+    int hosts[MAX_NODE_COUNT];             // The node whose process hosts each node
+    int node_keys[MAX_NODE_COUNT];         // The number of keys held by each node
+    int process_ids[MAX_NODE_COUNT] = { 0 };    // The number of IDs owned by each process
+    int process_nodes[MAX_NODE_COUNT] = { 0 };  // The number of nodes hosted by each process
+    int process_keys[MAX_NODE_COUNT] = { 0 };   // The number of keys held by each process
+    double id_shares[MAX_NODE_COUNT];      // The share of the ID space of each process
+    double key_shares[MAX_NODE_COUNT];     // The share of the keys of each process
+    int process_count = 0;                 // The number of processes
+    int total_keys = 0;                    // The number of keys held by all nodes
+    int previous;                          // The node before the one being looked at
+    
+    // Initialization
+    nodes = cmd_get_nodes();
+    
+    report_tag++;
+    cmd_request_report( report_tag );
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    
+    while( ( reported != nodes ) && ( bench_elapsed_ms( &start ) < REPORT_TIMEOUT_MS ) )
+    {
+        if( ( cmd_read_report( &report, 1 ) == CHORD_ERR_NONE ) && ( report.cmd == REPORT ) &&
+            ( report.tag == report_tag ) )
+        {
+            reported |= ( 1UL << report.sender );
+            hosts[report.sender] = report.hops;
+            node_keys[report.sender] = __builtin_popcountll( report.data );
+        }
+    }
+    
+    // The main node is the last node in the ring, so it is the first node's predecessor
+    previous = MAIN_DHT_NODE - MAX_NODE_COUNT;
+    
+    for( int id = 0; id < MAX_NODE_COUNT; id++ )
+    {
+        if( reported & ( 1UL << id ) )
+        {
+            process_ids[hosts[id]] += id - previous;
+            process_nodes[hosts[id]]++;
+            process_keys[hosts[id]] += node_keys[id];
+            total_keys += node_keys[id];
+            previous = id;
+        }
+    }
+    
+    printf( "Load per node process (%i node IDs per process):\n", cmd_get_virtual_nodes() );
+    
+    for( int host = 0; host < MAX_NODE_COUNT; host++ )
+    {
+        if( process_nodes[host] > 0 )
+        {
+            id_shares[process_count] = (double)process_ids[host] / MAX_NODE_COUNT;
+            key_shares[process_count] = ( total_keys > 0 ) ? 
+                                        (double)process_keys[host] / total_keys : 0.0;
+            
+            printf( "  Process of node %2i: %i node ID%s, %5.1f%% of the ID space, %5.1f%% of the "
+                    "keys\n", host, process_nodes[host], ( process_nodes[host] == 1 ) ? "" : "s",
+                    id_shares[process_count] * 100.0, key_shares[process_count] * 100.0 );
+            
+            process_count++;
+        }
+    }
+    
+    if( reported != nodes )
+    {
+        printf( "  %i nodes did not report in time\n", 
+                __builtin_popcountll( nodes & ~reported ) );
+    }
+    
+    bench_print_shares( "ID space", id_shares, process_count );
+    bench_print_shares( "Keys", key_shares, process_count );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_replay_collect
+ * 
+ * Collect the answers to replayed commands that have arrived, recording their latency. A range or
+ * multi-get command is answered by several nodes; its latency is that of the first answer.
+ * 
+ * param:  Send time of each command, indexed by tag - 1 (set negative once answered)
+ * param:  The number of commands
+ * param:  Holds the latencies of answered commands
+ * param:  The number of answered commands (updated)
+ * param:  The maximum time to wait for the first answer, in milliseconds
+ * param:  The time at which the replay started
+ * return: The number of answers collected
+ **************************************************************************************************/
+static int bench_replay_collect( double *sent_ms, int tag_count, double *latencies, 
+                                 int *answered, int timeout_ms, const struct timespec *start )
+{
+    // Local variables
+    chord_msg_t reply;                // A reply received from a node
+    int collected = 0;                // The number of answers collected
+    
+    while( cmd_read_report( &reply, ( collected == 0 ) ? timeout_ms : 0 ) == CHORD_ERR_NONE )
+    {
+        if( ( reply.tag > 0 ) && ( reply.tag <= tag_count ) && 
+            ( sent_ms[reply.tag - 1] != CHURN_NO_LATENCY ) &&
+            ( ( reply.cmd == ADD_KEY ) || ( reply.cmd == DELETE_KEY ) || ( reply.cmd == LOOKUP ) ||
+              ( reply.cmd == PUT ) || ( reply.cmd == GET ) || ( reply.cmd == MGET ) ||
+              ( reply.cmd == SCAN ) || ( reply.cmd == COUNT ) || ( reply.cmd == DELETE_RANGE ) ) )
+        {
+            latencies[( *answered )++] = bench_elapsed_ms( start ) - sent_ms[reply.tag - 1];
+            sent_ms[reply.tag - 1] = CHURN_NO_LATENCY;
+            collected++;
+        }
+    }
+    
+    return( collected );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_free_records
+ * 
+ * Release a list of commands read from a trace file, with the values of its puts.
+ * 
+ * param:  The list of commands (may be NULL)
+ * param:  The number of commands in the list
+ * return: void
+ **************************************************************************************************/
+static void bench_free_records( trace_record_t *records, int record_count )
+{
+    for( int index = 0; ( records != NULL ) && ( index < record_count ); index++ )
+    {
+        free( records[index].value );
+    }
+    
+    free( records );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_percentile
+ * 
+ * Get a percentile of a list of values. The list is sorted in place.
+ * 
+ * param:  The list of values
+ * param:  The number of values in the list
+ * param:  The percentile to get (0-100)
+ * return: The value at the percentile, or zero if the list is empty
+ **************************************************************************************************/
+static double bench_percentile( double *values, int count, double percentile )
+{
+    // Local variables
+    double result = 0.0;          // The value at the percentile
+    int index;                    // The index of the value at the percentile
+    
+    if( count > 0 )
+    {
+        qsort( values, count, sizeof( double ), bench_compare_doubles );
+        
+        index = (int)( ( percentile / 100.0 ) * ( count - 1 ) + 0.5 );
+        result = values[index];
+    }
+    
+    return( result );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_compare_doubles
+ * 
+ * Comparison function used to sort values in ascending order.
+ * 
+ * param:  The first value
+ * param:  The second value
+ * return: Negative, zero or positive if the first value is less than, equal to or greater than
+ *         the second value
+ **************************************************************************************************/
+static int bench_compare_doubles( const void *a, const void *b )
+{
+    // Local variables
+    double first = *(const double *)a;        // The first value
+    double second = *(const double *)b;       // The second value
+    
+    return( ( first > second ) - ( first < second ) );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_print_shares
+ * 
+ * Print the mean, variance and maximum of the shares of a resource held by each node process. The
+ * maximum is also given as a multiple of the mean.
+ * 
+ * param:  The name of the resource
+ * param:  The share of each process (0-1)
+ * param:  The number of processes
+ * return: void
+ **************************************************************************************************/
+static void bench_print_shares( const char *name, const double *shares, int count )
+{
+    // Local variables
+    double mean = 0.0;            // The mean share
+    double variance = 0.0;        // The variance of the shares
+    double largest = 0.0;         // The largest share
+    
+    for( int index = 0; index < count; index++ )
+    {
+        mean += shares[index] / count;
+        largest = ( shares[index] > largest ) ? shares[index] : largest;
+    }
+    
+    for( int index = 0; index < count; index++ )
+    {
+        variance += ( shares[index] - mean ) * ( shares[index] - mean ) / count;
+    }
+    
+    if( mean > 0.0 )
+    {
+        printf( "  %-8s share per process: mean %5.1f%%, variance %.5f, max %5.1f%% (%.2fx mean)\n",
+                name, mean * 100.0, variance, largest * 100.0, largest / mean );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: bench_poll_ring
+ * 
+ * Ask every node for a report and compare the key set of each node with the keys it should own,
+ * based on the nodes and keys the menu process has added to the DHT.
+ * 
+ * param:  void
+ * return: The observed state of the ring
+ **************************************************************************************************/
+static ring_poll_t bench_poll_ring()
+{
+    // Local variables
+    ring_poll_t result;               // The observed state of the ring
+    chord_msg_t report;               // A report received from a node
+    struct timespec start;            // The time at which the report request was sent
+    uint64_t nodes;                   // The nodes that should answer
+    uint64_t keys;                    // The keys that should be in the ring
+    uint64_t reported;                // The nodes that have answered
+    uint64_t owned;                   // The keys that the reporting node should own
+    uint64_t found;                   // The keys that were found on their owner
+
+    // Initialization
+    result.converged = false;
+    result.nodes_reported = 0;
+    result.misplaced_keys = 0;
+    result.stray_keys = 0;
+    result.msgs_sent = 0;
+    nodes = cmd_get_nodes();
+    keys = cmd_get_keys();
+    reported = 0;
+    found = 0;
+
+    // Request reports with a new tag, so that late answers to earlier polls can be told apart
+    report_tag++;
+    cmd_request_report( report_tag );
+    clock_gettime( CLOCK_MONOTONIC, &start );
+
+    while( ( reported != nodes ) && ( bench_elapsed_ms( &start ) < REPORT_TIMEOUT_MS ) )
+    {
+        if( ( cmd_read_report( &report, 1 ) == CHORD_ERR_NONE ) && ( report.cmd == REPORT ) &&
+            ( report.tag == report_tag ) )
+        {
+            reported |= ( 1UL << report.sender );
+            result.nodes_reported++;
+            result.msgs_sent += report.id;
+
+            // Work out which keys this node should own
+            owned = 0;
+
+            for( int key = 0; key < MAX_KEY_VALUE; key++ )
+            {
+                if( ( keys & ( 1UL << key ) ) &&
+                    ( bench_key_owner( nodes, key ) == report.sender ) )
+                {
+                    owned |= ( 1UL << key );
+                }
+            }
+
+            found |= ( report.data & owned );
+            result.stray_keys += __builtin_popcountll( report.data & ~owned );
+        }
+    }
+
+    result.misplaced_keys = __builtin_popcountll( keys & ~found );
+    result.converged = ( ( reported == nodes ) && ( result.misplaced_keys == 0 ) &&
+                         ( result.stray_keys == 0 ) );
+
+    return( result );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_wait_for_convergence
+ * 
+ * Poll the ring repeatedly until it has converged, or until the convergence timeout expires.
+ * 
+ * param:  Holds the state of the ring observed by the last poll
+ * return: The number of polls taken
+ **************************************************************************************************/
+static int bench_wait_for_convergence( ring_poll_t *result )
+{
+    // Local variables
+    struct timespec start;            // The time at which polling started
+    int polls;                        // The number of polls taken
+
+    // Initialization
+    clock_gettime( CLOCK_MONOTONIC, &start );
+    polls = 0;
+
+    do
+    {
+        *result = bench_poll_ring();
+        polls++;
+    }
+    while( ( result->converged == false ) &&
+           ( bench_elapsed_ms( &start ) < CONVERGENCE_TIMEOUT_MS ) );
+
+    return( polls );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_preload_keys
+ * 
+ * Add every key in the supported range that is not already in the DHT.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void bench_preload_keys()
+{
+    for( int key = 0; key < MAX_KEY_VALUE; key++ )
+    {
+        if( ( cmd_get_keys() & ( 1UL << key ) ) == 0 )
+        {
+            cmd_add_key( key, 0 );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: bench_key_owner
+ * 
+ * Determine the node that should own a key: the first node with an ID greater than or equal to
+ * the key. The main node (63) is always present, so every key has an owner.
+ * 
+ * param:  The set of nodes in the ring, where each bit corresponds to a node ID
+ * param:  The key in question
+ * return: The ID of the owning node
+ **************************************************************************************************/
+static int bench_key_owner( uint64_t nodes, int key )
+{
+    // Local variables
+    int owner = key;              // Candidate owner of the key
+
+    while( ( owner < MAIN_DHT_NODE ) && ( ( nodes & ( 1UL << owner ) ) == 0 ) )
+    {
+        owner++;
+    }
+
+    return( owner );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_is_replica
+ * 
+ * Determine whether a node holds a copy of another node's keys: that is, whether it is one of
+ * the successors of that node, up to the replication factor.
+ * 
+ * param:  The set of nodes in the ring, where each bit corresponds to a node ID
+ * param:  The owner of the keys
+ * param:  The node in question
+ * return: True if the node is a replica of the owner
+ **************************************************************************************************/
+static bool bench_is_replica( uint64_t nodes, int owner, int node_id )
+{
+    // Local variables
+    int successor = owner;        // A successor of the owner
+    
+    nodes |= ( 1UL << MAIN_DHT_NODE );
+    
+    for( int hop = 0; hop < cmd_get_replication(); hop++ )
+    {
+        // Find the next node in the ring, wrapping around after the main node
+        do
+        {
+            successor = ( successor + 1 ) % MAX_NODE_COUNT;
+        }
+        while( ( nodes & ( 1UL << successor ) ) == 0 );
+        
+        if( successor == node_id )
+        {
+            return( true );
+        }
+    }
+    
+    return( false );
+}
+
+
+/***************************************************************************************************
+ * Function: bench_elapsed_ms
+ * 
+ * Get the time elapsed since the given start time.
+ * 
+ * param:  The start time (monotonic clock)
+ * return: The elapsed time, in milliseconds
+ **************************************************************************************************/
+static double bench_elapsed_ms( const struct timespec *start )
+{
+    // Local variables
+    struct timespec now;          // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( ( now.tv_sec - start->tv_sec ) * 1000.0 + ( now.tv_nsec - start->tv_nsec ) / 1.0e6 );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
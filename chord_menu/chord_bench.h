@@ -0,0 +1,94 @@
+//**************************************************************************************************
+// File:   chord_bench.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Benchmarks that drive the DHT from the menu process and measure how it behaves under load. The
+// state of the ring is observed through the reports that nodes send back to the menu process.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_BENCH_H
+#define CHORD_BENCH_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: bench_join_storm
+ * 
+ * Ring-build benchmark. The full key range is loaded into the DHT, then the given number of nodes
+ * are added as fast as possible. The ring is polled until every key sits on its correct owner,
+ * and the convergence time and number of messages exchanged (total and per join) are printed to
+ * the standard output.
+ * 
+ * param:  The number of nodes to add
+ * return: void
+ **************************************************************************************************/
+void bench_join_storm( int join_count );
+
+
+/***************************************************************************************************
+ * Function: bench_churn
+ * 
+ * Churn workload benchmark. A steady load of key additions, deletions and lookups is sent to the
+ * DHT at the given rate, while new nodes join at the given interval. Throughput and latency are
+ * printed per reporting interval (so that dips and spikes around joins can be seen), along with
+ * operations that were answered by the wrong node, lookups that gave the wrong answer and
+ * operations that were never answered.
+ * 
+ * param:  The duration of the workload, in seconds
+ * param:  The rate at which operations are sent, in operations per second
+ * param:  The interval between node joins, in milliseconds (zero for no joins)
+ * return: void
+ **************************************************************************************************/
+void bench_churn( int duration_s, int op_rate, int join_interval_ms );
+
+
+/***************************************************************************************************
+ * Function: bench_replay
+ * 
+ * Replay a workload trace captured with the trace module against the DHT, either at the pacing
+ * it was recorded with or as fast as possible. Keys are tagged so that the time taken to answer
+ * each operation can be measured; the replay rate and latency are printed to the standard output.
+ * 
+ * param:  The path of the trace file
+ * param:  True to keep the recorded pacing, false to replay as fast as possible
+ * return: void
+ **************************************************************************************************/
+void bench_replay( const char *path, bool paced );
+
+
+/***************************************************************************************************
+ * Function: bench_load_balance
+ * 
+ * Report how evenly the load is spread over the node processes: the share of the ID space and of
+ * the keys held by the nodes of each process, with the mean, variance and maximum of the shares.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void bench_load_balance();
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -13,12 +13,18 @@
 // Includes
 //**************************************************************************************************
 
+// memfd_create() is a Linux extension
+#define _GNU_SOURCE
+
 #include <errno.h>
+#include <limits.h>
+#include <poll.h>
 #include <stdbool.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <time.h>
 #include <unistd.h>
 #include "chord_config.h"
@@ -26,7 +32,10 @@
 #include "chord_debug.h"
 #include "chord_error.h"
 #include "chord_init.h"
+#include "chord_load.h"
 #include "chord_message.h"
+#include "chord_shared_store.h"
+#include "chord_trace.h"
 
 
 //**************************************************************************************************
@@ -39,14 +48,29 @@ static const int arg_buffer_size = 32;
 // The communication pipe used to send commands to the DHT main node
 static int pipe_to_main_node[2];
 
+// The communication pipe used by DHT nodes to send reports back to the menu
+static int pipe_from_dht[2];
+
 // Tracks created nodes (duplicate IDs are not allowed)
 static uint64_t created_nodes = 0;
 
 // Tracks keys in the DHT (duplicate keys are not allowed)
 static uint64_t dht_keys = 0;
 
+// Tracks the virtual nodes hosted by the main node's process (which cannot be crashed)
+static uint64_t main_process_nodes = 0;
+
+// Holds the bytes that followed the last report read (e.g. a value)
+static char report_value[MAX_PAYLOAD_SIZE];
+
+// The shared store, if one was created (NULL otherwise)
+static chord_shared_store_t *shared_store = NULL;
+
 // Local prototypes
 static void cmd_populate_main_node();
+static void cmd_autoscale();
+static chord_err_t cmd_join_node( int node_id, int host_id, int tag );
+static chord_err_t cmd_send_range( chord_cmd_t cmd, int first_key, int last_key, int tag );
 
 
 //**************************************************************************************************
@@ -77,12 +101,14 @@ chord_err_t cmd_create_main_node()
     int exec_code;                          // Return value from new process exec call
     int errno_val;                          // Stores errno after a system call failure
     char arg[arg_buffer_size];              // Holds an argument to pass to the child program
+    char reply_arg[arg_buffer_size];        // Holds the report pipe argument for the child program
+    const char *program_path;               // The path of the chord_node program
     
     // Initialization
     err = CHORD_ERR_NONE;
     
-    // Create pipe
-    if( pipe( pipe_to_main_node ) == 0 )
+    // Create pipes
+    if( ( pipe( pipe_to_main_node ) == 0 ) && ( pipe( pipe_from_dht ) == 0 ) )
     {
         // Success; now create child process
         process_id = fork();
@@ -91,14 +117,20 @@ chord_err_t cmd_create_main_node()
         {
             /**
              * Have the child execute a new program; need to send it the pipe "read" handle as a 
-             * string, so that it can receive commands from the menu process.
-             * 
-             * TODO: change this to current working directory
+             * string, so that it can receive commands from the menu process, and the report pipe
+             * "write" handle so that it can answer.
              */
             sprintf( arg, "%i", pipe_to_main_node[0] );
+            sprintf( reply_arg, "%i", pipe_from_dht[1] );
+            
+            program_path = getenv( "CHORD_NODE_PROGRAM" );
+            
+            if( program_path == NULL )
+            {
+                program_path = node_program_path;
+            }
             
-            exec_code = execl( "//home//jwilliamson//NetBeansProjects//chord_node//dist//Debug//GNU-Linux//chord_node",
-                               arg, (char *)NULL );
+            exec_code = execl( program_path, arg, reply_arg, (char *)NULL );
 
             if( exec_code == -1 )
             {
@@ -131,6 +163,13 @@ chord_err_t cmd_create_main_node()
             
             // Populate main node with keys read from the data file
             cmd_populate_main_node();
+            
+            // The main node's process hosts virtual nodes as well, if asked to
+            for( int count = 1; count < cmd_get_virtual_nodes(); count++ )
+            {
+                cmd_add_virtual_node( load_pick_node_id( created_nodes, dht_keys ), 
+                                      MAIN_DHT_NODE, 0 );
+            }
         }
     }
     else
@@ -150,26 +189,79 @@ chord_err_t cmd_create_main_node()
 
 
 /***************************************************************************************************
- * Function: cmd_add_node
+ * Function: cmd_create_shared_store
  * 
- * Command to add a new node to the DHT ring. If the maximum amount of supported nodes are already
- * created, no action is taken and an error code is returned. The new node ID is randomly
- * generated; this function will block until an unassigned ID is found.
+ * Create the shared store (see chord_shared_store.h), in which the nodes then keep their values
+ * and publish their key sets. The store is backed by huge pages if the system has them set aside,
+ * and otherwise by ordinary shared memory (which the system may still back by huge pages). Its 
+ * file descriptor is left open across the exec of the main node, which finds it in the 
+ * environment.
  * 
  * param:  void
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_add_node()
+chord_err_t cmd_create_shared_store()
 {
     // Local variables
-    chord_msg_t msg;          // A message to pass to the main node
-    chord_err_t err;          // An error code to return from the function
-    int new_node_id;          // The (randomly-generated) ID for the new node
-    bool found_id;            // Flag: "found a suitable ID"
+    int handle;                             // The file descriptor of the store
+    void *region = MAP_FAILED;              // The store, as mapped
+    bool huge_pages = true;                 // Flag: "the store is backed by huge pages"
+    char arg[arg_buffer_size];              // The file descriptor, for the environment
+    chord_err_t err = CHORD_ERR_INIT;       // Return status code
     
-    // Initialization
-    err = CHORD_ERR_NONE;
-    found_id = false;
+    for( int attempt = 0; ( attempt < 2 ) && ( region == MAP_FAILED ); attempt++ )
+    {
+        huge_pages = ( attempt == 0 );
+        handle = memfd_create( "chord_shared_store", ( huge_pages == true ) ? MFD_HUGETLB : 0 );
+        
+        if( ( handle >= 0 ) && ( ftruncate( handle, SHARED_STORE_SIZE ) == 0 ) )
+        {
+            region = mmap( NULL, SHARED_STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 
+                           0 );
+        }
+        
+        if( ( handle >= 0 ) && ( region == MAP_FAILED ) )
+        {
+            close( handle );
+        }
+    }
+    
+    if( region != MAP_FAILED )
+    {
+        if( huge_pages == false )
+        {
+            madvise( region, SHARED_STORE_SIZE, MADV_HUGEPAGE );
+        }
+        
+        shared_store = (chord_shared_store_t *)region;
+        shared_store->huge_pages = huge_pages;
+        
+        snprintf( arg, sizeof( arg ), "%i", handle );
+        setenv( SHARED_STORE_ENV_VAR, arg, 1 );
+        err = CHORD_ERR_NONE;
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_add_node
+ * 
+ * Command to add a new node to the DHT ring. If the maximum amount of supported nodes are already
+ * created, no action is taken and an error code is returned. The new node ID is chosen by the 
+ * placement policy (see chord_load.h), normally to split the most loaded arc of the ring. If each
+ * process is to host virtual nodes, they are added along with the node (with IDs of their own, 
+ * chosen the same way), as far as there are IDs left for them.
+ * 
+ * param:  A tag echoed back by each new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_add_node( int tag )
+{
+    // Local variables
+    chord_err_t err;              // An error code to return from the function
+    int new_node_id;              // The ID for the new node
     
     // If all nodes are created, do nothing and return error code
     if( created_nodes == UINT64_MAX )
@@ -178,35 +270,67 @@ chord_err_t cmd_add_node()
     }
     else
     {
-        /**
-         * Generate a new ID for the node to add using a random number source. Keep going until
-         * an unused number is obtained.
-         */
-        while( found_id == false )
+        // Ask for the latest hot keys of the ring, which later nodes will be placed by
+        if( load_stats_due() )
         {
-            // Seed random number generator with the current time
-            srand( time( NULL ) );
-            new_node_id = ( rand() % ( MAX_NODE_COUNT - 1 ) );
-            
-            if( ( created_nodes & ( 1UL << new_node_id ) ) == 0 )
-            {
-                // Found a suitable ID
-                found_id = true;
-                created_nodes |= ( 1UL << new_node_id );
-            }
+            cmd_request_stats( LOAD_STATS_TAG );
         }
         
-        // Build the message
-        msg.cmd = ADD_NODE;
-        msg.id = new_node_id;
-        msg.sender = MENU_PROCESS_ID;
-        
-        // Debug
-        debug_printf( "[DBG] Info: Command <addnode> adding new node ID %i into DHT ring\n", 
-                       new_node_id );
+        new_node_id = load_pick_node_id( created_nodes, dht_keys );
+        err = cmd_add_node_id( new_node_id, tag );
         
-        // Send to main node
-        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+        for( int count = 1; ( count < cmd_get_virtual_nodes() ) && ( err == CHORD_ERR_NONE ) &&
+                            ( created_nodes != UINT64_MAX ); count++ )
+        {
+            err = cmd_add_virtual_node( load_pick_node_id( created_nodes, dht_keys ), 
+                                        new_node_id, tag );
+        }
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_add_node_id
+ * 
+ * Command to add a new node with the given ID to the DHT ring. If the ID is out of range or
+ * already assigned to a node, no action is taken and an error code is returned.
+ * 
+ * param:  The ID of the node to add
+ * param:  A tag echoed back by the new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_add_node_id( int node_id, int tag )
+{
+    return( cmd_join_node( node_id, INT_MAX, tag ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_add_virtual_node
+ * 
+ * Command to add a virtual node with the given ID to the DHT ring, hosted by the process of an
+ * existing node. If either ID is not valid, no action is taken and an error code is returned.
+ * 
+ * param:  The ID of the node to add
+ * param:  The ID of the node whose process is to host the new node
+ * param:  A tag echoed back by the new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_add_virtual_node( int node_id, int host_id, int tag )
+{
+    // Local variables
+    chord_err_t err;          // An error code to return from the function
+    
+    if( ( host_id < 0 ) || ( host_id >= MAX_NODE_COUNT ) || 
+        ( ( created_nodes & ( 1UL << host_id ) ) == 0 ) )
+    {
+        err = CHORD_ERR_INVALID_NODE;
+    }
+    else
+    {
+        err = cmd_join_node( node_id, host_id, tag );
     }
     
     return( err );
@@ -220,9 +344,10 @@ chord_err_t cmd_add_node()
  * is returned; it will not be added again.
  * 
  * param:  the key to be added to the DHT
+ * param:  A tag echoed back by the node that adds the key (zero if no reply is wanted)
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_add_key( int key_id )
+chord_err_t cmd_add_key( int key_id, int tag )
 {
     // Local variables
     chord_msg_t msg;          // A message to pass to the main node
@@ -249,6 +374,8 @@ chord_err_t cmd_add_key( int key_id )
             msg.cmd = ADD_KEY;
             msg.id = key_id;
             msg.sender = MENU_PROCESS_ID;
+            msg.tag = tag;
+            msg.hops = 0;
         
             // Debug
             debug_printf( "[DBG] Info: Command <addkey> adding new key ID %i into DHT ring\n", 
@@ -257,8 +384,14 @@ chord_err_t cmd_add_key( int key_id )
             // Mark key as active
             dht_keys |= ( 1UL << key_id );
         
+            // Record the command (if a workload trace is being captured)
+            trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+            
             // Send to main node
             write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+            
+            // Split the arc of the key if the ring reports it overloaded
+            cmd_autoscale();
         }
     }
     
@@ -273,9 +406,10 @@ chord_err_t cmd_add_key( int key_id )
  * is returned.
  * 
  * param:  the key to be removed from the DHT
+ * param:  A tag echoed back by the node that removes the key (zero if no reply is wanted)
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_delete_key( int key_id )
+chord_err_t cmd_delete_key( int key_id, int tag )
 {
     // Local variables
     chord_msg_t msg;          // A message to pass to the main node
@@ -302,6 +436,8 @@ chord_err_t cmd_delete_key( int key_id )
             msg.cmd = DELETE_KEY;
             msg.id = key_id;
             msg.sender = MENU_PROCESS_ID;
+            msg.tag = tag;
+            msg.hops = 0;
         
             // Debug
             debug_printf( "[DBG] Info: Command <delkey> removing key ID %i from DHT ring\n", 
@@ -310,8 +446,14 @@ chord_err_t cmd_delete_key( int key_id )
             // Mark key as inactive
             dht_keys &= ~( 1UL << key_id );
         
+            // Record the command (if a workload trace is being captured)
+            trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+            
             // Send to main node
             write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+            
+            // Split the arc of the key if the ring reports it overloaded
+            cmd_autoscale();
         }
     }
     
@@ -320,111 +462,877 @@ chord_err_t cmd_delete_key( int key_id )
 
 
 /***************************************************************************************************
- * Function: cmd_dump
+ * Function: cmd_lookup_key
  * 
- * Command to have all nodes in the DHT dump their ID and key set to standard output.
+ * Command to look up a key in the DHT ring. The owner of the key answers with a reply carrying
+ * the given tag, which can be collected with cmd_read_report; the payload of the reply is 1 if
+ * the key is present, and 0 otherwise.
  * 
- * param:  void
- * return: void
+ * param:  the key to look up
+ * param:  A tag echoed back by the owner of the key (must not be zero)
+ * return: An error code indicative of success or failure
  **************************************************************************************************/
-void cmd_dump()
+chord_err_t cmd_lookup_key( int key_id, int tag )
 {
     // Local variables
     chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
     
-    // Build the message
-    msg.cmd = DUMP;
-    msg.id = 0;
-    msg.sender = MENU_PROCESS_ID;
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure key is valid
+    if( ( key_id < 0 ) || ( key_id >= MAX_KEY_VALUE ) )
+    {
+        err = CHORD_ERR_INVALID_KEY;
+    }
+    else
+    {
+        // Build the message
+        msg.cmd = LOOKUP;
+        msg.id = key_id;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = 0;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <lookup> looking up key ID %i in DHT ring\n", key_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+        
+        // Split the arc of the key if the ring reports it overloaded
+        cmd_autoscale();
+    }
+    
+    return( err );
+}
 
-    // Debug
-    debug_printf( "[DBG] Info: Command <dump> sent to DHT\n" );
 
-    // Send to main node
-    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+/***************************************************************************************************
+ * Function: cmd_put_key
+ * 
+ * Command to store a value under a key in the DHT ring. The key is added if it is not present
+ * already; otherwise, the value replaces the one stored under it. If the command is tagged, the
+ * node that stores the value acknowledges it.
+ * 
+ * param:  The key to store the value under
+ * param:  The value
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * param:  A tag echoed back by the node that stores the value (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_put_key( int key_id, const char *value, int length, int tag )
+{
+    // Local variables
+    chord_payload_msg_t msg;  // A message to pass to the main node, followed by the value
+    chord_err_t err;          // An error code to return from the function
+    
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure key and value are valid
+    if( ( key_id < 0 ) || ( key_id >= MAX_KEY_VALUE ) )
+    {
+        err = CHORD_ERR_INVALID_KEY;
+    }
+    else if( ( length < 0 ) || ( length > MAX_VALUE_SIZE ) )
+    {
+        err = CHORD_ERR_VALUE_TOO_LONG;
+    }
+    else
+    {
+        // Build the message
+        msg.msg.cmd = PUT;
+        msg.msg.id = key_id;
+        msg.msg.sender = MENU_PROCESS_ID;
+        msg.msg.tag = tag;
+        msg.msg.hops = 0;
+        msg.msg.length = length;
+        memcpy( msg.payload, value, length );
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <put> storing %i bytes under key ID %i in DHT ring\n",
+                      length, key_id );
+        
+        // Mark key as active
+        dht_keys |= ( 1UL << key_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.msg.cmd, msg.msg.id, 0, value, length );
+        
+        // Send to main node, with the value, in one piece
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg.msg ) + length );
+        
+        // Split the arc of the key if the ring reports it overloaded
+        cmd_autoscale();
+    }
+    
+    return( err );
 }
 
 
 /***************************************************************************************************
- * Function: cmd_toggle_debug
+ * Function: cmd_get_key
  * 
- * Command to toggle the output of debug messages. This is useful for development purposes. By 
- * default, debug is disabled.
+ * Command to fetch the value stored under a key in the DHT ring. The owner of the key answers as
+ * it does a lookup (see cmd_lookup_key), with the value, if any, following the reply; it can be
+ * collected with cmd_get_report_value once the reply has been read.
  * 
- * param:  void
- * return: void
+ * param:  The key to fetch the value of
+ * param:  A tag echoed back by the owner of the key (must not be zero)
+ * return: An error code indicative of success or failure
  **************************************************************************************************/
-void cmd_toggle_debug()
+chord_err_t cmd_get_key( int key_id, int tag )
 {
     // Local variables
     chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
     
-    // Build the message
-    msg.cmd = TOGGLE_DEBUG;
-    msg.sender = MENU_PROCESS_ID;
+    // Initialization
+    err = CHORD_ERR_NONE;
     
-    if( debug_mode == true )
+    // Check to ensure key is valid
+    if( ( key_id < 0 ) || ( key_id >= MAX_KEY_VALUE ) )
     {
-        // Turn off debug
-        debug_mode = false;
-        debug_disable_prints();
-        msg.id = 0;
-        printf( "Debug messages disabled.\n" );
+        err = CHORD_ERR_INVALID_KEY;
     }
     else
     {
-        // Turn on debug
-        debug_mode = true;
-        debug_enable_prints();
-        msg.id = 1;
-        printf( "Debug messages enabled.\n" );
+        // Build the message
+        msg.cmd = GET;
+        msg.id = key_id;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = 0;
+        msg.length = 0;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <get> fetching the value of key ID %i\n", key_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+        
+        // Split the arc of the key if the ring reports it overloaded
+        cmd_autoscale();
     }
     
-    // Send to main node
-    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+    return( err );
 }
 
 
 /***************************************************************************************************
- * Function: cmd_populate_main_node
+ * Function: cmd_multi_get
  * 
- * Send the initial key list to the main node. This uses a sequence of "add key" messages through
- * a pipe so that DHT initialization can be completed.
+ * Command to fetch the values stored under a set of keys in the DHT ring at once. The request is
+ * split among the owners of the keys as it is routed, and each owner answers with a reply carrying
+ * the given tag for the keys it owns (split over several replies if their values do not fit in
+ * one), laid out as described in chord_message.h. The values of a reply can be collected with
+ * cmd_get_report_value once it has been read.
  * 
- * param:  void
- * return: void
+ * param:  The keys to fetch the values of, as a 64-bit bitmap
+ * param:  A tag echoed back by the owners of the keys (must not be zero)
+ * return: An error code indicative of success or failure
  **************************************************************************************************/
-static void cmd_populate_main_node()
+chord_err_t cmd_multi_get( uint64_t keys, int tag )
 {
     // Local variables
     chord_msg_t msg;          // A message to pass to the main node
-    int number_of_keys;       // The number of initial keys
-    int *key;                 // Pointer to a key (points to list of keys)
+    chord_err_t err;          // An error code to return from the function
     
     // Initialization
-    msg.cmd = ADD_KEY;
-    msg.sender = MENU_PROCESS_ID;
-    number_of_keys = init_get_key_count();
-    key = init_get_key_list();
+    err = CHORD_ERR_NONE;
     
-    if( number_of_keys > 0 )
+    // Check to ensure there is a key to fetch
+    if( keys == 0 )
     {
-        // Send an "add key" command for each key in the list
-        while( number_of_keys > 0 )
-        {
-            // Get next key ID and place into message
-            msg.id = *key;
-            
-            // Mark key as active
-            dht_keys |= ( 1UL << msg.id );
-            
-            // Send to main node
-            write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
-            
-            key++;
-            number_of_keys--;
-        }
+        err = CHORD_ERR_INVALID_KEY;
+    }
+    else
+    {
+        // Build the message
+        msg.cmd = MGET;
+        msg.id = 0;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = 0;
+        msg.length = 0;
+        msg.data = keys;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <mget> fetching the values of %i keys\n", 
+                      __builtin_popcountll( keys ) );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, msg.data, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
     }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_scan_range
+ * 
+ * Command to fetch the keys in a range of the DHT ring, with their values. The command is routed
+ * to the owner of the first key and passed from node to node until the last key; each node answers
+ * with a reply carrying the given tag for the part of the range it holds (split over several 
+ * replies if its values do not fit in one), laid out as described in chord_message.h. The values
+ * of a reply can be collected with cmd_get_report_value once it has been read.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_scan_range( int first_key, int last_key, int tag )
+{
+    return( cmd_send_range( SCAN, first_key, last_key, tag ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_count_range
+ * 
+ * Command to count the keys in a range of the DHT ring. The command travels as a scan does (see
+ * cmd_scan_range), and each node answers with the number of keys in its part of the range.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_count_range( int first_key, int last_key, int tag )
+{
+    return( cmd_send_range( COUNT, first_key, last_key, tag ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_delete_range
+ * 
+ * Command to delete the keys in a range from the DHT ring, with one message per node rather than
+ * one per key. The command travels as a scan does (see cmd_scan_range); if it is tagged, each node
+ * answers with the keys it deleted from its part of the range.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_delete_range( int first_key, int last_key, int tag )
+{
+    // Local variables
+    chord_err_t err;          // An error code to return from the function
+    
+    err = cmd_send_range( DELETE_RANGE, first_key, last_key, tag );
+    
+    // Mark the keys in the range as inactive
+    if( err == CHORD_ERR_NONE )
+    {
+        for( int key_id = first_key; key_id <= last_key; key_id++ )
+        {
+            dht_keys &= ~( 1UL << key_id );
+        }
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_remove_node
+ * 
+ * Command to remove a node from the DHT ring. The node hands its keys to its successor and exits
+ * once its predecessor links past it; if the command is tagged, the node then answers with a 
+ * reply whose payload is the set of keys it handed over. The main node cannot be removed.
+ * 
+ * param:  The ID of the node to remove
+ * param:  A tag echoed back by the node once it has left (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_remove_node( int node_id, int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
+    
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure the node exists, and is not the main node
+    if( ( node_id < 0 ) || ( node_id >= MAIN_DHT_NODE ) || 
+        ( ( created_nodes & ( 1UL << node_id ) ) == 0 ) )
+    {
+        err = CHORD_ERR_INVALID_NODE;
+    }
+    else
+    {
+        // Mark node as removed
+        created_nodes &= ~( 1UL << node_id );
+        main_process_nodes &= ~( 1UL << node_id );
+        
+        // Build the message
+        msg.cmd = LEAVE;
+        msg.id = node_id;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = 0;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <delnode> removing node ID %i from DHT ring\n", 
+                      node_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_crash_node
+ * 
+ * Command to make a node in the DHT ring fail abruptly, to exercise failure detection and ring 
+ * repair. The supervisor reports the repair with a notice that can be collected with 
+ * cmd_read_report; the node is no longer tracked as added once the notice has been read. The 
+ * main node cannot be crashed, and neither can the virtual nodes its process hosts.
+ * 
+ * param:  The ID of the node to crash
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_crash_node( int node_id )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
+    
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure the node exists, and is not the main node (or hosted by its process)
+    if( ( node_id < 0 ) || ( node_id >= MAIN_DHT_NODE ) || 
+        ( ( created_nodes & ( 1UL << node_id ) ) == 0 ) || 
+        ( main_process_nodes & ( 1UL << node_id ) ) )
+    {
+        err = CHORD_ERR_INVALID_NODE;
+    }
+    else
+    {
+        // Build the message
+        msg.cmd = CRASH;
+        msg.id = node_id;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = 0;
+        msg.hops = 0;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <crash> crashing node ID %i\n", node_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_dump
+ * 
+ * Command to have all nodes in the DHT dump their ID and key set to standard output. If the 
+ * command is tagged, the nodes then answer together with statistics about the ring (see 
+ * cmd_request_stats).
+ * 
+ * param:  A tag echoed back in the answer (zero if no answer is wanted)
+ * return: void
+ **************************************************************************************************/
+void cmd_dump( int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    
+    // Build the message
+    msg.cmd = DUMP;
+    msg.id = 0;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = tag;
+    msg.hops = 0;
+
+    // Debug
+    debug_printf( "[DBG] Info: Command <dump> sent to DHT\n" );
+
+    // Record the command (if a workload trace is being captured)
+    trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+    
+    // Send to main node
+    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_toggle_debug
+ * 
+ * Command to toggle the output of debug messages. This is useful for development purposes. By 
+ * default, debug is disabled.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void cmd_toggle_debug()
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    
+    // Build the message
+    msg.cmd = TOGGLE_DEBUG;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = 0;
+    msg.hops = 0;
+    
+    if( debug_mode == true )
+    {
+        // Turn off debug
+        debug_mode = false;
+        debug_disable_prints();
+        msg.id = 0;
+        printf( "Debug messages disabled.\n" );
+    }
+    else
+    {
+        // Turn on debug
+        debug_mode = true;
+        debug_enable_prints();
+        msg.id = 1;
+        printf( "Debug messages enabled. Nodes log to chord_node_<id>.clog (render the logs with "
+                "chord_node --decode-log).\n" );
+    }
+    
+    // Send to main node
+    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_request_report
+ * 
+ * Command to have all nodes in the DHT report their ID, key set and message count back to the
+ * menu process. The reports can be collected with cmd_read_report.
+ * 
+ * param:  A tag that is echoed back in each report, to match reports to this request
+ * return: void
+ **************************************************************************************************/
+void cmd_request_report( int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    
+    // Build the message
+    msg.cmd = REPORT;
+    msg.id = 0;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = tag;
+    msg.hops = 0;
+    
+    // Send to main node
+    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_request_stats
+ * 
+ * Command to gather statistics about the whole ring. The nodes answer together, in a single 
+ * AGGREGATE reply collected with cmd_read_report: its ID is the number of nodes that answered, 
+ * its hops field the number of messages they have sent, and its payload the union of their key
+ * sets. The sum of their store counters (see chord_store_stats_t) follows it, and can be collected
+ * with cmd_get_report_value.
+ * 
+ * param:  A tag echoed back in the answer, to match it to this request
+ * return: void
+ **************************************************************************************************/
+void cmd_request_stats( int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    
+    // Build the message
+    msg.cmd = STATS;
+    msg.id = 0;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = tag;
+    msg.hops = 0;
+    
+    // Send to main node
+    write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_read_report
+ * 
+ * Read a single report sent back to the menu process by a node, waiting up to the given time for
+ * one to arrive. Notices of ring repairs from the supervisor are read (and returned) as reports
+ * too.
+ * 
+ * param:  Holds the report that was read (if any)
+ * param:  The maximum time to wait, in milliseconds
+ * return: An error code indicative of success or failure (timeout)
+ **************************************************************************************************/
+chord_err_t cmd_read_report( chord_msg_t *report, int timeout_ms )
+{
+    // Local variables
+    struct pollfd report_poll;        // Used to wait for the report pipe to become readable
+    chord_err_t err;                  // An error code to return from the function
+    int length;                       // The number of bytes that follow the report
+    chord_store_stats_t stats;        // The statistics of the ring, if the report carries them
+    
+    // Initialization
+    err = CHORD_ERR_TIMEOUT;
+    report_poll.fd = pipe_from_dht[0];
+    report_poll.events = POLLIN;
+    
+    if( poll( &report_poll, 1, timeout_ms ) > 0 )
+    {
+        // Reports are smaller than PIPE_BUF, so each is written (and read) in one piece, with the
+        // bytes that follow it
+        if( read( pipe_from_dht[0], (void *)report, sizeof( *report ) ) == sizeof( *report ) )
+        {
+            err = CHORD_ERR_NONE;
+            length = MSG_PAYLOAD_LENGTH( report );
+            
+            if( ( length < 0 ) || ( length > MAX_PAYLOAD_SIZE ) ||
+                ( read( pipe_from_dht[0], (void *)report_value, length ) != length ) )
+            {
+                report->length = 0;
+            }
+            
+            // The supervisor repaired the ring around a failed node, so the node is gone
+            if( report->cmd == REPAIR )
+            {
+                created_nodes &= ~( 1UL << report->id );
+            }
+            
+            // Statistics of the ring (whoever asked for them) carry its latest hot keys
+            if( ( report->cmd == AGGREGATE ) && ( report->length == sizeof( stats ) ) )
+            {
+                memcpy( &stats, report_value, sizeof( stats ) );
+                load_record_stats( &stats );
+            }
+        }
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_report_value
+ * 
+ * Get the bytes that followed the last report read by cmd_read_report (e.g. the value in the 
+ * answer to cmd_get_key); the report's length field holds their number.
+ * 
+ * param:  void
+ * return: The bytes that followed the report
+ **************************************************************************************************/
+const char *cmd_get_report_value()
+{
+    return( report_value );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_shared_store
+ * 
+ * Get the shared store, from which the values and key sets of the nodes can be read directly.
+ * 
+ * param:  void
+ * return: The shared store, or NULL if there is none
+ **************************************************************************************************/
+const chord_shared_store_t *cmd_get_shared_store()
+{
+    return( shared_store );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_nodes
+ * 
+ * Get the set of nodes that have been added to the DHT, where each bit corresponds to a node ID.
+ * 
+ * param:  void
+ * return: The node set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t cmd_get_nodes()
+{
+    return( created_nodes );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_keys
+ * 
+ * Get the set of keys that have been added to the DHT, where each bit corresponds to a key.
+ * 
+ * param:  void
+ * return: The key set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t cmd_get_keys()
+{
+    return( dht_keys );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_replication
+ * 
+ * Get the replication factor of the DHT: the number of successors holding a copy of each node's
+ * keys, as set by the CHORD_REPLICATION environment variable that the nodes inherit.
+ * 
+ * param:  void
+ * return: The replication factor (zero if keys are not replicated)
+ **************************************************************************************************/
+int cmd_get_replication()
+{
+    // Local variables
+    const char *replication;      // The replication factor, from the environment
+    int factor;                   // The replication factor
+    
+    replication = getenv( "CHORD_REPLICATION" );
+    factor = ( replication != NULL ) ? atoi( replication ) : 0;
+    
+    // Nodes limit the factor in the same way
+    return( ( factor < 0 ) ? 0 : ( factor > MAX_REPLICATION ) ? MAX_REPLICATION : factor );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_get_virtual_nodes
+ * 
+ * Get the number of nodes each node process hosts: its own node and any virtual nodes, as set by 
+ * the CHORD_VNODES environment variable.
+ * 
+ * param:  void
+ * return: The number of nodes per process (one if processes do not host virtual nodes)
+ **************************************************************************************************/
+int cmd_get_virtual_nodes()
+{
+    // Local variables
+    const char *vnodes;           // The number of nodes per process, from the environment
+    int count;                    // The number of nodes per process
+    
+    vnodes = getenv( "CHORD_VNODES" );
+    count = ( vnodes != NULL ) ? atoi( vnodes ) : 1;
+    
+    return( ( count < 1 ) ? 1 : ( count > MAX_VIRTUAL_NODES ) ? MAX_VIRTUAL_NODES : count );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_populate_main_node
+ * 
+ * Send the initial key list to the main node. This uses a sequence of "add key" messages through
+ * a pipe so that DHT initialization can be completed.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void cmd_populate_main_node()
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    int number_of_keys;       // The number of initial keys
+    int *key;                 // Pointer to a key (points to list of keys)
+    
+    // Initialization
+    msg.cmd = ADD_KEY;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = 0;
+    msg.hops = 0;
+    number_of_keys = init_get_key_count();
+    key = init_get_key_list();
+    
+    if( number_of_keys > 0 )
+    {
+        // Send an "add key" command for each key in the list
+        while( number_of_keys > 0 )
+        {
+            // Get next key ID and place into message
+            msg.id = *key;
+            
+            // Mark key as active
+            dht_keys |= ( 1UL << msg.id );
+            
+            // Send to main node
+            write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+            
+            key++;
+            number_of_keys--;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_autoscale
+ * 
+ * Add a node if automatic scaling is on and some arc of the ring has become overloaded. The new
+ * node splits the most loaded arc, and does not reply once it has joined.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void cmd_autoscale()
+{
+    // Local variables
+    int new_node_id;              // The ID of the new node
+    
+    // Ask for the latest hot keys of the ring, which the next check will go by
+    if( load_stats_due() )
+    {
+        cmd_request_stats( LOAD_STATS_TAG );
+    }
+    
+    if( ( created_nodes != UINT64_MAX ) && load_autoscale_due( created_nodes, dht_keys ) )
+    {
+        new_node_id = load_pick_node_id( created_nodes, dht_keys );
+        
+        // Debug
+        debug_printf( "[DBG] Info: Autoscale adding node ID %i to split an overloaded arc\n", 
+                      new_node_id );
+        
+        cmd_add_node( 0 );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_join_node
+ * 
+ * Send the command to add a new node with the given ID to the DHT ring, in a process of its own or
+ * hosted by the process of an existing node. If the ID is out of range or already assigned to a 
+ * node, no action is taken and an error code is returned.
+ * 
+ * param:  The ID of the node to add
+ * param:  The ID of the node whose process is to host the new node (INT_MAX for its own process)
+ * param:  A tag echoed back by the new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+static chord_err_t cmd_join_node( int node_id, int host_id, int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
+    
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure node ID is valid (the main node ID is always taken)
+    if( ( node_id < 0 ) || ( node_id >= MAX_NODE_COUNT ) )
+    {
+        err = CHORD_ERR_INVALID_NODE;
+    }
+    else if( created_nodes & ( 1UL << node_id ) )
+    {
+        err = CHORD_ERR_NODE_ALREADY_ADDED;
+    }
+    else
+    {
+        // Mark node as created
+        created_nodes |= ( 1UL << node_id );
+        
+        if( host_id == MAIN_DHT_NODE )
+        {
+            main_process_nodes |= ( 1UL << node_id );
+        }
+        
+        // Build the message
+        msg.cmd = ADD_NODE;
+        msg.id = node_id;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = 0;
+        msg.data = ( host_id == INT_MAX ) ? 0 : ( 1UL << host_id );
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command <addnode> adding new node ID %i into DHT ring\n", 
+                       node_id );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, 0, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+    }
+    
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: cmd_send_range
+ * 
+ * Send a range command (scan, count or range delete) to the main node.
+ * 
+ * param:  The command
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+static chord_err_t cmd_send_range( chord_cmd_t cmd, int first_key, int last_key, int tag )
+{
+    // Local variables
+    chord_msg_t msg;          // A message to pass to the main node
+    chord_err_t err;          // An error code to return from the function
+    
+    // Initialization
+    err = CHORD_ERR_NONE;
+    
+    // Check to ensure the range is valid
+    if( ( first_key < 0 ) || ( last_key >= MAX_KEY_VALUE ) || ( first_key > last_key ) )
+    {
+        err = CHORD_ERR_INVALID_KEY;
+    }
+    else
+    {
+        // Build the message
+        msg.cmd = cmd;
+        msg.id = first_key;
+        msg.sender = MENU_PROCESS_ID;
+        msg.tag = tag;
+        msg.hops = last_key;
+        msg.length = 0;
+        msg.data = 0;
+        
+        // Debug
+        debug_printf( "[DBG] Info: Command %i sent for keys %i-%i of DHT ring\n", cmd, first_key,
+                      last_key );
+        
+        // Record the command (if a workload trace is being captured)
+        trace_record( msg.cmd, msg.id, msg.hops, NULL, 0 );
+        
+        // Send to main node
+        write( pipe_to_main_node[1], (void *)&msg, sizeof( msg ) );
+    }
+    
+    return( err );
 }
 
 
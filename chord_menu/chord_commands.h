@@ -17,7 +17,10 @@
 // Includes
 //**************************************************************************************************
 
+#include <stdint.h>
 #include "chord_error.h"
+#include "chord_message.h"
+#include "chord_shared_store.h"
 
 
 //**************************************************************************************************
@@ -49,17 +52,59 @@
 chord_err_t cmd_create_main_node();
 
 
+/***************************************************************************************************
+ * Function: cmd_create_shared_store
+ * 
+ * Create the shared store (see chord_shared_store.h), in which the nodes then keep their values
+ * and publish their key sets. This must be done before the main node is created, which is handed
+ * the store through the environment.
+ * 
+ * param:  void
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_create_shared_store();
+
+
 /***************************************************************************************************
  * Function: cmd_add_node
  * 
  * Command to add a new node to the DHT ring. If the maximum amount of supported nodes are already
  * created, no action is taken and an error code is returned. The new node ID is randomly
- * generated; this function will block until an unassigned ID is found.
+ * generated; this function will block until an unassigned ID is found. If each process is to 
+ * host virtual nodes, they are added along with the node (with IDs of their own, at random), as 
+ * far as there are IDs left for them.
  * 
- * param:  void
+ * param:  A tag echoed back by each new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_add_node( int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_add_node_id
+ * 
+ * Command to add a new node with the given ID to the DHT ring. If the ID is out of range or
+ * already assigned to a node, no action is taken and an error code is returned.
+ * 
+ * param:  The ID of the node to add
+ * param:  A tag echoed back by the new node once it has joined (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_add_node_id( int node_id, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_add_virtual_node
+ * 
+ * Command to add a virtual node with the given ID to the DHT ring, hosted by the process of an
+ * existing node. If either ID is not valid, no action is taken and an error code is returned.
+ * 
+ * param:  The ID of the node to add
+ * param:  The ID of the node whose process is to host the new node
+ * param:  A tag echoed back by the new node once it has joined (zero if no reply is wanted)
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_add_node();
+chord_err_t cmd_add_virtual_node( int node_id, int host_id, int tag );
 
 
 /***************************************************************************************************
@@ -69,9 +114,10 @@ chord_err_t cmd_add_node();
  * is returned; it will not be added again.
  * 
  * param:  the key to be added to the DHT
+ * param:  A tag echoed back by the node that adds the key (zero if no reply is wanted)
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_add_key( int key_id );
+chord_err_t cmd_add_key( int key_id, int tag );
 
 
 /***************************************************************************************************
@@ -81,20 +127,157 @@ chord_err_t cmd_add_key( int key_id );
  * is returned.
  * 
  * param:  the key to be removed from the DHT
+ * param:  A tag echoed back by the node that removes the key (zero if no reply is wanted)
  * return: An error code indicative of success or failure
  **************************************************************************************************/
-chord_err_t cmd_delete_key( int key_id );
+chord_err_t cmd_delete_key( int key_id, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_lookup_key
+ * 
+ * Command to look up a key in the DHT ring. The owner of the key answers with a reply carrying
+ * the given tag, which can be collected with cmd_read_report; the payload of the reply is 1 if
+ * the key is present, and 0 otherwise.
+ * 
+ * param:  the key to look up
+ * param:  A tag echoed back by the owner of the key (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_lookup_key( int key_id, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_put_key
+ * 
+ * Command to store a value under a key in the DHT ring. The key is added if it is not present
+ * already; otherwise, the value replaces the one stored under it. If the command is tagged, the
+ * node that stores the value acknowledges it.
+ * 
+ * param:  The key to store the value under
+ * param:  The value
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * param:  A tag echoed back by the node that stores the value (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_put_key( int key_id, const char *value, int length, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_get_key
+ * 
+ * Command to fetch the value stored under a key in the DHT ring. The owner of the key answers as
+ * it does a lookup (see cmd_lookup_key), with the value, if any, following the reply; it can be
+ * collected with cmd_get_report_value once the reply has been read.
+ * 
+ * param:  The key to fetch the value of
+ * param:  A tag echoed back by the owner of the key (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_get_key( int key_id, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_multi_get
+ * 
+ * Command to fetch the values stored under a set of keys in the DHT ring at once. The request is
+ * split among the owners of the keys as it is routed, and each owner answers with a reply carrying
+ * the given tag for the keys it owns (split over several replies if their values do not fit in
+ * one), laid out as described in chord_message.h. The values of a reply can be collected with
+ * cmd_get_report_value once it has been read.
+ * 
+ * param:  The keys to fetch the values of, as a 64-bit bitmap
+ * param:  A tag echoed back by the owners of the keys (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_multi_get( uint64_t keys, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_scan_range
+ * 
+ * Command to fetch the keys in a range of the DHT ring, with their values. The command is routed
+ * to the owner of the first key and passed from node to node until the last key; each node answers
+ * with a reply carrying the given tag for the part of the range it holds (split over several 
+ * replies if its values do not fit in one), laid out as described in chord_message.h. The values
+ * of a reply can be collected with cmd_get_report_value once it has been read.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_scan_range( int first_key, int last_key, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_count_range
+ * 
+ * Command to count the keys in a range of the DHT ring. The command travels as a scan does (see
+ * cmd_scan_range), and each node answers with the number of keys in its part of the range.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (must not be zero)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_count_range( int first_key, int last_key, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_delete_range
+ * 
+ * Command to delete the keys in a range from the DHT ring, with one message per node rather than
+ * one per key. The command travels as a scan does (see cmd_scan_range); if it is tagged, each node
+ * answers with the keys it deleted from its part of the range.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  A tag echoed back by the nodes (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_delete_range( int first_key, int last_key, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_remove_node
+ * 
+ * Command to remove a node from the DHT ring. The node hands its keys to its successor and exits
+ * once its predecessor links past it; if the command is tagged, the node then answers with a 
+ * reply whose payload is the set of keys it handed over. The main node cannot be removed.
+ * 
+ * param:  The ID of the node to remove
+ * param:  A tag echoed back by the node once it has left (zero if no reply is wanted)
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_remove_node( int node_id, int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_crash_node
+ * 
+ * Command to make a node in the DHT ring fail abruptly, to exercise failure detection and ring 
+ * repair. The supervisor reports the repair with a notice that can be collected with 
+ * cmd_read_report; the node is no longer tracked as added once the notice has been read. The 
+ * main node cannot be crashed, and neither can the virtual nodes its process hosts.
+ * 
+ * param:  The ID of the node to crash
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t cmd_crash_node( int node_id );
 
 
 /***************************************************************************************************
  * Function: cmd_dump
  * 
- * Command to have all nodes in the DHT dump their ID and key set to standard output.
+ * Command to have all nodes in the DHT dump their ID and key set to standard output. If the 
+ * command is tagged, the nodes then answer together with statistics about the ring (see 
+ * cmd_request_stats).
  * 
- * param:  void
+ * param:  A tag echoed back in the answer (zero if no answer is wanted)
  * return: void
  **************************************************************************************************/
-void cmd_dump();
+void cmd_dump( int tag );
 
 
 /***************************************************************************************************
@@ -109,6 +292,116 @@ void cmd_dump();
 void cmd_toggle_debug();
 
 
+/***************************************************************************************************
+ * Function: cmd_request_report
+ * 
+ * Command to have all nodes in the DHT report their ID, key set and message count back to the
+ * menu process. The reports can be collected with cmd_read_report.
+ * 
+ * param:  A tag that is echoed back in each report, to match reports to this request
+ * return: void
+ **************************************************************************************************/
+void cmd_request_report( int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_request_stats
+ * 
+ * Command to gather statistics about the whole ring. The nodes answer together, in a single 
+ * AGGREGATE reply collected with cmd_read_report: its ID is the number of nodes that answered, 
+ * its hops field the number of messages they have sent, and its payload the union of their key
+ * sets. The sum of their store counters (see chord_store_stats_t) follows it, and can be collected
+ * with cmd_get_report_value.
+ * 
+ * param:  A tag echoed back in the answer, to match it to this request
+ * return: void
+ **************************************************************************************************/
+void cmd_request_stats( int tag );
+
+
+/***************************************************************************************************
+ * Function: cmd_read_report
+ * 
+ * Read a single report sent back to the menu process by a node, waiting up to the given time for
+ * one to arrive. Notices of ring repairs from the supervisor are read (and returned) as reports
+ * too.
+ * 
+ * param:  Holds the report that was read (if any)
+ * param:  The maximum time to wait, in milliseconds
+ * return: An error code indicative of success or failure (timeout)
+ **************************************************************************************************/
+chord_err_t cmd_read_report( chord_msg_t *report, int timeout_ms );
+
+
+/***************************************************************************************************
+ * Function: cmd_get_report_value
+ * 
+ * Get the bytes that followed the last report read by cmd_read_report (e.g. the value in the 
+ * answer to cmd_get_key); the report's length field holds their number.
+ * 
+ * param:  void
+ * return: The bytes that followed the report
+ **************************************************************************************************/
+const char *cmd_get_report_value();
+
+
+/***************************************************************************************************
+ * Function: cmd_get_shared_store
+ * 
+ * Get the shared store, from which the values and key sets of the nodes can be read directly.
+ * 
+ * param:  void
+ * return: The shared store, or NULL if there is none
+ **************************************************************************************************/
+const chord_shared_store_t *cmd_get_shared_store();
+
+
+/***************************************************************************************************
+ * Function: cmd_get_nodes
+ * 
+ * Get the set of nodes that have been added to the DHT, where each bit corresponds to a node ID.
+ * 
+ * param:  void
+ * return: The node set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t cmd_get_nodes();
+
+
+/***************************************************************************************************
+ * Function: cmd_get_keys
+ * 
+ * Get the set of keys that have been added to the DHT, where each bit corresponds to a key.
+ * 
+ * param:  void
+ * return: The key set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t cmd_get_keys();
+
+
+/***************************************************************************************************
+ * Function: cmd_get_replication
+ * 
+ * Get the replication factor of the DHT: the number of successors holding a copy of each node's
+ * keys, as set by the CHORD_REPLICATION environment variable that the nodes inherit.
+ * 
+ * param:  void
+ * return: The replication factor (zero if keys are not replicated)
+ **************************************************************************************************/
+int cmd_get_replication();
+
+
+/***************************************************************************************************
+ * Function: cmd_get_virtual_nodes
+ * 
+ * Get the number of nodes each node process hosts: its own node and any virtual nodes, as set by 
+ * the CHORD_VNODES environment variable.
+ * 
+ * param:  void
+ * return: The number of nodes per process (one if processes do not host virtual nodes)
+ **************************************************************************************************/
+int cmd_get_virtual_nodes();
+
+
 #endif
 
 //**************************************************************************************************
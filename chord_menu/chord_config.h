@@ -32,12 +32,27 @@
 // Note: Increasing beyond 64 will break compatibility with the chord_key_set data structure
 #define MAX_KEY_VALUE               64
 
+// Maximum replication factor: the number of successors holding a copy of each node's keys (the
+// CHORD_REPLICATION environment variable sets the factor; by default, keys are not replicated)
+#define MAX_REPLICATION             8
+
+// Maximum number of nodes hosted by a single node process: its own node and any virtual nodes (the
+// CHORD_VNODES environment variable sets the number; by default, each process hosts one node)
+#define MAX_VIRTUAL_NODES           8
+
+// Maximum length of a value stored under a key, in bytes
+#define MAX_VALUE_SIZE              1024
+
 // The maximum allowable characters that can be read from the key data file
 #define MAX_FILE_SIZE_CHARS         512
 
 // The key data file path
 static const char file_path[] = ".//key.dat";
 
+// The chord_node program path, relative to the menu working directory (the CHORD_NODE_PROGRAM
+// environment variable takes precedence, if set)
+static const char node_program_path[] = "..//chord_node//dist//Debug//GNU-Linux//chord_node";
+
 
 //**************************************************************************************************
 // Module variables
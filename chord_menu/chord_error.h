@@ -33,6 +33,11 @@ typedef enum
     CHORD_ERR_INVALID_KEY         = 4,      // Invalid key value was entered by user
     CHORD_ERR_KEY_ALREADY_ADDED   = 5,      // The key is already in the DHT
     CHORD_ERR_NO_SUCH_KEY         = 6,      // The key is not found in the DHT
+    CHORD_ERR_INVALID_NODE        = 7,      // Invalid node ID was requested
+    CHORD_ERR_NODE_ALREADY_ADDED  = 8,      // The node ID is already in the DHT
+    CHORD_ERR_TIMEOUT             = 9,      // No reply was received from the DHT in time
+    CHORD_ERR_TRACE_FILE          = 10,     // A workload trace file could not be used
+    CHORD_ERR_VALUE_TOO_LONG      = 11,     // The value is longer than MAX_VALUE_SIZE
 } chord_err_t;
 
 
@@ -0,0 +1,398 @@
+//**************************************************************************************************
+// File:   chord_load.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Tracks the load on each node's arc of the ring, to place new nodes where they take the most
+// load off the ring, and to add nodes automatically when an arc becomes overloaded.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chord_config.h"
+#include "chord_load.h"
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The time after which an unanswered request for the hot keys is given up on, in milliseconds
+#define LOAD_STATS_TIMEOUT_MS           10000
+
+// Local prototypes
+static void load_measure( uint64_t keys, double *loads );
+static int load_split_arc( const double *loads, int from_id, int to_id );
+static double load_now_ms();
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// How the IDs of new nodes are chosen
+static load_placement_t placement_policy = PLACE_BY_KEYS;
+
+// The load above which an arc is split automatically (zero if automatic scaling is off)
+static int autoscale_limit = 0;
+
+// The requests per second for each key, from the last report of the hot keys
+static double key_rates[MAX_KEY_VALUE];
+
+// When the hot keys were last asked for (in milliseconds), and whether the answer is still due
+static double stats_asked_ms = 0.0;
+static bool stats_pending = false;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: load_set_placement
+ * 
+ * Set how the IDs of new nodes are chosen, and so which load is measured.
+ * 
+ * param:  The placement policy
+ * return: void
+ **************************************************************************************************/
+void load_set_placement( load_placement_t placement )
+{
+    placement_policy = placement;
+}
+
+
+/***************************************************************************************************
+ * Function: load_set_autoscale
+ * 
+ * Set the load above which an arc is split by adding a node automatically: a number of keys, or
+ * of requests per second, depending on the placement policy.
+ * 
+ * param:  The load limit (zero to turn automatic scaling off)
+ * return: void
+ **************************************************************************************************/
+void load_set_autoscale( int limit )
+{
+    autoscale_limit = ( limit < 0 ) ? 0 : limit;
+}
+
+
+/***************************************************************************************************
+ * Function: load_stats_due
+ * 
+ * Check whether the hot keys of the ring are to be asked for (with a statistics request tagged
+ * LOAD_STATS_TAG): new nodes are placed by request rates, the last report is over LOAD_WINDOW_MS
+ * old, and no request for one is still unanswered (unless it has been given up on).
+ * 
+ * param:  void
+ * return: True if a statistics request is to be sent (it is then taken as sent)
+ **************************************************************************************************/
+bool load_stats_due()
+{
+    // Local variables
+    double now_ms;                // The current time
+    bool due = false;             // Flag: "the hot keys are to be asked for"
+
+    if( placement_policy == PLACE_BY_REQUESTS )
+    {
+        now_ms = load_now_ms();
+        due = ( now_ms - stats_asked_ms >=
+                ( ( stats_pending == true ) ? LOAD_STATS_TIMEOUT_MS : LOAD_WINDOW_MS ) );
+
+        if( due == true )
+        {
+            stats_asked_ms = now_ms;
+            stats_pending = true;
+        }
+    }
+
+    return( due );
+}
+
+
+/***************************************************************************************************
+ * Function: load_record_stats
+ * 
+ * Take the request rates of keys from the hot keys of the ring, in place of those taken before. 
+ * The count of a key is taken at its guaranteed part (less the error it may be over-estimated 
+ * by), over the longest time any hot node reports counting for; keys that are not hot have no
+ * rate.
+ * 
+ * param:  The statistics of the ring (from an AGGREGATE answer to a statistics request)
+ * return: void
+ **************************************************************************************************/
+void load_record_stats( const chord_store_stats_t *stats )
+{
+    // Local variables
+    uint64_t window_ms = 1;       // The time the requests were counted over
+    const chord_hot_key_t *key;   // A hot key
+
+    for( int index = 0; index < HOT_NODE_COUNT; index++ )
+    {
+        if( stats->hot_nodes[index].window_ms > window_ms )
+        {
+            window_ms = stats->hot_nodes[index].window_ms;
+        }
+    }
+
+    memset( key_rates, 0, sizeof( key_rates ) );
+
+    for( int index = 0; index < HOT_KEY_COUNT; index++ )
+    {
+        key = &stats->hot_keys[index];
+
+        if( ( key->count > key->error ) && ( key->key >= 0 ) && ( key->key < MAX_KEY_VALUE ) )
+        {
+            key_rates[key->key] = ( key->count - key->error ) * 1000.0 / window_ms;
+        }
+    }
+
+    stats_pending = false;
+}
+
+
+/***************************************************************************************************
+ * Function: load_pick_node_id
+ * 
+ * Choose the ID of a new node. The heaviest arc that can be split is split where the load on
+ * either side is closest to even; if no arc can be split so as to lighten it, the widest arc is
+ * split in the middle (or, for random placement, an unassigned ID is picked at random).
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * param:  The keys in the ring, as a bitmap
+ * return: The ID of the new node, or -1 if every ID is assigned
+ **************************************************************************************************/
+int load_pick_node_id( uint64_t nodes, uint64_t keys )
+{
+    // Local variables
+    double loads[MAX_NODE_COUNT];     // The load at each ID
+    double arc_load;                  // The load on the arc ending at a node
+    double heaviest_load = 0.0;       // The load on the heaviest arc that can be split
+    int split_id;                     // Where an arc can be split to lighten it
+    int heaviest_id = -1;             // Where the heaviest arc that can be split is split
+    int widest = 1;                   // The number of IDs in the widest arc
+    int widest_id = -1;               // The middle of the widest arc
+    int previous;                     // The node before the one being looked at
+
+    // The main node is the last node in the ring, so the first arc starts at ID zero
+    nodes |= ( 1UL << MAIN_DHT_NODE );
+    previous = -1;
+
+    if( placement_policy == PLACE_AT_RANDOM )
+    {
+        return( load_random_id( nodes ) );
+    }
+
+    load_measure( keys, loads );
+
+    for( int id = 0; id < MAX_NODE_COUNT; id++ )
+    {
+        if( nodes & ( 1UL << id ) )
+        {
+            arc_load = 0.0;
+
+            for( int arc_id = previous + 1; arc_id <= id; arc_id++ )
+            {
+                arc_load += loads[arc_id];
+            }
+
+            split_id = load_split_arc( loads, previous, id );
+
+            if( ( split_id >= 0 ) && ( arc_load > heaviest_load ) )
+            {
+                heaviest_load = arc_load;
+                heaviest_id = split_id;
+            }
+
+            if( id - previous > widest )
+            {
+                widest = id - previous;
+                widest_id = previous + widest / 2;
+            }
+
+            previous = id;
+        }
+    }
+
+    return( ( heaviest_id >= 0 ) ? heaviest_id : widest_id );
+}
+
+
+/***************************************************************************************************
+ * Function: load_autoscale_due
+ * 
+ * Check whether a node should be added automatically: the load on some arc is above the limit,
+ * and adding a node can lighten it.
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * param:  The keys in the ring, as a bitmap
+ * return: True if a node should be added (see load_pick_node_id for its ID)
+ **************************************************************************************************/
+bool load_autoscale_due( uint64_t nodes, uint64_t keys )
+{
+    // Local variables
+    double loads[MAX_NODE_COUNT];     // The load at each ID
+    double arc_load = 0.0;            // The load on the arc ending at a node
+    bool due = false;                 // Flag: "a node should be added"
+    int previous = -1;                // The node before the one being looked at
+
+    if( ( autoscale_limit == 0 ) || ( placement_policy == PLACE_AT_RANDOM ) )
+    {
+        return( false );
+    }
+
+    nodes |= ( 1UL << MAIN_DHT_NODE );
+    load_measure( keys, loads );
+
+    for( int id = 0; ( id < MAX_NODE_COUNT ) && ( due == false ); id++ )
+    {
+        arc_load += loads[id];
+
+        if( nodes & ( 1UL << id ) )
+        {
+            due = ( arc_load > autoscale_limit ) && ( load_split_arc( loads, previous, id ) >= 0 );
+            arc_load = 0.0;
+            previous = id;
+        }
+    }
+
+    return( due );
+}
+
+
+/***************************************************************************************************
+ * Function: load_measure
+ * 
+ * Measure the load at each ID: whether a key sits there, or the rate of requests for it (from
+ * the last report of the hot keys of the ring).
+ * 
+ * param:  The keys in the ring, as a bitmap
+ * param:  Holds the load at each ID
+ * return: void
+ **************************************************************************************************/
+static void load_measure( uint64_t keys, double *loads )
+{
+    for( int id = 0; id < MAX_NODE_COUNT; id++ )
+    {
+        if( placement_policy == PLACE_BY_REQUESTS )
+        {
+            loads[id] = key_rates[id];
+        }
+        else
+        {
+            loads[id] = ( keys & ( 1UL << id ) ) ? 1.0 : 0.0;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: load_split_arc
+ * 
+ * Find where to split an arc so that the heavier side carries as little load as possible. Of
+ * equally good places, the one nearest the middle of the arc is taken.
+ * 
+ * param:  The load at each ID
+ * param:  The node before the arc (the arc starts just after it)
+ * param:  The node at the end of the arc
+ * return: The ID of the new node, or -1 if no split lightens the arc
+ **************************************************************************************************/
+static int load_split_arc( const double *loads, int from_id, int to_id )
+{
+    // Local variables
+    double total = 0.0;           // The load on the whole arc
+    double before = 0.0;          // The load up to and including the candidate ID
+    double heavier;               // The load on the heavier side of a split
+    double lightest;              // The load on the heavier side of the best split
+    int middle;                   // The middle of the arc
+    int split_id = -1;            // The best place to split the arc
+
+    for( int id = from_id + 1; id <= to_id; id++ )
+    {
+        total += loads[id];
+    }
+
+    lightest = total;
+    middle = from_id + ( to_id - from_id ) / 2;
+
+    for( int id = from_id + 1; id < to_id; id++ )
+    {
+        before += loads[id];
+        heavier = ( before > total - before ) ? before : total - before;
+
+        if( ( heavier < lightest ) ||
+            ( ( split_id >= 0 ) && ( heavier == lightest ) &&
+              ( abs( id - middle ) < abs( split_id - middle ) ) ) )
+        {
+            lightest = heavier;
+            split_id = id;
+        }
+    }
+
+    return( split_id );
+}
+
+
+/***************************************************************************************************
+ * Function: load_random_id
+ * 
+ * Pick an unassigned ID at random. The random number generator is seeded once, so that several
+ * nodes can be added within the same second.
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * return: The ID, or -1 if every ID is assigned
+ **************************************************************************************************/
+int load_random_id( uint64_t nodes )
+{
+    // Local variables
+    static bool seeded = false;   // Flag: "the random number generator has been seeded"
+    int node_id = -1;             // The (randomly-generated) ID
+
+    if( seeded == false )
+    {
+        // Seed random number generator with the current time
+        srand( time( NULL ) );
+        seeded = true;
+    }
+
+    // Keep going until an unused number is obtained
+    while( ( nodes != UINT64_MAX ) && ( ( node_id < 0 ) || ( nodes & ( 1UL << node_id ) ) ) )
+    {
+        node_id = ( rand() % ( MAX_NODE_COUNT - 1 ) );
+    }
+
+    return( node_id );
+}
+
+
+/***************************************************************************************************
+ * Function: load_now_ms
+ * 
+ * Read the monotonic clock.
+ * 
+ * param:  void
+ * return: The current time, in milliseconds
+ **************************************************************************************************/
+static double load_now_ms()
+{
+    // Local variables
+    struct timespec now;          // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6 );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,143 @@
+//**************************************************************************************************
+// File:   chord_load.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Tracks the load on each node's arc of the ring (the IDs from just after its predecessor up to
+// its own), so that new nodes can be placed where they take the most load off the ring, and can
+// be added automatically when an arc becomes overloaded.
+// 
+// The load of an arc is either the number of keys in it, or the rate of requests for those keys.
+// Key counts are kept by the menu process, as every key command passes through it. Request rates
+// are taken from the hot keys the nodes report in answer to a statistics request (see
+// chord_hot_keys.h in chord_node), merged over the ring: the menu process asks for them at most
+// once every LOAD_WINDOW_MS, and keeps the rates of the last report it read.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_LOAD_H
+#define CHORD_LOAD_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The time between requests for the hot keys of the ring, in milliseconds
+#define LOAD_WINDOW_MS                  1000
+
+// The tag of the statistics requests made for the hot keys (other requests have positive tags)
+#define LOAD_STATS_TAG                  -1
+
+// How the IDs of new nodes are chosen
+typedef enum
+{
+    PLACE_BY_KEYS,                   // Split the arc holding the most keys (the default)
+    PLACE_BY_REQUESTS,               // Split the arc receiving the most requests per second
+    PLACE_AT_RANDOM                  // Pick an unassigned ID at random
+} load_placement_t;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: load_set_placement
+ * 
+ * Set how the IDs of new nodes are chosen, and so which load is measured.
+ * 
+ * param:  The placement policy
+ * return: void
+ **************************************************************************************************/
+void load_set_placement( load_placement_t placement );
+
+
+/***************************************************************************************************
+ * Function: load_set_autoscale
+ * 
+ * Set the load above which an arc is split by adding a node automatically: a number of keys, or
+ * of requests per second, depending on the placement policy.
+ * 
+ * param:  The load limit (zero to turn automatic scaling off)
+ * return: void
+ **************************************************************************************************/
+void load_set_autoscale( int limit );
+
+
+/***************************************************************************************************
+ * Function: load_stats_due
+ * 
+ * Check whether the hot keys of the ring are to be asked for (with a statistics request tagged
+ * LOAD_STATS_TAG): new nodes are placed by request rates, the last report is over LOAD_WINDOW_MS
+ * old, and no request for one is still unanswered.
+ * 
+ * param:  void
+ * return: True if a statistics request is to be sent (it is then taken as sent)
+ **************************************************************************************************/
+bool load_stats_due();
+
+
+/***************************************************************************************************
+ * Function: load_record_stats
+ * 
+ * Take the request rates of keys from the hot keys of the ring, in place of those taken before.
+ * 
+ * param:  The statistics of the ring (from an AGGREGATE answer to a statistics request)
+ * return: void
+ **************************************************************************************************/
+void load_record_stats( const chord_store_stats_t *stats );
+
+
+/***************************************************************************************************
+ * Function: load_pick_node_id
+ * 
+ * Choose the ID of a new node. The heaviest arc that can be split is split where the load on
+ * either side is closest to even; if no arc can be split so as to lighten it, the widest arc is
+ * split in the middle (or, for random placement, an unassigned ID is picked at random).
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * param:  The keys in the ring, as a bitmap
+ * return: The ID of the new node, or -1 if every ID is assigned
+ **************************************************************************************************/
+int load_pick_node_id( uint64_t nodes, uint64_t keys );
+
+
+/***************************************************************************************************
+ * Function: load_random_id
+ * 
+ * Pick an unassigned ID at random, whatever the placement policy.
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * return: The ID, or -1 if every ID is assigned
+ **************************************************************************************************/
+int load_random_id( uint64_t nodes );
+
+
+/***************************************************************************************************
+ * Function: load_autoscale_due
+ * 
+ * Check whether a node should be added automatically: the load on some arc is above the limit,
+ * and adding a node can lighten it.
+ * 
+ * param:  The nodes in the ring, as a bitmap
+ * param:  The keys in the ring, as a bitmap
+ * return: True if a node should be added (see load_pick_node_id for its ID)
+ **************************************************************************************************/
+bool load_autoscale_due( uint64_t nodes, uint64_t keys );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
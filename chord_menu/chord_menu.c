@@ -20,9 +20,12 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include "chord_bench.h"
 #include "chord_config.h"
 #include "chord_commands.h"
 #include "chord_menu.h"
+#include "chord_trace.h"
 
 
 //**************************************************************************************************
@@ -32,17 +35,47 @@
 // Maximum number of characters able to be read from a single command
 #define MAX_KEYBOARD_INPUT_CHARS                16
 
+// Time to wait for the answer to a lookup, in milliseconds (or a "put" or "get")
+static const int lookup_timeout_ms = 1000;
+
+// Time to wait for new nodes to join the ring, in milliseconds
+static const int addnode_timeout_ms = 3000;
+
+// Time to wait for a node to leave the ring, in milliseconds
+static const int delnode_timeout_ms = 3000;
+
+// Time to wait for the supervisor to repair the ring after a crash, in milliseconds
+static const int repair_timeout_ms = 3000;
+
+// Time to wait for the nodes to answer a dump or statistics request, in milliseconds (longer than
+// the nodes themselves wait for each other; see chord_broadcast.h in the node program)
+static const int stats_timeout_ms = 3000;
+
 // String menu
 static const char menu[] =
     "Welcome to JW's Chord DHT simulation.\n"
     "Please enter one of the following commands:\n"
-    "  \"addnode\" - Add a new node to the DHT\n"
-    "  \"dump\"    - Display the content topology of the DHT\n"
-    "  \"addkey\"  - Add a key to the DHT\n"
-    "  \"delkey\"  - Delete a key from the DHT\n"
-    "  \"menu\"    - Redisplay this menu on the terminal\n"
-    "  \"debug\"   - Toggle debug messages (developer only)\n"
-    "  \"exit\"    - Exit the program\n";
+    "  \"addnode\"    - Add a new node to the DHT (\"addnode N\" adds N nodes at once)\n"
+    "  \"delnode\"    - Remove a node from the DHT, handing its keys to its successor\n"
+    "  \"dump\"       - Display the content topology of the DHT\n"
+    "  \"addkey\"     - Add a key to the DHT\n"
+    "  \"delkey\"     - Delete a key from the DHT\n"
+    "  \"lookup\"     - Look up a key in the DHT\n"
+    "  \"put\"        - Store a value under a key in the DHT (adding the key if needed)\n"
+    "  \"get\"        - Fetch the value stored under a key in the DHT\n"
+    "  \"mget\"       - Fetch the values stored under several keys in the DHT at once\n"
+    "  \"scan\"       - Fetch the keys in a range of the DHT, in order, with their values\n"
+    "  \"count\"      - Count the keys in a range of the DHT\n"
+    "  \"delrange\"   - Delete the keys in a range from the DHT\n"
+    "  \"benchjoin\"  - Benchmark ring convergence after a burst of node joins\n"
+    "  \"benchchurn\" - Benchmark steady key traffic while nodes join\n"
+    "  \"load\"       - Display how evenly keys are spread over the node processes\n"
+    "  \"stats\"      - Display the number of nodes, keys and messages sent, and value storage\n"
+    "  \"hot\"        - Display the keys and nodes taking the most requests lately\n"
+    "  \"menu\"       - Redisplay this menu on the terminal\n"
+    "  \"debug\"      - Toggle debug messages (developer only)\n"
+    "  \"crash\"      - Crash a node to test ring repair (developer only)\n"
+    "  \"exit\"       - Exit the program\n";
 
 // Prompts for additional input
 static const char prompt_addkey[] = 
@@ -51,6 +84,48 @@ static const char prompt_addkey[] =
 static const char prompt_delkey[] =
     "Enter a key value to delete from the DHT (must be between 0-63, inclusive).\n";
 
+static const char prompt_lookup[] =
+    "Enter a key value to look up in the DHT (must be between 0-63, inclusive).\n";
+
+static const char prompt_put[] =
+    "Enter a key value to store a value under (must be between 0-63, inclusive).\n";
+
+static const char prompt_put_value[] =
+    "Enter the value to store (a line of text, at most 1024 characters).\n";
+
+static const char prompt_get[] =
+    "Enter a key value to fetch the value of (must be between 0-63, inclusive).\n";
+
+static const char prompt_mget[] =
+    "Enter the keys to fetch, separated by spaces (each between 0-63, inclusive).\n";
+
+static const char prompt_range_first[] =
+    "Enter the first key of the range (must be between 0-63, inclusive).\n";
+
+static const char prompt_range_last[] =
+    "Enter the last key of the range (must be between the first key and 63, inclusive).\n";
+
+static const char prompt_benchjoin[] =
+    "Enter the number of nodes to join (must be between 1-63, inclusive).\n";
+
+static const char prompt_churn_duration[] =
+    "Enter the duration of the workload in seconds (must be between 1-60, inclusive).\n";
+
+static const char prompt_churn_rate[] =
+    "Enter the operation rate in ops/s (must be between 1-100000, inclusive).\n";
+
+static const char prompt_churn_joins[] =
+    "Enter the interval between node joins in ms (0 for no joins, at most 60000).\n";
+
+static const char prompt_addnodes[] =
+    "The number of nodes to add must be between 1-63, inclusive.\n";
+
+static const char prompt_delnode[] =
+    "Enter the ID of the node to remove (must be between 0-62, inclusive).\n";
+
+static const char prompt_crash[] =
+    "Enter the ID of the node to crash (must be between 0-62, inclusive).\n";
+
 // Error strings
 static const char input_error[] =
     "Invalid input. You must enter a value between 0-63, inclusive.\n";
@@ -60,17 +135,45 @@ static const char unrecognized_cmd[] =
 
 // Accepted commands
 static const char menu_add_node[] = "addnode\n";
+static const char menu_add_nodes[] = "addnode ";
+static const char menu_del_node[] = "delnode\n";
 static const char menu_dump[] = "dump\n";
 static const char menu_add_key[] = "addkey\n";
 static const char menu_del_key[] = "delkey\n";
+static const char menu_lookup[] = "lookup\n";
+static const char menu_put[] = "put\n";
+static const char menu_get[] = "get\n";
+static const char menu_mget[] = "mget\n";
+static const char menu_scan[] = "scan\n";
+static const char menu_count[] = "count\n";
+static const char menu_del_range[] = "delrange\n";
+static const char menu_bench_join[] = "benchjoin\n";
+static const char menu_bench_churn[] = "benchchurn\n";
+static const char menu_load[] = "load\n";
+static const char menu_stats[] = "stats\n";
+static const char menu_hot[] = "hot\n";
 static const char menu_show_menu[] = "menu\n";
 static const char menu_debug[] = "debug\n";
+static const char menu_crash[] = "crash\n";
 static const char menu_exit[] = "exit\n";
 
 // Local prototypes
-static void menu_process_addnode_cmd();
+static void menu_process_addnode_cmd( int node_count );
+static void menu_process_delnode_cmd();
 static void menu_process_addkey_cmd();
 static void menu_process_delkey_cmd();
+static void menu_process_lookup_cmd();
+static void menu_process_put_cmd();
+static void menu_process_get_cmd();
+static void menu_process_mget_cmd();
+static void menu_process_range_cmd( chord_cmd_t cmd );
+static void menu_print_values( const chord_msg_t *reply );
+static void menu_process_benchjoin_cmd();
+static void menu_process_benchchurn_cmd();
+static void menu_process_crash_cmd();
+static void menu_process_stats_cmd( bool dump );
+static void menu_process_hot_cmd();
+static bool menu_read_value( const char *prompt, int min_value, int max_value, int *value );
 
 
 //**************************************************************************************************
@@ -80,6 +183,22 @@ static void menu_process_delkey_cmd();
 // Holds user input
 static char user_input[MAX_KEYBOARD_INPUT_CHARS];
 
+// Holds a value entered by the user (with room for the newline, and one character too many)
+static char value_input[MAX_VALUE_SIZE + 3];
+
+// Tag of the most recent lookup (or "put" or "get"), so that its answer can be told apart from
+// any others
+static int lookup_tag = 0;
+
+// Tag of the most recent node addition, so that the answers to it can be told apart from others
+static int addnode_tag = 0;
+
+// Tag of the most recent node removal, so that its answer can be told apart from any others
+static int delnode_tag = 0;
+
+// Tag of the most recent dump or statistics request, so that its answer can be told apart
+static int stats_tag = 0;
+
 
 //**************************************************************************************************
 // Module functions
@@ -110,11 +229,19 @@ void menu_execute()
             // Process command or output error
             if( strcmp( user_input, menu_add_node ) == 0 )
             {
-                menu_process_addnode_cmd();
+                menu_process_addnode_cmd( 1 );
+            }
+            else if( strncmp( user_input, menu_add_nodes, strlen( menu_add_nodes ) ) == 0 )
+            {
+                menu_process_addnode_cmd( atoi( user_input + strlen( menu_add_nodes ) ) );
+            }
+            else if( strcmp( user_input, menu_del_node ) == 0 )
+            {
+                menu_process_delnode_cmd();
             }
             else if( strcmp( user_input, menu_dump ) == 0 )
             {
-                cmd_dump();
+                menu_process_stats_cmd( true );
             }
             else if( strcmp( user_input, menu_add_key ) == 0 )
             {
@@ -124,6 +251,54 @@ void menu_execute()
             {
                 menu_process_delkey_cmd();
             }
+            else if( strcmp( user_input, menu_lookup ) == 0 )
+            {
+                menu_process_lookup_cmd();
+            }
+            else if( strcmp( user_input, menu_put ) == 0 )
+            {
+                menu_process_put_cmd();
+            }
+            else if( strcmp( user_input, menu_get ) == 0 )
+            {
+                menu_process_get_cmd();
+            }
+            else if( strcmp( user_input, menu_mget ) == 0 )
+            {
+                menu_process_mget_cmd();
+            }
+            else if( strcmp( user_input, menu_scan ) == 0 )
+            {
+                menu_process_range_cmd( SCAN );
+            }
+            else if( strcmp( user_input, menu_count ) == 0 )
+            {
+                menu_process_range_cmd( COUNT );
+            }
+            else if( strcmp( user_input, menu_del_range ) == 0 )
+            {
+                menu_process_range_cmd( DELETE_RANGE );
+            }
+            else if( strcmp( user_input, menu_bench_join ) == 0 )
+            {
+                menu_process_benchjoin_cmd();
+            }
+            else if( strcmp( user_input, menu_bench_churn ) == 0 )
+            {
+                menu_process_benchchurn_cmd();
+            }
+            else if( strcmp( user_input, menu_load ) == 0 )
+            {
+                bench_load_balance();
+            }
+            else if( strcmp( user_input, menu_stats ) == 0 )
+            {
+                menu_process_stats_cmd( false );
+            }
+            else if( strcmp( user_input, menu_hot ) == 0 )
+            {
+                menu_process_hot_cmd();
+            }
             else if( strcmp( user_input, menu_show_menu ) == 0 )
             {
                 // Redisplay the menu for the user
@@ -133,8 +308,15 @@ void menu_execute()
             {
                 cmd_toggle_debug();
             }
+            else if( strcmp( user_input, menu_crash ) == 0 )
+            {
+                menu_process_crash_cmd();
+            }
             else if( strcmp( user_input, menu_exit ) == 0 )
             {
+                // Flush any workload trace being captured
+                trace_stop_recording();
+                
                 // Kill all processes in this group
                 kill( 0, SIGKILL );
                 
@@ -154,26 +336,146 @@ void menu_execute()
 /***************************************************************************************************
  * Function: menu_process_addnode_cmd
  * 
- * Helper function that processes the "addnode" cmd from the user.
+ * Helper function that processes the "addnode" cmd from the user. Every join is sent at once, 
+ * without waiting for the ones before it; each new node (and each virtual node it hosts) answers
+ * once it has taken over its keys. The time taken to add the nodes is displayed.
  * 
- * param:  void
+ * param:  The number of nodes to add
  * return: void
  **************************************************************************************************/
-static void menu_process_addnode_cmd()
+static void menu_process_addnode_cmd( int node_count )
 {
     // Local variables
-    chord_err_t err;            // An error code that may be returned by the command
+    chord_err_t err;             // An error code that may be returned by the command
+    chord_msg_t reply;           // An answer from a new node
+    struct timespec start;       // The time at which the first join was sent
+    struct timespec now;         // The time at which a join was answered
+    double join_ms;              // The time taken by a join
+    double slowest_ms = 0.0;     // The time taken by the slowest join
+    double total_ms = 0.0;       // The time taken by all joins, added up
+    int first_tag;               // The tag of the first join
+    int sent = 0;                // The number of nodes added
+    int node_ids;                // The number of node IDs added, including virtual nodes
+    int joined = 0;              // The number of joins answered
+    uint64_t old_nodes;          // The nodes in the DHT before any were added
     
-    // Attempt to add a new node
-    err = cmd_add_node();
+    // Initialization
+    err = CHORD_ERR_NONE;
+    first_tag = addnode_tag + 1;
+    old_nodes = cmd_get_nodes();
     
-    if( err == CHORD_ERR_MAX_NODES )
+    if( ( node_count < 1 ) || ( node_count > MAIN_DHT_NODE ) )
     {
-        fputs( "Unable to add node: the DHT has reached the maximum number of nodes\n", stdout );
+        fputs( prompt_addnodes, stdout );
     }
     else
     {
-        fputs( "New node added!\n", stdout );
+        clock_gettime( CLOCK_MONOTONIC, &start );
+        
+        // Attempt to add the new nodes, one tag per node
+        while( ( sent < node_count ) && ( err == CHORD_ERR_NONE ) )
+        {
+            err = cmd_add_node( addnode_tag + 1 );
+            
+            if( err == CHORD_ERR_NONE )
+            {
+                addnode_tag++;
+                sent++;
+            }
+        }
+        
+        // Wait for the answers carrying the tags
+        node_ids = __builtin_popcountll( cmd_get_nodes() & ~old_nodes );
+        
+        while( ( joined < node_ids ) && ( cmd_read_report( &reply, addnode_timeout_ms ) == 
+                                      CHORD_ERR_NONE ) )
+        {
+            if( ( reply.cmd == ADD_NODE ) && ( reply.tag >= first_tag ) && 
+                ( reply.tag <= addnode_tag ) )
+            {
+                clock_gettime( CLOCK_MONOTONIC, &now );
+                join_ms = ( now.tv_sec - start.tv_sec ) * 1000.0 + 
+                          ( now.tv_nsec - start.tv_nsec ) / 1.0e6;
+                slowest_ms = ( join_ms > slowest_ms ) ? join_ms : slowest_ms;
+                total_ms += join_ms;
+                joined++;
+            }
+        }
+        
+        if( err == CHORD_ERR_MAX_NODES )
+        {
+            printf( "Unable to add %s: the DHT has reached the maximum number of nodes\n",
+                    ( sent == 0 ) ? "node" : "all nodes" );
+        }
+        
+        if( joined < node_ids )
+        {
+            printf( "%i of %i new nodes did not report joining in time\n", node_ids - joined,
+                    node_ids );
+        }
+        else if( ( node_count == 1 ) && ( node_ids == 1 ) )
+        {
+            printf( "New node added! (joined in %.3f ms)\n", slowest_ms );
+        }
+        else if( node_ids > sent )
+        {
+            printf( "Added %i nodes hosting %i node IDs in %.3f ms (mean join latency %.3f ms)\n",
+                    sent, node_ids, slowest_ms, total_ms / node_ids );
+        }
+        else if( sent > 0 )
+        {
+            printf( "Added %i nodes in %.3f ms (mean join latency %.3f ms)\n", sent, slowest_ms,
+                    total_ms / sent );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_delnode_cmd
+ * 
+ * Helper function that processes the "delnode" cmd from the user, waiting for the node to leave.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_delnode_cmd()
+{
+    // Local variables
+    int parsed_id = 0;           // Holds a parsed ID from the user (if applicable)
+    chord_msg_t reply;           // The answer from the departing node
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( menu_read_value( prompt_delnode, 0, MAIN_DHT_NODE - 1, &parsed_id ) == true )
+    {
+        delnode_tag++;
+        err = cmd_remove_node( parsed_id, delnode_tag );
+        
+        // Wait for the answer carrying the tag, sent once the node has left the ring
+        if( err == CHORD_ERR_NONE )
+        {
+            do
+            {
+                err = cmd_read_report( &reply, delnode_timeout_ms );
+            }
+            while( ( err == CHORD_ERR_NONE ) && 
+                   ( ( reply.cmd != LEAVE ) || ( reply.tag != delnode_tag ) ) );
+        }
+        
+        if( err == CHORD_ERR_INVALID_NODE )
+        {
+            printf( "Unable to remove node: there is no node %i (or it is the main node)\n", 
+                    parsed_id );
+        }
+        else if( err != CHORD_ERR_NONE )
+        {
+            printf( "Node %i did not report leaving in time\n", parsed_id );
+        }
+        else
+        {
+            printf( "Node %i left the DHT, handing %i keys to its successor\n", parsed_id,
+                    __builtin_popcountll( reply.data ) );
+        }
     }
 }
 
@@ -210,7 +512,7 @@ static void menu_process_addkey_cmd()
         else
         {
             // ID is good - attempt to add the key
-            err = cmd_add_key( parsed_id );
+            err = cmd_add_key( parsed_id, 0 );
             
             if( err == CHORD_ERR_KEY_ALREADY_ADDED )
             {
@@ -261,7 +563,7 @@ static void menu_process_delkey_cmd()
         else
         {
             // ID is good - attempt to delete the key
-            err = cmd_delete_key( parsed_id );
+            err = cmd_delete_key( parsed_id, 0 );
             
             if( err == CHORD_ERR_NO_SUCH_KEY )
             {
@@ -280,6 +582,809 @@ static void menu_process_delkey_cmd()
 }
 
 
+/***************************************************************************************************
+ * Function: menu_process_lookup_cmd
+ * 
+ * Helper function that processes the "lookup" cmd from the user.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_lookup_cmd()
+{
+    // Local variables
+    int parsed_id = 0;           // Holds a parsed ID from the user (if applicable)
+    chord_msg_t reply;           // The answer from the owner of the key
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( menu_read_value( prompt_lookup, 0, MAX_KEY_VALUE - 1, &parsed_id ) == true )
+    {
+        // Send the lookup, then wait for the answer carrying its tag
+        lookup_tag++;
+        cmd_lookup_key( parsed_id, lookup_tag );
+        
+        do
+        {
+            err = cmd_read_report( &reply, lookup_timeout_ms );
+        }
+        while( ( err == CHORD_ERR_NONE ) && 
+               ( ( reply.cmd != LOOKUP ) || ( reply.tag != lookup_tag ) ) );
+        
+        if( err != CHORD_ERR_NONE )
+        {
+            printf( "Unable to look up key: <%i> was not answered in time\n", parsed_id );
+        }
+        else if( reply.hops == SUMMARY_ANSWER_HOPS )
+        {
+            printf( "Key <%i> is not in the DHT\n", parsed_id );
+        }
+        else if( reply.data != 0 )
+        {
+            printf( "Key <%i> is in the DHT (owned by node %i)\n", parsed_id, reply.sender );
+        }
+        else
+        {
+            printf( "Key <%i> is not in the DHT (would be owned by node %i)\n", parsed_id, 
+                    reply.sender );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_put_cmd
+ * 
+ * Helper function that processes the "put" cmd from the user: a key, then the value to store 
+ * under it (the rest of the next line).
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_put_cmd()
+{
+    // Local variables
+    int parsed_id = 0;           // Holds a parsed ID from the user (if applicable)
+    int length;                  // The length of the value
+    const char *line_end;        // The end of the line the value was entered on (if read)
+    chord_msg_t reply = { 0 };   // The acknowledgement from the owner of the key
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( ( menu_read_value( prompt_put, 0, MAX_KEY_VALUE - 1, &parsed_id ) == true ) &&
+        ( fputs( prompt_put_value, stdout ) >= 0 ) &&
+        ( fgets( value_input, sizeof( value_input ), stdin ) != NULL ) )
+    {
+        length = strcspn( value_input, "\n" );
+        line_end = strchr( value_input, '\n' );
+        
+        // Drop the rest of a line that is too long
+        while( ( line_end == NULL ) && 
+               ( fgets( user_input, MAX_KEYBOARD_INPUT_CHARS, stdin ) != NULL ) )
+        {
+            line_end = strchr( user_input, '\n' );
+        }
+        
+        // Send the value, then wait for the acknowledgement carrying its tag
+        lookup_tag++;
+        err = cmd_put_key( parsed_id, value_input, length, lookup_tag );
+        
+        while( ( err == CHORD_ERR_NONE ) && 
+               ( ( reply.cmd != PUT ) || ( reply.tag != lookup_tag ) ) )
+        {
+            err = cmd_read_report( &reply, lookup_timeout_ms );
+        }
+        
+        if( err == CHORD_ERR_VALUE_TOO_LONG )
+        {
+            printf( "Unable to store value: it is longer than %i characters\n", MAX_VALUE_SIZE );
+        }
+        else if( err != CHORD_ERR_NONE )
+        {
+            printf( "Unable to store value: <%i> was not answered in time\n", parsed_id );
+        }
+        else
+        {
+            printf( "Value of %i bytes stored under key <%i> (by node %i)\n", length, parsed_id,
+                    reply.sender );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_get_cmd
+ * 
+ * Helper function that processes the "get" cmd from the user.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_get_cmd()
+{
+    // Local variables
+    int parsed_id = 0;           // Holds a parsed ID from the user (if applicable)
+    chord_msg_t reply;           // The answer from the owner of the key
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( menu_read_value( prompt_get, 0, MAX_KEY_VALUE - 1, &parsed_id ) == true )
+    {
+        // Send the request, then wait for the answer carrying its tag
+        lookup_tag++;
+        cmd_get_key( parsed_id, lookup_tag );
+        
+        do
+        {
+            err = cmd_read_report( &reply, lookup_timeout_ms );
+        }
+        while( ( err == CHORD_ERR_NONE ) && 
+               ( ( reply.cmd != GET ) || ( reply.tag != lookup_tag ) ) );
+        
+        if( err != CHORD_ERR_NONE )
+        {
+            printf( "Unable to get value: <%i> was not answered in time\n", parsed_id );
+        }
+        else if( reply.hops == SUMMARY_ANSWER_HOPS )
+        {
+            printf( "Key <%i> is not in the DHT\n", parsed_id );
+        }
+        else if( reply.data == 0 )
+        {
+            printf( "Key <%i> is not in the DHT (would be owned by node %i)\n", parsed_id, 
+                    reply.sender );
+        }
+        else if( reply.length == 0 )
+        {
+            printf( "Key <%i> is in the DHT (owned by node %i), with no value\n", parsed_id, 
+                    reply.sender );
+        }
+        else
+        {
+            printf( "Key <%i> (owned by node %i): %.*s\n", parsed_id, reply.sender, reply.length,
+                    cmd_get_report_value() );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_mget_cmd
+ * 
+ * Helper function that processes the "mget" cmd from the user: a line of keys, whose values are
+ * fetched with a single request and displayed as the answers of their owners arrive. The time 
+ * taken for every key to be answered is displayed.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_mget_cmd()
+{
+    // Local variables
+    uint64_t keys = 0;           // The keys entered by the user
+    uint64_t pending;            // The keys not yet answered for
+    uint64_t owners = 0;         // The nodes that answered
+    const char *next;            // The rest of the line of keys
+    char *end;                   // The end of a key on the line
+    long key;                    // A key parsed from the line
+    bool valid = true;           // Flag: "every key entered is valid"
+    chord_msg_t reply;           // An answer from the owner of some of the keys
+    chord_err_t err;             // An error code that may be returned by the command
+    struct timespec start;       // When the request was sent
+    struct timespec now;         // When the last answer was read
+    
+    fputs( prompt_mget, stdout );
+    
+    if( fgets( value_input, sizeof( value_input ), stdin ) != NULL )
+    {
+        // Parse the keys, separated by spaces
+        next = value_input;
+        key = strtol( next, &end, 10 );
+        
+        while( end != next )
+        {
+            valid = valid && ( key >= 0 ) && ( key < MAX_KEY_VALUE );
+            keys |= valid ? ( 1UL << key ) : 0;
+            next = end;
+            key = strtol( next, &end, 10 );
+        }
+        
+        if( ( valid == false ) || ( keys == 0 ) )
+        {
+            fputs( input_error, stdout );
+        }
+        else
+        {
+            // Send the request, then collect the answers carrying its tag
+            clock_gettime( CLOCK_MONOTONIC, &start );
+            lookup_tag++;
+            err = cmd_multi_get( keys, lookup_tag );
+            pending = keys;
+            
+            while( ( err == CHORD_ERR_NONE ) && ( pending != 0 ) )
+            {
+                err = cmd_read_report( &reply, lookup_timeout_ms );
+                
+                if( ( err == CHORD_ERR_NONE ) && ( reply.cmd == MGET ) && 
+                    ( reply.tag == lookup_tag ) )
+                {
+                    pending &= ~reply.data;
+                    owners |= ( 1UL << reply.sender );
+                    menu_print_values( &reply );
+                }
+            }
+            
+            clock_gettime( CLOCK_MONOTONIC, &now );
+            
+            if( err != CHORD_ERR_NONE )
+            {
+                printf( "Unable to get values: %i of %i keys were not answered in time\n",
+                        __builtin_popcountll( pending ), __builtin_popcountll( keys ) );
+            }
+            else
+            {
+                printf( "Fetched %i keys from %i nodes in %.3f ms\n", 
+                        __builtin_popcountll( keys ), __builtin_popcountll( owners ),
+                        ( now.tv_sec - start.tv_sec ) * 1000.0 + 
+                        ( now.tv_nsec - start.tv_nsec ) / 1.0e6 );
+            }
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_range_cmd
+ * 
+ * Helper function that processes the "scan", "count" and "delrange" cmds from the user: a first
+ * and last key, then the answers of the nodes holding the range, collected until every part of the
+ * range is in. The keys (and values) found by a scan are displayed in order as they arrive.
+ * 
+ * param:  The range command (SCAN, COUNT or DELETE_RANGE)
+ * return: void
+ **************************************************************************************************/
+static void menu_process_range_cmd( chord_cmd_t cmd )
+{
+    // Local variables
+    int first_key = 0;           // The first key of the range
+    int last_key = 0;            // The last key of the range
+    uint64_t pending = 0;        // The keys of the range not yet answered for
+    int key_count = 0;           // The number of keys found (or deleted)
+    int answers = 0;             // The number of answers received
+    chord_msg_t reply;           // An answer from a node holding part of the range
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( ( menu_read_value( prompt_range_first, 0, MAX_KEY_VALUE - 1, &first_key ) == true ) &&
+        ( menu_read_value( prompt_range_last, first_key, MAX_KEY_VALUE - 1, &last_key ) == true ) )
+    {
+        // Send the command, then collect the answers carrying its tag
+        lookup_tag++;
+        
+        if( cmd == SCAN )
+        {
+            err = cmd_scan_range( first_key, last_key, lookup_tag );
+        }
+        else if( cmd == COUNT )
+        {
+            err = cmd_count_range( first_key, last_key, lookup_tag );
+        }
+        else
+        {
+            err = cmd_delete_range( first_key, last_key, lookup_tag );
+        }
+        
+        for( int key = first_key; key <= last_key; key++ )
+        {
+            pending |= ( 1UL << key );
+        }
+        
+        while( ( err == CHORD_ERR_NONE ) && ( pending != 0 ) )
+        {
+            err = cmd_read_report( &reply, lookup_timeout_ms );
+            
+            if( ( err == CHORD_ERR_NONE ) && ( reply.cmd == cmd ) && ( reply.tag == lookup_tag ) )
+            {
+                for( int key = reply.id; ( key <= reply.hops ) && ( key < MAX_KEY_VALUE ); key++ )
+                {
+                    pending &= ~( 1UL << key );
+                }
+                
+                key_count += ( cmd == COUNT ) ? (int)reply.data : 
+                                                __builtin_popcountll( reply.data );
+                answers++;
+                
+                if( cmd == SCAN )
+                {
+                    menu_print_values( &reply );
+                }
+            }
+        }
+        
+        if( err != CHORD_ERR_NONE )
+        {
+            printf( "Unable to complete the command: keys <%i>-<%i> were not all answered in "
+                    "time\n", first_key, last_key );
+        }
+        else if( cmd == SCAN )
+        {
+            printf( "%i keys in <%i>-<%i> (in %i answers)\n", key_count, first_key, last_key,
+                    answers );
+        }
+        else if( cmd == COUNT )
+        {
+            printf( "%i keys in <%i>-<%i> (counted by %i nodes)\n", key_count, first_key, 
+                    last_key, answers );
+        }
+        else
+        {
+            printf( "%i keys deleted from <%i>-<%i> (by %i nodes)\n", key_count, first_key, 
+                    last_key, answers );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_print_values
+ * 
+ * Helper function that displays the keys of an answer to a scan or multi-get, with the values 
+ * that follow it.
+ * 
+ * param:  The answer (its values are those of the last report read)
+ * return: void
+ **************************************************************************************************/
+static void menu_print_values( const chord_msg_t *reply )
+{
+    // Local variables
+    const char *values = cmd_get_report_value();  // The values that follow the answer
+    int offset = 0;                               // The offset of the next value
+    uint16_t length;                              // The length of a value (or VALUE_ABSENT_LENGTH)
+    int bytes;                                    // The bytes of the value that follow its length
+    
+    for( int key = 0; key < MAX_KEY_VALUE; key++ )
+    {
+        if( ( reply->data & ( 1UL << key ) ) != 0 )
+        {
+            length = 0;
+            bytes = 0;
+            
+            if( offset + (int)sizeof( length ) <= reply->length )
+            {
+                memcpy( &length, values + offset, sizeof( length ) );
+                offset += sizeof( length );
+                bytes = ( length == VALUE_ABSENT_LENGTH ) ? 0 : length;
+                bytes = ( offset + bytes > reply->length ) ? 0 : bytes;
+            }
+            
+            if( ( length == VALUE_ABSENT_LENGTH ) && ( reply->hops == SUMMARY_ANSWER_HOPS ) )
+            {
+                printf( "Key <%i> is not in the DHT\n", key );
+            }
+            else if( length == VALUE_ABSENT_LENGTH )
+            {
+                printf( "Key <%i> is not in the DHT (would be owned by node %i)\n", key, 
+                        reply->sender );
+            }
+            else if( bytes == 0 )
+            {
+                printf( "Key <%i> (owned by node %i), with no value\n", key, reply->sender );
+            }
+            else
+            {
+                printf( "Key <%i> (owned by node %i): %.*s\n", key, reply->sender, bytes,
+                        values + offset );
+            }
+            
+            offset += bytes;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_benchjoin_cmd
+ * 
+ * Helper function that processes the "benchjoin" cmd from the user.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_benchjoin_cmd()
+{
+    // Local variables
+    int join_count = 0;          // Holds the number of nodes to join
+    
+    if( menu_read_value( prompt_benchjoin, 1, MAX_NODE_COUNT - 1, &join_count ) == true )
+    {
+        bench_join_storm( join_count );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_benchchurn_cmd
+ * 
+ * Helper function that processes the "benchchurn" cmd from the user.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_benchchurn_cmd()
+{
+    // Local variables
+    int duration_s = 0;          // Holds the duration of the workload
+    int op_rate = 0;             // Holds the operation rate
+    int join_interval_ms = 0;    // Holds the interval between node joins
+    
+    if( ( menu_read_value( prompt_churn_duration, 1, 60, &duration_s ) == true ) &&
+        ( menu_read_value( prompt_churn_rate, 1, 100000, &op_rate ) == true ) &&
+        ( menu_read_value( prompt_churn_joins, 0, 60000, &join_interval_ms ) == true ) )
+    {
+        bench_churn( duration_s, op_rate, join_interval_ms );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_crash_cmd
+ * 
+ * Helper function that processes the "crash" cmd from the user, waiting for the supervisor to
+ * report that the ring has been repaired.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_crash_cmd()
+{
+    // Local variables
+    int parsed_id = 0;           // Holds a parsed ID from the user (if applicable)
+    chord_msg_t notice;          // The supervisor's notice of the repair
+    chord_err_t err;             // An error code that may be returned by the command
+    
+    if( menu_read_value( prompt_crash, 0, MAIN_DHT_NODE - 1, &parsed_id ) == true )
+    {
+        err = cmd_crash_node( parsed_id );
+        
+        // The supervisor prints the details of the repair; wait for it to finish
+        if( err == CHORD_ERR_NONE )
+        {
+            do
+            {
+                err = cmd_read_report( &notice, repair_timeout_ms );
+            }
+            while( ( err == CHORD_ERR_NONE ) && 
+                   ( ( notice.cmd != REPAIR ) || ( notice.id != parsed_id ) ) );
+        }
+        
+        if( err == CHORD_ERR_INVALID_NODE )
+        {
+            printf( "Unable to crash node: there is no node %i (or it is the main node, or hosted "
+                    "by its process)\n", parsed_id );
+        }
+        else if( err != CHORD_ERR_NONE )
+        {
+            printf( "Node %i was not reported repaired in time\n", parsed_id );
+        }
+        else
+        {
+            printf( "Node %i crashed; its keys are now owned by node %i\n", parsed_id, 
+                    notice.sender );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_stats_cmd
+ * 
+ * Helper function that processes the "dump" and "stats" cmds from the user. The request is spread
+ * over the ring along the nodes' fingers, and the nodes answer together; the number of nodes 
+ * reached, the keys they hold, the messages they have sent, how much their value stores have 
+ * written and read, and how fast values have been moved between them in bulk are displayed (after
+ * the dump, if one was asked for). With a shared store, the dump is read from the key sets the
+ * nodes publish there rather than asked of the nodes, and the values are counted there.
+ * 
+ * param:  Flag: "have each node dump its ID and key set first"
+ * return: void
+ **************************************************************************************************/
+static void menu_process_stats_cmd( bool dump )
+{
+    // Local variables
+    chord_msg_t reply;           // The combined answer of the nodes
+    chord_err_t err;             // An error code that may be returned by the command
+    int key_count;               // The number of keys in the DHT
+    chord_store_stats_t stats;   // The store counters of the nodes
+    const chord_shared_store_t *shared;     // The shared store (if any)
+    uint64_t nodes;              // The nodes in the shared store, as a bitmap
+    uint64_t keys;               // The key set of a node in the shared store
+    char where[64];              // Where the values are kept
+    
+    shared = cmd_get_shared_store();
+    
+    // Send the request, then wait for the answer carrying its tag
+    stats_tag++;
+    
+    if( ( dump == true ) && ( shared != NULL ) )
+    {
+        nodes = __atomic_load_n( &shared->nodes, __ATOMIC_ACQUIRE );
+        
+        for( int id = 0; id < MAX_NODE_COUNT; id++ )
+        {
+            keys = __atomic_load_n( &shared->key_sets[id], __ATOMIC_ACQUIRE );
+            
+            if( nodes & ( 1UL << id ) )
+            {
+                printf( "Node %i owns keys: ", id );
+                
+                for( int key = 0; key < MAX_KEY_VALUE; key++ )
+                {
+                    if( keys & ( 1UL << key ) )
+                    {
+                        printf( "%i ", key );
+                    }
+                }
+                
+                printf( "\n" );
+            }
+        }
+        
+        cmd_request_stats( stats_tag );
+    }
+    else if( dump == true )
+    {
+        cmd_dump( stats_tag );
+    }
+    else
+    {
+        cmd_request_stats( stats_tag );
+    }
+    
+    do
+    {
+        err = cmd_read_report( &reply, stats_timeout_ms );
+    }
+    while( ( err == CHORD_ERR_NONE ) && 
+           ( ( reply.cmd != AGGREGATE ) || ( reply.tag != stats_tag ) ) );
+    
+    if( err != CHORD_ERR_NONE )
+    {
+        printf( "Unable to gather statistics: the ring did not answer in time\n" );
+    }
+    else
+    {
+        key_count = __builtin_popcountll( reply.data );
+        printf( "%i node%s, %i key%s", reply.id, ( reply.id == 1 ) ? "" : "s", key_count,
+                ( key_count == 1 ) ? "" : "s" );
+        
+        if( key_count > 0 )
+        {
+            printf( " (lowest %i, highest %i)", __builtin_ctzll( reply.data ), 
+                    ( MAX_KEY_VALUE - 1 ) - __builtin_clzll( reply.data ) );
+        }
+        
+        printf( ", %i messages sent\n", reply.hops );
+        
+        // Amplification is the bytes that went to or from segments per byte requested
+        if( reply.length == sizeof( stats ) )
+        {
+            memcpy( &stats, cmd_get_report_value(), sizeof( stats ) );
+            snprintf( where, sizeof( where ), "%llu bytes of segments", 
+                      (unsigned long long)stats.segment_bytes );
+            
+            // Values in the shared store belong to no node's segments, so they are counted there
+            if( shared != NULL )
+            {
+                for( int key = 0; key < MAX_KEY_VALUE; key++ )
+                {
+                    stats.live_bytes += ( shared->values[key].present == true ) ? 
+                                        shared->values[key].length : 0;
+                }
+                
+                snprintf( where, sizeof( where ), "a shared store of %zu bytes (%s pages)", 
+                          SHARED_STORE_SIZE, ( shared->huge_pages == true ) ? "huge" : "normal" );
+            }
+            
+            printf( "Values: %llu bytes live in %s, write amplification %.2f, "
+                    "read amplification %.2f\n", (unsigned long long)stats.live_bytes, where, 
+                    ( stats.value_bytes_written > 0 ) ? 
+                    (double)stats.segment_bytes_written / stats.value_bytes_written : 1.0,
+                    ( stats.value_bytes_read > 0 ) ? 
+                    (double)stats.segment_bytes_read / stats.value_bytes_read : 1.0 );
+            
+            // Bytes per nanosecond are GB/s
+            if( ( stats.transfer_bytes > 0 ) && ( stats.transfer_ns > 0 ) )
+            {
+                printf( "Moved %llu bytes of values in bulk at %.3f GB/s\n", 
+                        (unsigned long long)stats.transfer_bytes, 
+                        (double)stats.transfer_bytes / stats.transfer_ns );
+            }
+            
+            if( stats.owner_cache_lookups > 0 )
+            {
+                printf( "Owner cache: %llu of %llu requests sent straight to their owner "
+                        "(%.1f%% hit rate)\n", (unsigned long long)stats.owner_cache_hits, 
+                        (unsigned long long)stats.owner_cache_lookups, 
+                        100.0 * stats.owner_cache_hits / stats.owner_cache_lookups );
+            }
+            
+            if( stats.value_cache_lookups > 0 )
+            {
+                printf( "Value cache: %llu of %llu gets answered at the main node "
+                        "(%.1f%% hit rate)\n", (unsigned long long)stats.value_cache_hits, 
+                        (unsigned long long)stats.value_cache_lookups, 
+                        100.0 * stats.value_cache_hits / stats.value_cache_lookups );
+            }
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_process_hot_cmd
+ * 
+ * Helper function that processes the "hot" cmd from the user. The statistics of the ring are 
+ * gathered as for "stats", and the hottest keys and nodes among them are displayed: the keys 
+ * requested most lately (by the merged sketches of the nodes, whose counts may over-estimate the
+ * requests by up to the error shown), and the nodes handling the most requests per second, both
+ * answered and passed on towards other nodes.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void menu_process_hot_cmd()
+{
+    // Local variables
+    chord_msg_t reply;           // The combined answer of the nodes
+    chord_err_t err;             // An error code that may be returned by the command
+    chord_store_stats_t stats;   // The counters of the nodes, with the hot keys and nodes
+    const chord_hot_key_t *key;  // A hot key
+    const chord_hot_node_t *node;           // A hot node
+    double seconds;              // The time a node counted its requests over, in seconds
+    int next;                    // The hottest key or node not displayed yet
+    unsigned int shown = 0;      // The keys or nodes displayed, as a bitmap
+    
+    // Send the request, then wait for the answer carrying its tag
+    stats_tag++;
+    cmd_request_stats( stats_tag );
+    
+    do
+    {
+        err = cmd_read_report( &reply, stats_timeout_ms );
+    }
+    while( ( err == CHORD_ERR_NONE ) && 
+           ( ( reply.cmd != AGGREGATE ) || ( reply.tag != stats_tag ) ) );
+    
+    if( ( err != CHORD_ERR_NONE ) || ( reply.length != sizeof( stats ) ) )
+    {
+        printf( "Unable to gather statistics: the ring did not answer in time\n" );
+    }
+    else
+    {
+        memcpy( &stats, cmd_get_report_value(), sizeof( stats ) );
+        printf( "Hottest keys (of %i node%s):\n", reply.id, ( reply.id == 1 ) ? "" : "s" );
+        
+        // Display the keys from the most requested down
+        for( int count = 0; count < HOT_KEY_COUNT; count++ )
+        {
+            next = -1;
+            
+            for( int index = 0; index < HOT_KEY_COUNT; index++ )
+            {
+                key = &stats.hot_keys[index];
+                
+                if( ( ( shown & ( 1U << index ) ) == 0 ) && ( key->count > 0 ) &&
+                    ( ( next < 0 ) || ( key->count > stats.hot_keys[next].count ) ) )
+                {
+                    next = index;
+                }
+            }
+            
+            if( next >= 0 )
+            {
+                key = &stats.hot_keys[next];
+                shown |= ( 1U << next );
+                printf( "  Key <%i>: %llu requests (at most %u too many)\n", key->key, 
+                        (unsigned long long)key->count, key->error );
+            }
+        }
+        
+        if( shown == 0 )
+        {
+            printf( "  (no requests lately)\n" );
+        }
+        
+        printf( "Hottest nodes:\n" );
+        shown = 0;
+        
+        // Display the nodes from the busiest down
+        for( int count = 0; count < HOT_NODE_COUNT; count++ )
+        {
+            next = -1;
+            
+            for( int index = 0; index < HOT_NODE_COUNT; index++ )
+            {
+                node = &stats.hot_nodes[index];
+                
+                if( ( ( shown & ( 1U << index ) ) == 0 ) && ( node->served + node->passed > 0 ) &&
+                    ( ( next < 0 ) || 
+                      ( ( node->served + node->passed ) * stats.hot_nodes[next].window_ms > 
+                        ( stats.hot_nodes[next].served + stats.hot_nodes[next].passed ) * 
+                        node->window_ms ) ) )
+                {
+                    next = index;
+                }
+            }
+            
+            if( next >= 0 )
+            {
+                node = &stats.hot_nodes[next];
+                shown |= ( 1U << next );
+                seconds = ( node->window_ms > 0 ) ? node->window_ms / 1000.0 : 0.001;
+                
+                if( node->first_key < 0 )
+                {
+                    printf( "  Node %i (arc not known yet)", node->node_id );
+                }
+                else
+                {
+                    printf( "  Node %i (keys %i-%i)", node->node_id, node->first_key, 
+                            node->node_id );
+                }
+                
+                printf( ": %.1f requests/s, %.1f/s answered and %.1f/s passed on\n", 
+                        ( node->served + node->passed ) / seconds, node->served / seconds, 
+                        node->passed / seconds );
+            }
+        }
+        
+        if( shown == 0 )
+        {
+            printf( "  (no requests lately)\n" );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: menu_read_value
+ * 
+ * Helper function that prompts the user for an integer value and checks it against a range. An 
+ * error is printed if the value is invalid.
+ * 
+ * param:  The prompt to display
+ * param:  The minimum accepted value
+ * param:  The maximum accepted value
+ * param:  Holds the value entered by the user
+ * return: True if a valid value was entered, false otherwise
+ **************************************************************************************************/
+static bool menu_read_value( const char *prompt, int min_value, int max_value, int *value )
+{
+    // Local variables
+    bool valid = false;          // Flag: "a valid value was entered"
+    
+    // Prompt user for the value
+    fputs( prompt, stdout );
+
+    // Get entered value
+    if( fgets( user_input, MAX_KEYBOARD_INPUT_CHARS, stdin ) != NULL )
+    {
+        // Try to convert to an integer and report an error if the operation fails
+        errno = 0;
+        *value = strtol( user_input, NULL, 10 );
+
+        if( ( errno != 0 ) || ( *value < min_value ) || ( *value > max_value ) )
+        {
+            // Tell user input is invalid
+            printf( "Invalid input. You must enter a value between %i-%i, inclusive.\n", 
+                    min_value, max_value );
+        }
+        else
+        {
+            valid = true;
+        }
+    }
+    
+    return( valid );
+}
+
+
 //**************************************************************************************************
 // End of file.
 //**************************************************************************************************
@@ -14,11 +14,41 @@
 // Includes
 //**************************************************************************************************
 
+#include <signal.h>
+#include <stdbool.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include "chord_bench.h"
 #include "chord_commands.h"
 #include "chord_debug.h"
 #include "chord_init.h"
+#include "chord_load.h"
 #include "chord_menu.h"
+#include "chord_trace.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Command line usage
+static const char usage[] =
+    "Usage: chord_menu [--record <trace file> | --replay <trace file> [--fast]] [--netem <spec>]\n"
+    "                  [--replicas <r>] [--vnodes <v>] [--placement <policy>] [--autoscale <n>]\n"
+    "                  [--shared-store]\n"
+    "  --record  Capture every command sent to the DHT into a trace file\n"
+    "  --replay  Replay a trace file against a fresh ring, then exit\n"
+    "  --fast    Replay as fast as possible instead of at the recorded pacing\n"
+    "  --netem   Emulate network conditions between nodes, e.g. \"delay=20ms,jitter=5ms,loss=1\"\n"
+    "            (sets CHORD_NETEM; see chord_netem.h in the node program)\n"
+    "  --replicas Keep copies of each node's keys on its r successors (sets CHORD_REPLICATION)\n"
+    "  --vnodes  Have each node process host v node IDs on the ring (sets CHORD_VNODES)\n"
+    "  --placement Place new nodes to split the arc with the most keys (\"keys\", the default)\n"
+    "            or requests per second (\"requests\"), or at random (\"random\")\n"
+    "  --autoscale Add a node whenever an arc holds more than n keys (or n requests per second)\n"
+    "  --shared-store Keep values in memory shared by all nodes, so that keys change owner\n"
+    "            without their values being copied\n";
 
 
 //**************************************************************************************************
@@ -33,17 +63,108 @@
  **************************************************************************************************/
 int main(int argc, char** argv) 
 {
+    // Local variables
+    const char *record_path = NULL;         // Trace file to record to (if any)
+    const char *replay_path = NULL;         // Trace file to replay (if any)
+    bool paced = true;                      // Flag: "replay at the recorded pacing"
+    bool shared_store = false;              // Flag: "keep values in the shared store"
+    
+    // Parse command line options
+    for( int index = 1; index < argc; index++ )
+    {
+        if( ( strcmp( argv[index], "--record" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            record_path = argv[++index];
+        }
+        else if( ( strcmp( argv[index], "--replay" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            replay_path = argv[++index];
+        }
+        else if( strcmp( argv[index], "--fast" ) == 0 )
+        {
+            paced = false;
+        }
+        else if( ( strcmp( argv[index], "--netem" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            // Nodes read the link specification from the environment they inherit
+            setenv( "CHORD_NETEM", argv[++index], 1 );
+        }
+        else if( ( strcmp( argv[index], "--replicas" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            setenv( "CHORD_REPLICATION", argv[++index], 1 );
+        }
+        else if( ( strcmp( argv[index], "--vnodes" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            setenv( "CHORD_VNODES", argv[++index], 1 );
+        }
+        else if( ( strcmp( argv[index], "--placement" ) == 0 ) && ( index + 1 < argc ) &&
+                 ( strcmp( argv[index + 1], "keys" ) == 0 ) )
+        {
+            load_set_placement( PLACE_BY_KEYS );
+            index++;
+        }
+        else if( ( strcmp( argv[index], "--placement" ) == 0 ) && ( index + 1 < argc ) &&
+                 ( strcmp( argv[index + 1], "requests" ) == 0 ) )
+        {
+            load_set_placement( PLACE_BY_REQUESTS );
+            index++;
+        }
+        else if( ( strcmp( argv[index], "--placement" ) == 0 ) && ( index + 1 < argc ) &&
+                 ( strcmp( argv[index + 1], "random" ) == 0 ) )
+        {
+            load_set_placement( PLACE_AT_RANDOM );
+            index++;
+        }
+        else if( ( strcmp( argv[index], "--autoscale" ) == 0 ) && ( index + 1 < argc ) )
+        {
+            load_set_autoscale( atoi( argv[++index] ) );
+        }
+        else if( strcmp( argv[index], "--shared-store" ) == 0 )
+        {
+            shared_store = true;
+        }
+        else
+        {
+            fputs( usage, stderr );
+            return( EXIT_FAILURE );
+        }
+    }
+    
     // Disable debug prints by default
     debug_disable_prints();
     
     // Read initial list of keys from data file
     init_key_list();
     
+    // Start capturing commands before the ring exists, so the whole session is recorded
+    if( ( record_path != NULL ) && ( trace_start_recording( record_path ) != CHORD_ERR_NONE ) )
+    {
+        fprintf( stderr, "Unable to record to trace file %s\n", record_path );
+        return( EXIT_FAILURE );
+    }
+    
+    // The shared store is handed to the main node when it is created
+    if( ( shared_store == true ) && ( cmd_create_shared_store() != CHORD_ERR_NONE ) )
+    {
+        fprintf( stderr, "Unable to create the shared store\n" );
+        return( EXIT_FAILURE );
+    }
+    
     // Create the main (initial) DHT node
     cmd_create_main_node();
     
-    // Run the menu that handles user I/O
-    menu_execute();
+    if( replay_path != NULL )
+    {
+        // Replay the trace against the fresh ring, then kill all processes in this group
+        bench_replay( replay_path, paced );
+        fflush( stdout );
+        kill( 0, SIGKILL );
+    }
+    else
+    {
+        // Run the menu that handles user I/O
+        menu_execute();
+    }
     
     // Terminate
     return( EXIT_SUCCESS );
@@ -17,7 +17,7 @@
 // Includes
 //**************************************************************************************************
 
-// (none)
+#include <stdint.h>
 
 
 //**************************************************************************************************
@@ -28,6 +28,15 @@
 #define MENU_PROCESS_ID    64        // Outside of normal node range 0-63
 #define MAIN_DHT_NODE      63        // The main node (communicates with the menu process)
 
+// The hops field of an answer given by the main node from its summary of the keys in the DHT, for
+// a key it knows is not there (the answer does not come from the owner of the key, which the main
+// node does not know, so its sender field is the main node)
+#define SUMMARY_ANSWER_HOPS    64    // More hops than any message takes
+
+// The most bytes that can follow a message (a message and its payload must fit in PIPE_BUF, so
+// that each is written to a pipe in one piece)
+#define MAX_PAYLOAD_SIZE   2048
+
 // Chord command types
 typedef enum
 {
@@ -39,6 +48,37 @@ typedef enum
     ANNOUNCE               = 6,      // Announce insertion of a new node (initiates key redist.)
     REDIST_KEY             = 7,      // Redistribute keys properly among the (updated) DHT ring
     TOGGLE_DEBUG           = 8,      // Turn on/off debug prints
+    REPORT                 = 9,      // Report node state back to the menu process
+    LOOKUP                 = 10,     // Look up a key in the DHT (answered by its owner)
+    REPLICATE              = 11,     // Copy a node's key set to its successors
+    HEARTBEAT              = 12,     // Tell the supervisor that a node is alive
+    REPAIR                 = 13,     // Splice the ring around a failed node
+    CRASH                  = 14,     // Make a node fail (to exercise failure handling)
+    LEAVE                  = 15,     // Make a node leave the ring
+    HANDOFF                = 16,     // Hand a departing node's keys to its successor
+    STABILIZE              = 17,     // Ask a node for its predecessor and successor list
+    PREDECESSOR            = 18,     // Answer STABILIZE
+    NOTIFY                 = 19,     // Tell a node that the sender may be its predecessor
+    FIND_SUCCESSOR         = 20,     // Find the node that owns an ID (to refresh a finger)
+    FINGER                 = 21,     // Answer FIND_SUCCESSOR
+    HOST_NODE              = 22,     // Start a virtual node in the process of an existing node
+    STATS                  = 23,     // Gather statistics about the whole ring
+    AGGREGATE              = 24,     // Answer a dump or statistics request, combining the answers
+                                     // of the nodes it was passed on to
+    PUT                    = 25,     // Store a value under a key in the DHT
+    GET                    = 26,     // Fetch the value stored under a key (answered by its owner)
+    VALUES                 = 27,     // Move the values of a set of keys to the node now holding
+                                     // them
+    BULK_VALUES            = 28,     // Tell a node that values moved to it wait in its bulk pipe
+                                     // (as a VALUES message with its records)
+    SCAN                   = 29,     // Fetch the keys in a range, with their values, in order
+    COUNT                  = 30,     // Count the keys in a range
+    DELETE_RANGE           = 31,     // Delete the keys in a range from the DHT
+    MGET                   = 32,     // Fetch the values of a set of keys (split among their owners)
+    OWNER                  = 33,     // Tell the main node the range of keys the sender owns (for
+                                     // its owner cache)
+    CACHE_VALUE            = 34,     // Send the main node a copy of the value of a hot key (for
+                                     // its value cache)
 } chord_cmd_t;
 
 // A message that can be transmitted between nodes/processes
@@ -47,8 +87,116 @@ typedef struct
     chord_cmd_t cmd;                 // A command to process
     int id;                          // If applicable, a node ID or key ID
     int sender;                      // The node that is sending the message
+    int tag;                         // Request tag, echoed back in replies to the menu process
+                                     // (zero if the menu process does not expect a reply)
+    int hops;                        // Hops left, for messages passed a limited distance along
+                                     // the ring (e.g. replica updates); for a broadcast, the end
+                                     // of the part of the ring to pass it on to; for a range
+                                     // command, the last key of the range; zero otherwise
+    int length;                      // The bytes that follow the message (for PUT, answers to
+                                     // GET, SCAN and MGET, VALUES, AGGREGATE and CACHE_VALUE;
+                                     // ignored otherwise)
+    uint64_t data;                   // Bulk payload, if applicable (e.g. a key set bitmap; for
+                                     // ADD_NODE, the node whose process is to host the new node
+                                     // as a bitmap, or zero for a process of its own; for a
+                                     // request passed on towards the owner of a key, the flags
+                                     // below; for CACHE_VALUE, the version it was asked for at)
 } chord_msg_t;
 
+// The keys counted by the hot-key sketch of a node, and the nodes listed in a report of the
+// hottest nodes of the ring
+#define HOT_KEY_COUNT          8
+#define HOT_NODE_COUNT         4
+
+// A key counted by a hot-key sketch: its count over-estimates the requests for it by at most its
+// error (zero if the counter is unused)
+typedef struct
+{
+    int32_t key;                     // The key
+    uint32_t error;                  // The most the count may over-estimate the requests by
+    uint64_t count;                  // The requests for the key
+} chord_hot_key_t;
+
+// The requests a node has handled lately: those it answered (for keys on its arc of the ring, the
+// keys it owns, or from the main node's caches), and those it passed on towards other nodes (none
+// if the entry is unused)
+typedef struct
+{
+    int32_t node_id;                 // The node
+    int32_t first_key;               // The first key of its arc (-1 if not known)
+    uint64_t served;                 // Requests answered
+    uint64_t passed;                 // Requests passed on to other nodes
+    uint64_t window_ms;              // The time the requests were counted over, in milliseconds
+} chord_hot_node_t;
+
+// Counters of the values stored by a node, and of its caches, which follow an AGGREGATE answer
+// summed over the nodes that answered, with the hottest keys and nodes among them. Bytes written
+// and read by requests are those of the records stored and fetched (including those moved between
+// nodes); those written to and read from segments include the records copied by compaction as
+// well. Bytes moved in bulk are those received through bulk pipes, and the time spent moving them
+// is that spent on both ends (so that their ratio, in bytes per nanosecond, is the transfer rate
+// in GB/s).
+typedef struct
+{
+    uint64_t value_bytes_written;    // Bytes of records written by requests
+    uint64_t segment_bytes_written;  // Bytes of records written to segments
+    uint64_t value_bytes_read;       // Bytes of records read by requests
+    uint64_t segment_bytes_read;     // Bytes of records read from segments
+    uint64_t live_bytes;             // Bytes of the records in use
+    uint64_t segment_bytes;          // Bytes of the segments the records are kept in
+    uint64_t transfer_bytes;         // Bytes of records moved in bulk
+    uint64_t transfer_ns;            // Nanoseconds spent moving them
+    uint64_t owner_cache_lookups;    // Requests looked up in owner caches
+    uint64_t owner_cache_hits;       // Requests sent straight to their owner from owner caches
+    uint64_t value_cache_lookups;    // Gets looked up in value caches
+    uint64_t value_cache_hits;       // Gets answered from value caches
+    chord_hot_key_t hot_keys[HOT_KEY_COUNT];     // The most requested keys (a merged sketch)
+    chord_hot_node_t hot_nodes[HOT_NODE_COUNT];  // The nodes handling the most requests per second
+} chord_store_stats_t;
+
+// Range commands (SCAN, COUNT and DELETE_RANGE) carry the first key of the range in their ID field
+// and the last in their hops field. They are routed to the owner of the first key, and then passed
+// from successor to successor, with the ID field moved past the keys served so far, until the last
+// key is reached. Each node answers the menu process with the part of the range it served: the ID
+// and hops fields of an answer hold the first and last key of the part, and its payload the keys
+// of the part it found (SCAN and DELETE_RANGE, as a bitmap) or their number (COUNT). An answer to
+// a SCAN is followed by the values of those keys, in order, each as its length (a uint16_t) and
+// its bytes; a node whose values do not fit in one answer splits its part over several.
+// 
+// A multi-get (MGET) carries the keys to fetch as a bitmap in its payload. Each node it reaches
+// keeps the keys it owns, and passes the others on in one message per next hop, each carrying the
+// keys for that hop, so that the keys reach their owners in parallel. Each owner answers the menu
+// process with the keys it kept as its payload, followed by their values in order as in an answer
+// to a SCAN; a key that is not in the DHT is given the length VALUE_ABSENT_LENGTH.
+
+// The length given for a key that is not in the DHT, in an answer to MGET
+#define VALUE_ABSENT_LENGTH    0xFFFF
+
+// Flags of a request passed on towards the owner of a key: the owner is to answer the main node
+// with OWNER as well; an owner cache has sent the request on already (so no other is consulted);
+// the ID plus one of another node the owner is to answer with OWNER (zero if none); and (for GET,
+// in the upper half) the version of the key at the main node plus one, if the owner is to send
+// the main node a copy of the value with CACHE_VALUE as well
+#define REQUEST_OWNER_HINT     0x1UL
+#define REQUEST_CACHE_USED     0x2UL
+#define REQUEST_HINT_SHIFT     8
+#define REQUEST_HINT_MASK      0xFFUL
+#define REQUEST_VERSION_SHIFT  32
+
+// A message with the bytes that follow it (e.g. a value)
+typedef struct
+{
+    chord_msg_t msg;                 // The message
+    char payload[MAX_PAYLOAD_SIZE];  // The bytes that follow it
+} chord_payload_msg_t;
+
+// The number of bytes that follow a message
+#define MSG_PAYLOAD_LENGTH( msg )    ( ( ( (msg)->cmd == PUT ) || ( (msg)->cmd == GET ) ||      \
+                                         ( (msg)->cmd == VALUES ) || ( (msg)->cmd == SCAN ) ||  \
+                                         ( (msg)->cmd == MGET ) ||                              \
+                                         ( (msg)->cmd == CACHE_VALUE ) ||                       \
+                                         ( (msg)->cmd == AGGREGATE ) ) ? (msg)->length : 0 )
+
 
 //**************************************************************************************************
 // Module variables
@@ -0,0 +1,283 @@
+//**************************************************************************************************
+// File:   chord_trace.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Captures the commands sent to the DHT into a compact binary trace file, and reads them back so
+// that a workload can be replayed against a fresh ring.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chord_config.h"
+#include "chord_debug.h"
+#include "chord_trace.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Trace file header
+static const char trace_magic[] = "CHTR";
+#define TRACE_MAGIC_SIZE                4
+#define TRACE_VERSION                   2
+
+// The size of a single record in the trace file (without the value that follows it), in bytes
+#define TRACE_RECORD_SIZE               16
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// The trace file being recorded to (NULL if not recording)
+static FILE *record_file = NULL;
+
+// The time at which the previous command was recorded
+static struct timespec last_record_time;
+
+// The trace file being read from (NULL if not open)
+static FILE *replay_file = NULL;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: trace_start_recording
+ * 
+ * Start recording commands to the given trace file. Any existing file is overwritten.
+ * 
+ * param:  The path of the trace file
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t trace_start_recording( const char *path )
+{
+    // Local variables
+    chord_err_t err;                        // Return status code
+
+    // Initialization
+    err = CHORD_ERR_NONE;
+
+    // Finish any recording already in progress
+    trace_stop_recording();
+
+    record_file = fopen( path, "wb" );
+
+    if( record_file == NULL )
+    {
+        err = CHORD_ERR_TRACE_FILE;
+        debug_printf( "[DBG] Error: Unable to open trace file %s for recording.\n", path );
+    }
+    else
+    {
+        // Write the header; the first record is timed from now
+        fwrite( trace_magic, 1, TRACE_MAGIC_SIZE, record_file );
+        fputc( TRACE_VERSION, record_file );
+        clock_gettime( CLOCK_MONOTONIC, &last_record_time );
+    }
+
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: trace_record
+ * 
+ * Record a command, timestamped relative to the previous one. If no recording is in progress,
+ * no action is taken.
+ * 
+ * param:  The command type
+ * param:  The node ID or key ID of the command
+ * param:  The last key of a range, or the key set of a multi-get (zero otherwise)
+ * param:  The value of a put (NULL if there is none)
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * return: void
+ **************************************************************************************************/
+void trace_record( chord_cmd_t cmd, int id, uint64_t data, const char *value, int length )
+{
+    // Local variables
+    struct timespec now;                    // The time of this command
+    uint64_t delta_us;                      // Time since the previous command, in microseconds
+    uint8_t record[TRACE_RECORD_SIZE];      // The encoded record
+
+    if( record_file != NULL )
+    {
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        delta_us = ( now.tv_sec - last_record_time.tv_sec ) * 1000000ULL +
+                   ( now.tv_nsec - last_record_time.tv_nsec ) / 1000;
+        last_record_time = now;
+
+        // Gaps too long to encode are shortened to the maximum
+        if( delta_us > UINT32_MAX )
+        {
+            delta_us = UINT32_MAX;
+        }
+
+        record[0] = (uint8_t)( delta_us );
+        record[1] = (uint8_t)( delta_us >> 8 );
+        record[2] = (uint8_t)( delta_us >> 16 );
+        record[3] = (uint8_t)( delta_us >> 24 );
+        record[4] = (uint8_t)cmd;
+        record[5] = (uint8_t)id;
+        length = ( value == NULL ) ? 0 : length;
+        record[6] = (uint8_t)( length );
+        record[7] = (uint8_t)( length >> 8 );
+
+        for( int byte = 0; byte < 8; byte++ )
+        {
+            record[8 + byte] = (uint8_t)( data >> ( 8 * byte ) );
+        }
+
+        fwrite( record, 1, TRACE_RECORD_SIZE, record_file );
+
+        if( length > 0 )
+        {
+            fwrite( value, 1, length, record_file );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: trace_stop_recording
+ * 
+ * Stop recording, flushing any buffered commands to the trace file. If no recording is in
+ * progress, no action is taken.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void trace_stop_recording()
+{
+    if( record_file != NULL )
+    {
+        fclose( record_file );
+        record_file = NULL;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: trace_open
+ * 
+ * Open a trace file for reading, checking its header.
+ * 
+ * param:  The path of the trace file
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t trace_open( const char *path )
+{
+    // Local variables
+    chord_err_t err;                        // Return status code
+    char magic[TRACE_MAGIC_SIZE];           // The magic value read from the file
+
+    // Initialization
+    err = CHORD_ERR_NONE;
+
+    trace_close();
+    replay_file = fopen( path, "rb" );
+
+    if( replay_file == NULL )
+    {
+        err = CHORD_ERR_TRACE_FILE;
+        debug_printf( "[DBG] Error: Unable to open trace file %s for reading.\n", path );
+    }
+    else if( ( fread( magic, 1, TRACE_MAGIC_SIZE, replay_file ) != TRACE_MAGIC_SIZE ) ||
+             ( memcmp( magic, trace_magic, TRACE_MAGIC_SIZE ) != 0 ) ||
+             ( fgetc( replay_file ) != TRACE_VERSION ) )
+    {
+        err = CHORD_ERR_TRACE_FILE;
+        debug_printf( "[DBG] Error: %s is not a supported trace file.\n", path );
+        trace_close();
+    }
+
+    return( err );
+}
+
+
+/***************************************************************************************************
+ * Function: trace_read
+ * 
+ * Read the next command from the trace file opened with trace_open.
+ * 
+ * param:  Holds the command that was read
+ * return: True if a command was read, false at the end of the file
+ **************************************************************************************************/
+bool trace_read( trace_record_t *record )
+{
+    // Local variables
+    uint8_t encoded[TRACE_RECORD_SIZE];     // The encoded record
+    bool record_read = false;               // Flag: "a complete record was read"
+
+    if( ( replay_file != NULL ) &&
+        ( fread( encoded, 1, TRACE_RECORD_SIZE, replay_file ) == TRACE_RECORD_SIZE ) )
+    {
+        record->delta_us = (uint32_t)encoded[0] | ( (uint32_t)encoded[1] << 8 ) |
+                           ( (uint32_t)encoded[2] << 16 ) | ( (uint32_t)encoded[3] << 24 );
+        record->cmd = (chord_cmd_t)encoded[4];
+        record->id = encoded[5];
+        record->length = encoded[6] | ( encoded[7] << 8 );
+        record->data = 0;
+        record->value = NULL;
+
+        for( int byte = 0; byte < 8; byte++ )
+        {
+            record->data |= (uint64_t)encoded[8 + byte] << ( 8 * byte );
+        }
+
+        // A record is complete once the value that follows it has been read
+        if( record->length == 0 )
+        {
+            record_read = true;
+        }
+        else if( record->length <= MAX_VALUE_SIZE )
+        {
+            record->value = malloc( record->length );
+            record_read = ( record->value != NULL ) && 
+                          ( fread( record->value, 1, record->length, replay_file ) == 
+                            (size_t)record->length );
+        }
+
+        if( record_read == false )
+        {
+            free( record->value );
+            record->value = NULL;
+            debug_printf( "[DBG] Error: Truncated or corrupt record in trace file.\n" );
+        }
+    }
+
+    return( record_read );
+}
+
+
+/***************************************************************************************************
+ * Function: trace_close
+ * 
+ * Close the trace file opened with trace_open.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void trace_close()
+{
+    if( replay_file != NULL )
+    {
+        fclose( replay_file );
+        replay_file = NULL;
+    }
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,128 @@
+//**************************************************************************************************
+// File:   chord_trace.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Captures the commands sent to the DHT into a compact binary trace file, and reads them back so
+// that a workload can be replayed against a fresh ring.
+// 
+// The file starts with a 4-byte magic value ("CHTR") and a 1-byte format version. Each command
+// is then stored as a 16-byte record: the time since the previous record in microseconds (32-bit,
+// little-endian), the command type, the node or key ID, the length of the value that follows the
+// record (16-bit, little-endian) and the command's data (64-bit, little-endian: the last key of a
+// range, or the key set of a multi-get). A put is followed by its value.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_TRACE_H
+#define CHORD_TRACE_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "chord_error.h"
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// A command read back from a trace file
+typedef struct
+{
+    uint32_t delta_us;               // Time since the previous command, in microseconds
+    chord_cmd_t cmd;                 // The command type
+    int id;                          // The node ID or key ID of the command
+    uint64_t data;                   // The last key of a range, or the key set of a multi-get
+    int length;                      // The length of the value, in bytes
+    char *value;                     // The value of a put (allocated; NULL if there is none)
+} trace_record_t;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: trace_start_recording
+ * 
+ * Start recording commands to the given trace file. Any existing file is overwritten.
+ * 
+ * param:  The path of the trace file
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t trace_start_recording( const char *path );
+
+
+/***************************************************************************************************
+ * Function: trace_record
+ * 
+ * Record a command, timestamped relative to the previous one. If no recording is in progress,
+ * no action is taken.
+ * 
+ * param:  The command type
+ * param:  The node ID or key ID of the command
+ * param:  The last key of a range, or the key set of a multi-get (zero otherwise)
+ * param:  The value of a put (NULL if there is none)
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * return: void
+ **************************************************************************************************/
+void trace_record( chord_cmd_t cmd, int id, uint64_t data, const char *value, int length );
+
+
+/***************************************************************************************************
+ * Function: trace_stop_recording
+ * 
+ * Stop recording, flushing any buffered commands to the trace file. If no recording is in
+ * progress, no action is taken.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void trace_stop_recording();
+
+
+/***************************************************************************************************
+ * Function: trace_open
+ * 
+ * Open a trace file for reading, checking its header.
+ * 
+ * param:  The path of the trace file
+ * return: An error code indicative of success or failure
+ **************************************************************************************************/
+chord_err_t trace_open( const char *path );
+
+
+/***************************************************************************************************
+ * Function: trace_read
+ * 
+ * Read the next command from the trace file opened with trace_open. The value of a put is
+ * allocated, and must be released by the caller with free.
+ * 
+ * param:  Holds the command that was read
+ * return: True if a command was read, false at the end of the file
+ **************************************************************************************************/
+bool trace_read( trace_record_t *record );
+
+
+/***************************************************************************************************
+ * Function: trace_close
+ * 
+ * Close the trace file opened with trace_open.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void trace_close();
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
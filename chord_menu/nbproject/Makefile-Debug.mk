@@ -35,11 +35,14 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
+	${OBJECTDIR}/chord_bench.o \
 	${OBJECTDIR}/chord_commands.o \
 	${OBJECTDIR}/chord_debug.o \
 	${OBJECTDIR}/chord_init.o \
+	${OBJECTDIR}/chord_load.o \
 	${OBJECTDIR}/chord_menu.o \
-	${OBJECTDIR}/chord_menu_main.o
+	${OBJECTDIR}/chord_menu_main.o \
+	${OBJECTDIR}/chord_trace.o
 
 
 # C Compiler Flags
@@ -66,6 +69,11 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/chord_menu: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/chord_menu ${OBJECTFILES} ${LDLIBSOPTIONS}
 
+${OBJECTDIR}/chord_bench.o: chord_bench.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_bench.o chord_bench.c
+
 ${OBJECTDIR}/chord_commands.o: chord_commands.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -81,6 +89,11 @@ ${OBJECTDIR}/chord_init.o: chord_init.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_init.o chord_init.c
 
+${OBJECTDIR}/chord_load.o: chord_load.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_load.o chord_load.c
+
 ${OBJECTDIR}/chord_menu.o: chord_menu.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -91,6 +104,11 @@ ${OBJECTDIR}/chord_menu_main.o: chord_menu_main.c
 	${RM} "$@.d"
 	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_menu_main.o chord_menu_main.c
 
+${OBJECTDIR}/chord_trace.o: chord_trace.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -g -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_trace.o chord_trace.c
+
 # Subprojects
 .build-subprojects:
 
@@ -0,0 +1,344 @@
+//**************************************************************************************************
+// File:   chord_broadcast.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Spreads ring-wide commands over a tree built from the finger tables, and combines the answers
+// on their way back up (see chord_broadcast.h).
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+#include "chord_broadcast.h"
+#include "chord_config.h"
+#include "chord_hot_keys.h"
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// A broadcast whose answers a node is waiting for
+typedef struct
+{
+    bool used;                       // Flag: "this entry is in use"
+    int node_id;                     // The node waiting for the answers
+    int parent_id;                   // The node to answer once all answers are in
+    int tag;                         // The tag of the broadcast
+    int pending;                     // The number of answers still to come
+    double deadline_ms;              // When to stop waiting for them
+    chord_msg_t answer;              // The answers so far, combined with the node's own
+    chord_store_stats_t stats;       // Their store counters, added up
+} broadcast_pending_t;
+
+// Local prototypes
+static void broadcast_add_stats( broadcast_pending_t *entry, const chord_msg_t *answer, 
+                                 const char *counters );
+static void broadcast_close( broadcast_pending_t *entry, chord_payload_msg_t *result, 
+                             int *parent_id );
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// The broadcasts the nodes of this process are waiting on
+static broadcast_pending_t pending_broadcasts[MAX_PENDING_BROADCASTS];
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: broadcast_children
+ * 
+ * Choose the nodes to pass a broadcast on to: the distinct known nodes that lie after this node
+ * and before the limit, each with the part of the ring up to the next of them (or the limit).
+ * 
+ * param:  The ID of this node
+ * param:  The end of the part of the ring this node covers (its own ID for the whole ring)
+ * param:  The nodes this node knows of (its successor and fingers; INT_MAX where not known)
+ * param:  The number of nodes this node knows of
+ * param:  Holds the nodes to pass the broadcast on to, nearest first
+ * param:  Holds the end of the part of the ring each of them covers
+ * return: The number of nodes to pass the broadcast on to
+ **************************************************************************************************/
+int broadcast_children( int node_id, int limit_id, const int *known_ids, int known_count,
+                        int *child_ids, int *limit_ids )
+{
+    // Local variables
+    int limit;                    // The distance from this node to the limit
+    int distance;                 // The distance from this node to a known node
+    int nearest;                  // The distance to the nearest known node not yet chosen
+    int previous = 0;             // The distance to the last node chosen
+    int count = 0;                // The number of nodes chosen
+
+    limit = ( limit_id - node_id + MAX_NODE_COUNT ) % MAX_NODE_COUNT;
+    limit = ( limit == 0 ) ? MAX_NODE_COUNT : limit;
+
+    // Choose the known nodes in order of distance, skipping duplicates
+    do
+    {
+        nearest = limit;
+
+        for( int index = 0; index < known_count; index++ )
+        {
+            distance = ( known_ids[index] - node_id + MAX_NODE_COUNT ) % MAX_NODE_COUNT;
+
+            if( ( known_ids[index] != INT_MAX ) && ( distance > previous ) && 
+                ( distance < nearest ) )
+            {
+                nearest = distance;
+            }
+        }
+
+        if( nearest < limit )
+        {
+            child_ids[count++] = ( node_id + nearest ) % MAX_NODE_COUNT;
+            previous = nearest;
+        }
+    }
+    while( nearest < limit );
+
+    // Each node covers the ring up to the next one
+    for( int index = 0; index < count; index++ )
+    {
+        limit_ids[index] = ( index + 1 < count ) ? child_ids[index + 1] : limit_id;
+    }
+
+    return( count );
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_open
+ * 
+ * Start waiting for the answers of the nodes a broadcast was passed on to.
+ * 
+ * param:  The ID of this node
+ * param:  The node to answer once all answers are in (MENU_PROCESS_ID for the menu process)
+ * param:  The tag of the broadcast
+ * param:  The number of answers to wait for
+ * param:  This node's own contribution to the answer (followed by its store counters)
+ * param:  The deadline for the answers, in milliseconds (on the monotonic clock)
+ * return: True if the answers are waited for; false if too many broadcasts are pending already
+ **************************************************************************************************/
+bool broadcast_open( int node_id, int parent_id, int tag, int children, const chord_msg_t *own,
+                     double deadline_ms )
+{
+    // Local variables
+    bool opened = false;          // Flag: "the answers are waited for"
+
+    for( int index = 0; ( index < MAX_PENDING_BROADCASTS ) && ( opened == false ); index++ )
+    {
+        if( pending_broadcasts[index].used == false )
+        {
+            pending_broadcasts[index].used = true;
+            pending_broadcasts[index].node_id = node_id;
+            pending_broadcasts[index].parent_id = parent_id;
+            pending_broadcasts[index].tag = tag;
+            pending_broadcasts[index].pending = children;
+            pending_broadcasts[index].deadline_ms = deadline_ms;
+            pending_broadcasts[index].answer = *own;
+            memset( &pending_broadcasts[index].stats, 0, sizeof( chord_store_stats_t ) );
+            broadcast_add_stats( &pending_broadcasts[index], own, (const char *)( own + 1 ) );
+            opened = true;
+        }
+    }
+
+    return( opened );
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_collect
+ * 
+ * Add an answer to the broadcast it belongs to. The answers carry the number of nodes that
+ * answered in their ID field, the messages those nodes have sent in their hops field, and the
+ * union of their key sets as their payload, followed by the store counters of those nodes, so 
+ * they are combined by adding and merging these.
+ * 
+ * param:  The ID of this node
+ * param:  The answer
+ * param:  The store counters that followed the answer (its length is theirs)
+ * param:  Holds the combined answer, if this was the last one
+ * param:  Holds the node to pass the combined answer to, if this was the last one
+ * return: True if this was the last answer
+ **************************************************************************************************/
+bool broadcast_collect( int node_id, const chord_msg_t *answer, const char *counters,
+                        chord_payload_msg_t *result, int *parent_id )
+{
+    // Local variables
+    bool complete = false;        // Flag: "this was the last answer"
+
+    for( int index = 0; index < MAX_PENDING_BROADCASTS; index++ )
+    {
+        if( ( pending_broadcasts[index].used == true ) &&
+            ( pending_broadcasts[index].node_id == node_id ) &&
+            ( pending_broadcasts[index].tag == answer->tag ) )
+        {
+            pending_broadcasts[index].answer.id += answer->id;
+            pending_broadcasts[index].answer.hops += answer->hops;
+            pending_broadcasts[index].answer.data |= answer->data;
+            broadcast_add_stats( &pending_broadcasts[index], answer, counters );
+            pending_broadcasts[index].pending--;
+
+            if( pending_broadcasts[index].pending <= 0 )
+            {
+                broadcast_close( &pending_broadcasts[index], result, parent_id );
+                complete = true;
+            }
+        }
+    }
+
+    return( complete );
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_expire
+ * 
+ * Give up waiting on a broadcast whose deadline has passed, taking the answers that are in.
+ * 
+ * param:  The ID of this node
+ * param:  The current time, in milliseconds (on the monotonic clock)
+ * param:  Holds the combined answer, if a broadcast has expired
+ * param:  Holds the node to pass the combined answer to, if a broadcast has expired
+ * return: True if a broadcast has expired (call again for any others)
+ **************************************************************************************************/
+bool broadcast_expire( int node_id, double now_ms, chord_payload_msg_t *result, int *parent_id )
+{
+    // Local variables
+    bool expired = false;         // Flag: "a broadcast has expired"
+
+    for( int index = 0; ( index < MAX_PENDING_BROADCASTS ) && ( expired == false ); index++ )
+    {
+        if( ( pending_broadcasts[index].used == true ) &&
+            ( pending_broadcasts[index].node_id == node_id ) &&
+            ( pending_broadcasts[index].deadline_ms <= now_ms ) )
+        {
+            broadcast_close( &pending_broadcasts[index], result, parent_id );
+            expired = true;
+        }
+    }
+
+    return( expired );
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_next_deadline_ms
+ * 
+ * Get the earliest deadline of the broadcasts a node is waiting on.
+ * 
+ * param:  The ID of this node
+ * return: The deadline, in milliseconds (on the monotonic clock), or -1 if there is none
+ **************************************************************************************************/
+double broadcast_next_deadline_ms( int node_id )
+{
+    // Local variables
+    double deadline_ms = -1.0;    // The earliest deadline
+
+    for( int index = 0; index < MAX_PENDING_BROADCASTS; index++ )
+    {
+        if( ( pending_broadcasts[index].used == true ) &&
+            ( pending_broadcasts[index].node_id == node_id ) &&
+            ( ( deadline_ms < 0.0 ) || ( pending_broadcasts[index].deadline_ms < deadline_ms ) ) )
+        {
+            deadline_ms = pending_broadcasts[index].deadline_ms;
+        }
+    }
+
+    return( deadline_ms );
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_forget
+ * 
+ * Stop waiting on the broadcasts of a node that is no longer run by this process.
+ * 
+ * param:  The ID of the node (or -1 for every node)
+ * return: void
+ **************************************************************************************************/
+void broadcast_forget( int node_id )
+{
+    for( int index = 0; index < MAX_PENDING_BROADCASTS; index++ )
+    {
+        if( ( node_id < 0 ) || ( pending_broadcasts[index].node_id == node_id ) )
+        {
+            pending_broadcasts[index].used = false;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_add_stats
+ * 
+ * Add the store counters that follow an answer (if any) to those of a broadcast.
+ * 
+ * param:  The broadcast
+ * param:  The answer
+ * param:  The store counters that followed the answer (its length is theirs)
+ * return: void
+ **************************************************************************************************/
+static void broadcast_add_stats( broadcast_pending_t *entry, const chord_msg_t *answer, 
+                                 const char *counters )
+{
+    // Local variables
+    chord_store_stats_t stats;    // The counters of the answer
+    
+    if( answer->length == sizeof( stats ) )
+    {
+        memcpy( &stats, counters, sizeof( stats ) );
+        entry->stats.value_bytes_written += stats.value_bytes_written;
+        entry->stats.segment_bytes_written += stats.segment_bytes_written;
+        entry->stats.value_bytes_read += stats.value_bytes_read;
+        entry->stats.segment_bytes_read += stats.segment_bytes_read;
+        entry->stats.live_bytes += stats.live_bytes;
+        entry->stats.segment_bytes += stats.segment_bytes;
+        entry->stats.transfer_bytes += stats.transfer_bytes;
+        entry->stats.transfer_ns += stats.transfer_ns;
+        entry->stats.owner_cache_lookups += stats.owner_cache_lookups;
+        entry->stats.owner_cache_hits += stats.owner_cache_hits;
+        entry->stats.value_cache_lookups += stats.value_cache_lookups;
+        entry->stats.value_cache_hits += stats.value_cache_hits;
+        hot_merge( &entry->stats, &stats );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: broadcast_close
+ * 
+ * Stop waiting on a broadcast, handing back its combined answer.
+ * 
+ * param:  The broadcast
+ * param:  Holds the combined answer, followed by its store counters
+ * param:  Holds the node to pass the combined answer to
+ * return: void
+ **************************************************************************************************/
+static void broadcast_close( broadcast_pending_t *entry, chord_payload_msg_t *result, 
+                             int *parent_id )
+{
+    result->msg = entry->answer;
+    result->msg.length = sizeof( entry->stats );
+    memcpy( result->payload, &entry->stats, sizeof( entry->stats ) );
+    *parent_id = entry->parent_id;
+    entry->used = false;
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
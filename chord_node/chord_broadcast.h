@@ -0,0 +1,147 @@
+//**************************************************************************************************
+// File:   chord_broadcast.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Spreads ring-wide commands (dump, debug toggling, reports and statistics) over a tree built from
+// the finger tables, rather than walking them around the ring one node at a time. A node that is
+// given the part of the ring up to (but not including) a limit passes the command to each of its
+// fingers that lies before the limit, giving each the part of the ring up to the next one. Every
+// node is reached once, and a ring of N nodes is covered in O(log N) steps rather than N.
+// 
+// Answers travel back up the same tree (a convergecast): each node adds its own contribution to
+// those of the nodes it passed the command to, and answers the node it got the command from. A
+// node stops waiting for an answer at a deadline that is earlier the smaller its part of the ring,
+// so that a failed node costs its ancestors a partial answer rather than none at all.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_BROADCAST_H
+#define CHORD_BROADCAST_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The time the node that starts a broadcast waits for answers, in milliseconds (other nodes wait
+// in proportion to the part of the ring they cover)
+#define BROADCAST_TIMEOUT_MS            2000
+
+// The number of convergecasts a process can wait on at once
+#define MAX_PENDING_BROADCASTS          16
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: broadcast_children
+ * 
+ * Choose the nodes to pass a broadcast on to: the distinct known nodes that lie after this node
+ * and before the limit, each with the part of the ring up to the next of them (or the limit).
+ * 
+ * param:  The ID of this node
+ * param:  The end of the part of the ring this node covers (its own ID for the whole ring)
+ * param:  The nodes this node knows of (its successor and fingers; INT_MAX where not known)
+ * param:  The number of nodes this node knows of
+ * param:  Holds the nodes to pass the broadcast on to, nearest first
+ * param:  Holds the end of the part of the ring each of them covers
+ * return: The number of nodes to pass the broadcast on to
+ **************************************************************************************************/
+int broadcast_children( int node_id, int limit_id, const int *known_ids, int known_count,
+                        int *child_ids, int *limit_ids );
+
+
+/***************************************************************************************************
+ * Function: broadcast_open
+ * 
+ * Start waiting for the answers of the nodes a broadcast was passed on to.
+ * 
+ * param:  The ID of this node
+ * param:  The node to answer once all answers are in (MENU_PROCESS_ID for the menu process)
+ * param:  The tag of the broadcast
+ * param:  The number of answers to wait for
+ * param:  This node's own contribution to the answer (followed by its store counters)
+ * param:  The deadline for the answers, in milliseconds (on the monotonic clock)
+ * return: True if the answers are waited for; false if too many broadcasts are pending already
+ **************************************************************************************************/
+bool broadcast_open( int node_id, int parent_id, int tag, int children, const chord_msg_t *own,
+                     double deadline_ms );
+
+
+/***************************************************************************************************
+ * Function: broadcast_collect
+ * 
+ * Add an answer to the broadcast it belongs to. Answers to broadcasts that are not pending (e.g.
+ * ones that have passed their deadline) are dropped.
+ * 
+ * param:  The ID of this node
+ * param:  The answer
+ * param:  The store counters that followed the answer (its length is theirs)
+ * param:  Holds the combined answer, if this was the last one
+ * param:  Holds the node to pass the combined answer to, if this was the last one
+ * return: True if this was the last answer
+ **************************************************************************************************/
+bool broadcast_collect( int node_id, const chord_msg_t *answer, const char *counters,
+                        chord_payload_msg_t *result, int *parent_id );
+
+
+/***************************************************************************************************
+ * Function: broadcast_expire
+ * 
+ * Give up waiting on a broadcast whose deadline has passed, taking the answers that are in.
+ * 
+ * param:  The ID of this node
+ * param:  The current time, in milliseconds (on the monotonic clock)
+ * param:  Holds the combined answer, if a broadcast has expired
+ * param:  Holds the node to pass the combined answer to, if a broadcast has expired
+ * return: True if a broadcast has expired (call again for any others)
+ **************************************************************************************************/
+bool broadcast_expire( int node_id, double now_ms, chord_payload_msg_t *result, int *parent_id );
+
+
+/***************************************************************************************************
+ * Function: broadcast_next_deadline_ms
+ * 
+ * Get the earliest deadline of the broadcasts a node is waiting on.
+ * 
+ * param:  The ID of this node
+ * return: The deadline, in milliseconds (on the monotonic clock), or -1 if there is none
+ **************************************************************************************************/
+double broadcast_next_deadline_ms( int node_id );
+
+
+/***************************************************************************************************
+ * Function: broadcast_forget
+ * 
+ * Stop waiting on the broadcasts of a node that is no longer run by this process.
+ * 
+ * param:  The ID of the node (or -1 for every node)
+ * return: void
+ **************************************************************************************************/
+void broadcast_forget( int node_id );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
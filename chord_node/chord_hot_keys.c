@@ -0,0 +1,337 @@
+//**************************************************************************************************
+// File:   chord_hot_keys.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Tracks the requests a node handles, to find the hot keys and nodes (see chord_hot_keys.h).
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include "chord_hot_keys.h"
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Local prototypes
+static double hot_now_ms();
+static void hot_roll( hot_tracker_t *tracker, double now_ms );
+static void hot_add_key( chord_hot_key_t *keys, int key, uint64_t count, uint64_t error );
+static double hot_node_rate( const chord_hot_node_t *node );
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: hot_init
+ * 
+ * Clear the counts of a tracker, starting its windows now.
+ * 
+ * param:  The tracker
+ * return: void
+ **************************************************************************************************/
+void hot_init( hot_tracker_t *tracker )
+{
+    memset( tracker, 0, sizeof( *tracker ) );
+    tracker->current.start_ms = hot_now_ms();
+    tracker->previous.start_ms = tracker->current.start_ms;
+}
+
+
+/***************************************************************************************************
+ * Function: hot_note_served
+ * 
+ * Count a request the node answered.
+ * 
+ * param:  The tracker
+ * param:  The key
+ * return: void
+ **************************************************************************************************/
+void hot_note_served( hot_tracker_t *tracker, int key )
+{
+    hot_roll( tracker, hot_now_ms() );
+    hot_add_key( tracker->current.keys, key, 1, 0 );
+    tracker->current.served++;
+}
+
+
+/***************************************************************************************************
+ * Function: hot_note_passed
+ * 
+ * Count a request passed on to another node.
+ * 
+ * param:  The tracker
+ * return: void
+ **************************************************************************************************/
+void hot_note_passed( hot_tracker_t *tracker )
+{
+    hot_roll( tracker, hot_now_ms() );
+    tracker->current.passed++;
+}
+
+
+/***************************************************************************************************
+ * Function: hot_key_requests
+ * 
+ * Get the number of requests the node has answered for a key lately, as far as the sketch can
+ * vouch for them: the counts of the key in the current window and the one before it, less the
+ * most each may be over-estimated by.
+ * 
+ * param:  The tracker
+ * param:  The key
+ * return: The requests (zero if the key is not among the hot keys)
+ **************************************************************************************************/
+uint64_t hot_key_requests( hot_tracker_t *tracker, int key )
+{
+    // Local variables
+    uint64_t requests = 0;        // The requests for the key
+    const hot_window_t *windows[2] = { &tracker->previous, &tracker->current };
+
+    hot_roll( tracker, hot_now_ms() );
+
+    for( int window = 0; window < 2; window++ )
+    {
+        for( int index = 0; index < HOT_KEY_COUNT; index++ )
+        {
+            if( ( windows[window]->keys[index].count > windows[window]->keys[index].error ) &&
+                ( windows[window]->keys[index].key == key ) )
+            {
+                requests += windows[window]->keys[index].count - windows[window]->keys[index].error;
+            }
+        }
+    }
+
+    return( requests );
+}
+
+
+/***************************************************************************************************
+ * Function: hot_report
+ * 
+ * Report the requests a node has handled lately, as the only node of a set of statistics: those
+ * counted in the current window and the one before it.
+ * 
+ * param:  The tracker
+ * param:  The ID of the node
+ * param:  The first key of its arc (-1 if not known)
+ * param:  Holds the report (the hot keys and nodes of the statistics are set)
+ * return: void
+ **************************************************************************************************/
+void hot_report( hot_tracker_t *tracker, int node_id, int first_key, chord_store_stats_t *stats )
+{
+    // Local variables
+    double now_ms;                // The current time
+    const hot_window_t *windows[2] = { &tracker->previous, &tracker->current };
+
+    now_ms = hot_now_ms();
+    hot_roll( tracker, now_ms );
+    memset( stats->hot_keys, 0, sizeof( stats->hot_keys ) );
+    memset( stats->hot_nodes, 0, sizeof( stats->hot_nodes ) );
+
+    for( int window = 0; window < 2; window++ )
+    {
+        for( int index = 0; index < HOT_KEY_COUNT; index++ )
+        {
+            if( windows[window]->keys[index].count > 0 )
+            {
+                hot_add_key( stats->hot_keys, windows[window]->keys[index].key,
+                             windows[window]->keys[index].count,
+                             windows[window]->keys[index].error );
+            }
+        }
+    }
+
+    stats->hot_nodes[0].node_id = node_id;
+    stats->hot_nodes[0].first_key = first_key;
+    stats->hot_nodes[0].served = tracker->previous.served + tracker->current.served;
+    stats->hot_nodes[0].passed = tracker->previous.passed + tracker->current.passed;
+    stats->hot_nodes[0].window_ms = (uint64_t)( now_ms - tracker->previous.start_ms );
+}
+
+
+/***************************************************************************************************
+ * Function: hot_merge
+ * 
+ * Merge the hot keys and nodes of one set of statistics into another. Each key is added to the
+ * sketch as a weighted Space-Saving update; each node takes the place of the node handling the
+ * fewest requests per second, if it handles more.
+ * 
+ * param:  The statistics to merge into
+ * param:  The statistics to merge
+ * return: void
+ **************************************************************************************************/
+void hot_merge( chord_store_stats_t *into, const chord_store_stats_t *from )
+{
+    // Local variables
+    int coldest;                  // The node handling the fewest requests per second
+
+    for( int index = 0; index < HOT_KEY_COUNT; index++ )
+    {
+        if( from->hot_keys[index].count > 0 )
+        {
+            hot_add_key( into->hot_keys, from->hot_keys[index].key, from->hot_keys[index].count,
+                         from->hot_keys[index].error );
+        }
+    }
+
+    for( int index = 0; index < HOT_NODE_COUNT; index++ )
+    {
+        coldest = 0;
+
+        for( int slot = 1; slot < HOT_NODE_COUNT; slot++ )
+        {
+            if( hot_node_rate( &into->hot_nodes[slot] ) <
+                hot_node_rate( &into->hot_nodes[coldest] ) )
+            {
+                coldest = slot;
+            }
+        }
+
+        if( hot_node_rate( &from->hot_nodes[index] ) > hot_node_rate( &into->hot_nodes[coldest] ) )
+        {
+            into->hot_nodes[coldest] = from->hot_nodes[index];
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: hot_now_ms
+ * 
+ * Get the current time.
+ * 
+ * param:  void
+ * return: The time, in milliseconds (on the monotonic clock)
+ **************************************************************************************************/
+static double hot_now_ms()
+{
+    // Local variables
+    struct timespec now;          // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6 );
+}
+
+
+/***************************************************************************************************
+ * Function: hot_roll
+ * 
+ * Start a new window, if the current one has run its length. The current window becomes the one
+ * before it, unless no request has been counted for a whole window since.
+ * 
+ * param:  The tracker
+ * param:  The current time, in milliseconds (on the monotonic clock)
+ * return: void
+ **************************************************************************************************/
+static void hot_roll( hot_tracker_t *tracker, double now_ms )
+{
+    if( now_ms - tracker->current.start_ms >= HOT_WINDOW_MS )
+    {
+        if( now_ms - tracker->current.start_ms < 2 * HOT_WINDOW_MS )
+        {
+            tracker->previous = tracker->current;
+        }
+        else
+        {
+            memset( &tracker->previous, 0, sizeof( tracker->previous ) );
+            tracker->previous.start_ms = now_ms - HOT_WINDOW_MS;
+        }
+
+        memset( &tracker->current, 0, sizeof( tracker->current ) );
+        tracker->current.start_ms = now_ms;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: hot_add_key
+ * 
+ * Add requests for a key to a Space-Saving sketch. A key the sketch does not count yet takes the
+ * counter with the smallest count, adding that count to its own (and to its error), so that no
+ * count can fall short of the requests for its key.
+ * 
+ * param:  The sketch (HOT_KEY_COUNT counters)
+ * param:  The key
+ * param:  The requests for the key
+ * param:  The most the requests may be over-estimated by
+ * return: void
+ **************************************************************************************************/
+static void hot_add_key( chord_hot_key_t *keys, int key, uint64_t count, uint64_t error )
+{
+    // Local variables
+    int slot = -1;                // The counter of the key
+    int smallest = 0;             // The counter with the smallest count
+
+    for( int index = 0; index < HOT_KEY_COUNT; index++ )
+    {
+        if( ( keys[index].count > 0 ) && ( keys[index].key == key ) )
+        {
+            slot = index;
+        }
+
+        if( keys[index].count < keys[smallest].count )
+        {
+            smallest = index;
+        }
+    }
+
+    if( slot < 0 )
+    {
+        slot = smallest;
+        error += keys[slot].count;
+        count += keys[slot].count;
+        keys[slot].key = key;
+        keys[slot].error = 0;
+        keys[slot].count = 0;
+    }
+
+    keys[slot].error = (uint32_t)( keys[slot].error + error );
+    keys[slot].count += count;
+}
+
+
+/***************************************************************************************************
+ * Function: hot_node_rate
+ * 
+ * Get the requests per second a node in a report handled.
+ * 
+ * param:  The node
+ * return: The requests per second, or -1 if the entry is unused
+ **************************************************************************************************/
+static double hot_node_rate( const chord_hot_node_t *node )
+{
+    // Local variables
+    double rate = -1.0;           // The requests per second
+
+    if( node->served + node->passed > 0 )
+    {
+        rate = ( node->served + node->passed ) * 1000.0 /
+               ( ( node->window_ms > 0 ) ? node->window_ms : 1 );
+    }
+
+    return( rate );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,142 @@
+//**************************************************************************************************
+// File:   chord_hot_keys.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Tracks the requests a node handles, so that the keys and nodes taking the traffic can be found:
+// a Space-Saving sketch of the keys of the requests the node answered, which counts only the
+// HOT_KEY_COUNT keys requested most (each count over-estimating by a known error at most), and
+// the numbers of requests the node answered and passed on. Counting is done in two windows of
+// HOT_WINDOW_MS, the current one and the one before it, so that a report covers recent traffic.
+// 
+// Reports of several nodes are merged on their way back up a statistics broadcast: the sketches
+// are merged as Space-Saving sketches are (adding the counts of each key, the smallest counts
+// making way for larger ones), and the nodes handling the most requests per second are kept.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_HOT_KEYS_H
+#define CHORD_HOT_KEYS_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The length of a counting window, in milliseconds
+#define HOT_WINDOW_MS                   10000
+
+// The requests counted over a window
+typedef struct
+{
+    chord_hot_key_t keys[HOT_KEY_COUNT];   // The sketch of the keys requested
+    uint64_t served;                 // Requests answered
+    uint64_t passed;                 // Requests passed on to other nodes
+    double start_ms;                 // When the window started (monotonic milliseconds)
+} hot_window_t;
+
+// The requests a node has handled lately
+typedef struct
+{
+    hot_window_t current;            // The window being counted
+    hot_window_t previous;           // The window before it
+} hot_tracker_t;
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: hot_init
+ * 
+ * Clear the counts of a tracker, starting its windows now.
+ * 
+ * param:  The tracker
+ * return: void
+ **************************************************************************************************/
+void hot_init( hot_tracker_t *tracker );
+
+
+/***************************************************************************************************
+ * Function: hot_note_served
+ * 
+ * Count a request the node answered.
+ * 
+ * param:  The tracker
+ * param:  The key
+ * return: void
+ **************************************************************************************************/
+void hot_note_served( hot_tracker_t *tracker, int key );
+
+
+/***************************************************************************************************
+ * Function: hot_note_passed
+ * 
+ * Count a request passed on to another node.
+ * 
+ * param:  The tracker
+ * return: void
+ **************************************************************************************************/
+void hot_note_passed( hot_tracker_t *tracker );
+
+
+/***************************************************************************************************
+ * Function: hot_key_requests
+ * 
+ * Get the number of requests the node has answered for a key lately, as far as the sketch can
+ * vouch for them.
+ * 
+ * param:  The tracker
+ * param:  The key
+ * return: The requests (zero if the key is not among the hot keys)
+ **************************************************************************************************/
+uint64_t hot_key_requests( hot_tracker_t *tracker, int key );
+
+
+/***************************************************************************************************
+ * Function: hot_report
+ * 
+ * Report the requests a node has handled lately, as the only node of a set of statistics.
+ * 
+ * param:  The tracker
+ * param:  The ID of the node
+ * param:  The first key of its arc (-1 if not known)
+ * param:  Holds the report (the hot keys and nodes of the statistics are set)
+ * return: void
+ **************************************************************************************************/
+void hot_report( hot_tracker_t *tracker, int node_id, int first_key, chord_store_stats_t *stats );
+
+
+/***************************************************************************************************
+ * Function: hot_merge
+ * 
+ * Merge the hot keys and nodes of one set of statistics into another.
+ * 
+ * param:  The statistics to merge into
+ * param:  The statistics to merge
+ * return: void
+ **************************************************************************************************/
+void hot_merge( chord_store_stats_t *into, const chord_store_stats_t *from );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
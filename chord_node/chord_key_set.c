@@ -28,7 +28,8 @@
 // Module definitions
 //**************************************************************************************************
 
-// (none)
+// Local prototypes
+static uint64_t keyset_range_mask( chord_key_t first_key, chord_key_t last_key );
 
 
 //**************************************************************************************************
@@ -153,6 +154,93 @@ void keyset_print()
 }
 
 
+/***************************************************************************************************
+ * Function: keyset_get_bitmap
+ * 
+ * Get the raw content of the key set, where each bit corresponds to a key.
+ * 
+ * param:  void
+ * return: The key set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t keyset_get_bitmap()
+{
+    return( key_set );
+}
+
+
+/***************************************************************************************************
+ * Function: keyset_set_bitmap
+ * 
+ * Replace the content of the key set, where each bit corresponds to a key.
+ * 
+ * param:  The new key set as a 64-bit bitmap
+ * return: void
+ **************************************************************************************************/
+void keyset_set_bitmap( uint64_t bitmap )
+{
+    key_set = bitmap;
+}
+
+
+/***************************************************************************************************
+ * Function: keyset_get_range
+ * 
+ * Get the keys of the set that lie in a range, where each bit corresponds to a key.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * return: The keys in the range as a 64-bit bitmap (none if the range is invalid)
+ **************************************************************************************************/
+uint64_t keyset_get_range( chord_key_t first_key, chord_key_t last_key )
+{
+    return( key_set & keyset_range_mask( first_key, last_key ) );
+}
+
+
+/***************************************************************************************************
+ * Function: keyset_remove_range
+ * 
+ * Remove the keys that lie in a range from the set, all at once.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * return: The keys that were removed as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t keyset_remove_range( chord_key_t first_key, chord_key_t last_key )
+{
+    // Local variables
+    uint64_t removed;                 // The keys that were removed
+    
+    removed = key_set & keyset_range_mask( first_key, last_key );
+    key_set &= ~removed;
+    
+    return( removed );
+}
+
+
+/***************************************************************************************************
+ * Function: keyset_range_mask
+ * 
+ * Build the mask of a range of keys: the bits from the first key up to the last, inclusive.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * return: The mask as a 64-bit bitmap (empty if the range is invalid)
+ **************************************************************************************************/
+static uint64_t keyset_range_mask( chord_key_t first_key, chord_key_t last_key )
+{
+    // Local variables
+    uint64_t mask = 0;                // The mask of the range
+    
+    if( ( first_key <= last_key ) && ( last_key < MAX_KEY_VALUE ) )
+    {
+        mask = ( ~0UL >> ( MAX_KEY_VALUE - 1 - last_key ) ) & ~( ( 1UL << first_key ) - 1 );
+    }
+    
+    return( mask );
+}
+
+
 //**************************************************************************************************
 // End of file
 //**************************************************************************************************
@@ -102,6 +102,52 @@ bool keyset_check( chord_key_t key );
 void keyset_print();
 
 
+/***************************************************************************************************
+ * Function: keyset_get_bitmap
+ * 
+ * Get the raw content of the key set, where each bit corresponds to a key.
+ * 
+ * param:  void
+ * return: The key set as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t keyset_get_bitmap();
+
+
+/***************************************************************************************************
+ * Function: keyset_set_bitmap
+ * 
+ * Replace the content of the key set, where each bit corresponds to a key.
+ * 
+ * param:  The new key set as a 64-bit bitmap
+ * return: void
+ **************************************************************************************************/
+void keyset_set_bitmap( uint64_t bitmap );
+
+
+/***************************************************************************************************
+ * Function: keyset_get_range
+ * 
+ * Get the keys of the set that lie in a range, where each bit corresponds to a key.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * return: The keys in the range as a 64-bit bitmap (none if the range is invalid)
+ **************************************************************************************************/
+uint64_t keyset_get_range( chord_key_t first_key, chord_key_t last_key );
+
+
+/***************************************************************************************************
+ * Function: keyset_remove_range
+ * 
+ * Remove the keys that lie in a range from the set, all at once.
+ * 
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * return: The keys that were removed as a 64-bit bitmap
+ **************************************************************************************************/
+uint64_t keyset_remove_range( chord_key_t first_key, chord_key_t last_key );
+
+
 #endif
 
 //**************************************************************************************************
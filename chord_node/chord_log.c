@@ -0,0 +1,537 @@
+//**************************************************************************************************
+// File:   chord_log.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Asynchronous binary event log for node processes. The node's message loop is the only producer
+// and the flushing thread the only consumer of the ring buffer, so the buffer needs no locks: the
+// producer alone advances the head and the consumer alone advances the tail.
+// 
+// A log file holds a header ("CHLG" and a version byte) followed by fixed-size records.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "chord_log.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Log file header
+#define LOG_MAGIC                       "CHLG"
+#define LOG_MAGIC_SIZE                  4
+#define LOG_VERSION                     1
+
+// The number of records the ring buffer holds (a power of two)
+#define LOG_RING_SIZE                   4096
+
+// How long the flushing thread sleeps when the ring buffer is empty
+#define LOG_FLUSH_INTERVAL_NS           5000000
+
+// The longest path of a log file
+#define LOG_PATH_SIZE                   256
+
+// A log record, as stored in the ring buffer and the log file
+typedef struct
+{
+    uint64_t time_ns;                // Monotonic time at which the record was logged
+    uint16_t event;                  // The event (log_event_t)
+    uint8_t level;                   // The level of the record
+    uint8_t node_id;                 // The node that logged the record
+    int32_t args[LOG_MAX_ARGS];      // The arguments of the event
+} log_record_t;
+
+// Local prototypes
+static void log_open_file();
+static void *log_flush_thread( void *unused );
+static void log_write_all( const void *data, size_t size );
+static uint64_t log_now_ns();
+static int log_compare_records( const void *a, const void *b );
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// Flag: "logging is on"
+volatile bool log_active = false;
+
+// The ID of this node (that of the node the process was created for)
+static int log_node_id;
+
+// The node that records are logged for (the node being run, when a process hosts several)
+static int record_node_id;
+
+// The ring buffer, with the next slot to fill (head) and the next record to write out (tail)
+static log_record_t ring[LOG_RING_SIZE];
+static atomic_uint ring_head;
+static atomic_uint ring_tail;
+
+// The number of records lost because the ring buffer was full
+static atomic_uint records_lost;
+
+// The log file descriptor (-1 until the file is created)
+static int log_fd = -1;
+
+// Event formats, for the decoder (indexed by event)
+static const char *event_formats[LOG_EVENT_COUNT] =
+{
+    [LOG_NODE_CREATED] = "Addnode: Node %i (PID: %i, PPID: %i, SUCC: %i) was created",
+    [LOG_NODE_SPAWNED] = "Addnode: Node %i (PID: %i, PPID: %i, SUCC: %i) spawned new node, "
+                         "updated successor",
+    [LOG_NODE_CREATE_FAILED] = "Creation of new node failed (id: %i, errno: %i)",
+    [LOG_ADDNODE_FORWARDED] = "Node %i is forwarding addnode<%i> to successor node %i",
+    [LOG_ANNOUNCE_RECEIVED] = "Node %i received announcement of creation of node %i - "
+                              "redistributing keys now",
+    [LOG_KEY_ADDED] = "Node %i added key %i",
+    [LOG_KEY_REDISTRIBUTED] = "Node %i added redistributed key %i",
+    [LOG_KEY_REMOVED] = "Node %i removed key %i",
+    [LOG_NETEM_DROPPED] = "Netem: dropped message (cmd: %i, id: %i) to node %i",
+    [LOG_NETEM_QUEUE_FULL] = "Netem: queue full, dropped message (cmd: %i, id: %i) to node %i",
+    [LOG_RECORDS_LOST] = "%i log records lost (ring buffer full)",
+    [LOG_REPAIR_TAKEOVER] = "Repair: node %i took over from failed node %i (%i keys restored, "
+                            "from replica: %i)",
+    [LOG_REPAIR_SPLICED] = "Repair: node %i linked past failed node %i to successor node %i",
+    [LOG_NODE_LEAVING] = "Delnode: Node %i is leaving; successor node %i takes over %i keys",
+    [LOG_HANDOFF_RECEIVED] = "Delnode: Node %i took over from departing node %i (%i keys)",
+    [LOG_LEAVE_SPLICED] = "Delnode: Node %i linked past departing node %i to successor node %i",
+    [LOG_SUCCESSOR_FOUND] = "Stabilize: Node %i found node between it and successor node %i; "
+                            "new successor node %i",
+    [LOG_SUCCESSOR_SKIPPED] = "Stabilize: Node %i skipped exited successor node %i; new successor "
+                              "node %i",
+};
+
+// Level names, for the decoder
+static const char *level_names[] = { "NONE", "ERROR", "INFO", "DEBUG" };
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: log_init
+ * 
+ * Set the ID of the node that records are logged for. Logging starts off.
+ * 
+ * param:  The ID of this node
+ * return: void
+ **************************************************************************************************/
+void log_init( int node_id )
+{
+    log_node_id = node_id;
+    record_node_id = node_id;
+    log_active = false;
+}
+
+
+/***************************************************************************************************
+ * Function: log_after_fork
+ * 
+ * Prepare the log in a newly forked node process: records and the log file inherited from the
+ * parent are discarded (the flushing thread does not survive the fork), and logging continues
+ * into a file of the new node's own if it was on.
+ * 
+ * param:  The ID of the new node
+ * return: void
+ **************************************************************************************************/
+void log_after_fork( int node_id )
+{
+    log_node_id = node_id;
+    record_node_id = node_id;
+    atomic_store( &ring_head, 0 );
+    atomic_store( &ring_tail, 0 );
+    atomic_store( &records_lost, 0 );
+
+    if( log_fd >= 0 )
+    {
+        close( log_fd );
+        log_fd = -1;
+    }
+
+    if( log_active == true )
+    {
+        log_enable();
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: log_set_node
+ * 
+ * Set the node that records are logged for from now on, as a process that hosts several nodes
+ * runs each in turn. The log file stays that of the node the process was created for.
+ * 
+ * param:  The ID of the node being run
+ * return: void
+ **************************************************************************************************/
+void log_set_node( int node_id )
+{
+    record_node_id = node_id;
+}
+
+
+/***************************************************************************************************
+ * Function: log_enable
+ * 
+ * Turn logging on, creating the node's log file and flushing thread the first time.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void log_enable()
+{
+    if( log_fd < 0 )
+    {
+        log_open_file();
+    }
+
+    log_active = ( log_fd >= 0 );
+}
+
+
+/***************************************************************************************************
+ * Function: log_disable
+ * 
+ * Turn logging off. Records already logged are still written to the log file.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void log_disable()
+{
+    log_active = false;
+}
+
+
+/***************************************************************************************************
+ * Function: log_write
+ * 
+ * Store a record in the ring buffer, timestamped now. This never blocks: if the buffer is full,
+ * the record is counted as lost. Use the LOG_* macros rather than calling this directly.
+ * 
+ * param:  The level of the record
+ * param:  The event
+ * param:  The arguments of the event
+ * return: void
+ **************************************************************************************************/
+void log_write( int level, log_event_t event, const int32_t args[LOG_MAX_ARGS] )
+{
+    // Local variables
+    unsigned int head;               // The slot to fill
+    log_record_t *record;            // The record in that slot
+
+    head = atomic_load_explicit( &ring_head, memory_order_relaxed );
+
+    if( head - atomic_load_explicit( &ring_tail, memory_order_acquire ) == LOG_RING_SIZE )
+    {
+        atomic_fetch_add_explicit( &records_lost, 1, memory_order_relaxed );
+        return;
+    }
+
+    record = &ring[head % LOG_RING_SIZE];
+    record->time_ns = log_now_ns();
+    record->event = (uint16_t)event;
+    record->level = (uint8_t)level;
+    record->node_id = (uint8_t)record_node_id;
+    memcpy( record->args, args, sizeof( record->args ) );
+
+    // Publish the record to the flushing thread
+    atomic_store_explicit( &ring_head, head + 1, memory_order_release );
+}
+
+
+/***************************************************************************************************
+ * Function: log_decode
+ * 
+ * Render log files as text on the standard output, merging the records of every file in time
+ * order.
+ * 
+ * param:  The number of log files
+ * param:  The paths of the log files
+ * return: The program exit status
+ **************************************************************************************************/
+int log_decode( int file_count, char **paths )
+{
+    // Local variables
+    log_record_t *records = NULL;    // Records read from every file
+    log_record_t *resized;           // The record array after growing it
+    size_t record_count = 0;         // The number of records read
+    size_t capacity = 0;             // The number of records the array holds
+    char header[LOG_MAGIC_SIZE + 1]; // A log file header
+    const log_record_t *record;      // A record being printed
+    FILE *file;                      // A log file
+
+    if( file_count < 1 )
+    {
+        fputs( "Usage: chord_node --decode-log <log file>...\n", stderr );
+        return( EXIT_FAILURE );
+    }
+
+    for( int index = 0; index < file_count; index++ )
+    {
+        file = fopen( paths[index], "rb" );
+
+        if( ( file == NULL ) ||
+            ( fread( header, 1, sizeof( header ), file ) != sizeof( header ) ) ||
+            ( memcmp( header, LOG_MAGIC, LOG_MAGIC_SIZE ) != 0 ) ||
+            ( header[LOG_MAGIC_SIZE] != LOG_VERSION ) )
+        {
+            fprintf( stderr, "%s is not a node log file\n", paths[index] );
+
+            if( file != NULL )
+            {
+                fclose( file );
+            }
+
+            free( records );
+            return( EXIT_FAILURE );
+        }
+
+        while( true )
+        {
+            if( record_count == capacity )
+            {
+                capacity = ( capacity == 0 ) ? LOG_RING_SIZE : capacity * 2;
+                resized = realloc( records, capacity * sizeof( log_record_t ) );
+
+                if( resized == NULL )
+                {
+                    fputs( "Out of memory\n", stderr );
+                    fclose( file );
+                    free( records );
+                    return( EXIT_FAILURE );
+                }
+
+                records = resized;
+            }
+
+            // A partial record at the end (the node was killed mid-write) is ignored
+            if( fread( &records[record_count], sizeof( log_record_t ), 1, file ) != 1 )
+            {
+                break;
+            }
+
+            record_count++;
+        }
+
+        fclose( file );
+    }
+
+    qsort( records, record_count, sizeof( log_record_t ), log_compare_records );
+
+    for( size_t index = 0; index < record_count; index++ )
+    {
+        record = &records[index];
+        printf( "%12.6f node %2i %-5s ", ( record->time_ns - records[0].time_ns ) / 1.0e9,
+                record->node_id, ( record->level <= LOG_LEVEL_DEBUG ) ?
+                    level_names[record->level] : "?" );
+
+        if( ( record->event < LOG_EVENT_COUNT ) && ( event_formats[record->event] != NULL ) )
+        {
+            printf( event_formats[record->event], record->args[0], record->args[1],
+                    record->args[2], record->args[3] );
+        }
+        else
+        {
+            printf( "Unknown event %i (%i, %i, %i, %i)", record->event, record->args[0],
+                    record->args[1], record->args[2], record->args[3] );
+        }
+
+        printf( "\n" );
+    }
+
+    free( records );
+
+    return( EXIT_SUCCESS );
+}
+
+
+/***************************************************************************************************
+ * Function: log_open_file
+ * 
+ * Create the node's log file and start the thread that flushes records to it. On failure,
+ * logging stays off.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void log_open_file()
+{
+    // Local variables
+    char path[LOG_PATH_SIZE];        // The path of the log file
+    const char *directory;           // The directory for log files
+    const char header[] = { LOG_MAGIC[0], LOG_MAGIC[1], LOG_MAGIC[2], LOG_MAGIC[3], LOG_VERSION };
+    pthread_t thread;                // The flushing thread
+
+    directory = getenv( LOG_DIR_ENV_VAR );
+    snprintf( path, sizeof( path ), "%s/chord_node_%i.clog",
+              ( directory != NULL ) ? directory : ".", log_node_id );
+
+    log_fd = open( path, O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+
+    if( log_fd < 0 )
+    {
+        fprintf( stderr, "Node %i: unable to create log file %s\n", log_node_id, path );
+        return;
+    }
+
+    log_write_all( header, sizeof( header ) );
+
+    if( pthread_create( &thread, NULL, log_flush_thread, NULL ) != 0 )
+    {
+        fprintf( stderr, "Node %i: unable to start log thread\n", log_node_id );
+        close( log_fd );
+        log_fd = -1;
+        return;
+    }
+
+    pthread_detach( thread );
+}
+
+
+/***************************************************************************************************
+ * Function: log_flush_thread
+ * 
+ * Flushing thread: write records from the ring buffer to the log file as they arrive, in
+ * batches, and note any records that were lost.
+ * 
+ * param:  Unused
+ * return: Never returns
+ **************************************************************************************************/
+static void *log_flush_thread( void *unused )
+{
+    // Local variables
+    const struct timespec interval = { 0, LOG_FLUSH_INTERVAL_NS };
+    log_record_t lost_record;        // Records the number of records lost
+    unsigned int head;               // The next slot the node will fill
+    unsigned int tail;               // The next record to write out
+    unsigned int count;              // Records that can be written in one go
+    unsigned int lost;               // Records lost since the last check
+
+    while( true )
+    {
+        tail = atomic_load_explicit( &ring_tail, memory_order_relaxed );
+        head = atomic_load_explicit( &ring_head, memory_order_acquire );
+
+        if( head == tail )
+        {
+            nanosleep( &interval, NULL );
+            continue;
+        }
+
+        // Write up to the end of the buffer (the rest, if any, on the next pass)
+        count = head - tail;
+
+        if( ( tail % LOG_RING_SIZE ) + count > LOG_RING_SIZE )
+        {
+            count = LOG_RING_SIZE - ( tail % LOG_RING_SIZE );
+        }
+
+        log_write_all( &ring[tail % LOG_RING_SIZE], count * sizeof( log_record_t ) );
+
+        // Free the slots for the node
+        atomic_store_explicit( &ring_tail, tail + count, memory_order_release );
+
+        lost = atomic_exchange_explicit( &records_lost, 0, memory_order_relaxed );
+
+        if( lost > 0 )
+        {
+            memset( &lost_record, 0, sizeof( lost_record ) );
+            lost_record.time_ns = log_now_ns();
+            lost_record.event = LOG_RECORDS_LOST;
+            lost_record.level = LOG_LEVEL_ERROR;
+            lost_record.node_id = (uint8_t)log_node_id;
+            lost_record.args[0] = (int32_t)lost;
+            log_write_all( &lost_record, sizeof( lost_record ) );
+        }
+    }
+
+    return( unused );
+}
+
+
+/***************************************************************************************************
+ * Function: log_write_all
+ * 
+ * Write a block of data to the log file, continuing after partial writes.
+ * 
+ * param:  The data to write
+ * param:  The size of the data, in bytes
+ * return: void
+ **************************************************************************************************/
+static void log_write_all( const void *data, size_t size )
+{
+    // Local variables
+    const char *position = data;     // The data not yet written
+    ssize_t written;                 // Bytes written by one call
+
+    while( size > 0 )
+    {
+        written = write( log_fd, position, size );
+
+        if( written <= 0 )
+        {
+            return;
+        }
+
+        position += written;
+        size -= written;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: log_now_ns
+ * 
+ * Read the monotonic clock (shared by every node process, so records can be merged).
+ * 
+ * param:  void
+ * return: The current time, in nanoseconds
+ **************************************************************************************************/
+static uint64_t log_now_ns()
+{
+    // Local variables
+    struct timespec now;             // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec );
+}
+
+
+/***************************************************************************************************
+ * Function: log_compare_records
+ * 
+ * Order log records by time (for qsort).
+ * 
+ * param:  The first record
+ * param:  The second record
+ * return: Negative, zero or positive as the first record is earlier, simultaneous or later
+ **************************************************************************************************/
+static int log_compare_records( const void *a, const void *b )
+{
+    // Local variables
+    const log_record_t *first = a;   // The first record
+    const log_record_t *second = b;  // The second record
+
+    return( ( first->time_ns > second->time_ns ) - ( first->time_ns < second->time_ns ) );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
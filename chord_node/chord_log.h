@@ -0,0 +1,203 @@
+//**************************************************************************************************
+// File:   chord_log.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Asynchronous binary event log for node processes. Rather than formatting text on the message
+// path, a node stores fixed-size binary records (an event number and up to four integers) in a
+// lock-free ring buffer, and a background thread writes them to a log file of its own. The log
+// files are rendered as text offline, with "chord_node --decode-log <files>".
+// 
+// Levels above CHORD_LOG_LEVEL (set at compile time) are removed entirely, and the arguments of
+// the remaining log statements are only evaluated while logging is on.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_LOG_H
+#define CHORD_LOG_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Log levels
+#define LOG_LEVEL_NONE                  0
+#define LOG_LEVEL_ERROR                 1
+#define LOG_LEVEL_INFO                  2
+#define LOG_LEVEL_DEBUG                 3
+
+// The most detailed level compiled in (e.g. -DCHORD_LOG_LEVEL=1 keeps only errors)
+#ifndef CHORD_LOG_LEVEL
+#define CHORD_LOG_LEVEL                 LOG_LEVEL_DEBUG
+#endif
+
+// The number of integer arguments a record holds
+#define LOG_MAX_ARGS                    4
+
+// The environment variable naming the directory for log files (default: working directory)
+#define LOG_DIR_ENV_VAR                 "CHORD_LOG_DIR"
+
+// Log events (each is rendered by the decoder with its own format)
+typedef enum
+{
+    LOG_NODE_CREATED = 0,            // Node ID, PID, parent PID, successor ID
+    LOG_NODE_SPAWNED,                // Node ID, PID, parent PID, successor ID
+    LOG_NODE_CREATE_FAILED,          // New node ID, errno
+    LOG_ADDNODE_FORWARDED,           // Node ID, new node ID, successor ID
+    LOG_ANNOUNCE_RECEIVED,           // Node ID, new node ID
+    LOG_KEY_ADDED,                   // Node ID, key
+    LOG_KEY_REDISTRIBUTED,           // Node ID, key
+    LOG_KEY_REMOVED,                 // Node ID, key
+    LOG_NETEM_DROPPED,               // Command, message ID, destination node ID
+    LOG_NETEM_QUEUE_FULL,            // Command, message ID, destination node ID
+    LOG_RECORDS_LOST,                // Number of records lost because the ring buffer was full
+    LOG_REPAIR_TAKEOVER,             // Node ID, failed node ID, keys restored, from replica (0/1)
+    LOG_REPAIR_SPLICED,              // Node ID, failed node ID, new successor ID
+    LOG_NODE_LEAVING,                // Node ID, successor ID, keys handed off
+    LOG_HANDOFF_RECEIVED,            // Node ID, departing node ID, keys taken over
+    LOG_LEAVE_SPLICED,               // Node ID, departing node ID, new successor ID
+    LOG_SUCCESSOR_FOUND,             // Node ID, old successor ID, new successor ID
+    LOG_SUCCESSOR_SKIPPED,           // Node ID, exited successor ID, new successor ID
+    LOG_EVENT_COUNT
+} log_event_t;
+
+// Log statements, by level
+#define LOG_WRITE( level, event, ... )                                                          \
+    do                                                                                          \
+    {                                                                                           \
+        if( log_active )                                                                        \
+        {                                                                                       \
+            log_write( (level), (event), (const int32_t[LOG_MAX_ARGS]){ __VA_ARGS__ } );        \
+        }                                                                                       \
+    } while( 0 )
+
+#if CHORD_LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR( event, ... )         LOG_WRITE( LOG_LEVEL_ERROR, event, __VA_ARGS__ )
+#else
+#define LOG_ERROR( event, ... )         ( (void)0 )
+#endif
+
+#if CHORD_LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO( event, ... )          LOG_WRITE( LOG_LEVEL_INFO, event, __VA_ARGS__ )
+#else
+#define LOG_INFO( event, ... )          ( (void)0 )
+#endif
+
+#if CHORD_LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG( event, ... )         LOG_WRITE( LOG_LEVEL_DEBUG, event, __VA_ARGS__ )
+#else
+#define LOG_DEBUG( event, ... )         ( (void)0 )
+#endif
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// Flag: "logging is on" (checked by the log statements before evaluating their arguments)
+extern volatile bool log_active;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: log_init
+ * 
+ * Set the ID of the node that records are logged for. Logging starts off.
+ * 
+ * param:  The ID of this node
+ * return: void
+ **************************************************************************************************/
+void log_init( int node_id );
+
+
+/***************************************************************************************************
+ * Function: log_after_fork
+ * 
+ * Prepare the log in a newly forked node process: records and the log file inherited from the
+ * parent are discarded (the flushing thread does not survive the fork), and logging continues
+ * into a file of the new node's own if it was on.
+ * 
+ * param:  The ID of the new node
+ * return: void
+ **************************************************************************************************/
+void log_after_fork( int node_id );
+
+
+/***************************************************************************************************
+ * Function: log_set_node
+ * 
+ * Set the node that records are logged for from now on, as a process that hosts several nodes
+ * runs each in turn. The log file stays that of the node the process was created for.
+ * 
+ * param:  The ID of the node being run
+ * return: void
+ **************************************************************************************************/
+void log_set_node( int node_id );
+
+
+/***************************************************************************************************
+ * Function: log_enable
+ * 
+ * Turn logging on, creating the node's log file and flushing thread the first time.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void log_enable();
+
+
+/***************************************************************************************************
+ * Function: log_disable
+ * 
+ * Turn logging off. Records already logged are still written to the log file.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void log_disable();
+
+
+/***************************************************************************************************
+ * Function: log_write
+ * 
+ * Store a record in the ring buffer, timestamped now. This never blocks: if the buffer is full,
+ * the record is counted as lost. Use the LOG_* macros rather than calling this directly.
+ * 
+ * param:  The level of the record
+ * param:  The event
+ * param:  The arguments of the event
+ * return: void
+ **************************************************************************************************/
+void log_write( int level, log_event_t event, const int32_t args[LOG_MAX_ARGS] );
+
+
+/***************************************************************************************************
+ * Function: log_decode
+ * 
+ * Render log files as text on the standard output, merging the records of every file in time
+ * order.
+ * 
+ * param:  The number of log files
+ * param:  The paths of the log files
+ * return: The program exit status
+ **************************************************************************************************/
+int log_decode( int file_count, char **paths );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,754 @@
+//**************************************************************************************************
+// File:   chord_netem.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Network condition emulation for the node transport. Messages sent by a node are held in a
+// queue, ordered by the time they are due, until the node's message loop flushes them to the
+// underlying transport. See chord_netem.h for the link specification.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "chord_config.h"
+#include "chord_log.h"
+#include "chord_netem.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The most rules a link specification may hold
+#define NETEM_MAX_RULES                 32
+
+// The most messages a node may hold back at once; further messages are dropped, as by a full
+// network queue
+#define NETEM_QUEUE_LIMIT               1024
+
+// Matches any node in a link rule
+#define NETEM_ANY_NODE                  -1
+
+// Parameters given by a rule
+#define NETEM_PARAM_DELAY               0x01
+#define NETEM_PARAM_JITTER              0x02
+#define NETEM_PARAM_RATE                0x04
+#define NETEM_PARAM_LOSS                0x08
+#define NETEM_PARAM_REORDER             0x10
+
+// The conditions on a link
+typedef struct
+{
+    int64_t delay_us;                // Fixed one-way delay, in microseconds
+    int64_t jitter_us;               // Maximum deviation from the delay, in microseconds
+    double rate;                     // Bandwidth cap, in bytes per second (zero for none)
+    double loss;                     // Probability of dropping a message, in percent
+    double reorder;                  // Probability of sending a message at once, in percent
+} netem_link_t;
+
+// A rule of the link specification
+typedef struct
+{
+    int src_id;                      // The sending node (or NETEM_ANY_NODE)
+    int dest_id;                     // The receiving node (or NETEM_ANY_NODE)
+    unsigned int params;             // The parameters given by the rule (NETEM_PARAM_*)
+    netem_link_t link;               // The values of those parameters
+} netem_rule_t;
+
+// A message being held back
+typedef struct
+{
+    int64_t due_us;                  // The time at which the message is due to be sent
+    int dest_id;                     // The node the message is sent to
+    chord_msg_t msg;                 // The message
+    char *payload;                   // A copy of the message's payload (NULL if it has none)
+} netem_entry_t;
+
+// Local prototypes
+static void netem_send( int dest_id, const chord_msg_t *msg );
+static void netem_reply( const chord_msg_t *msg );
+static pid_t netem_spawn( const chord_msg_t *msg );
+static int netem_backlog();
+static void netem_configure( int id );
+static void netem_resolve();
+static bool netem_parse( char *spec );
+static bool netem_parse_rule( char *text, netem_rule_t *rule );
+static bool netem_parse_node( const char *text, int *id );
+static bool netem_parse_value( const char *text, const char *units[], const double scales[],
+                               double *value );
+static int64_t netem_now_us();
+static double netem_random_percent();
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// The transport that emulates network conditions (values are moved in messages, never in bulk, so
+// that they are held back like any others)
+static const chord_transport_t netem_transport = { netem_send, netem_reply, netem_spawn,
+                                                    netem_backlog, NULL };
+
+// The transport that messages are handed to once they are due
+static const chord_transport_t *inner_transport = NULL;
+
+// The rules of the link specification
+static netem_rule_t rules[NETEM_MAX_RULES];
+static int rule_count = 0;
+
+// The ID of the node the process was created for (the sender of messages that name no node)
+static int local_node_id = 0;
+
+// The conditions on the links between every pair of nodes, by sender and then receiver (a process
+// may host several virtual nodes, each sending on its own links)
+static netem_link_t links[MAX_NODE_COUNT][MAX_NODE_COUNT];
+
+// The time at which each link finishes sending what has been sent on it (for the bandwidth cap)
+static int64_t link_free_us[MAX_NODE_COUNT][MAX_NODE_COUNT];
+
+// The latest due time on each link, so that messages on a link are not reordered by jitter
+static int64_t last_due_us[MAX_NODE_COUNT][MAX_NODE_COUNT];
+
+// Messages being held back, sorted latest due first (so the next due is at the end); messages
+// due at the same time are sent in the order they were queued
+static netem_entry_t queue[NETEM_QUEUE_LIMIT];
+static int queue_count = 0;
+
+// Random number generator state
+static unsigned int random_seed;
+
+// Time suffixes (default microseconds) and rate suffixes (default bytes per second)
+static const char *time_units[] = { "us", "ms", "s", NULL };
+static const double time_scales[] = { 1.0, 1000.0, 1000000.0 };
+static const char *rate_units[] = { "k", "m", NULL };
+static const double rate_scales[] = { 1000.0, 1000000.0 };
+static const char *no_units[] = { NULL };
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: netem_wrap
+ * 
+ * Wrap a transport so that messages sent through it are subject to the emulated network
+ * conditions. If no link specification is set (or it is invalid), the transport is returned
+ * unchanged. Nodes created through the wrapped transport emulate their own links.
+ * 
+ * param:  The underlying transport
+ * param:  The ID of this node
+ * return: The transport to use
+ **************************************************************************************************/
+const chord_transport_t *netem_wrap( const chord_transport_t *inner, int local_id )
+{
+    // Local variables
+    const char *env_spec;            // The link specification in the environment
+    char *spec;                      // A copy of the specification, for parsing
+    bool valid;                      // Flag: "the specification is valid"
+
+    env_spec = getenv( NETEM_ENV_VAR );
+
+    if( ( env_spec == NULL ) || ( env_spec[0] == '\0' ) )
+    {
+        return( inner );
+    }
+
+    spec = strdup( env_spec );
+    valid = ( spec != NULL ) && netem_parse( spec );
+    free( spec );
+
+    if( valid == false )
+    {
+        fprintf( stderr, "Ignoring invalid %s specification: %s\n", NETEM_ENV_VAR, env_spec );
+        return( inner );
+    }
+
+    inner_transport = inner;
+    netem_resolve();
+    netem_configure( local_id );
+
+    return( &netem_transport );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_flush
+ * 
+ * Send every delayed message that is due to the underlying transport. This should be called
+ * regularly from the node's message loop.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void netem_flush()
+{
+    // Local variables
+    int64_t now_us;                  // The current time
+    chord_payload_msg_t out;         // A message with a payload, as it is sent
+
+    if( queue_count == 0 )
+    {
+        return;
+    }
+
+    now_us = netem_now_us();
+
+    while( ( queue_count > 0 ) && ( queue[queue_count - 1].due_us <= now_us ) )
+    {
+        queue_count--;
+
+        if( queue[queue_count].payload == NULL )
+        {
+            inner_transport->send( queue[queue_count].dest_id, &queue[queue_count].msg );
+        }
+        else
+        {
+            out.msg = queue[queue_count].msg;
+            memcpy( out.payload, queue[queue_count].payload,
+                    MSG_PAYLOAD_LENGTH( &queue[queue_count].msg ) );
+            free( queue[queue_count].payload );
+            inner_transport->send( queue[queue_count].dest_id, &out.msg );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: netem_next_due_ms
+ * 
+ * Determine how long a node may wait for incoming messages before it has delayed messages to
+ * send.
+ * 
+ * param:  void
+ * return: Milliseconds until the next delayed message is due (rounded up), or -1 if none are
+ *         waiting
+ **************************************************************************************************/
+int netem_next_due_ms()
+{
+    // Local variables
+    int64_t wait_us;                 // Time until the next message is due
+
+    if( queue_count == 0 )
+    {
+        return( -1 );
+    }
+
+    wait_us = queue[queue_count - 1].due_us - netem_now_us();
+
+    return( ( wait_us > 0 ) ? (int)( ( wait_us + 999 ) / 1000 ) : 0 );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_send
+ * 
+ * Transport hook: apply the conditions of the link to a message, then either send it at once or
+ * hold it back until it is due. The link is the one from the node named as the message's sender
+ * (or from the node the process was created for, if it names none) to the destination.
+ * 
+ * param:  The ID of the destination node
+ * param:  The message to send
+ * return: void
+ **************************************************************************************************/
+static void netem_send( int dest_id, const chord_msg_t *msg )
+{
+    // Local variables
+    int src_id;                              // The node sending the message
+    netem_link_t *link;                      // The conditions on the link
+    int64_t now_us;                          // The current time
+    int64_t due_us;                          // The time at which the message is due
+    int position;                            // Where the message is placed in the queue
+    int length;                              // The length of the message's payload
+    char *payload = NULL;                    // A copy of the payload, while the message waits
+
+    // Send anything already due first, so that this message cannot overtake it
+    netem_flush();
+
+    src_id = ( ( msg->sender >= 0 ) && ( msg->sender < MAX_NODE_COUNT ) ) ? msg->sender :
+                                                                             local_node_id;
+    link = &links[src_id][dest_id];
+
+    if( netem_random_percent() < link->loss )
+    {
+        LOG_DEBUG( LOG_NETEM_DROPPED, msg->cmd, msg->id, dest_id );
+        return;
+    }
+
+    if( netem_random_percent() < link->reorder )
+    {
+        inner_transport->send( dest_id, msg );
+        return;
+    }
+
+    // Queue behind earlier messages on the link, if it is bandwidth limited
+    now_us = netem_now_us();
+    due_us = now_us;
+    length = MSG_PAYLOAD_LENGTH( msg );
+
+    if( link->rate > 0.0 )
+    {
+        due_us = ( link_free_us[src_id][dest_id] > now_us ) ? link_free_us[src_id][dest_id] :
+                                                               now_us;
+        due_us += (int64_t)( ( sizeof( *msg ) + length ) * 1000000.0 / link->rate );
+        link_free_us[src_id][dest_id] = due_us;
+    }
+
+    // Add the delay and jitter, without overtaking earlier messages on the link
+    due_us += link->delay_us;
+
+    if( link->jitter_us > 0 )
+    {
+        due_us += (int64_t)( rand_r( &random_seed ) % ( 2 * link->jitter_us + 1 ) ) -
+                  link->jitter_us;
+    }
+
+    if( due_us < last_due_us[src_id][dest_id] )
+    {
+        due_us = last_due_us[src_id][dest_id];
+    }
+
+    last_due_us[src_id][dest_id] = due_us;
+
+    if( due_us <= now_us )
+    {
+        inner_transport->send( dest_id, msg );
+        return;
+    }
+
+    if( ( length > 0 ) && ( queue_count < NETEM_QUEUE_LIMIT ) )
+    {
+        payload = malloc( length );
+    }
+
+    if( ( queue_count == NETEM_QUEUE_LIMIT ) || ( ( length > 0 ) && ( payload == NULL ) ) )
+    {
+        LOG_DEBUG( LOG_NETEM_QUEUE_FULL, msg->cmd, msg->id, dest_id );
+        return;
+    }
+
+    // Insert ahead of messages due no later (most messages are due last, so search from the front)
+    position = 0;
+
+    while( ( position < queue_count ) && ( queue[position].due_us > due_us ) )
+    {
+        position++;
+    }
+
+    memmove( &queue[position + 1], &queue[position],
+             ( queue_count - position ) * sizeof( netem_entry_t ) );
+
+    queue[position].due_us = due_us;
+    queue[position].dest_id = dest_id;
+    queue[position].msg = *msg;
+    queue[position].payload = payload;
+    queue_count++;
+
+    if( payload != NULL )
+    {
+        memcpy( payload, msg + 1, length );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: netem_reply
+ * 
+ * Transport hook: send a reply to the menu process, unaffected by the emulated conditions.
+ * 
+ * param:  The reply to send
+ * return: void
+ **************************************************************************************************/
+static void netem_reply( const chord_msg_t *msg )
+{
+    inner_transport->reply( msg );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_spawn
+ * 
+ * Transport hook: create a new node. The new node discards the messages held back by the node
+ * that created it (which that node still sends), and starts its links afresh.
+ * 
+ * param:  The "addnode" message that causes the node to be created
+ * return: As the underlying transport
+ **************************************************************************************************/
+static pid_t netem_spawn( const chord_msg_t *msg )
+{
+    // Local variables
+    pid_t process_id;                // Result of creating the node
+
+    process_id = inner_transport->spawn( msg );
+
+    if( process_id == 0 )
+    {
+        netem_configure( msg->id );
+    }
+
+    return( process_id );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_backlog
+ * 
+ * Transport hook: measure the messages waiting for this node, as the underlying transport.
+ * 
+ * param:  void
+ * return: The number of bytes waiting
+ **************************************************************************************************/
+static int netem_backlog()
+{
+    return( inner_transport->backlog() );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_configure
+ * 
+ * Start a node's process with idle links and no messages held back. Messages held back by the
+ * process it was forked from are still sent by that process, so their copies are freed here.
+ * 
+ * param:  The ID of the node the process is for
+ * return: void
+ **************************************************************************************************/
+static void netem_configure( int id )
+{
+    for( int index = 0; index < queue_count; index++ )
+    {
+        free( queue[index].payload );
+    }
+
+    memset( link_free_us, 0, sizeof( link_free_us ) );
+    memset( last_due_us, 0, sizeof( last_due_us ) );
+    queue_count = 0;
+    local_node_id = ( ( id >= 0 ) && ( id < MAX_NODE_COUNT ) ) ? id : 0;
+    random_seed = (unsigned int)getpid() ^ (unsigned int)netem_now_us();
+}
+
+
+/***************************************************************************************************
+ * Function: netem_resolve
+ * 
+ * Resolve the conditions on the links between every pair of nodes from the rule list.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void netem_resolve()
+{
+    // Local variables
+    const netem_rule_t *rule;        // A rule of the specification
+    netem_link_t *link;              // The link being resolved
+
+    memset( links, 0, sizeof( links ) );
+
+    for( int src_id = 0; src_id < MAX_NODE_COUNT; src_id++ )
+    {
+        for( int dest_id = 0; dest_id < MAX_NODE_COUNT; dest_id++ )
+        {
+            link = &links[src_id][dest_id];
+
+            for( int index = 0; index < rule_count; index++ )
+            {
+                rule = &rules[index];
+
+                if( ( ( rule->src_id != NETEM_ANY_NODE ) && ( rule->src_id != src_id ) ) ||
+                    ( ( rule->dest_id != NETEM_ANY_NODE ) && ( rule->dest_id != dest_id ) ) )
+                {
+                    continue;
+                }
+
+                if( rule->params & NETEM_PARAM_DELAY )
+                {
+                    link->delay_us = rule->link.delay_us;
+                }
+
+                if( rule->params & NETEM_PARAM_JITTER )
+                {
+                    link->jitter_us = rule->link.jitter_us;
+                }
+
+                if( rule->params & NETEM_PARAM_RATE )
+                {
+                    link->rate = rule->link.rate;
+                }
+
+                if( rule->params & NETEM_PARAM_LOSS )
+                {
+                    link->loss = rule->link.loss;
+                }
+
+                if( rule->params & NETEM_PARAM_REORDER )
+                {
+                    link->reorder = rule->link.reorder;
+                }
+            }
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: netem_parse
+ * 
+ * Parse a link specification into the rule list.
+ * 
+ * param:  The specification (modified while parsing)
+ * return: True if the specification is valid
+ **************************************************************************************************/
+static bool netem_parse( char *spec )
+{
+    // Local variables
+    char *save;                      // strtok_r state
+    char *text;                      // The text of a rule
+
+    rule_count = 0;
+
+    for( text = strtok_r( spec, ";", &save ); text != NULL; text = strtok_r( NULL, ";", &save ) )
+    {
+        if( ( rule_count == NETEM_MAX_RULES ) ||
+            ( netem_parse_rule( text, &rules[rule_count] ) == false ) )
+        {
+            return( false );
+        }
+
+        rule_count++;
+    }
+
+    return( rule_count > 0 );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_parse_rule
+ * 
+ * Parse a rule of the link specification: an optional "src>dst:" link, then parameters.
+ * 
+ * param:  The text of the rule (modified while parsing)
+ * param:  Holds the parsed rule
+ * return: True if the rule is valid
+ **************************************************************************************************/
+static bool netem_parse_rule( char *text, netem_rule_t *rule )
+{
+    // Local variables
+    char *save;                      // strtok_r state
+    char *param;                     // The text of a parameter
+    char *value;                     // The value of the parameter
+    char *separator;                 // The end of the link
+    double number;                   // The parsed value
+
+    memset( rule, 0, sizeof( *rule ) );
+    rule->src_id = NETEM_ANY_NODE;
+    rule->dest_id = NETEM_ANY_NODE;
+
+    // Link
+    separator = strchr( text, ':' );
+
+    if( separator != NULL )
+    {
+        *separator = '\0';
+        value = strchr( text, '>' );
+
+        if( value == NULL )
+        {
+            return( false );
+        }
+
+        *value++ = '\0';
+
+        if( ( netem_parse_node( text, &rule->src_id ) == false ) ||
+            ( netem_parse_node( value, &rule->dest_id ) == false ) )
+        {
+            return( false );
+        }
+
+        text = separator + 1;
+    }
+
+    // Parameters
+    for( param = strtok_r( text, ",", &save ); param != NULL; param = strtok_r( NULL, ",", &save ) )
+    {
+        value = strchr( param, '=' );
+
+        if( value == NULL )
+        {
+            return( false );
+        }
+
+        *value++ = '\0';
+
+        if( strcmp( param, "delay" ) == 0 )
+        {
+            if( netem_parse_value( value, time_units, time_scales, &number ) == false )
+            {
+                return( false );
+            }
+
+            rule->link.delay_us = (int64_t)number;
+            rule->params |= NETEM_PARAM_DELAY;
+        }
+        else if( strcmp( param, "jitter" ) == 0 )
+        {
+            if( netem_parse_value( value, time_units, time_scales, &number ) == false )
+            {
+                return( false );
+            }
+
+            rule->link.jitter_us = (int64_t)number;
+            rule->params |= NETEM_PARAM_JITTER;
+        }
+        else if( strcmp( param, "rate" ) == 0 )
+        {
+            if( netem_parse_value( value, rate_units, rate_scales, &rule->link.rate ) == false )
+            {
+                return( false );
+            }
+
+            rule->params |= NETEM_PARAM_RATE;
+        }
+        else if( strcmp( param, "loss" ) == 0 )
+        {
+            if( ( netem_parse_value( value, no_units, NULL, &rule->link.loss ) == false ) ||
+                ( rule->link.loss > 100.0 ) )
+            {
+                return( false );
+            }
+
+            rule->params |= NETEM_PARAM_LOSS;
+        }
+        else if( strcmp( param, "reorder" ) == 0 )
+        {
+            if( ( netem_parse_value( value, no_units, NULL, &rule->link.reorder ) == false ) ||
+                ( rule->link.reorder > 100.0 ) )
+            {
+                return( false );
+            }
+
+            rule->params |= NETEM_PARAM_REORDER;
+        }
+        else
+        {
+            return( false );
+        }
+    }
+
+    return( rule->params != 0 );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_parse_node
+ * 
+ * Parse one end of a link: a node ID, or '*' for any node.
+ * 
+ * param:  The text to parse
+ * param:  Holds the node ID (or NETEM_ANY_NODE)
+ * return: True if the text is valid
+ **************************************************************************************************/
+static bool netem_parse_node( const char *text, int *id )
+{
+    // Local variables
+    char *end;                       // The end of the parsed number
+
+    if( strcmp( text, "*" ) == 0 )
+    {
+        *id = NETEM_ANY_NODE;
+        return( true );
+    }
+
+    *id = (int)strtol( text, &end, 10 );
+
+    return( ( end != text ) && ( *end == '\0' ) && ( *id >= 0 ) && ( *id < MAX_NODE_COUNT ) );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_parse_value
+ * 
+ * Parse a non-negative number with an optional unit suffix.
+ * 
+ * param:  The text to parse
+ * param:  The allowed suffixes (terminated by NULL)
+ * param:  The scale applied by each suffix
+ * param:  Holds the scaled value
+ * return: True if the text is valid
+ **************************************************************************************************/
+static bool netem_parse_value( const char *text, const char *units[], const double scales[],
+                               double *value )
+{
+    // Local variables
+    char *end;                       // The end of the parsed number
+
+    *value = strtod( text, &end );
+
+    if( ( end == text ) || ( *value < 0.0 ) )
+    {
+        return( false );
+    }
+
+    if( *end == '\0' )
+    {
+        return( true );
+    }
+
+    for( int index = 0; units[index] != NULL; index++ )
+    {
+        if( strcmp( end, units[index] ) == 0 )
+        {
+            *value *= scales[index];
+            return( true );
+        }
+    }
+
+    return( false );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_now_us
+ * 
+ * Read the monotonic clock.
+ * 
+ * param:  void
+ * return: The current time, in microseconds
+ **************************************************************************************************/
+static int64_t netem_now_us()
+{
+    // Local variables
+    struct timespec now;             // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( (int64_t)now.tv_sec * 1000000 + now.tv_nsec / 1000 );
+}
+
+
+/***************************************************************************************************
+ * Function: netem_random_percent
+ * 
+ * Draw a random percentage.
+ * 
+ * param:  void
+ * return: A number in the range [0, 100)
+ **************************************************************************************************/
+static double netem_random_percent()
+{
+    return( rand_r( &random_seed ) * 100.0 / ( RAND_MAX + 1.0 ) );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
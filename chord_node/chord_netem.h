@@ -0,0 +1,95 @@
+//**************************************************************************************************
+// File:   chord_netem.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Network condition emulation for the node transport. When the CHORD_NETEM environment variable
+// holds a link specification, messages sent between nodes are delayed, jittered, rate limited,
+// reordered and dropped before being handed to the underlying transport. Everything runs in the
+// sending node process, so no special privileges are needed.
+// 
+// The specification is a list of rules separated by ';'. Each rule is an optional directed link
+// ("src>dst:", where either end may be '*') followed by parameters separated by ',':
+// 
+//     delay=<time>      Fixed one-way delay (time in us, or with a "ms" or "s" suffix)
+//     jitter=<time>     Maximum random deviation from the delay, either way
+//     rate=<bytes/s>    Link bandwidth cap (with an optional "k" or "m" suffix)
+//     loss=<percent>    Probability of dropping a message
+//     reorder=<percent> Probability of sending a message at once, ahead of those queued
+// 
+// A rule without a link applies to every link. Where rules overlap, later rules take precedence,
+// parameter by parameter. For example, "delay=20ms,jitter=5ms;*>63:loss=1" delays every message
+// by 15-25 ms, and drops 1% of the messages sent to node 63.
+// 
+// Messages on a link are otherwise delivered in order (as through a pipe). Replies to the menu
+// process are never affected.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_NETEM_H
+#define CHORD_NETEM_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include "chord_node.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The environment variable that holds the link specification
+#define NETEM_ENV_VAR                   "CHORD_NETEM"
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: netem_wrap
+ * 
+ * Wrap a transport so that messages sent through it are subject to the emulated network
+ * conditions. If no link specification is set (or it is invalid), the transport is returned
+ * unchanged. Nodes created through the wrapped transport emulate their own links.
+ * 
+ * param:  The underlying transport
+ * param:  The ID of this node
+ * return: The transport to use
+ **************************************************************************************************/
+const chord_transport_t *netem_wrap( const chord_transport_t *inner, int local_id );
+
+
+/***************************************************************************************************
+ * Function: netem_flush
+ * 
+ * Send every delayed message that is due to the underlying transport. This should be called
+ * regularly from the node's message loop.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void netem_flush();
+
+
+/***************************************************************************************************
+ * Function: netem_next_due_ms
+ * 
+ * Determine how long a node may wait for incoming messages before it has delayed messages to
+ * send.
+ * 
+ * param:  void
+ * return: Milliseconds until the next delayed message is due (rounded up), or -1 if none are
+ *         waiting
+ **************************************************************************************************/
+int netem_next_due_ms();
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -9,9 +9,14 @@
 // to create new (local-only) nodes if a command to add a node is received from the menu process.
 // A Chord node handles the addition or removal of keys from its local set, the scheme of which 
 // is based on its ID and place in the DHT ring.
-//
+// 
 // Each node knows its successor information and local keys, but not the complete DHT node list or
-// total keys present in the system. The intent is to decentralize the algorithm.
+// total keys present in the system. The intent is to decentralize the algorithm. Nodes also keep
+// track of their predecessor, a short list of successors and a finger table, which a periodic 
+// stabilization protocol keeps up to date; messages are routed along the fingers.
+// 
+// A node process may host virtual nodes as well as its own: further IDs on the ring, each with its
+// own key range, so that keys are spread more evenly over the processes.
 // 
 //**************************************************************************************************
 
@@ -19,16 +24,35 @@
 // Includes
 //**************************************************************************************************
 
+// F_SETPIPE_SZ is a Linux extension
+#define _GNU_SOURCE
+
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
+#include <poll.h>
+#include <signal.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/types.h>
+#include <time.h>
 #include <unistd.h>
-#include "chord_debug.h"
 #include "chord_node.h"
+#include "chord_broadcast.h"
 #include "chord_config.h"
 #include "chord_key_set.h"
+#include "chord_log.h"
+#include "chord_netem.h"
+#include "chord_hot_keys.h"
+#include "chord_owner_cache.h"
+#include "chord_value_cache.h"
+#include "chord_pool.h"
+#include "chord_shared_store.h"
+#include "chord_supervisor.h"
+#include "chord_value_store.h"
 
 
 //**************************************************************************************************
@@ -47,25 +71,200 @@ static bool has_successor;
 // The pipe descriptor for receiving commands from the menu
 static int pipe_from_menu;
 
+// The pipe descriptor for sending reports back to the menu
+static int pipe_to_menu;
+
+// The number of messages this node has sent to other nodes (excluding reports)
+static int msgs_sent;
+
 // Pipe descriptors for communication between DHT nodes
 static int dht_pipes[MAX_NODE_COUNT][2];
 
+// Pipe descriptors for moving values between DHT nodes in bulk (-1 where there is none). A node
+// that sends values in bulk holds a lock on the pipe while it writes, so that transfers from 
+// different nodes do not interleave. The pipes are written without blocking, so that a node does
+// not hold the lock while waiting for room for a transfer.
+static int bulk_pipes[MAX_NODE_COUNT][2];
+
+// The capacity of a bulk pipe, in bytes (room for several transfers, so that a node sending values
+// in bulk is not held up by the receiving node)
+#define BULK_PIPE_SIZE              1048576
+
+// The times a node tries, a millisecond apart, to start a transfer into a full bulk pipe before it
+// sends the values in messages instead
+#define BULK_RETRY_LIMIT            100
+
+// The number of successors that hold a copy of each node's key set (zero for no replication)
+static int replication_factor;
+
+// The nodes this node holds a copy of the key set for, as a bitmap
+static uint64_t replica_owners;
+
+// The copies of other nodes' key sets, indexed by owner
+static uint64_t replica_keys[MAX_NODE_COUNT];
+
+// The number of further successors each copy is passed on to, indexed by owner
+static int replica_hops[MAX_NODE_COUNT];
+
+// A node hands lookups to its replicas when more than this many bytes of messages are waiting
+// for it (two messages without payloads)
+#define LOOKUP_BUSY_BYTES           ( 2 * (int)sizeof( chord_msg_t ) )
+
+// The pipe descriptor for sending heartbeats to the supervisor (-1 when there is no supervisor)
+static int heartbeat_pipe = -1;
+
+// The time at which the next heartbeat is due, in milliseconds
+static double next_heartbeat_ms;
+
+// The pipes of failed nodes whose messages this node now receives, as a bitmap of node IDs
+static uint64_t adopted_inboxes;
+
+// Flag: "this node is leaving the ring" (its keys have been handed to its successor)
+static bool leaving;
+
+// The main node's summary of the keys that may be in the DHT, as a bitmap (see filter_request)
+static uint64_t key_summary;
+
+// The nodes last known to own ranges of keys, learned from the nodes themselves
+static owner_cache_t owner_cache;
+
+// Copies of the values of hot keys, kept by the main node (see filter_request)
+static value_cache_t value_cache;
+
+// The requests this node has handled lately, by key (see chord_hot_keys.h)
+static hot_tracker_t hot_tracker;
+
+// The interval between stabilization rounds, in milliseconds
+#define STABILIZE_INTERVAL_MS       250
+
+// A successor that has not answered this many stabilization rounds, and whose process has exited,
+// is skipped
+#define STABILIZE_MISSED_LIMIT      4
+
+// The node's predecessor (INT_MAX if not known)
+static int predecessor_id;
+
+// The node's successors, nearest first (INT_MAX where not known)
+static int successors[SUCCESSOR_LIST_LENGTH];
+
+// The finger table: finger i is the owner of node ID + 2^i (INT_MAX where not known)
+static int fingers[FINGER_COUNT];
+
+// The finger to refresh in the next stabilization round
+static int next_finger;
+
+// The process of the successor, as last reported by it (zero if not known)
+static pid_t successor_pid;
+
+// The number of stabilization rounds the successor has not answered
+static int stabilize_missed;
+
+// The time at which the next stabilization round is due, in milliseconds
+static double next_stabilize_ms;
+
+// The pipe descriptor for assigning new nodes to idle processes (-1 if new nodes are forked)
+static int pool_pipe = -1;
+
+// The nodes hosted by this process: its own node first, then any virtual nodes started in it. The
+// node being run is held in the variables above, and the state of the others here.
+static chord_node_state_t hosted_nodes[MAX_VIRTUAL_NODES];
+
+// The IDs of the nodes hosted by this process
+static int hosted_ids[MAX_VIRTUAL_NODES] = { MAIN_DHT_NODE };
+
+// The number of nodes hosted by this process
+static int hosted_count = 1;
+
+// The hosted node being run, as an index into the above
+static int running_node = 0;
+
+// The values stored under the keys of the node being run
+static value_store_t values;
+
+// The message being processed, with its payload (which travels on with the message if it is passed
+// on to another node)
+static chord_payload_msg_t received;
+
 // Local prototypes
-static void process_msg( chord_msg_t rx_msg );
+static bool filter_request( chord_msg_t *msg );
 static void process_add_node( chord_msg_t msg );
 static void process_node_announcement( chord_msg_t msg );
 static void process_add_key( chord_msg_t msg );
 static void process_redist_key( chord_msg_t msg );
 static void process_delete_key( chord_msg_t msg );
-static void process_dump( chord_msg_t msg );
-static void process_toggle_debug( chord_msg_t msg );
+static void process_broadcast( chord_msg_t msg );
+static void process_aggregate( chord_msg_t msg );
+static void process_lookup_key( chord_msg_t msg );
+static void process_range( chord_msg_t msg );
+static void serve_range( chord_msg_t msg );
+static void process_mget( chord_msg_t msg );
+static void forward_request( chord_msg_t msg );
+static void pass_request( int dest_id, chord_msg_t msg );
+static void send_owner_hint( chord_msg_t msg );
+static void process_owner( chord_msg_t msg );
+static void send_cache_value( chord_msg_t msg, const char *value, int length );
+static void process_cache_value( chord_msg_t msg );
+static int first_owned_key();
+static void process_replicate( chord_msg_t msg );
+static void process_replica_lookup( chord_msg_t msg );
+static void process_repair( chord_msg_t msg );
+static void process_crash( chord_msg_t msg );
+static void process_leave( chord_msg_t msg );
+static void process_handoff( chord_msg_t msg );
+static void finish_leaving( chord_msg_t msg );
+static void process_stabilize( chord_msg_t msg );
+static void process_predecessor( chord_msg_t msg );
+static void process_notify( chord_msg_t msg );
+static void process_find_successor( chord_msg_t msg );
+static void process_finger( chord_msg_t msg );
+static void process_host_node( chord_msg_t msg );
+static void process_values( chord_msg_t msg );
+static void process_bulk_values( chord_msg_t msg );
+static void set_successor( int new_successor_id );
+static void replace_finger( int old_id, int new_id );
+static int next_hop( int target_id );
+static bool between( int id, int from_id, int to_id );
+static bool owns_key( int key );
+static void answer_lookup( chord_msg_t msg );
+static void answer_values( chord_msg_t msg, uint64_t keys );
+static void keep_key( chord_msg_t msg );
+static void send_values( int dest_id, uint64_t keys );
+static void push_replicas( bool include_held );
+static void send_heartbeat();
+static void reply_to_menu( chord_msg_t msg, uint64_t data );
+static void answer_broadcast( int parent_id, chord_payload_msg_t *answer );
+static void send_msg( int dest_id, const chord_msg_t *msg );
+static void send_payload_msg( int dest_id, const chord_msg_t *msg, const char *payload );
+static bool read_msg( int handle );
+static void pipe_send( int dest_id, const chord_msg_t *msg );
+static void pipe_reply( const chord_msg_t *msg );
+static bool pipe_bulk( int dest_id, uint64_t keys );
+static pid_t fork_spawn( const chord_msg_t *msg );
+static pid_t pool_spawn( const chord_msg_t *msg );
+static int pipe_backlog();
+static void init_pooled_node( chord_msg_t msg );
+static uint64_t pack_successors();
+static void unpack_successors( uint64_t list );
+static pid_t host_spawn( const chord_msg_t *msg );
+static void switch_node( int index );
+static void forget_hosted_nodes( int own_id );
+static void remove_running_node();
 
 
 //**************************************************************************************************
 // Module variables
 //**************************************************************************************************
 
-// (none)
+// The transport used between node processes: pipes, with new nodes created by forking
+static const chord_transport_t pipe_transport = { pipe_send, pipe_reply, fork_spawn, 
+                                                   pipe_backlog, pipe_bulk };
+
+// The same, with new nodes taken from the pool of idle processes
+static const chord_transport_t pooled_transport = { pipe_send, pipe_reply, pool_spawn, 
+                                                     pipe_backlog, pipe_bulk };
+
+// The transport currently in use
+static const chord_transport_t *transport = &pipe_transport;
 
 
 //**************************************************************************************************
@@ -79,30 +278,140 @@ static void process_toggle_debug( chord_msg_t msg );
  * communication mechanisms.
  * 
  * param:  The pipe handle from the menu process, so that commands may be received
+ * param:  The pipe handle to the menu process, so that reports may be sent
  * return: void
  **************************************************************************************************/
-void init_dht( int menu_pipe_handle )
+void init_dht( int menu_pipe_handle, int menu_reply_handle )
 {
+    // Local variables
+    const char *replication;      // The replication factor, from the environment
+    const char *pool;             // The number of idle node processes, from the environment
+    int pool_size;                // The number of idle node processes
+    int heartbeat_pipes[2];       // The pipe from the nodes to the supervisor
+    int pool_pipes[2];            // The pipe from the nodes to the idle node processes
+    const char *shared_store;     // The file descriptor of the shared store, from the environment
+    
     // Setup "main node"
     node_id = MAIN_DHT_NODE;
     successor_id = INT_MAX;
     has_successor = false;
+    msgs_sent = 0;
+    
+    // The main node starts alone, so it knows no other nodes
+    predecessor_id = INT_MAX;
+    
+    for( int index = 0; index < SUCCESSOR_LIST_LENGTH; index++ )
+    {
+        successors[index] = INT_MAX;
+    }
+    
+    for( int index = 0; index < FINGER_COUNT; index++ )
+    {
+        fingers[index] = INT_MAX;
+    }
     
-    // Ensure the node's key set is cleared
+    // Ensure the node's key set, caches and request counts are cleared
     keyset_init();
+    owner_cache_init( &owner_cache );
+    value_cache_init( &value_cache );
+    hot_init( &hot_tracker );
     
-    // Assign menu pipe handle for receiving commands 
+    // Keep values in the shared store, if the menu process created one (nodes created later 
+    // inherit it)
+    shared_store = getenv( SHARED_STORE_ENV_VAR );
+    
+    if( ( shared_store != NULL ) && ( store_attach_shared( atoi( shared_store ) ) == true ) )
+    {
+        store_set_owner( node_id, 0 );
+    }
+    
+    // Event logging stays off until debug is toggled on
+    log_init( node_id );
+    
+    // Assign menu pipe handles for receiving commands and sending reports
     pipe_from_menu = menu_pipe_handle;
+    pipe_to_menu = menu_reply_handle;
     
     // Set up all DHT pipes
     for( int index = 0; index < MAX_NODE_COUNT; index++ )
     {
         pipe( dht_pipes[index] );
+        
+        // Values are moved in messages to a node whose bulk pipe cannot hold several transfers
+        if( pipe( bulk_pipes[index] ) != 0 )
+        {
+            bulk_pipes[index][1] = -1;
+        }
+        else if( fcntl( bulk_pipes[index][1], F_SETPIPE_SZ, BULK_PIPE_SIZE ) < BULK_PIPE_SIZE )
+        {
+            close( bulk_pipes[index][0] );
+            close( bulk_pipes[index][1] );
+            bulk_pipes[index][1] = -1;
+        }
+        else
+        {
+            fcntl( bulk_pipes[index][1], F_SETFL, O_NONBLOCK );
+        }
     }
     
     // Set only main node's pipes to nonblocking mode so it can look at multiple inputs
     fcntl( dht_pipes[MAIN_DHT_NODE][0], F_SETFL, O_NONBLOCK );
     fcntl( pipe_from_menu, F_SETFL, O_NONBLOCK );
+    
+    // Take new nodes from a pool of idle processes, unless asked not to
+    pool = getenv( POOL_ENV_VAR );
+    pool_size = ( pool != NULL ) ? atoi( pool ) : POOL_DEFAULT_SIZE;
+    pool_size = ( pool_size > POOL_MAX_SIZE ) ? POOL_MAX_SIZE : pool_size;
+    
+    if( ( pool_size > 0 ) && ( pipe( pool_pipes ) == 0 ) )
+    {
+        pool_pipe = pool_pipes[1];
+    }
+    
+    // Emulate network conditions between nodes, if asked to
+    transport = netem_wrap( ( pool_pipe >= 0 ) ? &pooled_transport : &pipe_transport, node_id );
+    
+    // Replicate key sets to successors, if asked to (nodes created later inherit the setting)
+    replication = getenv( "CHORD_REPLICATION" );
+    set_replication( ( replication != NULL ) ? atoi( replication ) : 0 );
+    
+    // Node processes are not waited for; let the system reap them when they exit
+    signal( SIGCHLD, SIG_IGN );
+    
+    /*
+     * Start the supervisor, which watches every node through its heartbeats and repairs the ring
+     * when one fails. A heartbeat is never worth blocking a node for, so they are sent without.
+     */
+    if( pipe( heartbeat_pipes ) == 0 )
+    {
+        fcntl( heartbeat_pipes[1], F_SETFL, O_NONBLOCK );
+        
+        if( fork() == 0 )
+        {
+            close( heartbeat_pipes[1] );
+            supervisor_run( heartbeat_pipes[0], dht_pipes, pipe_to_menu );
+        }
+        
+        close( heartbeat_pipes[0] );
+        heartbeat_pipe = heartbeat_pipes[1];
+    }
+    
+    /*
+     * Start the zygote, which keeps the pool of idle processes filled. It is forked last, so that
+     * the idle processes hold everything a node needs; one that is assigned a node returns from
+     * here as that node.
+     */
+    if( pool_pipe >= 0 )
+    {
+        if( fork() == 0 )
+        {
+            init_pooled_node( pool_run( pool_pipes[0], pool_size ) );
+        }
+        else
+        {
+            close( pool_pipes[0] );
+        }
+    }
 }
 
 
@@ -117,28 +426,353 @@ void init_dht( int menu_pipe_handle )
 void check_messages( void )
 {
     // Local variables
-    chord_msg_t rx_msg;         // Holds a received message
-    ssize_t bytes_read;         // The number of bytes read
+    struct pollfd dht_polls[MAX_NODE_COUNT];     // Each hosted node's pipe, then its adopted pipes
+    int poll_ids[MAX_NODE_COUNT];                // The node whose pipe each poll entry is
+    int poll_nodes[MAX_NODE_COUNT];              // The hosted node each poll entry is read for
+    int poll_count = 0;                          // The number of pipes polled
+    int node_count;                              // The number of hosted nodes, as polled
+    int timeout_ms = INT_MAX;                    // The longest time to wait for messages
+    struct timespec now;                         // The current time
+    double now_ms;                               // The current time, in milliseconds
+    double deadline_ms;                          // The deadline of a pending broadcast
+    chord_payload_msg_t answer;                  // The answer to an expired broadcast
+    int parent_id;                               // The node to pass the answer to
     
-    // If this is the main node, check for messages from menu process
-    if( node_id == MAIN_DHT_NODE )
+    // Send any messages held back by network emulation that are now due
+    netem_flush();
+    
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    now_ms = now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6;
+    
+    for( int index = 0; index < hosted_count; index++ )
+    {
+        switch_node( index );
+        
+        // Keep routing state up to date as nodes join, leave and fail
+        if( now_ms >= next_stabilize_ms )
+        {
+            stabilize();
+            next_stabilize_ms = now_ms + STABILIZE_INTERVAL_MS;
+        }
+        
+        if( next_stabilize_ms - now_ms < timeout_ms )
+        {
+            timeout_ms = (int)( next_stabilize_ms - now_ms ) + 1;
+        }
+        
+        // Let the supervisor know this node is alive
+        if( heartbeat_pipe >= 0 )
+        {
+            if( now_ms >= next_heartbeat_ms )
+            {
+                send_heartbeat();
+                next_heartbeat_ms = now_ms + HEARTBEAT_INTERVAL_MS;
+            }
+            
+            if( next_heartbeat_ms - now_ms < timeout_ms )
+            {
+                timeout_ms = (int)( next_heartbeat_ms - now_ms ) + 1;
+            }
+        }
+        
+        // Stop waiting on nodes that have not answered a broadcast in time
+        while( broadcast_expire( node_id, now_ms, &answer, &parent_id ) == true )
+        {
+            answer.msg.sender = node_id;
+            answer_broadcast( parent_id, &answer );
+        }
+        
+        // Reclaim the space of dead values a step at a time, between messages
+        if( store_compact( &values ) == true )
+        {
+            timeout_ms = 0;
+        }
+        
+        deadline_ms = broadcast_next_deadline_ms( node_id );
+        
+        if( ( deadline_ms >= 0.0 ) && ( deadline_ms - now_ms < timeout_ms ) )
+        {
+            timeout_ms = (int)( deadline_ms - now_ms ) + 1;
+        }
+    }
+    
+    // If this is the main node's process, check for messages from menu process
+    if( hosted_ids[0] == MAIN_DHT_NODE )
     {
-        bytes_read = read( pipe_from_menu, (void *)&rx_msg, sizeof( rx_msg ) );
+        switch_node( 0 );
         
         // Process command
-        if( bytes_read == sizeof( rx_msg ) )
+        if( read_msg( pipe_from_menu ) == true )
+        {
+            process_msg( received.msg );
+        }
+    }
+    
+    /*
+     * Wait for DHT messages, on the pipe of each hosted node and those of failed nodes it took 
+     * over from, but no longer than until the next stabilization round, heartbeat or held back 
+     * message is due. The main node does not wait, as it must keep checking for commands from the
+     * menu process as well.
+     */
+    for( int index = 0; index < hosted_count; index++ )
+    {
+        switch_node( index );
+        
+        dht_polls[poll_count].fd = dht_pipes[node_id][0];
+        dht_polls[poll_count].events = POLLIN;
+        poll_nodes[poll_count] = index;
+        poll_ids[poll_count++] = node_id;
+        
+        for( int id = 0; ( id < MAX_NODE_COUNT ) && ( poll_count < MAX_NODE_COUNT ); id++ )
+        {
+            if( adopted_inboxes & ( 1UL << id ) )
+            {
+                dht_polls[poll_count].fd = dht_pipes[id][0];
+                dht_polls[poll_count].events = POLLIN;
+                poll_nodes[poll_count] = index;
+                poll_ids[poll_count++] = id;
+            }
+        }
+    }
+    
+    if( ( netem_next_due_ms() >= 0 ) && ( netem_next_due_ms() < timeout_ms ) )
+    {
+        timeout_ms = netem_next_due_ms();
+    }
+    
+    if( poll( dht_polls, poll_count, ( hosted_ids[0] == MAIN_DHT_NODE ) ? 0 : timeout_ms ) <= 0 )
+    {
+        return;
+    }
+    
+    /*
+     * A message may hand a pipe back to a node that replaces a failed one, or create a new node
+     * (in which case this may be the new node's process), so check the pipe is still this node's.
+     * Once a hosted node has left, the rest are polled again.
+     */
+    node_count = hosted_count;
+    
+    for( int index = 0; ( index < poll_count ) && ( hosted_count >= node_count ); index++ )
+    {
+        switch_node( poll_nodes[index] );
+        
+        if( ( dht_polls[index].revents & POLLIN ) && 
+            ( ( poll_ids[index] == node_id ) || ( adopted_inboxes & ( 1UL << poll_ids[index] ) ) ) )
         {
-            process_msg( rx_msg );
+            // Process command
+            if( read_msg( dht_polls[index].fd ) == true )
+            {
+                process_msg( received.msg );
+            }
         }
     }
+}
+
+
+/***************************************************************************************************
+ * Function: init_new_node
+ * 
+ * Initialize the state of a node that has just been created by its predecessor. The state starts
+ * as a copy of the predecessor's state (as left by fork), which already holds the correct 
+ * successor ID in most cases.
+ * 
+ * param:  The "addnode" message that caused the node to be created
+ * return: void
+ **************************************************************************************************/
+void init_new_node( chord_msg_t msg )
+{
+    // The node that created this one is its predecessor
+    predecessor_id = node_id;
+    
+    // Overwrite old node ID with new ID of the child process/node
+    node_id = msg.id;
+    log_set_node( node_id );
+
+    /**
+     * Special case when adding the first (non-main) node: if successor ID is INT_MAX, 
+     * update it to 63, so that the two nodes point to each other as successors.
+     * Otherwise, for subsequent additions, the child will already have the correct
+     * successor ID - it's the parent that needs to update their copy.
+     */
+    if( successor_id == INT_MAX )
+    {
+        set_successor( MAIN_DHT_NODE );
+    }
+    
+    // The successor list and fingers inherited from the predecessor are close enough to start with
+    successor_pid = 0;
+    stabilize_missed = 0;
+    next_stabilize_ms = 0;
     
-    // Wait for DHT messages
-    bytes_read = read( dht_pipes[node_id][0], (void *)&rx_msg, sizeof( rx_msg ) );
+    // Initialize key set, values and message count of new node (the segments inherited from the
+    // predecessor are unmapped, unless the predecessor runs in this process and still uses them)
+    keyset_init();
+    store_init( &values );
+    owner_cache_init( &owner_cache );
+    value_cache_init( &value_cache );
+    hot_init( &hot_tracker );
+    msgs_sent = 0;
+    
+    // Copies of other nodes' key sets are passed on to the new node by its predecessors
+    replica_owners = 0;
+    
+    // The new node is a new process for the supervisor to watch, so it sends a heartbeat at once
+    next_heartbeat_ms = 0;
+    adopted_inboxes = 0;
+    leaving = false;
+
+    LOG_INFO( LOG_NODE_CREATED, node_id, getpid(), getppid(), successor_id );
+}
+
+
+/***************************************************************************************************
+ * Function: set_transport
+ * 
+ * Replace the means by which this process sends messages and creates nodes. By default, nodes
+ * communicate through pipes and new nodes are forked.
+ * 
+ * param:  The transport to use
+ * return: void
+ **************************************************************************************************/
+void set_transport( const chord_transport_t *new_transport )
+{
+    transport = new_transport;
+}
+
+
+/***************************************************************************************************
+ * Function: set_replication
+ * 
+ * Set the number of successors that hold a copy of each node's key set. The factor is limited to
+ * MAX_REPLICATION; zero turns replication off.
+ * 
+ * param:  The replication factor
+ * return: void
+ **************************************************************************************************/
+void set_replication( int factor )
+{
+    replication_factor = ( factor < 0 ) ? 0 : 
+                         ( factor > MAX_REPLICATION ) ? MAX_REPLICATION : factor;
+}
+
+
+/***************************************************************************************************
+ * Function: get_node_state
+ * 
+ * Get a copy of the state of the node hosted by this process.
+ * 
+ * param:  Holds the state of the node
+ * return: void
+ **************************************************************************************************/
+void get_node_state( chord_node_state_t *state )
+{
+    state->node_id = node_id;
+    state->successor_id = successor_id;
+    state->has_successor = has_successor;
+    state->predecessor_id = predecessor_id;
+    memcpy( state->successors, successors, sizeof( successors ) );
+    memcpy( state->fingers, fingers, sizeof( fingers ) );
+    state->next_finger = next_finger;
+    state->msgs_sent = msgs_sent;
+    state->key_set = keyset_get_bitmap();
+    state->values = values;
+    state->owner_cache = owner_cache;
+    state->value_cache = value_cache;
+    state->hot_tracker = hot_tracker;
+    state->replica_owners = replica_owners;
+    memcpy( state->replica_keys, replica_keys, sizeof( replica_keys ) );
+    memcpy( state->replica_hops, replica_hops, sizeof( replica_hops ) );
+    state->adopted_inboxes = adopted_inboxes;
+    state->leaving = leaving;
+    state->successor_pid = successor_pid;
+    state->stabilize_missed = stabilize_missed;
+    state->next_stabilize_ms = next_stabilize_ms;
+    state->next_heartbeat_ms = next_heartbeat_ms;
+}
 
-    // Process command
-    if( bytes_read == sizeof( rx_msg ) )
+
+/***************************************************************************************************
+ * Function: set_node_state
+ * 
+ * Replace the state of the node hosted by this process. Together with get_node_state, this lets
+ * a single process act as many nodes, by swapping the state of each in before it processes a 
+ * message.
+ * 
+ * param:  The new state of the node
+ * return: void
+ **************************************************************************************************/
+void set_node_state( const chord_node_state_t *state )
+{
+    node_id = state->node_id;
+    log_set_node( node_id );
+    successor_id = state->successor_id;
+    has_successor = state->has_successor;
+    predecessor_id = state->predecessor_id;
+    memcpy( successors, state->successors, sizeof( successors ) );
+    memcpy( fingers, state->fingers, sizeof( fingers ) );
+    next_finger = state->next_finger;
+    msgs_sent = state->msgs_sent;
+    keyset_set_bitmap( state->key_set );
+    values = state->values;
+    owner_cache = state->owner_cache;
+    value_cache = state->value_cache;
+    hot_tracker = state->hot_tracker;
+    replica_owners = state->replica_owners;
+    memcpy( replica_keys, state->replica_keys, sizeof( replica_keys ) );
+    memcpy( replica_hops, state->replica_hops, sizeof( replica_hops ) );
+    adopted_inboxes = state->adopted_inboxes;
+    leaving = state->leaving;
+    successor_pid = state->successor_pid;
+    stabilize_missed = state->stabilize_missed;
+    next_stabilize_ms = state->next_stabilize_ms;
+    next_heartbeat_ms = state->next_heartbeat_ms;
+}
+
+
+/***************************************************************************************************
+ * Function: stabilize
+ * 
+ * Run one round of the stabilization protocol: ask the successor for its predecessor and successor
+ * list (see process_predecessor), and refresh one finger. A successor that has stopped answering,
+ * and whose process has exited, is replaced by the next node in the successor list.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void stabilize()
+{
+    // Local variables
+    chord_msg_t msg;              // The stabilization request, then the finger lookup
+    
+    if( ( successor_id != INT_MAX ) && ( leaving == false ) )
     {
-        process_msg( rx_msg );
+        if( ( stabilize_missed > STABILIZE_MISSED_LIMIT ) && ( successor_pid != 0 ) && 
+            ( successors[1] != INT_MAX ) && ( kill( successor_pid, 0 ) == -1 ) && 
+            ( errno == ESRCH ) )
+        {
+            LOG_INFO( LOG_SUCCESSOR_SKIPPED, node_id, successor_id, successors[1] );
+            
+            set_successor( successors[1] );
+            push_replicas( true );
+        }
+        
+        msg.cmd = STABILIZE;
+        msg.id = node_id;
+        msg.sender = node_id;
+        msg.tag = 0;
+        msg.hops = 0;
+        msg.data = 0;
+        
+        stabilize_missed++;
+        send_msg( successor_id, &msg );
+        
+        // Look up the owner of the start of the next finger's interval (node ID + 2^i)
+        msg.cmd = FIND_SUCCESSOR;
+        msg.id = ( node_id + ( 1 << next_finger ) ) % MAX_NODE_COUNT;
+        msg.tag = next_finger;
+        
+        next_finger = ( next_finger + 1 ) % FINGER_COUNT;
+        process_find_successor( msg );
     }
 }
 
@@ -147,12 +781,29 @@ void check_messages( void )
  * Function: process_msg
  * 
  * Process the given message, using its command and ID information to perform a specific action.
+ * Requests from the menu process are first checked against the main node's summary of the keys in
+ * the DHT, which answers those for keys that are not there. The key set of the node is then
+ * published in the shared store, if there is one, in case the message changed it.
  * 
  * param:  A message received from another process/node
  * return: void
  **************************************************************************************************/
-static void process_msg( chord_msg_t rx_msg )
+void process_msg( chord_msg_t rx_msg )
 {
+    // A departing node passes everything on to its successor, which now owns its keys
+    if( ( leaving == true ) && ( rx_msg.cmd != HANDOFF ) )
+    {
+        send_msg( successor_id, &rx_msg );
+        return;
+    }
+    
+    // The main node answers requests for keys that are certainly not in the DHT at once
+    if( ( node_id == MAIN_DHT_NODE ) && ( rx_msg.sender == MENU_PROCESS_ID ) && 
+        ( filter_request( &rx_msg ) == true ) )
+    {
+        return;
+    }
+    
     switch( rx_msg.cmd )
     {
         case( ADD_NODE ):
@@ -160,6 +811,7 @@ static void process_msg( chord_msg_t rx_msg )
             break;
 
         case( ADD_KEY ):
+        case( PUT ):
             process_add_key( rx_msg );
             break;
 
@@ -168,7 +820,14 @@ static void process_msg( chord_msg_t rx_msg )
             break;
 
         case( DUMP ):
-            process_dump( rx_msg );
+        case( TOGGLE_DEBUG ):
+        case( REPORT ):
+        case( STATS ):
+            process_broadcast( rx_msg );
+            break;
+            
+        case( AGGREGATE ):
+            process_aggregate( rx_msg );
             break;
             
         case( ANNOUNCE ):
@@ -179,41 +838,263 @@ static void process_msg( chord_msg_t rx_msg )
             process_redist_key( rx_msg );
             break;
             
-        case( TOGGLE_DEBUG ):
-            process_toggle_debug( rx_msg );
+        case( LOOKUP ):
+        case( GET ):
+            process_lookup_key( rx_msg );
             break;
-    }
-}
 
+        case( SCAN ):
+        case( COUNT ):
+        case( DELETE_RANGE ):
+            process_range( rx_msg );
+            break;
 
-/***************************************************************************************************
- * Function: process_add_node
- * 
- * Process the "addnode" command, which seeks to insert a node (in the proper sequence) into the
- * DHT. If the message ID is less than that of the successor, the current node forks and creates
- * the new node. Successor information is then updated appropriately to maintain the ring. If the 
- * message ID is not less than that of the successor, the message is forwarded and no action is
- * taken.
- * 
- * param:  A message received from another process/node
- * return: void
- **************************************************************************************************/
-static void process_add_node( chord_msg_t msg )
-{
-    // Local variables
-    pid_t process_id;                     // Holds a process ID for the fork operation
-    int errno_val;                        // Stores errno after a system call failure
-    chord_msg_t announcement_msg;         // A message to announce new node insertion to successor
-    
-    if( msg.id < successor_id )
-    {
-        /*
-         * If the new node ID is less than the successor ID, the node should be inserted
-         * "in between" the two, so fork here.
-         */
-        process_id = fork();
-        
-        switch( process_id )
+        case( MGET ):
+            process_mget( rx_msg );
+            break;
+
+        case( OWNER ):
+            process_owner( rx_msg );
+            break;
+
+        case( CACHE_VALUE ):
+            process_cache_value( rx_msg );
+            break;
+
+        case( REPLICATE ):
+            process_replicate( rx_msg );
+            break;
+
+        case( REPAIR ):
+            process_repair( rx_msg );
+            break;
+
+        case( CRASH ):
+            process_crash( rx_msg );
+            break;
+
+        case( LEAVE ):
+            process_leave( rx_msg );
+            break;
+
+        case( HANDOFF ):
+            process_handoff( rx_msg );
+            break;
+
+        case( STABILIZE ):
+            process_stabilize( rx_msg );
+            break;
+
+        case( PREDECESSOR ):
+            process_predecessor( rx_msg );
+            break;
+
+        case( NOTIFY ):
+            process_notify( rx_msg );
+            break;
+
+        case( FIND_SUCCESSOR ):
+            process_find_successor( rx_msg );
+            break;
+
+        case( FINGER ):
+            process_finger( rx_msg );
+            break;
+
+        case( HOST_NODE ):
+            process_host_node( rx_msg );
+            break;
+
+        case( VALUES ):
+            process_values( rx_msg );
+            break;
+
+        case( BULK_VALUES ):
+            process_bulk_values( rx_msg );
+            break;
+
+        case( RESERVED ):
+        case( HEARTBEAT ):
+            // Heartbeats go only to the supervisor, and the reserved command is never sent
+            break;
+    }
+    
+    store_set_owner( node_id, keyset_get_bitmap() );
+}
+
+
+/***************************************************************************************************
+ * Function: process_payload_msg
+ * 
+ * Process a message handed over with its payload (as by the simulator), as if it had been read
+ * from a pipe.
+ * 
+ * param:  The message, followed by its payload
+ * return: void
+ **************************************************************************************************/
+void process_payload_msg( const chord_msg_t *msg )
+{
+    memcpy( &received, msg, sizeof( *msg ) + MSG_PAYLOAD_LENGTH( msg ) );
+    process_msg( received.msg );
+}
+
+
+/***************************************************************************************************
+ * Function: filter_request
+ * 
+ * Keep the main node's summary of the keys in the DHT, from the requests of the menu process that
+ * change them, and answer requests for keys the summary shows not to be there at once, rather than
+ * routing them to the owners only to learn that. Every request enters the ring at the main node,
+ * so a key is marked before any request that adds it is passed on: the summary may show keys that
+ * are no longer there (e.g. lost with a failed node), but never misses one that is. In the same 
+ * way, the value cache drops the values of keys about to change, and answers "get" requests for
+ * hot keys from their cached values (see chord_value_cache.h).
+ * 
+ * param:  A request from the menu process (for a multi-get, the keys answered here are removed;
+ *         for a "get", whether its owner is to send a copy of the value is set)
+ * return: True if the request has been answered, and needs no further processing
+ **************************************************************************************************/
+static bool filter_request( chord_msg_t *msg )
+{
+    // Local variables
+    bool answered = false;        // Flag: "the request has been answered"
+    chord_msg_t answer;           // An answer from the summary
+    chord_payload_msg_t reply;    // An answer from the value cache
+    const char *value;            // The value of a key in the value cache
+    int length;                   // The length of the value (-1 if it is not in the cache)
+    int owner_id;                 // The node that owned the key when the value was cached
+    struct timespec now;          // The current time
+    
+    answer = *msg;
+    answer.hops = SUMMARY_ANSWER_HOPS;
+    
+    switch( msg->cmd )
+    {
+        case( ADD_KEY ):
+        case( PUT ):
+            key_summary |= ( 1UL << msg->id );
+            value_cache_invalidate( &value_cache, 1UL << msg->id );
+            break;
+            
+        case( DELETE_KEY ):
+            key_summary &= ~( 1UL << msg->id );
+            value_cache_invalidate( &value_cache, 1UL << msg->id );
+            break;
+            
+        case( DELETE_RANGE ):
+            for( int key = msg->id; ( key <= msg->hops ) && ( key < MAX_KEY_VALUE ); key++ )
+            {
+                key_summary &= ~( 1UL << key );
+                value_cache_invalidate( &value_cache, 1UL << key );
+            }
+            break;
+            
+        case( LOOKUP ):
+            if( ( key_summary & ( 1UL << msg->id ) ) == 0 )
+            {
+                hot_note_served( &hot_tracker, msg->id );
+                reply_to_menu( answer, 0 );
+                answered = true;
+            }
+            break;
+            
+        case( GET ):
+            clock_gettime( CLOCK_MONOTONIC, &now );
+            length = -1;
+            
+            if( ( key_summary & ( 1UL << msg->id ) ) != 0 )
+            {
+                length = value_cache_find( &value_cache, msg->id, 
+                                           now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6, &value, 
+                                           &owner_id );
+            }
+            
+            if( ( key_summary & ( 1UL << msg->id ) ) == 0 )
+            {
+                hot_note_served( &hot_tracker, msg->id );
+                reply_to_menu( answer, 0 );
+                answered = true;
+            }
+            else if( length >= 0 )
+            {
+                hot_note_served( &hot_tracker, msg->id );
+                
+                // A hot key: answer from the cached copy of its value, as its owner would
+                if( msg->tag != 0 )
+                {
+                    reply.msg = *msg;
+                    reply.msg.sender = owner_id;
+                    reply.msg.data = 1;
+                    reply.msg.length = length;
+                    memcpy( reply.payload, value, length );
+                    transport->reply( &reply.msg );
+                }
+                
+                answered = true;
+            }
+            else
+            {
+                // Ask the owner for a copy of the value with the answer (sent if the key is hot)
+                msg->data = (uint64_t)value_cache_version( &value_cache, msg->id ) << 
+                            REQUEST_VERSION_SHIFT;
+            }
+            break;
+            
+        case( MGET ):
+            if( ( msg->data & ~key_summary ) != 0 )
+            {
+                answer_values( answer, msg->data & ~key_summary );
+                msg->data &= key_summary;
+                answered = ( msg->data == 0 );
+            }
+            break;
+            
+        default:
+            break;
+    }
+    
+    return( answered );
+}
+
+
+/***************************************************************************************************
+ * Function: process_add_node
+ * 
+ * Process the "addnode" command, which seeks to insert a node (in the proper sequence) into the
+ * DHT. If the message ID is less than that of the successor, the current node forks and creates
+ * the new node. Successor information is then updated appropriately to maintain the ring. If the 
+ * message ID is not less than that of the successor, the message is forwarded and no action is
+ * taken.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_add_node( chord_msg_t msg )
+{
+    // Local variables
+    pid_t process_id;                     // Holds a process ID for the fork operation
+    int errno_val;                        // Stores errno after a system call failure
+    chord_msg_t announcement_msg;         // A message to announce new node insertion to successor
+    chord_msg_t join_report;              // A report of the join to the supervisor
+    
+    if( ( node_id != MAIN_DHT_NODE ) && ( msg.id < node_id ) )
+    {
+        /*
+         * A stale finger (or a pipe taken over from a node that left) brought the message past 
+         * the place of the new node in the ring, so pass it back.
+         */
+        send_msg( ( predecessor_id == INT_MAX ) ? successor_id : predecessor_id, &msg );
+    }
+    else if( msg.id < successor_id )
+    {
+        /*
+         * If the new node ID is less than the successor ID, the node should be inserted
+         * "in between" the two, so fork here (or, for a virtual node, have the process of the
+         * node hosting it start it).
+         */
+        process_id = ( msg.data != 0 ) ? host_spawn( &msg ) : transport->spawn( &msg );
+        
+        switch( process_id )
         {
             case( -1 ):
                 
@@ -221,37 +1102,32 @@ static void process_add_node( chord_msg_t msg )
                 errno_val = errno;
 
                 // Inform user
-                debug_printf( "[DBG] Error: creation of new node failed (id: %i, errno: %i)\n", 
-                              msg.id, errno_val );
+                LOG_ERROR( LOG_NODE_CREATE_FAILED, msg.id, errno_val );
                 
                 break;
                 
             case( 0 ):
                 
-                // Overwrite old node ID with new ID of the child process/node
-                node_id = msg.id;
-
-                /**
-                 * Special case when adding the first (non-main) node: if successor ID is INT_MAX, 
-                 * update it to 63, so that the two nodes point to each other as successors.
-                 * Otherwise, for subsequent additions, the child will already have the correct
-                 * successor ID - it's the parent that needs to update their copy.
-                 */
-                if( successor_id == INT_MAX )
-                {
-                    successor_id = MAIN_DHT_NODE;
-                }
-                
-                // Initialize key set of new node
-                keyset_init();
-
-                debug_printf( "[DBG] Addnode: Node %i (PID: %i, PPID: %i, SUCC: %i) was created\n", 
-                              node_id, getpid(), getppid(), successor_id );
+                // This is the new node, which is the only node its process hosts
+                forget_hosted_nodes( msg.id );
+                init_new_node( msg );
                 
                 break;
                 
             default:
                 
+                // The supervisor counts the new node as part of the ring until it is heard from
+                if( heartbeat_pipe >= 0 )
+                {
+                    join_report.cmd = ADD_NODE;
+                    join_report.id = 0;
+                    join_report.sender = msg.id;
+                    join_report.tag = 0;
+                    join_report.hops = 0;
+                    join_report.data = 0;
+                    write( heartbeat_pipe, (const void *)&join_report, sizeof( join_report ) );
+                }
+                
                 /*
                  * Before updating the successor ID to point to the new inserted node, send
                  * an announcement to original successor to initiate a key redistribution.
@@ -259,6 +1135,9 @@ static void process_add_node( chord_msg_t msg )
                 announcement_msg.cmd = ANNOUNCE;
                 announcement_msg.id = msg.id;
                 announcement_msg.sender = node_id;
+                announcement_msg.tag = msg.tag;
+                announcement_msg.hops = 0;
+                announcement_msg.data = 0;
             
                 /*
                  * Note: if there is no successor, (only main node exists), just have the message
@@ -266,21 +1145,20 @@ static void process_add_node( chord_msg_t msg )
                  */
                 if( successor_id == INT_MAX )
                 {
-                    write( dht_pipes[node_id][1], (void *)&announcement_msg, 
-                           sizeof( announcement_msg ) );
+                    send_msg( node_id, &announcement_msg );
                 }
                 else
                 {
-                    write( dht_pipes[successor_id][1], (void *)&announcement_msg, 
-                           sizeof( announcement_msg ) );
+                    send_msg( successor_id, &announcement_msg );
                 }
                 
                 // Now, parent updates their successor ID to point to inserted node
-                successor_id = msg.id;
+                set_successor( msg.id );
+                
+                // The new node joins the replica sets of this node and its predecessors
+                push_replicas( true );
                 
-                debug_printf( "[DBG] Addnode: Node %i (PID: %i, PPID: %i, SUCC: %i) spawned "
-                              "new node, updated successor\n", node_id, getpid(), getppid(), 
-                              successor_id );
+                LOG_INFO( LOG_NODE_SPAWNED, node_id, getpid(), getppid(), successor_id );
                 
                 break;
         }
@@ -291,10 +1169,9 @@ static void process_add_node( chord_msg_t msg )
          * If the new node ID is not less than the successor ID, forward the message to the next
          * node.
          */
-        debug_printf( "[DBG] Info: Node %i is forwarding addnode<%i> to successor node %i\n",
-                      node_id, msg.id, successor_id );
+        LOG_INFO( LOG_ADDNODE_FORWARDED, node_id, msg.id, next_hop( msg.id ) );
         
-        write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+        send_msg( next_hop( msg.id ), &msg );
     }
 }
 
@@ -303,7 +1180,9 @@ static void process_add_node( chord_msg_t msg )
  * Function: process_node_announcement
  * 
  * Process a message that announces the insertion of a new node into the DHT ring. This is used 
- * to initiate key redistribution.
+ * to initiate key redistribution: the keys the new node now owns are sent straight to it in a
+ * single message, which also completes the join (see process_redist_key). The values stored under
+ * them go ahead of it, as segments of this node's arena (see send_values).
  * 
  * param:  A message received from another process/node
  * return: void
@@ -311,7 +1190,7 @@ static void process_add_node( chord_msg_t msg )
 static void process_node_announcement( chord_msg_t msg )
 {
     // Local variables
-    int key_index = 0;            // Used to index the local key set
+    uint64_t moved_keys;          // The keys that move to the new node
     chord_msg_t redist_msg;       // A message indicating key re-distribution is occurring
     
     /*
@@ -319,22 +1198,36 @@ static void process_node_announcement( chord_msg_t msg )
      * signal that a new node was inserted between the predecessor and the current node. So, 
      * the current node must redistribute any keys that are less than the new node ID.
      */
-    debug_printf( "[DBG] Info: Node %i received announcement of creation of node %i - "
-                  "redistributing keys now\n", node_id, msg.id );
+    LOG_INFO( LOG_ANNOUNCE_RECEIVED, node_id, msg.id );
     
-    for( key_index; key_index <= msg.id; key_index++ )
+    /*
+     * The new node is this node's predecessor now, unless a node that joined later, between the 
+     * two, was announced first. If the new node replaces one that failed, it receives its own 
+     * messages again.
+     */
+    if( ( predecessor_id == INT_MAX ) || ( between( msg.id, predecessor_id, node_id ) == true ) )
     {
-        if( keyset_check( key_index ) == true )
-        {
-            // Delete the key from the local set and send it along
-            keyset_remove( key_index );
-            
-            redist_msg.cmd = REDIST_KEY;
-            redist_msg.id = key_index;
-            redist_msg.sender = node_id;
-            
-            write( dht_pipes[successor_id][1], (void *)&redist_msg, sizeof( redist_msg ) );
-        }
+        predecessor_id = msg.id;
+    }
+    
+    adopted_inboxes &= ~( 1UL << msg.id );
+    
+    moved_keys = keyset_get_bitmap() & ( UINT64_MAX >> ( MAX_KEY_VALUE - 1 - msg.id ) );
+    keyset_set_bitmap( keyset_get_bitmap() & ~moved_keys );
+    send_values( msg.id, moved_keys );
+    
+    redist_msg.cmd = REDIST_KEY;
+    redist_msg.id = msg.id;
+    redist_msg.sender = node_id;
+    redist_msg.tag = msg.tag;
+    redist_msg.hops = 0;
+    redist_msg.data = moved_keys;
+    
+    send_msg( msg.id, &redist_msg );
+    
+    if( moved_keys != 0 )
+    {
+        push_replicas( false );
     }
 }
 
@@ -343,7 +1236,9 @@ static void process_node_announcement( chord_msg_t msg )
  * Function: process_add_key
  * 
  * Processes the "addkey" command, used to add a key to the DHT. If the key is not a correct match
- * for the node, based on the ID, it is forwarded appropriately.
+ * for the node, based on the ID, it is forwarded appropriately. If the menu process tagged the
+ * command, the node that adds the key acknowledges it. The "put" command, which adds a key with a
+ * value, is routed in the same way.
  * 
  * param:  A message received from another process/node
  * return: void
@@ -363,40 +1258,38 @@ static void process_add_key( chord_msg_t msg )
             if( successor_id == INT_MAX )
             {
                 // Special case: there is no ring yet - so just add the key here.
-                keyset_add( msg.id );
-                
-                debug_printf( "[DBG] Info: Node %i added key %i\n", node_id, msg.id );
+                keep_key( msg );
             }
             else
             {
-                // Received original command - change sender and forward to the rest of the ring
-                msg.sender = MAIN_DHT_NODE;
-                write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+                // Received original command - pass it on towards the owner of the key
+                forward_request( msg );
             }
         }
         else if( msg.sender == MAIN_DHT_NODE )
         {
             // If the message got all the way around the ring, key should be placed here
-            keyset_add( msg.id );
-            
-            debug_printf( "[DBG] Info: Node %i added key %i\n", node_id, msg.id );
+            keep_key( msg );
         }
     }
     else
     {
         /*
          * Other nodes look at the message payload and compare it to their ID - if the key to 
-         * add is larger than the node ID, forward the message. Else, add it to the local keyset.
+         * add is larger than the node ID, forward the message. Else, add it to the local keyset,
+         * unless a stale finger sent the message past the key's owner.
          */
         if( msg.id > node_id )
         {
-            write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+            pass_request( next_hop( msg.id ), msg );
+        }
+        else if( owns_key( msg.id ) == false )
+        {
+            pass_request( predecessor_id, msg );
         }
         else
         {
-            keyset_add( msg.id );
-            
-            debug_printf( "[DBG] Info: Node %i added key %i\n", node_id, msg.id );
+            keep_key( msg );
         }
     }
 }
@@ -405,38 +1298,54 @@ static void process_add_key( chord_msg_t msg )
 /***************************************************************************************************
  * Function: process_redist_key
  * 
- * Processes a message that is used to redistribute keys across the DHT. If the key is not a 
- * correct match for the node, based on the ID, it is forwarded appropriately.
+ * Processes a message that is used to redistribute keys across the DHT: the keys a new node takes
+ * over from its successor. The node keeps the keys it owns. Any others belong to nodes that joined
+ * before it between it and its predecessor (if announcements were reordered), so they are passed
+ * back to the predecessor. The message first sent to a new node completes its join, which the node
+ * acknowledges if the menu process tagged the command.
  * 
- * param:  A message received from another process/node
+ * param:  A message received from another process/node (the payload is the set of keys)
  * return: void
  **************************************************************************************************/
 static void process_redist_key( chord_msg_t msg )
 {
-    /*
-     * Process a key redistribution message. If the current node ID is greater than that of the
-     * sender, the key needs to keep moving through the ring to find the added node.
-     */
-    if( node_id > msg.sender )
-    {
-        write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
-    }
-    else
+    // Local variables
+    uint64_t kept_keys = 0;       // The keys this node owns
+    
+    for( int key = 0; key < MAX_KEY_VALUE; key++ )
     {
-        // Current node ID is less than the sender, so look at the key
-        if( msg.id > node_id )
-        {
-            // Key is larger than the current node id, so forward the key
-            write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
-        }
-        else
+        if( ( msg.data & ( 1UL << key ) ) && ( owns_key( key ) == true ) )
         {
-            // Key is not larger (or equal to) node id - redistribution complete
-            keyset_add( msg.id );
+            kept_keys |= ( 1UL << key );
             
-            debug_printf( "[DBG] Info: Node %i added redistributed key %i\n", node_id, msg.id );
+            LOG_DEBUG( LOG_KEY_REDISTRIBUTED, node_id, key );
         }
     }
+    
+    if( kept_keys != 0 )
+    {
+        keyset_set_bitmap( keyset_get_bitmap() | kept_keys );
+        push_replicas( false );
+    }
+    
+    if( msg.hops == 0 )
+    {
+        msg.cmd = ADD_NODE;
+        msg.id = node_id;
+        reply_to_menu( msg, kept_keys );
+    }
+    
+    if( kept_keys != msg.data )
+    {
+        msg.cmd = REDIST_KEY;
+        msg.sender = node_id;
+        msg.tag = 0;
+        msg.hops = 1;
+        msg.data &= ~kept_keys;
+        
+        send_values( predecessor_id, msg.data );
+        send_msg( predecessor_id, &msg );
+    }
 }
 
 
@@ -444,7 +1353,8 @@ static void process_redist_key( chord_msg_t msg )
  * Function: process_delete_key
  * 
  * Processes the "delkey" command, which is used to remove a key from the DHT. If the key is not 
- * in the local key set of the node, it is forwarded appropriately.
+ * in the local key set of the node, it is forwarded appropriately. If the menu process tagged the
+ * command, the node that removes the key acknowledges it.
  * 
  * param:  A message received from another process/node
  * return: void
@@ -464,23 +1374,30 @@ static void process_delete_key( chord_msg_t msg )
             if( successor_id == INT_MAX )
             {
                 // Special case: there is no ring yet - remove the key from the local set
+                hot_note_served( &hot_tracker, msg.id );
                 keyset_remove( msg.id );
+                store_delete( &values, 1UL << msg.id );
+                push_replicas( false );
+                reply_to_menu( msg, 0 );
                 
-                debug_printf( "[DBG] Info: Node %i removed key %i\n", node_id, msg.id );
+                LOG_DEBUG( LOG_KEY_REMOVED, node_id, msg.id );
             }
             else
             {
-                // Received original command - change sender and forward to the rest of the ring
-                msg.sender = MAIN_DHT_NODE;
-                write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+                // Received original command - pass it on towards the owner of the key
+                forward_request( msg );
             }
         }
         else if( msg.sender == MAIN_DHT_NODE )
         {
             // If the message got all the way around the ring, key should be here, so remove it
+            hot_note_served( &hot_tracker, msg.id );
             keyset_remove( msg.id );
+            store_delete( &values, 1UL << msg.id );
+            push_replicas( false );
+            reply_to_menu( msg, 0 );
             
-            debug_printf( "[DBG] Info: Node %i removed key %i\n", node_id, msg.id );
+            LOG_DEBUG( LOG_KEY_REMOVED, node_id, msg.id );
         }
     }
     else
@@ -488,95 +1405,2175 @@ static void process_delete_key( chord_msg_t msg )
         // If the key is here, remove it. Otherwise, send the message along.
         if( keyset_check( msg.id ) )
         {
+            send_owner_hint( msg );
+            hot_note_served( &hot_tracker, msg.id );
             keyset_remove( msg.id );
+            store_delete( &values, 1UL << msg.id );
+            push_replicas( false );
+            reply_to_menu( msg, 0 );
             
-            debug_printf( "[DBG] Info: Node %i removed key %i\n", node_id, msg.id );
+            LOG_DEBUG( LOG_KEY_REMOVED, node_id, msg.id );
+        }
+        else if( msg.id > node_id )
+        {
+            pass_request( next_hop( msg.id ), msg );
+        }
+        else if( owns_key( msg.id ) == false )
+        {
+            pass_request( predecessor_id, msg );
         }
         else
         {
-            write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+            send_msg( successor_id, &msg );
         }
     }
 }
 
 
 /***************************************************************************************************
- * Function: process_dump
+ * Function: process_lookup_key
  * 
- * Process the "dump" command, which instructs each node to print their current key set and ID to
- * the console. This message is forwarded to all nodes in the ring.
+ * Processes the "lookup" command, which is routed to the owner of the key in the same way as the
+ * "addkey" command. The owner answers the menu process, indicating whether the key is present. If
+ * keys are replicated and the owner is busy, it hands the lookup to its replicas instead. The 
+ * "get" command, which fetches the value stored under a key, is routed in the same way.
  * 
  * param:  A message received from another process/node
  * return: void
  **************************************************************************************************/
-static void process_dump( chord_msg_t msg )
+static void process_lookup_key( chord_msg_t msg )
 {
-    if( node_id == MAIN_DHT_NODE )
+    if( msg.hops > 0 )
+    {
+        // A busy owner handed the lookup to its replicas
+        process_replica_lookup( msg );
+    }
+    else if( msg.hops < 0 )
+    {
+        // A replica handed the lookup back, as it had no copy of this node's key set
+        reply_to_menu( msg, keyset_check( msg.id ) );
+    }
+    else if( node_id == MAIN_DHT_NODE )
     {
         /*
-         * The main node (63) will receive this message twice; once from the menu process to
-         * initiate the DHT dump, and again when the message has been forwarded around the
-         * ring. Upon second receipt is when 63 dumps its key set (to maintain proper ascending 
-         * order on the console printout). Then, the message is not forwarded again.
+         * As with "addkey", the main node (63) forwards the lookup unless it is the only node, 
+         * and answers it only if the message makes its way around the ring.
          */
         if( msg.sender == MENU_PROCESS_ID )
         {
             if( successor_id == INT_MAX )
             {
-                // Special case: there is no ring yet - only this node. So just dump.
-                printf( "Node %i owns keys: ", node_id );
-                keyset_print();
+                // Special case: there is no ring yet - so answer here
+                answer_lookup( msg );
             }
             else
             {
-                // Received original command - change sender and forward to the rest of the ring
-                msg.sender = MAIN_DHT_NODE;
-                write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+                // Received original command - pass it on towards the owner of the key
+                forward_request( msg );
             }
         }
         else if( msg.sender == MAIN_DHT_NODE )
         {
-            // Now, dump main node's key set and don't forward again
-            printf( "Node %i owns keys: ", node_id );
-            keyset_print();
+            answer_lookup( msg );
         }
     }
     else
     {
-        // Dump to console
-        printf( "Node %i owns keys: ", node_id );
-        keyset_print();
-        
-        // Forward to next node
-        write( dht_pipes[successor_id][1], (void *)&msg, sizeof( msg ) );
+        /*
+         * Forward the lookup if the key is larger than the node ID, or back to the predecessor if
+         * a stale finger sent it past the owner; otherwise, this is the owner.
+         */
+        if( msg.id > node_id )
+        {
+            pass_request( next_hop( msg.id ), msg );
+        }
+        else if( owns_key( msg.id ) == false )
+        {
+            pass_request( predecessor_id, msg );
+        }
+        else
+        {
+            answer_lookup( msg );
+        }
     }
 }
 
 
 /***************************************************************************************************
- * Function: process_toggle_debug
+ * Function: process_range
  * 
- * Toggles the output of debug messages. This is useful for development purposes. By default,
- * debug is disabled.
+ * Process a range command ("scan", "count" or "delrange"). The command is routed to the owner of
+ * the first key of the range as a lookup is; from there, it is served by serve_range, which passes
+ * it along the ring until the last key of the range has been served.
  * 
  * param:  A message received from another process/node
  * return: void
  **************************************************************************************************/
-static void process_toggle_debug( chord_msg_t msg )
+static void process_range( chord_msg_t msg )
+{
+    if( node_id == MAIN_DHT_NODE )
+    {
+        /*
+         * As with "lookup", the main node (63) forwards the command unless it is the only node; it
+         * serves the command if it comes back, whether around the ring or passed along the range.
+         */
+        if( ( msg.sender == MENU_PROCESS_ID ) && ( successor_id != INT_MAX ) )
+        {
+            forward_request( msg );
+        }
+        else
+        {
+            serve_range( msg );
+        }
+    }
+    else if( msg.id > node_id )
+    {
+        pass_request( next_hop( msg.id ), msg );
+    }
+    else if( owns_key( msg.id ) == false )
+    {
+        pass_request( predecessor_id, msg );
+    }
+    else
+    {
+        serve_range( msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: serve_range
+ * 
+ * Serve the part of a range command that falls to this node: the keys from the first key of the
+ * command up to this node's ID or the last key of the range, whichever comes first. The keys are
+ * found with a single mask of the key set, and deleted all at once for a "delrange". The menu 
+ * process is answered with this part (see chord_message.h), and, unless it ends the range, the
+ * command is passed on to the successor with the rest of the range.
+ * 
+ * param:  The range command
+ * return: void
+ **************************************************************************************************/
+static void serve_range( chord_msg_t msg )
 {
-    if( msg.id == 0 )
+    // Local variables
+    int last_key;                 // The last key of the part served here
+    uint64_t keys;                // The keys of the part that are in the key set
+    chord_msg_t answer;           // The answer to the menu process
+    
+    last_key = ( msg.hops < node_id ) ? msg.hops : node_id;
+    answer = msg;
+    answer.hops = last_key;
+    send_owner_hint( msg );
+    
+    if( msg.cmd == DELETE_RANGE )
+    {
+        keys = keyset_remove_range( msg.id, last_key );
+        
+        if( keys != 0 )
+        {
+            store_delete( &values, keys );
+            push_replicas( false );
+        }
+        
+        reply_to_menu( answer, keys );
+        
+        for( int key = msg.id; key <= last_key; key++ )
+        {
+            if( ( keys & ( 1UL << key ) ) != 0 )
+            {
+                LOG_DEBUG( LOG_KEY_REMOVED, node_id, key );
+            }
+        }
+    }
+    else if( msg.cmd == COUNT )
     {
-        // Turn off debug
-        debug_disable_prints();
+        reply_to_menu( answer, __builtin_popcountll( keyset_get_range( msg.id, last_key ) ) );
     }
     else
     {
-        // Turn on debug
-        debug_enable_prints();
+        answer_values( answer, keyset_get_range( msg.id, last_key ) );
+    }
+    
+    // Pass the rest of the range on
+    if( last_key < msg.hops )
+    {
+        msg.id = last_key + 1;
+        msg.sender = node_id;
+        msg.data = 0;
+        send_msg( successor_id, &msg );
     }
 }
 
 
+/***************************************************************************************************
+ * Function: process_mget
+ * 
+ * Process a multi-get. The keys this node owns are answered here; the others are routed as 
+ * lookups are, but grouped by the node they are passed on to, so that each next hop is sent one
+ * message for all of its keys, and the owners work on their keys in parallel. As with "lookup",
+ * the main node (63) passes on every key unless it is the only node, and answers the keys that 
+ * come back to it.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_mget( chord_msg_t msg )
+{
+    // Local variables
+    uint64_t hop_keys[MAX_NODE_COUNT] = { 0 };  // The keys to pass on, by the node to pass them to
+    uint64_t own_keys = 0;                      // The keys to answer here
+    int hop_id;                                 // The node to pass a key on to
+    
+    for( int key = 0; key < MAX_KEY_VALUE; key++ )
+    {
+        if( ( msg.data & ( 1UL << key ) ) != 0 )
+        {
+            if( node_id == MAIN_DHT_NODE )
+            {
+                hop_id = ( ( msg.sender == MENU_PROCESS_ID ) && ( successor_id != INT_MAX ) ) ?
+                         owner_cache_find( &owner_cache, key ) : node_id;
+                hop_id = ( hop_id < 0 ) ? next_hop( key ) : hop_id;
+            }
+            else if( key > node_id )
+            {
+                hop_id = next_hop( key );
+            }
+            else if( owns_key( key ) == false )
+            {
+                hop_id = predecessor_id;
+            }
+            else
+            {
+                hop_id = node_id;
+            }
+            
+            if( hop_id == node_id )
+            {
+                own_keys |= ( 1UL << key );
+            }
+            else
+            {
+                hop_keys[hop_id] |= ( 1UL << key );
+            }
+        }
+    }
+    
+    // Pass the other keys on first, so that their owners start on them while this node answers
+    if( msg.sender == MENU_PROCESS_ID )
+    {
+        msg.sender = MAIN_DHT_NODE;
+    }
+    
+    for( int index = 0; index < MAX_NODE_COUNT; index++ )
+    {
+        if( hop_keys[index] != 0 )
+        {
+            msg.data = hop_keys[index];
+            hot_note_passed( &hot_tracker );
+            send_msg( index, &msg );
+        }
+    }
+    
+    if( own_keys != 0 )
+    {
+        for( int key = 0; key < MAX_KEY_VALUE; key++ )
+        {
+            if( ( own_keys & ( 1UL << key ) ) != 0 )
+            {
+                hot_note_served( &hot_tracker, key );
+            }
+        }
+        
+        answer_values( msg, own_keys );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: forward_request
+ * 
+ * Pass a request from the menu process on from the main node towards the owner of its key: 
+ * straight to the owner, if the owner cache knows it, or else through the fingers, asking the 
+ * owner to tell the main node the range of keys it owns (see send_owner_hint).
+ * 
+ * param:  The request
+ * return: void
+ **************************************************************************************************/
+static void forward_request( chord_msg_t msg )
+{
+    // Local variables
+    int owner_id;                 // The owner of the key, if known
+    
+    owner_id = owner_cache_find( &owner_cache, msg.id );
+    msg.sender = MAIN_DHT_NODE;
+    msg.data = ( msg.cmd == GET ) ? ( msg.data & ~( ( 1UL << REQUEST_VERSION_SHIFT ) - 1 ) ) : 0;
+    msg.data |= ( owner_id < 0 ) ? REQUEST_OWNER_HINT : REQUEST_CACHE_USED;
+    hot_note_passed( &hot_tracker );
+    send_msg( ( owner_id < 0 ) ? next_hop( msg.id ) : owner_id, &msg );
+}
+
+
+/***************************************************************************************************
+ * Function: pass_request
+ * 
+ * Pass on a request for a key this node does not own, asking the owner to tell the main node the
+ * range of keys it owns. Unless an owner cache has sent the request on already, the request goes
+ * straight to the owner if this node's owner cache knows it, and the owner is asked to tell this
+ * node its range too. Only one owner cache is consulted per request, so that stale entries cannot
+ * send it round in circles: if the request was sent here from an owner cache, the entry was
+ * stale, and the answer of the owner (to the node that holds it) replaces it.
+ * 
+ * param:  The node to pass the request on to (through the fingers)
+ * param:  The request
+ * return: void
+ **************************************************************************************************/
+static void pass_request( int dest_id, chord_msg_t msg )
+{
+    // Local variables
+    int owner_id;                 // The owner of the key, if known
+    
+    if( ( msg.data & REQUEST_CACHE_USED ) == 0 )
+    {
+        owner_id = owner_cache_find( &owner_cache, msg.id );
+        msg.data &= ~( REQUEST_HINT_MASK << REQUEST_HINT_SHIFT );
+        msg.data |= (uint64_t)( node_id + 1 ) << REQUEST_HINT_SHIFT;
+        
+        if( ( owner_id >= 0 ) && ( owner_id != node_id ) )
+        {
+            msg.data |= REQUEST_CACHE_USED;
+            dest_id = owner_id;
+        }
+    }
+    
+    msg.data |= REQUEST_OWNER_HINT;
+    hot_note_passed( &hot_tracker );
+    send_msg( dest_id, &msg );
+}
+
+
+/***************************************************************************************************
+ * Function: send_owner_hint
+ * 
+ * Tell the main node the range of keys this node owns, if a request for one of them that entered
+ * the ring at the main node asks for it (see forward_request), and the node that passed it on
+ * from its own owner cache or fingers, if the request names one (see pass_request), so that they
+ * can send further requests for them straight here.
+ * 
+ * param:  The request
+ * return: void
+ **************************************************************************************************/
+static void send_owner_hint( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t hint;             // The range of keys this node owns
+    bool to_main;                 // Flag: "the main node is to be told"
+    int hint_id;                  // The other node to tell (-1 if none)
+    
+    to_main = ( ( msg.data & REQUEST_OWNER_HINT ) != 0 ) && ( msg.sender == MAIN_DHT_NODE );
+    hint_id = (int)( ( msg.data >> REQUEST_HINT_SHIFT ) & REQUEST_HINT_MASK ) - 1;
+    
+    hint.cmd = OWNER;
+    hint.sender = node_id;
+    hint.tag = 0;
+    hint.hops = node_id;
+    hint.length = 0;
+    hint.data = 0;
+    hint.id = ( first_owned_key() < 0 ) ? msg.id : first_owned_key();
+    
+    if( ( to_main == true ) && ( node_id != MAIN_DHT_NODE ) )
+    {
+        send_msg( MAIN_DHT_NODE, &hint );
+    }
+    
+    if( ( hint_id >= 0 ) && ( hint_id < MAX_NODE_COUNT ) && ( hint_id != node_id ) && 
+        ( ( hint_id != MAIN_DHT_NODE ) || ( to_main == false ) ) && ( node_id != MAIN_DHT_NODE ) )
+    {
+        send_msg( hint_id, &hint );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_owner
+ * 
+ * Record the range of keys a node owns in the owner cache.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_owner( chord_msg_t msg )
+{
+    owner_cache_learn( &owner_cache, msg.id, msg.hops, msg.sender );
+}
+
+
+/***************************************************************************************************
+ * Function: send_cache_value
+ * 
+ * Send the main node a copy of the value of a key this node owns, if the "get" answered with it
+ * asks for one (see filter_request) and the key is among this node's hot keys, having been read
+ * at least VALUE_CACHE_HOT_READS times lately. The main node keeps its own copy at once.
+ * 
+ * param:  The "get"
+ * param:  The value
+ * param:  The length of the value, in bytes
+ * return: void
+ **************************************************************************************************/
+static void send_cache_value( chord_msg_t msg, const char *value, int length )
+{
+    // Local variables
+    chord_msg_t copy;             // The copy of the value
+    
+    if( ( ( msg.data >> REQUEST_VERSION_SHIFT ) != 0 ) &&
+        ( hot_key_requests( &hot_tracker, msg.id ) >= VALUE_CACHE_HOT_READS ) )
+    {
+        copy.cmd = CACHE_VALUE;
+        copy.id = msg.id;
+        copy.sender = node_id;
+        copy.tag = 0;
+        copy.hops = 0;
+        copy.length = length;
+        copy.data = msg.data >> REQUEST_VERSION_SHIFT;
+        
+        if( node_id == MAIN_DHT_NODE )
+        {
+            memcpy( received.payload, value, length );
+            process_cache_value( copy );
+        }
+        else
+        {
+            send_payload_msg( MAIN_DHT_NODE, &copy, value );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_cache_value
+ * 
+ * Keep a copy of the value of a hot key in the value cache, unless the key has changed since the
+ * copy was asked for.
+ * 
+ * param:  A message received from another process/node (the value is its payload)
+ * return: void
+ **************************************************************************************************/
+static void process_cache_value( chord_msg_t msg )
+{
+    // Local variables
+    struct timespec now;          // The current time
+    
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    value_cache_store( &value_cache, msg.id, (uint32_t)msg.data, msg.sender, received.payload, 
+                       msg.length, now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6 );
+}
+
+
+/***************************************************************************************************
+ * Function: first_owned_key
+ * 
+ * Find the first key this node owns: the key after its predecessor, or zero if this is the lowest
+ * node (which owns all keys up to its ID).
+ * 
+ * param:  void
+ * return: The key, or -1 if the predecessor is not known
+ **************************************************************************************************/
+static int first_owned_key()
+{
+    // Local variables
+    int first_key = -1;           // The first key this node owns
+    
+    if( predecessor_id != INT_MAX )
+    {
+        first_key = ( predecessor_id > node_id ) ? 0 : predecessor_id + 1;
+    }
+    
+    return( first_key );
+}
+
+
+/***************************************************************************************************
+ * Function: process_broadcast
+ * 
+ * Process a command meant for every node in the ring: a dump (each node prints its ID and key set
+ * to the console), a debug toggle, a report request (each node reports its state back to the menu
+ * process, see below) or a statistics request. The command reaches the main node from the menu 
+ * process, and is spread from there over a tree built from the finger tables (see 
+ * chord_broadcast.h); the hops field carries the end of the part of the ring the receiving node 
+ * is to pass it on to.
+ * 
+ * A report carries the number of messages sent by the node in its ID field, the node whose 
+ * process hosts it (its own ID, unless it is a virtual node) in its hops field, and the key set 
+ * as its payload. If the menu process asked for an answer to a dump or statistics request, the 
+ * nodes answer it together, with the number of nodes reached in the ID field, the messages they 
+ * have sent in the hops field and the union of their key sets as the payload, followed by the sum
+ * of their store counters.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_broadcast( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t answer;                          // This node's report
+    chord_payload_msg_t aggregate;               // This node's answer
+    int known_ids[FINGER_COUNT + 1];             // The successor and fingers
+    int child_ids[FINGER_COUNT + 1];             // The nodes to pass the command on to
+    int limit_ids[FINGER_COUNT + 1];             // The end of the part of the ring each covers
+    int child_count = 0;                         // The number of nodes to pass the command on to
+    int parent_id = msg.sender;                  // The node to answer
+    int limit_id;                                // The end of the part of the ring to cover
+    int range;                                   // The number of IDs in that part of the ring
+    bool reached;                                // Flag: "this node lies in that part"
+    struct timespec now;                         // The current time
+    chord_store_stats_t stats;                   // This node's store and owner cache counters
+    
+    // The main node covers the whole ring
+    limit_id = ( parent_id == MENU_PROCESS_ID ) ? node_id : msg.hops;
+    
+    /*
+     * A stale finger may have sent the command to a node that has left the ring, whose pipe has 
+     * passed to its successor. If the successor lies beyond the limit, the command reaches it 
+     * along another branch of the tree, so here it only answers.
+     */
+    reached = ( parent_id == MENU_PROCESS_ID ) || between( node_id, parent_id, limit_id );
+    
+    if( reached == true )
+    {
+        switch( msg.cmd )
+        {
+            case( DUMP ):
+                printf( "Node %i owns keys: ", node_id );
+                keyset_print();
+                
+                // Print before answering, so that the lines come before the menu's summary
+                fflush( stdout );
+                break;
+                
+            case( TOGGLE_DEBUG ):
+                if( msg.id == 0 )
+                {
+                    log_disable();
+                }
+                else
+                {
+                    log_enable();
+                }
+                break;
+                
+            case( REPORT ):
+                answer = msg;
+                answer.id = msgs_sent;
+                answer.hops = hosted_ids[0];
+                reply_to_menu( answer, keyset_get_bitmap() );
+                break;
+                
+            default:
+                break;
+        }
+        
+        // Pass the command on, giving each node the part of the ring up to the next
+        known_ids[0] = successor_id;
+        memcpy( &known_ids[1], fingers, sizeof( fingers ) );
+        child_count = broadcast_children( node_id, limit_id, known_ids, FINGER_COUNT + 1, 
+                                          child_ids, limit_ids );
+        msg.sender = node_id;
+        
+        for( int index = 0; index < child_count; index++ )
+        {
+            msg.hops = limit_ids[index];
+            send_msg( child_ids[index], &msg );
+        }
+    }
+    
+    // Answer once the nodes the command was passed on to have answered (or stopped waiting)
+    if( ( msg.tag != 0 ) && ( ( msg.cmd == DUMP ) || ( msg.cmd == STATS ) ) )
+    {
+        aggregate.msg.cmd = AGGREGATE;
+        aggregate.msg.id = ( reached == true ) ? 1 : 0;
+        aggregate.msg.sender = node_id;
+        aggregate.msg.tag = msg.tag;
+        aggregate.msg.hops = ( reached == true ) ? msgs_sent : 0;
+        aggregate.msg.data = ( reached == true ) ? keyset_get_bitmap() : 0;
+        aggregate.msg.length = ( reached == true ) ? sizeof( chord_store_stats_t ) : 0;
+        store_get_stats( &values, &stats );
+        stats.owner_cache_lookups = owner_cache.lookups;
+        stats.owner_cache_hits = owner_cache.hits;
+        stats.value_cache_lookups = value_cache.lookups;
+        stats.value_cache_hits = value_cache.hits;
+        hot_report( &hot_tracker, node_id, first_owned_key(), &stats );
+        memcpy( aggregate.payload, &stats, sizeof( stats ) );
+        
+        clock_gettime( CLOCK_MONOTONIC, &now );
+        range = ( limit_id - node_id + MAX_NODE_COUNT - 1 ) % MAX_NODE_COUNT + 1;
+        
+        if( ( child_count == 0 ) || 
+            ( broadcast_open( node_id, parent_id, msg.tag, child_count, &aggregate.msg, 
+                              now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6 + 
+                              (double)BROADCAST_TIMEOUT_MS * range / MAX_NODE_COUNT ) == false ) )
+        {
+            answer_broadcast( parent_id, &aggregate );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_aggregate
+ * 
+ * Process the answer to a broadcast from a node it was passed on to. Once every such node has 
+ * answered, the combined answer is passed up the tree.
+ * 
+ * param:  A message received from another process/node (its store counters are its payload)
+ * return: void
+ **************************************************************************************************/
+static void process_aggregate( chord_msg_t msg )
+{
+    // Local variables
+    chord_payload_msg_t answer;   // The combined answer
+    int parent_id;                // The node to pass it to
+    
+    if( broadcast_collect( node_id, &msg, received.payload, &answer, &parent_id ) == true )
+    {
+        answer.msg.sender = node_id;
+        answer_broadcast( parent_id, &answer );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_replicate
+ * 
+ * Process a copy of another node's key set, which is passed along the ring to as many successors
+ * of the owner as the replication factor. The copy is stored and passed on; the successor beyond
+ * the last replica discards any copy it holds, since a join has pushed it out of the replica set.
+ * 
+ * param:  A message received from another process/node (the ID is the owner of the key set)
+ * return: void
+ **************************************************************************************************/
+static void process_replicate( chord_msg_t msg )
+{
+    // Local variables
+    uint64_t owner_bit = ( 1UL << msg.id );   // The owner's bit in the replica owner bitmap
+    
+    if( msg.id == node_id )
+    {
+        // The copy went all the way around a ring smaller than the replica set
+        return;
+    }
+    
+    if( msg.hops > 0 )
+    {
+        replica_owners |= owner_bit;
+        replica_keys[msg.id] = msg.data;
+        replica_hops[msg.id] = msg.hops - 1;
+        
+        msg.sender = node_id;
+        msg.hops--;
+        send_msg( successor_id, &msg );
+    }
+    else
+    {
+        replica_owners &= ~owner_bit;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_replica_lookup
+ * 
+ * Process a lookup that a busy owner handed to its replicas. The replica answers from its copy of
+ * the owner's key set, unless it is busy as well and further replicas remain. A node that holds 
+ * no copy (the replica set is being rebuilt after a join) hands the lookup back to the owner.
+ * 
+ * param:  A message received from another process/node (the sender is the owner of the key)
+ * return: void
+ **************************************************************************************************/
+static void process_replica_lookup( chord_msg_t msg )
+{
+    if( ( replica_owners & ( 1UL << msg.sender ) ) == 0 )
+    {
+        msg.hops = -1;
+        send_msg( msg.sender, &msg );
+    }
+    else if( ( msg.hops > 1 ) && ( transport->backlog() > LOOKUP_BUSY_BYTES ) )
+    {
+        msg.hops--;
+        send_msg( successor_id, &msg );
+    }
+    else
+    {
+        reply_to_menu( msg, ( replica_keys[msg.sender] >> msg.id ) & 1 );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_repair
+ * 
+ * Process the supervisor's instruction to repair the ring around a failed node. The failed node's
+ * successor takes over its keys, restoring them from its replica if it holds one, or else from 
+ * the snapshot the failed node last sent with a heartbeat, and receives the messages left in (and
+ * still being sent to) the failed node's pipe. The failed node's predecessor links to the 
+ * successor. Each acknowledges the repair to the supervisor.
+ * 
+ * param:  A message received from the supervisor (the ID is the failed node, the sender the node
+ *         that takes over from it, the tag its predecessor, and the payload the failed node's 
+ *         last key set snapshot)
+ * return: void
+ **************************************************************************************************/
+static void process_repair( chord_msg_t msg )
+{
+    // Local variables
+    uint64_t failed_bit = ( 1UL << msg.id );  // The failed node's bit in node bitmaps
+    uint64_t restored = 0;                    // The keys taken over from the failed node
+    bool from_replica = false;                // Flag: "the keys were restored from a replica"
+    chord_msg_t ack;                          // Acknowledgement to the supervisor
+    
+    if( msg.sender == node_id )
+    {
+        from_replica = ( ( replica_owners & failed_bit ) != 0 );
+        restored = ( from_replica == true ) ? replica_keys[msg.id] : msg.data;
+        replica_owners &= ~failed_bit;
+        
+        keyset_set_bitmap( keyset_get_bitmap() | restored );
+        store_drop_owner( msg.id );
+        
+        /*
+         * Take over the pipes of every node between the predecessor and this node: the failed 
+         * node's, and those it had taken over itself. Several nodes may read a pipe in turn (e.g.
+         * if a failed node is added again), so none may block on it.
+         */
+        for( int id = ( msg.tag + 1 ) % MAX_NODE_COUNT; id != node_id; id++ )
+        {
+            fcntl( dht_pipes[id][0], F_SETFL, O_NONBLOCK );
+            adopted_inboxes |= ( 1UL << id );
+        }
+        
+        // The failed node's predecessor is this node's predecessor now
+        predecessor_id = ( msg.tag == node_id ) ? INT_MAX : msg.tag;
+        
+        LOG_INFO( LOG_REPAIR_TAKEOVER, node_id, msg.id, __builtin_popcountll( restored ),
+                  from_replica );
+    }
+    
+    replace_finger( msg.id, msg.sender );
+    owner_cache_forget( &owner_cache, msg.id );
+    
+    if( successor_id == msg.id )
+    {
+        // If the successor is this node, the ring is back to the main node alone
+        set_successor( ( msg.sender == node_id ) ? INT_MAX : msg.sender );
+        
+        LOG_INFO( LOG_REPAIR_SPLICED, node_id, msg.id, successor_id );
+        
+        // The new successor takes the failed node's place in the replica sets
+        push_replicas( true );
+    }
+    else if( msg.sender == node_id )
+    {
+        push_replicas( false );
+    }
+    
+    ack.cmd = REPAIR;
+    ack.id = msg.id;
+    ack.sender = node_id;
+    ack.tag = 0;
+    ack.hops = from_replica;
+    ack.data = restored;
+    write( heartbeat_pipe, (const void *)&ack, sizeof( ack ) );
+}
+
+
+/***************************************************************************************************
+ * Function: process_crash
+ * 
+ * Process the "crash" command, which makes a node fail abruptly so that failure detection and 
+ * ring repair can be exercised. The message is routed along the ring to the node, which kills 
+ * its process (and with it, any other nodes the process hosts). The main node cannot be crashed 
+ * this way.
+ * 
+ * param:  A message received from another process/node (the ID is the node to crash)
+ * return: void
+ **************************************************************************************************/
+static void process_crash( chord_msg_t msg )
+{
+    if( node_id == MAIN_DHT_NODE )
+    {
+        // Forward the command to the rest of the ring; drop it if it comes all the way back
+        if( ( msg.sender == MENU_PROCESS_ID ) && ( successor_id != INT_MAX ) )
+        {
+            msg.sender = MAIN_DHT_NODE;
+            send_msg( successor_id, &msg );
+        }
+    }
+    else if( msg.id == node_id )
+    {
+        // A virtual node hosted by the main node's process cannot be crashed either
+        if( hosted_ids[0] != MAIN_DHT_NODE )
+        {
+            raise( SIGKILL );
+        }
+    }
+    else if( msg.id > node_id )
+    {
+        send_msg( successor_id, &msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_leave
+ * 
+ * Process the "delnode" command, which removes a node from the ring. The message is routed along
+ * the ring to the node, which hands its whole key set to its successor in a single message, and
+ * from then on passes every message it receives to the successor. The node exits once its 
+ * predecessor has linked past it (see process_handoff). The main node cannot leave.
+ * 
+ * param:  A message received from another process/node (the ID is the node to remove)
+ * return: void
+ **************************************************************************************************/
+static void process_leave( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t handoff_msg;      // The departing node's key set
+    
+    if( node_id == MAIN_DHT_NODE )
+    {
+        // Forward the command to the rest of the ring; drop it if it comes all the way back
+        if( ( msg.sender == MENU_PROCESS_ID ) && ( successor_id != INT_MAX ) )
+        {
+            msg.sender = MAIN_DHT_NODE;
+            send_msg( successor_id, &msg );
+        }
+    }
+    else if( msg.id == node_id )
+    {
+        handoff_msg.cmd = HANDOFF;
+        handoff_msg.id = node_id;
+        handoff_msg.sender = node_id;
+        handoff_msg.tag = msg.tag;
+        handoff_msg.hops = 0;
+        handoff_msg.data = keyset_get_bitmap();
+        
+        LOG_INFO( LOG_NODE_LEAVING, node_id, successor_id, 
+                  __builtin_popcountll( handoff_msg.data ) );
+        
+        send_values( successor_id, handoff_msg.data );
+        store_free( &values );
+        keyset_init();
+        leaving = true;
+        send_msg( successor_id, &handoff_msg );
+    }
+    else if( msg.id > node_id )
+    {
+        send_msg( successor_id, &msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_handoff
+ * 
+ * Process the key set of a departing node. The successor adds the keys to its own, then sends the
+ * message on around the ring, naming itself as the departing node's replacement. The node whose
+ * successor is the departing node (its predecessor) links to the replacement instead and returns
+ * the message to the departing node, which can then exit.
+ * 
+ * param:  A message received from another process/node (the ID is the departing node, and the 
+ *         payload its key set)
+ * return: void
+ **************************************************************************************************/
+static void process_handoff( chord_msg_t msg )
+{
+    if( msg.id == node_id )
+    {
+        finish_leaving( msg );
+    }
+    else if( msg.hops > 0 )
+    {
+        /*
+         * The departing node has exited: take over its pipe, as nodes with stale fingers may
+         * still send messages to it (until a node with its ID joins again).
+         */
+        fcntl( dht_pipes[msg.id][0], F_SETFL, O_NONBLOCK );
+        adopted_inboxes |= ( 1UL << msg.id );
+    }
+    else
+    {
+        if( msg.sender == msg.id )
+        {
+            // This is the successor: take over the keys, and the departing node's place
+            keyset_set_bitmap( keyset_get_bitmap() | msg.data );
+            replica_owners &= ~( 1UL << msg.id );
+            push_replicas( false );
+            
+            LOG_INFO( LOG_HANDOFF_RECEIVED, node_id, msg.id, __builtin_popcountll( msg.data ) );
+            
+            // The departing node's predecessor is not known here; it notifies this node in time
+            predecessor_id = INT_MAX;
+            msg.sender = node_id;
+        }
+        
+        replace_finger( msg.id, msg.sender );
+        owner_cache_forget( &owner_cache, msg.id );
+        
+        if( successor_id == msg.id )
+        {
+            // If the replacement is this node, the ring is back to the main node alone
+            set_successor( ( msg.sender == node_id ) ? INT_MAX : msg.sender );
+            
+            LOG_INFO( LOG_LEAVE_SPLICED, node_id, msg.id, successor_id );
+            
+            // The replacement takes the departing node's place in the replica sets
+            push_replicas( true );
+            send_msg( msg.id, &msg );
+        }
+        else
+        {
+            send_msg( successor_id, &msg );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: finish_leaving
+ * 
+ * Complete this node's departure from the ring, once no node links to it any more: the supervisor
+ * is told not to treat the exit as a failure, the menu process is answered, any messages still 
+ * queued for this node are passed to its successor, the successor is told to take over the pipe,
+ * and the process exits (unless it hosts other nodes, which carry on).
+ * 
+ * param:  The returned handoff message
+ * return: void
+ **************************************************************************************************/
+static void finish_leaving( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t notice;           // Notice of the departure to the supervisor
+    
+    store_drop_owner( node_id );
+    
+    if( heartbeat_pipe >= 0 )
+    {
+        notice.cmd = LEAVE;
+        notice.id = getpid();
+        notice.sender = node_id;
+        notice.tag = 0;
+        notice.hops = 0;
+        notice.data = 0;
+        write( heartbeat_pipe, (const void *)&notice, sizeof( notice ) );
+    }
+    
+    msg.cmd = LEAVE;
+    reply_to_menu( msg, msg.data );
+    
+    fcntl( dht_pipes[node_id][0], F_SETFL, O_NONBLOCK );
+    
+    while( read_msg( dht_pipes[node_id][0] ) == true )
+    {
+        send_msg( successor_id, &received.msg );
+    }
+    
+    msg.cmd = HANDOFF;
+    msg.hops = 1;
+    send_msg( successor_id, &msg );
+    
+    // The process carries on while it hosts other nodes
+    if( hosted_count > 1 )
+    {
+        remove_running_node();
+        return;
+    }
+    
+    // Messages held back by network emulation are sent before exiting
+    while( netem_next_due_ms() >= 0 )
+    {
+        poll( NULL, 0, netem_next_due_ms() );
+        netem_flush();
+    }
+    
+    exit( EXIT_SUCCESS );
+}
+
+
+/***************************************************************************************************
+ * Function: process_stabilize
+ * 
+ * Answer a stabilization request from this node's predecessor (or a node that believes it is), 
+ * with this node's predecessor, process ID and successor list.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_stabilize( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t reply;            // The answer
+    
+    reply.cmd = PREDECESSOR;
+    reply.id = predecessor_id;
+    reply.sender = node_id;
+    reply.tag = getpid();
+    reply.hops = 0;
+    reply.data = pack_successors();
+    
+    send_msg( msg.sender, &reply );
+}
+
+
+/***************************************************************************************************
+ * Function: process_predecessor
+ * 
+ * Process the successor's answer to a stabilization request. If the successor's predecessor lies
+ * between this node and the successor, it becomes the new successor; otherwise, the successor 
+ * list is rebuilt from the successor's own. Either way, the successor is then notified of this 
+ * node. Answers from nodes that are no longer the successor are ignored.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_predecessor( chord_msg_t msg )
+{
+    // Local variables
+    int list_id;                  // A node ID from the successor's list
+    int index = 1;                // Used to index the successor list
+    bool list_ended = false;      // Flag: "the end of the successor's list has been reached"
+    chord_msg_t notify_msg;       // Notification to the successor
+    
+    if( msg.sender == successor_id )
+    {
+        stabilize_missed = 0;
+        successor_pid = msg.tag;
+        
+        if( ( msg.id != INT_MAX ) && ( between( msg.id, node_id, successor_id ) == true ) )
+        {
+            LOG_INFO( LOG_SUCCESSOR_FOUND, node_id, successor_id, msg.id );
+            
+            set_successor( msg.id );
+            push_replicas( true );
+        }
+        else
+        {
+            // The successor's list, less its last entry, follows the successor on this node's list
+            for( int shift = 0; shift < 8 * ( SUCCESSOR_LIST_LENGTH - 1 ); shift += 8 )
+            {
+                list_id = ( msg.data >> shift ) & 0xFF;
+                
+                // The list ends where the successor's does, or at this node if the ring is short
+                if( ( list_id == 0xFF ) || ( list_id == node_id ) )
+                {
+                    list_ended = true;
+                }
+                
+                if( list_ended == false )
+                {
+                    successors[index++] = list_id;
+                }
+            }
+            
+            for( ; index < SUCCESSOR_LIST_LENGTH; index++ )
+            {
+                successors[index] = INT_MAX;
+            }
+        }
+        
+        notify_msg.cmd = NOTIFY;
+        notify_msg.id = successor_id;
+        notify_msg.sender = node_id;
+        notify_msg.tag = 0;
+        notify_msg.hops = 0;
+        notify_msg.data = 0;
+        
+        send_msg( successor_id, &notify_msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_notify
+ * 
+ * Process a notification from a node that believes it is this node's predecessor. It becomes the 
+ * predecessor if none is known, or if it lies between the current predecessor and this node.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+static void process_notify( chord_msg_t msg )
+{
+    if( ( msg.sender != node_id ) && 
+        ( ( predecessor_id == INT_MAX ) || 
+          ( between( msg.sender, predecessor_id, node_id ) == true ) ) )
+    {
+        predecessor_id = msg.sender;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_find_successor
+ * 
+ * Find the node that owns an ID, for a node refreshing one of its fingers. If the ID lies between
+ * this node and its successor, the successor owns it and the answer is sent to the node that asked;
+ * otherwise, the request is passed on along the fingers.
+ * 
+ * param:  A message received from another process/node (the ID to find, and the tag the index of
+ *         the finger being refreshed)
+ * return: void
+ **************************************************************************************************/
+static void process_find_successor( chord_msg_t msg )
+{
+    // Local variables
+    int owner_id = INT_MAX;       // The node that owns the ID, if known here
+    
+    if( msg.id == node_id )
+    {
+        owner_id = node_id;
+    }
+    else if( successor_id == INT_MAX )
+    {
+        // Only the main node is left, so it owns every ID
+        owner_id = node_id;
+    }
+    else if( ( msg.id == successor_id ) || 
+             ( between( msg.id, node_id, successor_id ) == true ) )
+    {
+        owner_id = successor_id;
+    }
+    else
+    {
+        send_msg( next_hop( msg.id ), &msg );
+    }
+    
+    if( owner_id != INT_MAX )
+    {
+        msg.cmd = FINGER;
+        msg.id = owner_id;
+        
+        if( msg.sender == node_id )
+        {
+            process_finger( msg );
+        }
+        else
+        {
+            send_msg( msg.sender, &msg );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_finger
+ * 
+ * Process the answer to a finger lookup.
+ * 
+ * param:  A message received from another process/node (the ID is the owner, and the tag the
+ *         index of the finger)
+ * return: void
+ **************************************************************************************************/
+static void process_finger( chord_msg_t msg )
+{
+    fingers[msg.tag] = ( msg.id == node_id ) ? INT_MAX : msg.id;
+}
+
+
+/***************************************************************************************************
+ * Function: process_host_node
+ * 
+ * Start a virtual node in this process, as assigned by the node that inserts it into the ring (see
+ * host_spawn). The new node starts from the assignment as a node taken from the pool does, and is 
+ * run alongside the other nodes this process hosts.
+ * 
+ * param:  A message received from another process/node (the assignment)
+ * return: void
+ **************************************************************************************************/
+static void process_host_node( chord_msg_t msg )
+{
+    if( hosted_count == MAX_VIRTUAL_NODES )
+    {
+        LOG_ERROR( LOG_NODE_CREATE_FAILED, msg.id, ENOSPC );
+    }
+    else
+    {
+        get_node_state( &hosted_nodes[running_node] );
+        running_node = hosted_count++;
+        hosted_ids[running_node] = msg.id;
+        
+        node_id = msg.sender;
+        successor_id = msg.hops;
+        unpack_successors( msg.data );
+        
+        // The host's fingers point the wrong way for the new node; stabilization fills them in
+        for( int index = 0; index < FINGER_COUNT; index++ )
+        {
+            fingers[index] = INT_MAX;
+        }
+        
+        init_new_node( msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: process_values
+ * 
+ * Process values moved to this node with the keys they are stored under (see send_values): the
+ * run of records that follows the message is appended to this node's arena as it is.
+ * 
+ * param:  A message received from another process/node (the payload is the set of keys)
+ * return: void
+ **************************************************************************************************/
+static void process_values( chord_msg_t msg )
+{
+    store_unpack( &values, received.payload, msg.length );
+}
+
+
+/***************************************************************************************************
+ * Function: process_bulk_values
+ * 
+ * Process values moved to this node in bulk (see pipe_bulk): the VALUES message that waits in the
+ * bulk pipe is read, and its records are read from the pipe straight into this node's arena. The
+ * records of a message that cannot be stored are read and dropped, so that the next transfer is
+ * read from its start.
+ * 
+ * param:  A message received from another process/node (the node the values were sent to)
+ * return: void
+ **************************************************************************************************/
+static void process_bulk_values( chord_msg_t msg )
+{
+    // Local variables
+    chord_msg_t header;           // The VALUES message in the bulk pipe
+    int handle;                   // The bulk pipe
+    int left;                     // The bytes of records left to drop
+    ssize_t count = 1;            // The bytes dropped by a read
+    
+    handle = bulk_pipes[msg.id][0];
+    
+    if( ( read( handle, (void *)&header, sizeof( header ) ) == sizeof( header ) ) && 
+        ( header.cmd == VALUES ) && 
+        ( store_receive( &values, handle, header.length ) == false ) )
+    {
+        for( left = header.length; ( left > 0 ) && ( count > 0 ); left -= count )
+        {
+            count = read( handle, (void *)received.payload, 
+                          ( left < MAX_PAYLOAD_SIZE ) ? left : MAX_PAYLOAD_SIZE );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: set_successor
+ * 
+ * Change this node's successor, keeping the successor list in order: nodes the new successor 
+ * comes before stay on the list, while any it replaces are dropped.
+ * 
+ * param:  The ID of the new successor (INT_MAX if there is none)
+ * return: void
+ **************************************************************************************************/
+static void set_successor( int new_successor_id )
+{
+    // Local variables
+    int old_successors[SUCCESSOR_LIST_LENGTH];    // The successor list before the change
+    int count = 0;                                // The number of successors on the new list
+    
+    memcpy( old_successors, successors, sizeof( successors ) );
+    
+    // Nothing is known yet of the new successor's process
+    if( new_successor_id != successor_id )
+    {
+        successor_pid = 0;
+        stabilize_missed = 0;
+    }
+    
+    successor_id = new_successor_id;
+    
+    if( new_successor_id != INT_MAX )
+    {
+        successors[count++] = new_successor_id;
+        
+        for( int index = 0; index < SUCCESSOR_LIST_LENGTH; index++ )
+        {
+            if( ( count < SUCCESSOR_LIST_LENGTH ) && ( old_successors[index] != INT_MAX ) &&
+                ( between( old_successors[index], new_successor_id, node_id ) == true ) )
+            {
+                successors[count++] = old_successors[index];
+            }
+        }
+    }
+    
+    for( count; count < SUCCESSOR_LIST_LENGTH; count++ )
+    {
+        successors[count] = INT_MAX;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: replace_finger
+ * 
+ * Point the fingers that refer to a node that has left (or failed) at the node that replaced it.
+ * 
+ * param:  The ID of the node that has left
+ * param:  The ID of the node that replaced it
+ * return: void
+ **************************************************************************************************/
+static void replace_finger( int old_id, int new_id )
+{
+    for( int index = 0; index < FINGER_COUNT; index++ )
+    {
+        if( fingers[index] == old_id )
+        {
+            fingers[index] = ( new_id == node_id ) ? INT_MAX : new_id;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: next_hop
+ * 
+ * Choose the node to send a message for an ID to: the finger that comes closest to the ID without
+ * passing it, going around the ring from this node, or the successor if no finger does. Fingers
+ * may be stale, but any node that has not passed the ID is still on the way to its owner.
+ * 
+ * param:  The ID (a key or node ID)
+ * return: The ID of the node to send the message to
+ **************************************************************************************************/
+static int next_hop( int target_id )
+{
+    // Local variables
+    int hop_id = successor_id;                                       // The chosen node
+    int best = 0;                                                    // Its distance from here
+    int target = ( target_id - node_id + MAX_NODE_COUNT ) % MAX_NODE_COUNT;  // Target distance
+    int distance;                                                    // A finger's distance
+    
+    for( int index = 0; index < FINGER_COUNT; index++ )
+    {
+        distance = ( fingers[index] - node_id + MAX_NODE_COUNT ) % MAX_NODE_COUNT;
+        
+        if( ( fingers[index] != INT_MAX ) && ( distance > best ) && ( distance <= target ) )
+        {
+            hop_id = fingers[index];
+            best = distance;
+        }
+    }
+    
+    if( hop_id == INT_MAX )
+    {
+        hop_id = node_id;
+    }
+    
+    return hop_id;
+}
+
+
+/***************************************************************************************************
+ * Function: between
+ * 
+ * Check whether an ID lies strictly between two others, going clockwise around the ring.
+ * 
+ * param:  The ID to check
+ * param:  The ID the interval starts after
+ * param:  The ID the interval ends before
+ * return: True if the ID lies in the interval
+ **************************************************************************************************/
+static bool between( int id, int from_id, int to_id )
+{
+    // Local variables
+    bool result;                  // The result of the check
+    
+    if( from_id < to_id )
+    {
+        result = ( id > from_id ) && ( id < to_id );
+    }
+    else
+    {
+        // The interval wraps around (or, if both ends are the same, covers the whole ring)
+        result = ( ( id > from_id ) || ( id < to_id ) ) && ( id != from_id );
+    }
+    
+    return result;
+}
+
+
+/***************************************************************************************************
+ * Function: owns_key
+ * 
+ * Check whether this node owns a key that is not larger than its ID, i.e. whether the key is 
+ * larger than the ID of its predecessor. If the predecessor is not known, the node assumes so.
+ * 
+ * param:  The key
+ * return: True if the key belongs to this node
+ **************************************************************************************************/
+static bool owns_key( int key )
+{
+    return ( predecessor_id == INT_MAX ) || ( predecessor_id > node_id ) || 
+           ( key > predecessor_id );
+}
+
+
+/***************************************************************************************************
+ * Function: answer_lookup
+ * 
+ * Answer a lookup for a key this node owns. If keys are replicated and messages are queueing up
+ * for this node, the lookup is handed to the first replica rather than answered here. A "get" is
+ * always answered here (replicas hold no values), with whether the key is present as the payload
+ * and the value stored under it, if any, following the reply.
+ * 
+ * param:  The lookup
+ * return: void
+ **************************************************************************************************/
+static void answer_lookup( chord_msg_t msg )
+{
+    // Local variables
+    chord_payload_msg_t reply;    // The answer to a "get"
+    const char *value = "";       // The value stored under the key
+    
+    send_owner_hint( msg );
+    hot_note_served( &hot_tracker, msg.id );
+    
+    if( msg.cmd == GET )
+    {
+        if( msg.tag != 0 )
+        {
+            reply.msg = msg;
+            reply.msg.sender = node_id;
+            reply.msg.data = keyset_check( msg.id );
+            reply.msg.length = store_get( &values, msg.id, &value );
+            reply.msg.length = ( reply.msg.length < 0 ) ? 0 : reply.msg.length;
+            memcpy( reply.payload, value, reply.msg.length );
+            
+            transport->reply( &reply.msg );
+            
+            if( reply.msg.data != 0 )
+            {
+                send_cache_value( msg, value, reply.msg.length );
+            }
+        }
+    }
+    else if( ( replication_factor > 0 ) && ( successor_id != INT_MAX ) &&
+             ( transport->backlog() > LOOKUP_BUSY_BYTES ) )
+    {
+        msg.sender = node_id;
+        msg.hops = replication_factor;
+        send_msg( successor_id, &msg );
+    }
+    else
+    {
+        reply_to_menu( msg, keyset_check( msg.id ) );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: answer_values
+ * 
+ * Answer a "scan" or multi-get with the keys served by this node, followed by their values in 
+ * order (see chord_message.h). The answer is split into chunks of consecutive keys wherever the
+ * values would not fit in a single message; for a scan, each chunk covers the keys up to the next.
+ * 
+ * param:  The answer (for a scan, with the first and last key of the part in its ID and hops 
+ *         fields)
+ * param:  The keys to answer with
+ * return: void
+ **************************************************************************************************/
+static void answer_values( chord_msg_t msg, uint64_t keys )
+{
+    // Local variables
+    chord_payload_msg_t chunk;    // The chunk being filled
+    const char *value = "";       // The value stored under a key
+    uint16_t length;              // Its length (or VALUE_ABSENT_LENGTH)
+    int stored;                   // The length returned by the store (negative if none)
+    int bytes;                    // The bytes of the value that follow its length
+    int last_key = msg.hops;      // The last key of the part (for a scan)
+    
+    if( msg.tag != 0 )
+    {
+        chunk.msg = msg;
+        chunk.msg.sender = node_id;
+        chunk.msg.data = 0;
+        chunk.msg.length = 0;
+        
+        for( int key = 0; key < MAX_KEY_VALUE; key++ )
+        {
+            if( ( keys & ( 1UL << key ) ) != 0 )
+            {
+                if( keyset_check( key ) == false )
+                {
+                    length = VALUE_ABSENT_LENGTH;
+                    bytes = 0;
+                }
+                else
+                {
+                    stored = store_get( &values, key, &value );
+                    length = ( stored < 0 ) ? 0 : stored;
+                    bytes = length;
+                }
+                
+                // Send the chunk so far if the value does not fit behind it
+                if( chunk.msg.length + sizeof( length ) + bytes > MAX_PAYLOAD_SIZE )
+                {
+                    chunk.msg.hops = key - 1;
+                    transport->reply( &chunk.msg );
+                    chunk.msg.id = key;
+                    chunk.msg.data = 0;
+                    chunk.msg.length = 0;
+                }
+                
+                chunk.msg.data |= ( 1UL << key );
+                memcpy( chunk.payload + chunk.msg.length, &length, sizeof( length ) );
+                memcpy( chunk.payload + chunk.msg.length + sizeof( length ), value, bytes );
+                chunk.msg.length += sizeof( length ) + bytes;
+            }
+        }
+        
+        chunk.msg.hops = last_key;
+        transport->reply( &chunk.msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: keep_key
+ * 
+ * Add a key to this node's key set, storing the value that follows a "put", and acknowledge it if
+ * the menu process tagged the command.
+ * 
+ * param:  The "addkey" or "put" message
+ * return: void
+ **************************************************************************************************/
+static void keep_key( chord_msg_t msg )
+{
+    send_owner_hint( msg );
+    hot_note_served( &hot_tracker, msg.id );
+    keyset_add( msg.id );
+    
+    if( msg.cmd == PUT )
+    {
+        store_put( &values, msg.id, received.payload, msg.length );
+    }
+    
+    push_replicas( false );
+    reply_to_menu( msg, 0 );
+    
+    LOG_DEBUG( LOG_KEY_ADDED, node_id, msg.id );
+}
+
+
+/***************************************************************************************************
+ * Function: send_values
+ * 
+ * Move the values stored under a set of keys to another node (unless they are kept in the shared
+ * store, where they need not move at all). The records are not taken apart:
+ * they are moved in bulk where the transport can do so (see pipe_bulk), and otherwise runs of them
+ * are copied out of the arena as they are, as many as fit in a message, and the receiving node 
+ * appends each run to its own arena (see process_values).
+ * 
+ * param:  The ID of the destination node
+ * param:  The keys whose values move, as a bitmap
+ * return: void
+ **************************************************************************************************/
+static void send_values( int dest_id, uint64_t keys )
+{
+    // Local variables
+    chord_payload_msg_t msg;      // A run of records
+    uint64_t keys_left = keys;    // The keys whose records are still to be sent
+    
+    msg.msg.cmd = VALUES;
+    msg.msg.id = dest_id;
+    msg.msg.sender = node_id;
+    msg.msg.tag = 0;
+    msg.msg.hops = 0;
+    
+    // Values in the shared store stay where they are; the keys change owner with the key sets
+    if( store_is_shared() == true )
+    {
+        return;
+    }
+    
+    if( ( transport->bulk != NULL ) && ( transport->bulk( dest_id, keys ) == true ) )
+    {
+        keys_left = 0;
+    }
+    
+    while( keys_left != 0 )
+    {
+        msg.msg.data = keys_left;
+        msg.msg.length = store_pack( &values, &keys_left, msg.payload, MAX_PAYLOAD_SIZE );
+        msg.msg.data &= ~keys_left;
+        
+        if( msg.msg.length > 0 )
+        {
+            send_payload_msg( dest_id, &msg.msg, msg.payload );
+        }
+    }
+    
+    store_delete( &values, keys );
+}
+
+
+/***************************************************************************************************
+ * Function: push_replicas
+ * 
+ * Send a copy of this node's key set to its successors, as many as the replication factor (and to
+ * the supervisor, with the next heartbeat). This is done whenever the key set changes. When the
+ * successor has changed, the copies this node holds for its predecessors are passed on as well,
+ * so that the new successor takes its place in their replica sets.
+ * 
+ * param:  True to pass on the copies this node holds as well
+ * return: void
+ **************************************************************************************************/
+static void push_replicas( bool include_held )
+{
+    // Local variables
+    chord_msg_t msg;              // A copy of a key set
+    
+    // The supervisor's snapshot of the key set is refreshed too, with the next heartbeat
+    next_heartbeat_ms = 0;
+    
+    if( ( replication_factor == 0 ) || ( successor_id == INT_MAX ) )
+    {
+        return;
+    }
+    
+    msg.cmd = REPLICATE;
+    msg.id = node_id;
+    msg.sender = node_id;
+    msg.tag = 0;
+    msg.hops = replication_factor;
+    msg.data = keyset_get_bitmap();
+    send_msg( successor_id, &msg );
+    
+    for( int owner = 0; ( include_held == true ) && ( owner < MAX_NODE_COUNT ); owner++ )
+    {
+        if( ( replica_owners & ( 1UL << owner ) ) && ( replica_hops[owner] > 0 ) )
+        {
+            msg.id = owner;
+            msg.hops = replica_hops[owner];
+            msg.data = replica_keys[owner];
+            send_msg( successor_id, &msg );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: send_heartbeat
+ * 
+ * Tell the supervisor that this node is alive. The heartbeat carries the node's process ID and a 
+ * snapshot of its key set, from which the keys are restored if the node fails without a replica.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void send_heartbeat()
+{
+    // Local variables
+    chord_msg_t msg;              // The heartbeat
+    
+    msg.cmd = HEARTBEAT;
+    msg.id = getpid();
+    msg.sender = node_id;
+    msg.tag = 0;
+    msg.hops = 0;
+    msg.data = keyset_get_bitmap();
+    write( heartbeat_pipe, (const void *)&msg, sizeof( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: reply_to_menu
+ * 
+ * Answer a request from the menu process. The reply echoes the command, ID and tag of the request
+ * and carries the given payload (but not the bytes that follow the request, if any). Requests that
+ * were not tagged by the menu process are not answered.
+ * 
+ * param:  The request message
+ * param:  The payload of the reply
+ * return: void
+ **************************************************************************************************/
+static void reply_to_menu( chord_msg_t msg, uint64_t data )
+{
+    if( msg.tag != 0 )
+    {
+        msg.sender = node_id;
+        msg.data = data;
+        msg.length = 0;
+        
+        transport->reply( &msg );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: answer_broadcast
+ * 
+ * Pass the answer to a broadcast up the tree, or back to the menu process from the main node.
+ * 
+ * param:  The node to answer (MENU_PROCESS_ID for the menu process)
+ * param:  The answer
+ * return: void
+ **************************************************************************************************/
+static void answer_broadcast( int parent_id, chord_payload_msg_t *answer )
+{
+    if( parent_id == MENU_PROCESS_ID )
+    {
+        transport->reply( &answer->msg );
+    }
+    else
+    {
+        send_payload_msg( parent_id, &answer->msg, answer->payload );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: send_msg
+ * 
+ * Send a message to another node in the DHT, keeping count of the messages sent. Report and 
+ * statistics requests (and their answers) are not counted, so that measurements taken by the menu
+ * process do not skew the count, and neither are the messages of the stabilization protocol, 
+ * which nodes send all the time. A message that carries a payload takes that of the message being
+ * processed with it, so that it can be passed on as it is.
+ * 
+ * param:  The ID of the destination node
+ * param:  The message to send
+ * return: void
+ **************************************************************************************************/
+static void send_msg( int dest_id, const chord_msg_t *msg )
+{
+    send_payload_msg( dest_id, msg, received.payload );
+}
+
+
+/***************************************************************************************************
+ * Function: send_payload_msg
+ * 
+ * Send a message to another node in the DHT, followed by the given payload (see send_msg).
+ * 
+ * param:  The ID of the destination node
+ * param:  The message to send
+ * param:  The payload (MSG_PAYLOAD_LENGTH bytes of it are sent)
+ * return: void
+ **************************************************************************************************/
+static void send_payload_msg( int dest_id, const chord_msg_t *msg, const char *payload )
+{
+    // Local variables
+    chord_payload_msg_t out;      // The message, followed by its payload
+    
+    out.msg = *msg;
+    memcpy( out.payload, payload, MSG_PAYLOAD_LENGTH( msg ) );
+    
+    if( ( msg->cmd != REPORT ) && ( msg->cmd != STATS ) && ( msg->cmd != AGGREGATE ) && 
+        ( ( msg->cmd < STABILIZE ) || ( msg->cmd > FINGER ) ) )
+    {
+        msgs_sent++;
+    }
+    
+    transport->send( dest_id, &out.msg );
+}
+
+
+/***************************************************************************************************
+ * Function: read_msg
+ * 
+ * Read a message from a pipe into the message being processed, with its payload. Both are written
+ * to the pipe at once, so the payload is there to be read as soon as the message is.
+ * 
+ * param:  The pipe handle to read from
+ * return: True if a whole message was read
+ **************************************************************************************************/
+static bool read_msg( int handle )
+{
+    // Local variables
+    int length;                   // The length of the payload
+    bool complete = false;        // Flag: "a whole message was read"
+    
+    if( read( handle, (void *)&received.msg, sizeof( received.msg ) ) == sizeof( received.msg ) )
+    {
+        length = MSG_PAYLOAD_LENGTH( &received.msg );
+        complete = ( length == 0 ) || 
+                   ( ( length > 0 ) && ( length <= MAX_PAYLOAD_SIZE ) &&
+                     ( read( handle, (void *)received.payload, length ) == length ) );
+    }
+    
+    return( complete );
+}
+
+
+/***************************************************************************************************
+ * Function: pipe_send
+ * 
+ * Send a message to another node through its pipe, with its payload, in a single write.
+ * 
+ * param:  The ID of the destination node
+ * param:  The message to send
+ * return: void
+ **************************************************************************************************/
+static void pipe_send( int dest_id, const chord_msg_t *msg )
+{
+    write( dht_pipes[dest_id][1], (const void *)msg, sizeof( *msg ) + MSG_PAYLOAD_LENGTH( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: pipe_reply
+ * 
+ * Send a reply to the menu process through the report pipe, with its payload, in a single write.
+ * 
+ * param:  The reply to send
+ * return: void
+ **************************************************************************************************/
+static void pipe_reply( const chord_msg_t *msg )
+{
+    write( pipe_to_menu, (const void *)msg, sizeof( *msg ) + MSG_PAYLOAD_LENGTH( msg ) );
+}
+
+
+/***************************************************************************************************
+ * Function: pipe_bulk
+ * 
+ * Move the values stored under a set of keys to another node through its bulk pipe. For each 
+ * transfer, a VALUES message and its records are written to the bulk pipe, the records spliced
+ * from the arena rather than copied (see store_send), and then a BULK_VALUES message is sent to
+ * the node through its pipe, so that it reads the transfer in turn with its other messages. Nodes
+ * hosted by this process are sent values in messages, as this process could not read a transfer 
+ * that it is held up writing. The lock on the bulk pipe is held for one transfer at a time, and a
+ * transfer is started only if the pipe looks to have room for the largest one (the bytes waiting
+ * are an estimate of the room, as the pipe's buffers hold whole pages); otherwise the lock is
+ * released, and the transfer tried again a little later.
+ * 
+ * param:  The ID of the destination node
+ * param:  The keys whose values move, as a bitmap
+ * return: True if the values were moved; false if they are to be sent in messages (any already
+ *         moved are sent again)
+ **************************************************************************************************/
+static bool pipe_bulk( int dest_id, uint64_t keys )
+{
+    // Local variables
+    chord_msg_t header;           // The message that goes ahead of the records
+    struct flock lock;            // The lock on the bulk pipe
+    uint64_t keys_left = keys;    // The keys whose records are still to be sent
+    uint64_t keys_before;         // The keys left before a transfer was tried
+    int retries = 0;              // The transfers that could not be started
+    bool moved;                   // Flag: "the values were moved"
+    bool sent;                    // Flag: "a transfer was written in full"
+    int bytes_waiting;            // Bytes waiting in the bulk pipe
+    int room_needed;              // The room in the pipe a transfer may take
+    
+    moved = ( bulk_pipes[dest_id][1] >= 0 );
+    
+    for( int index = 0; index < hosted_count; index++ )
+    {
+        moved = moved && ( hosted_ids[index] != dest_id );
+    }
+    
+    header.cmd = VALUES;
+    header.id = dest_id;
+    header.sender = node_id;
+    header.tag = 0;
+    header.hops = 0;
+    
+    lock.l_whence = SEEK_SET;
+    lock.l_start = 0;
+    lock.l_len = 1;
+    
+    // The records of a transfer, with a page to spare for each piece they are spliced in
+    room_needed = (int)sizeof( header ) + STORE_SEND_SIZE + 
+                  ( STORE_SEND_SPANS + 1 ) * (int)sysconf( _SC_PAGESIZE );
+    
+    while( ( moved == true ) && ( keys_left != 0 ) )
+    {
+        keys_before = keys_left;
+        bytes_waiting = BULK_PIPE_SIZE;
+        lock.l_type = F_WRLCK;
+        sent = ( fcntl( bulk_pipes[dest_id][1], F_SETLKW, &lock ) == 0 ) &&
+               ( ioctl( bulk_pipes[dest_id][1], FIONREAD, &bytes_waiting ) == 0 ) &&
+               ( BULK_PIPE_SIZE - bytes_waiting >= room_needed ) &&
+               ( store_send( &values, &keys_left, &header, bulk_pipes[dest_id][1] ) == true );
+        lock.l_type = F_UNLCK;
+        fcntl( bulk_pipes[dest_id][1], F_SETLK, &lock );
+        
+        // A transfer the pipe had no room for is tried again, until the node has waited too long
+        if( ( sent == false ) && ( keys_left == keys_before ) && 
+            ( ++retries < BULK_RETRY_LIMIT ) )
+        {
+            poll( NULL, 0, 1 );
+        }
+        else
+        {
+            moved = sent;
+        }
+        
+        // The transfer is in the pipe before the node is told of it, so it never waits to read it
+        if( ( moved == true ) && ( sent == true ) )
+        {
+            header.cmd = BULK_VALUES;
+            header.length = 0;
+            msgs_sent++;
+            pipe_send( dest_id, &header );
+            header.cmd = VALUES;
+        }
+    }
+    
+    return( moved );
+}
+
+
+/***************************************************************************************************
+ * Function: fork_spawn
+ * 
+ * Create the process for a new node by forking this one.
+ * 
+ * param:  The "addnode" message that causes the node to be created
+ * return: As fork(): zero in the new process, its process ID in this one, or -1 on failure
+ **************************************************************************************************/
+static pid_t fork_spawn( const chord_msg_t *msg )
+{
+    // Local variables
+    pid_t process_id;           // Result of the fork
+    
+    process_id = fork();
+    
+    // The new process logs as the new node
+    if( process_id == 0 )
+    {
+        log_after_fork( msg->id );
+    }
+    
+    return( process_id );
+}
+
+
+/***************************************************************************************************
+ * Function: pool_spawn
+ * 
+ * Create a new node by assigning it to an idle process from the pool. The assignment carries what
+ * the new node would have inherited from this node by forking: its predecessor (this node), its
+ * successor, the successor list and whether logging is on. If no process is idle, the assignment
+ * waits in the pipe until the zygote has started one.
+ * 
+ * param:  The "addnode" message that causes the node to be created
+ * return: A positive value (the process is not known here), or -1 if the assignment failed
+ **************************************************************************************************/
+static pid_t pool_spawn( const chord_msg_t *msg )
+{
+    // Local variables
+    chord_msg_t assignment;     // The assignment for an idle process
+    pid_t result = 1;           // The result
+    
+    assignment = *msg;
+    assignment.sender = node_id;
+    assignment.tag = log_active;
+    assignment.hops = successor_id;
+    assignment.data = pack_successors();
+    
+    if( write( pool_pipe, (const void *)&assignment, sizeof( assignment ) ) != 
+        sizeof( assignment ) )
+    {
+        result = -1;
+    }
+    
+    return( result );
+}
+
+
+/***************************************************************************************************
+ * Function: host_spawn
+ * 
+ * Create a new virtual node by assigning it to the process of the node that is to host it. The 
+ * assignment carries the same as one for the pool (see pool_spawn); the host already has logging
+ * set up.
+ * 
+ * param:  The "addnode" message that causes the node to be created
+ * return: A positive value (the node is not created in this process)
+ **************************************************************************************************/
+static pid_t host_spawn( const chord_msg_t *msg )
+{
+    // Local variables
+    chord_msg_t assignment;     // The assignment for the hosting process
+    
+    assignment = *msg;
+    assignment.cmd = HOST_NODE;
+    assignment.sender = node_id;
+    assignment.tag = 0;
+    assignment.hops = successor_id;
+    assignment.data = pack_successors();
+    
+    send_msg( __builtin_ctzll( msg->data ), &assignment );
+    
+    return( 1 );
+}
+
+
+/***************************************************************************************************
+ * Function: pipe_backlog
+ * 
+ * Measure the messages waiting in this node's pipe, in bytes (messages carry payloads of different
+ * lengths, so the bytes cannot be turned into a count of messages).
+ * 
+ * param:  void
+ * return: The number of bytes waiting
+ **************************************************************************************************/
+static int pipe_backlog()
+{
+    // Local variables
+    int bytes_waiting = 0;      // Bytes waiting in the pipe
+    
+    ioctl( dht_pipes[node_id][0], FIONREAD, &bytes_waiting );
+    
+    return( bytes_waiting );
+}
+
+
+/***************************************************************************************************
+ * Function: init_pooled_node
+ * 
+ * Initialize the state of a node taken from the pool of idle processes, as if it had been forked
+ * by its predecessor. Its finger table starts empty, and is filled in by stabilization.
+ * 
+ * param:  The assignment (see pool_spawn)
+ * return: void
+ **************************************************************************************************/
+static void init_pooled_node( chord_msg_t msg )
+{
+    node_id = msg.sender;
+    successor_id = msg.hops;
+    unpack_successors( msg.data );
+    
+    log_after_fork( msg.id );
+    
+    if( msg.tag != 0 )
+    {
+        log_enable();
+    }
+    
+    transport = netem_wrap( &pooled_transport, msg.id );
+    forget_hosted_nodes( msg.id );
+    init_new_node( msg );
+}
+
+
+/***************************************************************************************************
+ * Function: pack_successors
+ * 
+ * Pack the successor list into a message payload, one byte per node (0xFF where not known).
+ * 
+ * param:  void
+ * return: The packed list
+ **************************************************************************************************/
+static uint64_t pack_successors()
+{
+    // Local variables
+    uint64_t list = 0;          // The packed list
+    
+    for( int index = SUCCESSOR_LIST_LENGTH - 1; index >= 0; index-- )
+    {
+        list = ( list << 8 ) | ( ( successors[index] == INT_MAX ) ? 0xFF : successors[index] );
+    }
+    
+    return( list );
+}
+
+
+/***************************************************************************************************
+ * Function: unpack_successors
+ * 
+ * Replace the successor list with one packed by pack_successors.
+ * 
+ * param:  The packed list
+ * return: void
+ **************************************************************************************************/
+static void unpack_successors( uint64_t list )
+{
+    // Local variables
+    int list_id;                // A node ID from the successor list
+    
+    for( int index = 0; index < SUCCESSOR_LIST_LENGTH; index++ )
+    {
+        list_id = ( list >> ( 8 * index ) ) & 0xFF;
+        successors[index] = ( list_id == 0xFF ) ? INT_MAX : list_id;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: switch_node
+ * 
+ * Run the given hosted node: the state of the node being run is stored, and that of the given node
+ * swapped in. Nothing is swapped when the process hosts a single node.
+ * 
+ * param:  The hosted node to run, as an index into the hosted nodes
+ * return: void
+ **************************************************************************************************/
+static void switch_node( int index )
+{
+    if( index != running_node )
+    {
+        get_node_state( &hosted_nodes[running_node] );
+        set_node_state( &hosted_nodes[index] );
+        running_node = index;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: forget_hosted_nodes
+ * 
+ * Start hosting only the given node, in a new process: the virtual nodes hosted by the process it 
+ * was forked from are not run here, neither are the broadcasts they were waiting on, and their 
+ * value segments are unmapped (those of the node that forked it are unmapped by store_init, as
+ * the new node's state is initialized).
+ * 
+ * param:  The ID of the node the process is for
+ * return: void
+ **************************************************************************************************/
+static void forget_hosted_nodes( int own_id )
+{
+    broadcast_forget( -1 );
+    
+    // The segments of the values stay with the nodes of the process this one was forked from
+    for( int index = 0; index < hosted_count; index++ )
+    {
+        if( index != running_node )
+        {
+            store_free( &hosted_nodes[index].values );
+        }
+    }
+    
+    hosted_ids[0] = own_id;
+    hosted_count = 1;
+    running_node = 0;
+}
+
+
+/***************************************************************************************************
+ * Function: remove_running_node
+ * 
+ * Stop hosting the node being run, once it has left the ring, and run the first of the nodes that 
+ * remain.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void remove_running_node()
+{
+    broadcast_forget( node_id );
+    
+    for( int index = running_node; index < hosted_count - 1; index++ )
+    {
+        hosted_nodes[index] = hosted_nodes[index + 1];
+        hosted_ids[index] = hosted_ids[index + 1];
+    }
+    
+    hosted_count--;
+    running_node = 0;
+    set_node_state( &hosted_nodes[0] );
+}
+
+
 //**************************************************************************************************
 // End of file.
 //**************************************************************************************************
@@ -9,7 +9,7 @@
 // to create new (local-only) nodes if a command to add a node is received from the menu process.
 // A Chord node handles the addition or removal of keys from its local set, the scheme of which 
 // is based on its ID and place in the DHT ring.
-//
+// 
 // Each node knows its successor information and local keys, but not the complete DHT node list or
 // total keys present in the system. The intent is to decentralize the algorithm.
 // 
@@ -23,14 +23,70 @@
 // Includes
 //**************************************************************************************************
 
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "chord_config.h"
+#include "chord_hot_keys.h"
 #include "chord_message.h"
+#include "chord_owner_cache.h"
+#include "chord_value_cache.h"
+#include "chord_value_store.h"
 
 
 //**************************************************************************************************
 // Module definitions
 //**************************************************************************************************
 
-// (none)
+// The number of fingers in a node's finger table (finger i points at the owner of node ID + 2^i)
+#define FINGER_COUNT                    6
+
+// The number of successors each node keeps track of, so that it can skip over failed ones
+#define SUCCESSOR_LIST_LENGTH           4
+
+// The state of a single node. A node process normally hosts one node, but may host virtual nodes 
+// as well, swapping the state of each in to run it; the simulator swaps the state of every node in
+// and out of a single process.
+typedef struct
+{
+    int node_id;                     // The identification number of the node
+    int successor_id;                // The identification number of the node's successor
+    bool has_successor;              // Used to track whether this node has a successor
+    int predecessor_id;              // The node's predecessor (INT_MAX if not known)
+    int successors[SUCCESSOR_LIST_LENGTH];   // The node's successors, nearest first (INT_MAX
+                                             // where not known)
+    int fingers[FINGER_COUNT];       // The finger table (INT_MAX where not known)
+    int next_finger;                 // The finger to refresh in the next stabilization round
+    int msgs_sent;                   // Messages sent to other nodes (excluding reports)
+    uint64_t key_set;                // The key set of the node, as a bitmap
+    value_store_t values;            // The values stored under the node's keys
+    owner_cache_t owner_cache;       // The nodes last known to own ranges of keys
+    value_cache_t value_cache;       // Copies of the values of hot keys
+    hot_tracker_t hot_tracker;       // The requests the node has handled lately
+    uint64_t replica_owners;         // The nodes whose key sets this node holds copies of
+    uint64_t replica_keys[MAX_NODE_COUNT];   // Copies of other nodes' key sets, by owner
+    int replica_hops[MAX_NODE_COUNT];        // Successors each copy is passed on to, by owner
+    uint64_t adopted_inboxes;        // The pipes of failed nodes taken over, as a node bitmap
+    bool leaving;                    // Flag: "this node is leaving the ring"
+    pid_t successor_pid;             // The process of the successor (zero if not known)
+    int stabilize_missed;            // Stabilization rounds the successor has not answered
+    double next_stabilize_ms;        // The time the next stabilization round is due
+    double next_heartbeat_ms;        // The time the next heartbeat is due
+} chord_node_state_t;
+
+// The means by which nodes communicate and new nodes are created. A message that carries a payload
+// (see MSG_PAYLOAD_LENGTH) is followed by it in memory, as in chord_payload_msg_t.
+typedef struct
+{
+    void (*send)( int dest_id, const chord_msg_t *msg );     // Send a message to another node
+    void (*reply)( const chord_msg_t *msg );                  // Send a reply to the menu process
+    pid_t (*spawn)( const chord_msg_t *msg );                 // Create a new node (as fork())
+    int (*backlog)();                                         // Measure the messages waiting for
+                                                              // the node being run, in bytes
+    bool (*bulk)( int dest_id, uint64_t keys );               // Move the values of a set of keys
+                                                              // to another node in bulk (NULL, or
+                                                              // false, if it cannot)
+} chord_transport_t;
 
 
 //**************************************************************************************************
@@ -43,9 +99,10 @@
  * Initialize the distributed hash table,
  * 
  * param:  The pipe handle from the menu process, so that commands may be received
+ * param:  The pipe handle to the menu process, so that reports may be sent
  * return: void
  **************************************************************************************************/
-void init_dht( int menu_pipe_handle );
+void init_dht( int menu_pipe_handle, int menu_reply_handle );
 
 
 /***************************************************************************************************
@@ -59,6 +116,104 @@ void init_dht( int menu_pipe_handle );
 void check_messages( void );
 
 
+/***************************************************************************************************
+ * Function: process_msg
+ * 
+ * Process the given message, using its command and ID information to perform a specific action.
+ * 
+ * param:  A message received from another process/node
+ * return: void
+ **************************************************************************************************/
+void process_msg( chord_msg_t rx_msg );
+
+
+/***************************************************************************************************
+ * Function: process_payload_msg
+ * 
+ * Process a message handed over with its payload (as by the simulator), as if it had been read
+ * from a pipe.
+ * 
+ * param:  The message, followed by its payload
+ * return: void
+ **************************************************************************************************/
+void process_payload_msg( const chord_msg_t *msg );
+
+
+/***************************************************************************************************
+ * Function: init_new_node
+ * 
+ * Initialize the state of a node that has just been created by its predecessor. The state starts
+ * as a copy of the predecessor's state (as left by fork), which already holds the correct 
+ * successor ID in most cases.
+ * 
+ * param:  The "addnode" message that caused the node to be created
+ * return: void
+ **************************************************************************************************/
+void init_new_node( chord_msg_t msg );
+
+
+/***************************************************************************************************
+ * Function: stabilize
+ * 
+ * Run one round of the stabilization protocol: check that the successor is still the nearest 
+ * node (a node may have joined in between), refresh the successor list, tell the successor about
+ * this node (so that it can update its predecessor), and refresh one finger. Node processes do 
+ * this periodically from check_messages.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+void stabilize();
+
+
+/***************************************************************************************************
+ * Function: set_transport
+ * 
+ * Replace the means by which this process sends messages and creates nodes. By default, nodes
+ * communicate through pipes and new nodes are forked.
+ * 
+ * param:  The transport to use
+ * return: void
+ **************************************************************************************************/
+void set_transport( const chord_transport_t *new_transport );
+
+
+/***************************************************************************************************
+ * Function: set_replication
+ * 
+ * Set the number of successors that hold a copy of each node's key set. The factor is limited to
+ * MAX_REPLICATION; zero turns replication off.
+ * 
+ * param:  The replication factor
+ * return: void
+ **************************************************************************************************/
+void set_replication( int factor );
+
+
+/***************************************************************************************************
+ * Function: get_node_state
+ * 
+ * Get a copy of the state of the node hosted by this process.
+ * 
+ * param:  Holds the state of the node
+ * return: void
+ **************************************************************************************************/
+void get_node_state( chord_node_state_t *state );
+
+
+/***************************************************************************************************
+ * Function: set_node_state
+ * 
+ * Replace the state of the node hosted by this process. Together with get_node_state, this lets
+ * a single process act as many nodes, by swapping the state of each in before it processes a 
+ * message.
+ * 
+ * param:  The new state of the node
+ * return: void
+ **************************************************************************************************/
+void set_node_state( const chord_node_state_t *state );
+
+
 #endif
 
 //**************************************************************************************************
@@ -7,7 +7,10 @@
 // 
 // Application entrypoint for a Chord node program. This program is not intended to be executed
 // as a standalone application (under typical usage); rather, it is expected that it is invoked
-// by a (parent) menu process, which will pipe in commands.
+// by a (parent) menu process, which will pipe in commands. When invoked with "--sim", the program
+// instead runs the discrete-event simulator of the DHT (see chord_sim.h); with "--decode-log", it
+// renders node log files as text (see chord_log.h); with "--bench-bulk", it measures how fast
+// values move between nodes in bulk and in messages (see store_bench).
 // 
 //**************************************************************************************************
 
@@ -18,8 +21,11 @@
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
-#include "chord_debug.h"
+#include <string.h>
+#include "chord_log.h"
 #include "chord_node.h"
+#include "chord_sim.h"
+#include "chord_value_store.h"
 
 
 //**************************************************************************************************
@@ -50,15 +56,28 @@ int main(int argc, char** argv)
 {
     // Local variables
     int menu_pipe_handle;         // The file descriptor to receive data from the menu program
+    int menu_reply_handle;        // The file descriptor to send reports to the menu program
     
-    // Disable debug prints by default
-    debug_disable_prints();
+    // Run the simulator, log decoder or transfer benchmark instead, if asked to
+    if( ( argc > 1 ) && ( strcmp( argv[1], "--sim" ) == 0 ) )
+    {
+        return( sim_main( argc - 2, argv + 2 ) );
+    }
+    else if( ( argc > 1 ) && ( strcmp( argv[1], "--decode-log" ) == 0 ) )
+    {
+        return( log_decode( argc - 2, argv + 2 ) );
+    }
+    else if( ( argc > 1 ) && ( strcmp( argv[1], "--bench-bulk" ) == 0 ) )
+    {
+        return( store_bench( argc - 2, argv + 2 ) );
+    }
     
-    // Retrieve file descriptor so menu program can send commands
+    // Retrieve file descriptors so menu program can send commands and receive reports
     sscanf( argv[0], "%i", &menu_pipe_handle );
+    sscanf( argv[1], "%i", &menu_reply_handle );
     
     // Initialize "anchor" node
-    init_dht( menu_pipe_handle );
+    init_dht( menu_pipe_handle, menu_reply_handle );
     
     while( true )
     {
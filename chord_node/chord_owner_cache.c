@@ -0,0 +1,154 @@
+//**************************************************************************************************
+// File:   chord_owner_cache.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// A small cache of the nodes that own ranges of keys (see chord_owner_cache.h).
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include "chord_owner_cache.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: owner_cache_init
+ * 
+ * Empty a cache, and clear its counters.
+ * 
+ * param:  The cache
+ * return: void
+ **************************************************************************************************/
+void owner_cache_init( owner_cache_t *cache )
+{
+    for( int index = 0; index < OWNER_CACHE_SIZE; index++ )
+    {
+        cache->entries[index].owner_id = -1;
+    }
+
+    cache->clock = 0;
+    cache->lookups = 0;
+    cache->hits = 0;
+}
+
+
+/***************************************************************************************************
+ * Function: owner_cache_find
+ * 
+ * Find the node last known to own a key, counting the lookup (and the hit, if any).
+ * 
+ * param:  The cache
+ * param:  The key
+ * return: The ID of the node, or -1 if the owner of the key is not known
+ **************************************************************************************************/
+int owner_cache_find( owner_cache_t *cache, int key )
+{
+    // Local variables
+    int owner_id = -1;            // The node that owns the key
+
+    cache->lookups++;
+
+    for( int index = 0; ( index < OWNER_CACHE_SIZE ) && ( owner_id < 0 ); index++ )
+    {
+        if( ( cache->entries[index].owner_id >= 0 ) &&
+            ( key >= cache->entries[index].first_key ) &&
+            ( key <= cache->entries[index].last_key ) )
+        {
+            owner_id = cache->entries[index].owner_id;
+            cache->entries[index].last_used = ++cache->clock;
+            cache->hits++;
+        }
+    }
+
+    return( owner_id );
+}
+
+
+/***************************************************************************************************
+ * Function: owner_cache_learn
+ * 
+ * Record the range of keys a node owns, replacing any entries for ranges it overlaps (which can
+ * no longer be right), or else the entry used least recently.
+ * 
+ * param:  The cache
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  The node that owns the range
+ * return: void
+ **************************************************************************************************/
+void owner_cache_learn( owner_cache_t *cache, int first_key, int last_key, int owner_id )
+{
+    // Local variables
+    int victim = 0;               // The entry to replace
+
+    for( int index = 0; index < OWNER_CACHE_SIZE; index++ )
+    {
+        if( ( cache->entries[index].owner_id >= 0 ) &&
+            ( cache->entries[index].first_key <= last_key ) &&
+            ( cache->entries[index].last_key >= first_key ) )
+        {
+            // An overlapping range is out of date
+            cache->entries[index].owner_id = -1;
+        }
+
+        if( ( cache->entries[victim].owner_id >= 0 ) &&
+            ( ( cache->entries[index].owner_id < 0 ) ||
+              ( cache->entries[index].last_used < cache->entries[victim].last_used ) ) )
+        {
+            victim = index;
+        }
+    }
+
+    cache->entries[victim].first_key = first_key;
+    cache->entries[victim].last_key = last_key;
+    cache->entries[victim].owner_id = owner_id;
+    cache->entries[victim].last_used = ++cache->clock;
+}
+
+
+/***************************************************************************************************
+ * Function: owner_cache_forget
+ * 
+ * Drop the entries of a node that is no longer in the ring.
+ * 
+ * param:  The cache
+ * param:  The ID of the node
+ * return: void
+ **************************************************************************************************/
+void owner_cache_forget( owner_cache_t *cache, int owner_id )
+{
+    for( int index = 0; index < OWNER_CACHE_SIZE; index++ )
+    {
+        if( cache->entries[index].owner_id == owner_id )
+        {
+            cache->entries[index].owner_id = -1;
+        }
+    }
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
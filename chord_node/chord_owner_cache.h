@@ -0,0 +1,118 @@
+//**************************************************************************************************
+// File:   chord_owner_cache.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// A small cache of the nodes that own ranges of keys, so that a node can send a request for a key
+// straight to its owner rather than route it through its fingers. Each entry maps a range of keys
+// to the node last known to own it, as told by that node; when the cache is full, the entry used
+// least recently is replaced. An entry may be stale (the range may have been split by a new node,
+// or handed on by a node that left), which costs nothing more than routing: the node a request is
+// sent to passes on a key it does not own, and the owner then tells the sender about its range,
+// replacing the stale entry.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_OWNER_CACHE_H
+#define CHORD_OWNER_CACHE_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The number of key ranges a cache holds
+#define OWNER_CACHE_SIZE                8
+
+// A range of keys and the node that owns them
+typedef struct
+{
+    int first_key;                   // The first key of the range
+    int last_key;                    // The last key of the range (inclusive; the owner's ID)
+    int owner_id;                    // The node that owns the range (-1 if the entry is unused)
+    uint32_t last_used;              // When the entry was last used (by the cache's clock)
+} owner_cache_entry_t;
+
+// A cache of the nodes that own ranges of keys
+typedef struct
+{
+    owner_cache_entry_t entries[OWNER_CACHE_SIZE];   // The cached ranges
+    uint32_t clock;                  // Counts the uses of the cache, to order the entries by
+    uint64_t lookups;                // The number of keys looked up
+    uint64_t hits;                   // The number of keys whose owner was found
+} owner_cache_t;
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: owner_cache_init
+ * 
+ * Empty a cache, and clear its counters.
+ * 
+ * param:  The cache
+ * return: void
+ **************************************************************************************************/
+void owner_cache_init( owner_cache_t *cache );
+
+
+/***************************************************************************************************
+ * Function: owner_cache_find
+ * 
+ * Find the node last known to own a key, counting the lookup (and the hit, if any).
+ * 
+ * param:  The cache
+ * param:  The key
+ * return: The ID of the node, or -1 if the owner of the key is not known
+ **************************************************************************************************/
+int owner_cache_find( owner_cache_t *cache, int key );
+
+
+/***************************************************************************************************
+ * Function: owner_cache_learn
+ * 
+ * Record the range of keys a node owns, replacing any entries for ranges it overlaps (which can
+ * no longer be right), or else the entry used least recently.
+ * 
+ * param:  The cache
+ * param:  The first key of the range
+ * param:  The last key of the range (inclusive)
+ * param:  The node that owns the range
+ * return: void
+ **************************************************************************************************/
+void owner_cache_learn( owner_cache_t *cache, int first_key, int last_key, int owner_id );
+
+
+/***************************************************************************************************
+ * Function: owner_cache_forget
+ * 
+ * Drop the entries of a node that is no longer in the ring.
+ * 
+ * param:  The cache
+ * param:  The ID of the node
+ * return: void
+ **************************************************************************************************/
+void owner_cache_forget( owner_cache_t *cache, int owner_id );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
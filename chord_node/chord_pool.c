@@ -0,0 +1,214 @@
+//**************************************************************************************************
+// File:   chord_pool.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Pool of idle node processes, started ahead of time so that adding a node to the ring does not
+// wait for a fork. The idle processes are copies of the main node as it was right after setup,
+// so they hold every pipe a node needs.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <errno.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include "chord_log.h"
+#include "chord_pool.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Local prototypes
+static bool pool_start_process( chord_msg_t *assignment );
+static void pool_leave_zygote();
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// Pipe descriptors for passing an assignment to each idle process
+static int idle_handles[POOL_MAX_SIZE];
+
+// The number of idle processes
+static int idle_count = 0;
+
+// The pipe descriptor for reading assignments
+static int assignment_pipe;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: pool_run
+ * 
+ * Run the zygote, keeping the given number of idle node processes ready. The zygote alone reads 
+ * the assignment pipe, and passes each assignment on to one idle process through a pipe of its 
+ * own, so that an assignment wakes a single process. The pool is refilled only while no 
+ * assignment is waiting, so that the forks do not hold up a burst of joins; if it runs dry, a 
+ * process is forked for the assignment instead.
+ * 
+ * param:  The pipe descriptor for reading assignments
+ * param:  The number of idle processes to keep ready
+ * return: The assignment
+ **************************************************************************************************/
+chord_msg_t pool_run( int assignment_handle, int pool_size )
+{
+    // Local variables
+    struct pollfd assignment_poll;    // Used to check for waiting assignments
+    chord_msg_t assignment;           // The node assigned to this process
+    bool assigned = false;            // Flag: "this process has been assigned a node"
+    int ready;                        // Result of the poll
+    int previous_count;               // The number of idle processes before one was started
+    
+    // Initialization
+    assignment_pipe = assignment_handle;
+    assignment_poll.fd = assignment_handle;
+    assignment_poll.events = POLLIN;
+    pool_size = ( pool_size > POOL_MAX_SIZE ) ? POOL_MAX_SIZE : pool_size;
+    
+    while( assigned == false )
+    {
+        ready = poll( &assignment_poll, 1, ( idle_count < pool_size ) ? 0 : -1 );
+        
+        if( ready == 0 )
+        {
+            previous_count = idle_count;
+            assigned = pool_start_process( &assignment );
+            
+            // If no process could be started, stop refilling the pool
+            if( ( assigned == false ) && ( idle_count == previous_count ) )
+            {
+                pool_size = idle_count;
+            }
+        }
+        else if( ( ready > 0 ) && 
+                 ( read( assignment_handle, (void *)&assignment, sizeof( assignment ) ) == 
+                   sizeof( assignment ) ) )
+        {
+            if( idle_count > 0 )
+            {
+                idle_count--;
+                write( idle_handles[idle_count], (const void *)&assignment, sizeof( assignment ) );
+                close( idle_handles[idle_count] );
+            }
+            else
+            {
+                // The pool has run dry: a new process takes the assignment at once
+                switch( fork() )
+                {
+                    case( -1 ):
+                        
+                        LOG_ERROR( LOG_NODE_CREATE_FAILED, assignment.id, errno );
+                        
+                        break;
+                        
+                    case( 0 ):
+                        
+                        pool_leave_zygote();
+                        assigned = true;
+                        
+                        break;
+                        
+                    default:
+                        
+                        break;
+                }
+            }
+        }
+    }
+    
+    return( assignment );
+}
+
+
+/***************************************************************************************************
+ * Function: pool_start_process
+ * 
+ * Start an idle process, which waits for an assignment from the zygote.
+ * 
+ * param:  Holds the assignment, in the new process
+ * return: True in the new process, once it has been assigned a node; false in the zygote
+ **************************************************************************************************/
+static bool pool_start_process( chord_msg_t *assignment )
+{
+    // Local variables
+    int handles[2];               // The pipe for passing an assignment to the new process
+    bool assigned = false;        // Flag: "this process has been assigned a node"
+    
+    if( pipe( handles ) == 0 )
+    {
+        switch( fork() )
+        {
+            case( -1 ):
+                
+                close( handles[0] );
+                close( handles[1] );
+                
+                break;
+                
+            case( 0 ):
+                
+                pool_leave_zygote();
+                close( handles[1] );
+                
+                while( read( handles[0], (void *)assignment, sizeof( *assignment ) ) != 
+                       sizeof( *assignment ) )
+                {
+                    if( errno != EINTR )
+                    {
+                        exit( EXIT_FAILURE );
+                    }
+                }
+                
+                close( handles[0] );
+                assigned = true;
+                
+                break;
+                
+            default:
+                
+                close( handles[0] );
+                idle_handles[idle_count++] = handles[1];
+                
+                break;
+        }
+    }
+    
+    return( assigned );
+}
+
+
+/***************************************************************************************************
+ * Function: pool_leave_zygote
+ * 
+ * Close, in a process forked by the zygote, the pipe descriptors that only the zygote uses.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void pool_leave_zygote()
+{
+    for( int index = 0; index < idle_count; index++ )
+    {
+        close( idle_handles[index] );
+    }
+    
+    idle_count = 0;
+    close( assignment_pipe );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
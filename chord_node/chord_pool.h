@@ -0,0 +1,60 @@
+//**************************************************************************************************
+// File:   chord_pool.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Pool of idle node processes, started ahead of time so that adding a node to the ring does not
+// wait for a fork. A "zygote" process, forked by the main node once it is set up, forks the idle
+// processes and starts a new one each time one is taken. A node that inserts a new node writes an
+// assignment (the new node's ID, and what it would otherwise have inherited by forking) to the 
+// pool pipe; the zygote passes it on to an idle process, which becomes the new node.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_POOL_H
+#define CHORD_POOL_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The environment variable that holds the number of idle node processes (0 to fork on each join)
+#define POOL_ENV_VAR                    "CHORD_NODE_POOL"
+
+// The number of idle node processes, if not set by the environment
+#define POOL_DEFAULT_SIZE               8
+
+// The largest number of idle node processes
+#define POOL_MAX_SIZE                   32
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: pool_run
+ * 
+ * Run the zygote, keeping the given number of idle node processes ready. This function does not
+ * return in the zygote; it returns in an idle process once that process has been assigned a node.
+ * 
+ * param:  The pipe descriptor for reading assignments
+ * param:  The number of idle processes to keep ready
+ * return: The assignment
+ **************************************************************************************************/
+chord_msg_t pool_run( int assignment_handle, int pool_size );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
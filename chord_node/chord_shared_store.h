@@ -0,0 +1,84 @@
+//**************************************************************************************************
+// File:   chord_shared_store.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Layout of the shared store: a region of memory, shared by the menu process and every node, that
+// holds the value stored under each key and the key set of each node. It is an optional storage
+// mode ("--shared-store"), possible because every node runs on the same machine.
+// 
+// The value of a key has a fixed place in the region, so it never moves: a key changes owner when
+// the key sets say so, and moving a range of keys to another node (e.g. when it joins) rewrites
+// two key sets rather than copying any values. Only the owner of a key writes its value. The key
+// sets are published by the nodes as they change, so that the menu process can read them directly
+// rather than asking the nodes.
+// 
+// The region is created by the menu process (backed by huge pages where the system has them) and
+// handed to the main node as an open file descriptor, named by SHARED_STORE_ENV_VAR; the other
+// nodes inherit it.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_SHARED_STORE_H
+#define CHORD_SHARED_STORE_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include "chord_config.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The environment variable holding the file descriptor of the shared store (unset if there is none)
+#define SHARED_STORE_ENV_VAR            "CHORD_SHARED_STORE"
+
+// The size of a huge page, in bytes
+#define SHARED_STORE_PAGE_SIZE          2097152
+
+// The value stored under a key
+typedef struct
+{
+    uint16_t present;                // Flag: "a value is stored under the key"
+    uint16_t length;                 // The length of the value, in bytes
+    char value[MAX_VALUE_SIZE];      // The value
+} chord_shared_value_t;
+
+// The shared store
+typedef struct
+{
+    uint32_t huge_pages;             // Flag: "the region is backed by huge pages"
+    uint64_t nodes;                  // The nodes in the ring, as a bitmap (updated atomically)
+    uint64_t key_sets[MAX_NODE_COUNT];           // The key set of each node, as a bitmap
+    chord_shared_value_t values[MAX_KEY_VALUE];  // The value stored under each key
+} chord_shared_store_t;
+
+// The size of the region, in bytes (a whole number of huge pages)
+#define SHARED_STORE_SIZE    ( ( sizeof( chord_shared_store_t ) + SHARED_STORE_PAGE_SIZE - 1 ) / \
+                               SHARED_STORE_PAGE_SIZE * SHARED_STORE_PAGE_SIZE )
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+// (none)
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
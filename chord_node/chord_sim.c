@@ -0,0 +1,848 @@
+//**************************************************************************************************
+// File:   chord_sim.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Single-process, deterministic discrete-event simulator of the DHT. The state of every node is
+// held in memory and swapped in before the node processes a message, so the simulation runs the
+// same message handlers as the node processes do. Message delivery is modeled by a priority queue
+// ordered by virtual time, with a configurable latency; node creation does not fork.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <limits.h>
+#include <math.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "chord_config.h"
+#include "chord_node.h"
+#include "chord_sim.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// Command line usage
+static const char sim_usage[] =
+    "Usage: chord_node --sim [options]\n"
+    "  --nodes <n>       Largest ring size to simulate (2-64, default 64)\n"
+    "  --keys <n>        Keys loaded into the ring (0-64, default 64)\n"
+    "  --lookups <n>     Lookups measured at each ring size (default 1000)\n"
+    "  --trials <n>      Independent rings built, with different join orders (default 10)\n"
+    "  --latency <us>    Mean message latency, in microseconds (default 100)\n"
+    "  --jitter <us>     Maximum deviation from the mean latency, in microseconds (default 50)\n"
+    "  --replicas <n>    Successors holding a copy of each node's keys (default 0)\n"
+    "  --stabilize <n>   Stabilization rounds run before each measurement, to fill the finger\n"
+    "                    tables (default 0: lookups follow successors only)\n"
+    "  --seed <n>        Random seed (default 1)\n";
+
+// Process IDs handed out for simulated nodes (never real processes)
+#define SIM_PID_BASE                    100000
+
+// Initial capacity of the event queue
+#define SIM_QUEUE_CAPACITY              1024
+
+// A message in flight, delivered at a virtual time
+typedef struct
+{
+    uint64_t time_ns;                // The virtual time at which the message is delivered
+    uint64_t seq;                    // Send order, so that simultaneous deliveries stay in order
+    int dest_id;                     // The node the message is delivered to
+    chord_msg_t msg;                 // The message
+    char *payload;                   // A copy of the message's payload (NULL if it has none)
+} sim_event_t;
+
+// Measurements accumulated for one ring size, over every trial
+typedef struct
+{
+    long lookups;                    // The number of lookups answered
+    long lookup_hops;                // Total node-to-node hops taken by lookups
+    int max_hops;                    // The most hops taken by a single lookup
+    double lookup_ns;                // Total virtual time taken by lookups
+    long wrong_answers;              // Lookups answered by the wrong node, or incorrectly
+    long joins;                      // The number of joins that grew the ring to this size
+    long join_msgs;                  // Total messages delivered because of those joins
+    double join_ns;                  // Total virtual time until those joins converged
+    long misplaced_keys;             // Keys not on their owner once the joins converged
+    double load_ratio;               // Total ratio of the most keys on a node to the mean
+    double load_stddev;              // Total standard deviation of keys per node
+    long samples;                    // The number of trials measured at this size
+} sim_row_t;
+
+// Local prototypes
+static void sim_send( int dest_id, const chord_msg_t *msg );
+static void sim_reply( const chord_msg_t *msg );
+static pid_t sim_spawn( const chord_msg_t *msg );
+static int sim_backlog();
+static void sim_inject( chord_cmd_t cmd, int id, int tag );
+static void sim_run_until_idle();
+static void sim_stabilize( int rounds );
+static void sim_push( const sim_event_t *event );
+static void sim_pop( sim_event_t *event );
+static bool sim_event_before( const sim_event_t *a, const sim_event_t *b );
+static void sim_reset_ring();
+static void sim_measure( sim_row_t *row, int lookups );
+static int sim_key_owner( int key );
+static uint64_t sim_random();
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// The transport that delivers messages through the event queue (values are moved in messages)
+static const chord_transport_t sim_transport = { sim_send, sim_reply, sim_spawn, sim_backlog,
+                                                 NULL };
+
+// The event queue (a binary heap ordered by delivery time)
+static sim_event_t *event_queue = NULL;
+static int event_count = 0;
+static int event_capacity = 0;
+
+// The current virtual time and the send order of the next message
+static uint64_t now_ns;
+static uint64_t next_seq;
+
+// The node processing a message
+static int current_id;
+
+// The latest delivery time to each node, since messages to a node arrive in order (as in a pipe)
+static uint64_t last_delivery_ns[MAX_NODE_COUNT + 1];
+
+// Latency model
+static uint64_t latency_ns;
+static uint64_t jitter_ns;
+
+// The state of every simulated node, and the set of nodes that exist
+static chord_node_state_t nodes[MAX_NODE_COUNT];
+static uint64_t node_set;
+
+// The keys loaded into the ring
+static uint64_t ring_keys;
+
+// Counters
+static long deliveries;              // Total messages delivered
+static int lookup_hops;              // Deliveries made by the lookup in progress
+static bool lookup_answered;         // Flag: "the lookup in progress was answered"
+static bool lookup_correct;          // Flag: "the lookup was answered correctly, by the owner"
+static uint64_t lookup_answer_ns;    // The time at which the lookup was answered
+
+// Random number generator state
+static uint64_t random_state;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: sim_main
+ * 
+ * Run the simulator with the given command line options, printing hop counts, message volume,
+ * key load distribution and join convergence as functions of ring size to the standard output.
+ * 
+ * param:  The number of command line options
+ * param:  The command line options (following "--sim")
+ * return: The program exit status
+ **************************************************************************************************/
+int sim_main( int argc, char **argv )
+{
+    // Local variables
+    sim_row_t rows[MAX_NODE_COUNT + 1];      // Measurements, indexed by ring size
+    int order[MAX_NODE_COUNT - 1];           // The order in which nodes join
+    struct timespec wall_start;              // Real time at which the simulation started
+    struct timespec wall_end;                // Real time at which the simulation ended
+    double wall_s;                           // Real time taken by the simulation
+    double virtual_s;                        // Virtual time simulated
+    uint64_t join_start_ns;                  // The time at which a join was sent
+    long join_start_deliveries;              // Deliveries made before a join was sent
+    int max_nodes = MAX_NODE_COUNT;          // Largest ring size
+    int key_count = MAX_KEY_VALUE;           // Keys loaded into the ring
+    int lookups = 1000;                      // Lookups per ring size
+    int trials = 10;                         // Rings built
+    int rounds = 0;                          // Stabilization rounds before each measurement
+    int size;                                // The current ring size
+    int swap;                                // Used to shuffle the join order
+    int key;                                 // A key
+
+    // Defaults
+    latency_ns = 100000;
+    jitter_ns = 50000;
+    random_state = 1;
+
+    // Parse command line options
+    for( int index = 0; index < argc; index++ )
+    {
+        if( index + 1 >= argc )
+        {
+            fputs( sim_usage, stderr );
+            return( EXIT_FAILURE );
+        }
+        else if( strcmp( argv[index], "--nodes" ) == 0 )
+        {
+            max_nodes = atoi( argv[++index] );
+        }
+        else if( strcmp( argv[index], "--keys" ) == 0 )
+        {
+            key_count = atoi( argv[++index] );
+        }
+        else if( strcmp( argv[index], "--lookups" ) == 0 )
+        {
+            lookups = atoi( argv[++index] );
+        }
+        else if( strcmp( argv[index], "--trials" ) == 0 )
+        {
+            trials = atoi( argv[++index] );
+        }
+        else if( strcmp( argv[index], "--latency" ) == 0 )
+        {
+            latency_ns = strtoull( argv[++index], NULL, 10 ) * 1000;
+        }
+        else if( strcmp( argv[index], "--jitter" ) == 0 )
+        {
+            jitter_ns = strtoull( argv[++index], NULL, 10 ) * 1000;
+        }
+        else if( strcmp( argv[index], "--replicas" ) == 0 )
+        {
+            set_replication( atoi( argv[++index] ) );
+        }
+        else if( strcmp( argv[index], "--stabilize" ) == 0 )
+        {
+            rounds = atoi( argv[++index] );
+        }
+        else if( strcmp( argv[index], "--seed" ) == 0 )
+        {
+            random_state = strtoull( argv[++index], NULL, 10 ) | 1;
+        }
+        else
+        {
+            fputs( sim_usage, stderr );
+            return( EXIT_FAILURE );
+        }
+    }
+
+    if( ( max_nodes < 2 ) || ( max_nodes > MAX_NODE_COUNT ) || ( key_count < 0 ) ||
+        ( key_count > MAX_KEY_VALUE ) || ( lookups < 0 ) || ( trials < 1 ) || ( rounds < 0 ) ||
+        ( jitter_ns > latency_ns ) )
+    {
+        fputs( sim_usage, stderr );
+        return( EXIT_FAILURE );
+    }
+
+    // Initialization
+    memset( rows, 0, sizeof( rows ) );
+    set_transport( &sim_transport );
+    virtual_s = 0.0;
+    deliveries = 0;
+    clock_gettime( CLOCK_MONOTONIC, &wall_start );
+
+    for( int trial = 0; trial < trials; trial++ )
+    {
+        sim_reset_ring();
+
+        // Load a random set of keys through the main node, as the menu process would
+        while( __builtin_popcountll( ring_keys ) < key_count )
+        {
+            key = sim_random() % MAX_KEY_VALUE;
+
+            if( ( ring_keys & ( 1UL << key ) ) == 0 )
+            {
+                ring_keys |= ( 1UL << key );
+                sim_inject( ADD_KEY, key, 0 );
+            }
+        }
+
+        sim_run_until_idle();
+        sim_measure( &rows[1], lookups );
+
+        // Shuffle the order in which nodes join
+        for( int index = 0; index < MAX_NODE_COUNT - 1; index++ )
+        {
+            order[index] = index;
+        }
+
+        for( int index = MAX_NODE_COUNT - 2; index > 0; index-- )
+        {
+            swap = sim_random() % ( index + 1 );
+            size = order[index];
+            order[index] = order[swap];
+            order[swap] = size;
+        }
+
+        // Grow the ring one join at a time, measuring at every power-of-two size (and the last)
+        for( size = 2; size <= max_nodes; size++ )
+        {
+            join_start_ns = now_ns;
+            join_start_deliveries = deliveries;
+
+            sim_inject( ADD_NODE, order[size - 2], 0 );
+            sim_run_until_idle();
+
+            rows[size].joins++;
+            rows[size].join_msgs += deliveries - join_start_deliveries - 1;
+            rows[size].join_ns += now_ns - join_start_ns;
+
+            if( ( ( size & ( size - 1 ) ) == 0 ) || ( size == max_nodes ) )
+            {
+                sim_stabilize( rounds );
+                sim_measure( &rows[size], lookups );
+            }
+        }
+
+        virtual_s += now_ns / 1.0e9;
+    }
+
+    clock_gettime( CLOCK_MONOTONIC, &wall_end );
+    wall_s = ( wall_end.tv_sec - wall_start.tv_sec ) +
+             ( wall_end.tv_nsec - wall_start.tv_nsec ) / 1.0e9;
+
+    // Print results
+    printf( "Simulated %i rings of up to %i nodes, %i keys, %i lookups per size, "
+            "latency %.0f +/- %.0f us, %i stabilization rounds\n", trials, max_nodes, key_count, 
+            lookups, latency_ns / 1000.0, jitter_ns / 1000.0, rounds );
+    printf( "%6s %9s %9s %11s %10s %13s %9s %9s %10s %8s\n", "nodes", "hops avg", "hops max",
+            "lookup us", "join msgs", "join conv us", "load max", "load sd", "misplaced",
+            "wrong" );
+
+    for( size = 1; size <= max_nodes; size++ )
+    {
+        if( rows[size].samples > 0 )
+        {
+            printf( "%6i %9.2f %9i %11.1f %10.1f %13.1f %9.2f %9.2f %10li %8li\n", size,
+                    ( rows[size].lookups > 0 ) ?
+                        (double)rows[size].lookup_hops / rows[size].lookups : 0.0,
+                    rows[size].max_hops,
+                    ( rows[size].lookups > 0 ) ?
+                        rows[size].lookup_ns / rows[size].lookups / 1000.0 : 0.0,
+                    ( rows[size].joins > 0 ) ?
+                        (double)rows[size].join_msgs / rows[size].joins : 0.0,
+                    ( rows[size].joins > 0 ) ? rows[size].join_ns / rows[size].joins / 1000.0 : 0.0,
+                    rows[size].load_ratio / rows[size].samples,
+                    rows[size].load_stddev / rows[size].samples,
+                    rows[size].misplaced_keys, rows[size].wrong_answers );
+        }
+    }
+
+    printf( "Columns: lookup hops and virtual latency; messages and virtual time per join into a "
+            "ring of that size;\n         most keys on one node relative to the mean, and "
+            "standard deviation of keys per node\n" );
+    printf( "Delivered %li messages; simulated %.3f s in %.3f s of real time (%.0fx real time)\n",
+            deliveries, virtual_s, wall_s, ( wall_s > 0.0 ) ? virtual_s / wall_s : 0.0 );
+
+    free( event_queue );
+
+    return( EXIT_SUCCESS );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_send
+ * 
+ * Transport hook: queue a message for delivery to a node after the modeled latency, with a copy of
+ * its payload. Messages to the same node are delivered in the order they were sent, as they would
+ * be through its pipe.
+ * 
+ * param:  The ID of the destination node
+ * param:  The message to send
+ * return: void
+ **************************************************************************************************/
+static void sim_send( int dest_id, const chord_msg_t *msg )
+{
+    // Local variables
+    sim_event_t event;               // The message in flight
+    int length;                      // The length of the message's payload
+
+    event.time_ns = now_ns + latency_ns - jitter_ns;
+
+    if( jitter_ns > 0 )
+    {
+        event.time_ns += sim_random() % ( 2 * jitter_ns + 1 );
+    }
+
+    if( event.time_ns < last_delivery_ns[dest_id] )
+    {
+        event.time_ns = last_delivery_ns[dest_id];
+    }
+
+    last_delivery_ns[dest_id] = event.time_ns;
+    event.seq = next_seq++;
+    event.dest_id = dest_id;
+    event.msg = *msg;
+    event.payload = NULL;
+    length = MSG_PAYLOAD_LENGTH( msg );
+
+    if( length > 0 )
+    {
+        event.payload = malloc( length );
+
+        if( event.payload == NULL )
+        {
+            fputs( "Simulation aborted: out of memory for a message payload\n", stderr );
+            exit( EXIT_FAILURE );
+        }
+
+        memcpy( event.payload, msg + 1, length );
+    }
+
+    sim_push( &event );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_reply
+ * 
+ * Transport hook: receive a reply meant for the menu process. Lookup answers are checked against
+ * the owner of the key and the keys loaded into the ring.
+ * 
+ * param:  The reply
+ * return: void
+ **************************************************************************************************/
+static void sim_reply( const chord_msg_t *msg )
+{
+    if( msg->cmd == LOOKUP )
+    {
+        lookup_answered = true;
+        lookup_answer_ns = now_ns;
+        lookup_correct = ( msg->sender == sim_key_owner( msg->id ) ) &&
+                         ( ( msg->data != 0 ) == ( ( ring_keys & ( 1UL << msg->id ) ) != 0 ) );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: sim_spawn
+ * 
+ * Transport hook: create a new node. As with fork, the new node starts as a copy of the node
+ * creating it; its state is initialized and stored, and the creating node carries on.
+ * 
+ * param:  The "addnode" message that causes the node to be created
+ * return: A (simulated) process ID for the new node
+ **************************************************************************************************/
+static pid_t sim_spawn( const chord_msg_t *msg )
+{
+    // Local variables
+    chord_node_state_t parent;       // The state of the node creating the new node
+
+    get_node_state( &parent );
+    init_new_node( *msg );
+    get_node_state( &nodes[msg->id] );
+    set_node_state( &parent );
+
+    node_set |= ( 1UL << msg->id );
+
+    return( SIM_PID_BASE + msg->id );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_backlog
+ * 
+ * Transport hook: measure the messages in flight to the node processing a message, in bytes (as
+ * they would wait in its pipe).
+ * 
+ * param:  void
+ * return: The number of bytes in flight to the node
+ **************************************************************************************************/
+static int sim_backlog()
+{
+    // Local variables
+    int bytes = 0;                   // Bytes in flight to the node
+
+    for( int index = 0; index < event_count; index++ )
+    {
+        if( event_queue[index].dest_id == current_id )
+        {
+            bytes += (int)sizeof( chord_msg_t ) + MSG_PAYLOAD_LENGTH( &event_queue[index].msg );
+        }
+    }
+
+    return( bytes );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_inject
+ * 
+ * Send a command from the (simulated) menu process to the main node.
+ * 
+ * param:  The command type
+ * param:  The node or key ID of the command
+ * param:  The tag of the command
+ * return: void
+ **************************************************************************************************/
+static void sim_inject( chord_cmd_t cmd, int id, int tag )
+{
+    // Local variables
+    chord_msg_t msg;                 // The command
+
+    msg.cmd = cmd;
+    msg.id = id;
+    msg.sender = MENU_PROCESS_ID;
+    msg.tag = tag;
+    msg.hops = 0;
+    msg.data = 0;
+    msg.length = 0;
+
+    sim_send( MAIN_DHT_NODE, &msg );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_run_until_idle
+ * 
+ * Deliver messages in order of virtual time until none are in flight. Each node's state is
+ * swapped in before its handler runs, and saved afterwards.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void sim_run_until_idle()
+{
+    // Local variables
+    sim_event_t event;               // The next message to deliver
+    chord_payload_msg_t delivered;   // The message, followed by its payload
+
+    while( event_count > 0 )
+    {
+        sim_pop( &event );
+        now_ns = event.time_ns;
+        deliveries++;
+
+        if( event.msg.cmd == LOOKUP )
+        {
+            lookup_hops++;
+        }
+
+        // Messages for nodes that do not exist are dropped, as nothing would read them
+        if( node_set & ( 1UL << event.dest_id ) )
+        {
+            current_id = event.dest_id;
+            set_node_state( &nodes[event.dest_id] );
+            delivered.msg = event.msg;
+
+            if( event.payload != NULL )
+            {
+                memcpy( delivered.payload, event.payload, MSG_PAYLOAD_LENGTH( &event.msg ) );
+            }
+
+            process_payload_msg( &delivered.msg );
+            get_node_state( &nodes[event.dest_id] );
+        }
+
+        free( event.payload );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: sim_stabilize
+ * 
+ * Run rounds of the stabilization protocol: in each, every node starts a round, as its timer 
+ * would, and the messages are delivered until none are in flight.
+ * 
+ * param:  The number of rounds
+ * return: void
+ **************************************************************************************************/
+static void sim_stabilize( int rounds )
+{
+    for( int round = 0; round < rounds; round++ )
+    {
+        for( int id = 0; id < MAX_NODE_COUNT; id++ )
+        {
+            if( node_set & ( 1UL << id ) )
+            {
+                current_id = id;
+                set_node_state( &nodes[id] );
+                stabilize();
+                get_node_state( &nodes[id] );
+            }
+        }
+
+        sim_run_until_idle();
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: sim_push
+ * 
+ * Add a message to the event queue.
+ * 
+ * param:  The message in flight
+ * return: void
+ **************************************************************************************************/
+static void sim_push( const sim_event_t *event )
+{
+    // Local variables
+    sim_event_t *resized;            // The queue after growing it
+    int index;                       // Position of the new event in the heap
+    int parent;                      // Position of its parent
+
+    if( event_count == event_capacity )
+    {
+        event_capacity = ( event_capacity == 0 ) ? SIM_QUEUE_CAPACITY : event_capacity * 2;
+        resized = realloc( event_queue, event_capacity * sizeof( sim_event_t ) );
+
+        if( resized == NULL )
+        {
+            fputs( "Simulation aborted: out of memory for the event queue\n", stderr );
+            exit( EXIT_FAILURE );
+        }
+
+        event_queue = resized;
+    }
+
+    // Sift up
+    index = event_count++;
+
+    while( index > 0 )
+    {
+        parent = ( index - 1 ) / 2;
+
+        if( sim_event_before( &event_queue[parent], event ) )
+        {
+            break;
+        }
+
+        event_queue[index] = event_queue[parent];
+        index = parent;
+    }
+
+    event_queue[index] = *event;
+}
+
+
+/***************************************************************************************************
+ * Function: sim_pop
+ * 
+ * Remove the earliest message from the event queue. The queue must not be empty.
+ * 
+ * param:  Holds the earliest message
+ * return: void
+ **************************************************************************************************/
+static void sim_pop( sim_event_t *event )
+{
+    // Local variables
+    sim_event_t last;                // The last event in the heap, to be placed again
+    int index;                       // Position being filled
+    int child;                       // Earlier child of that position
+
+    *event = event_queue[0];
+    last = event_queue[--event_count];
+    index = 0;
+
+    // Sift down
+    while( ( child = 2 * index + 1 ) < event_count )
+    {
+        if( ( child + 1 < event_count ) &&
+            sim_event_before( &event_queue[child + 1], &event_queue[child] ) )
+        {
+            child++;
+        }
+
+        if( sim_event_before( &last, &event_queue[child] ) )
+        {
+            break;
+        }
+
+        event_queue[index] = event_queue[child];
+        index = child;
+    }
+
+    event_queue[index] = last;
+}
+
+
+/***************************************************************************************************
+ * Function: sim_event_before
+ * 
+ * Compare two messages in flight by delivery time, then by send order.
+ * 
+ * param:  The first message
+ * param:  The second message
+ * return: True if the first message is delivered before the second
+ **************************************************************************************************/
+static bool sim_event_before( const sim_event_t *a, const sim_event_t *b )
+{
+    return( ( a->time_ns < b->time_ns ) ||
+            ( ( a->time_ns == b->time_ns ) && ( a->seq < b->seq ) ) );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_reset_ring
+ * 
+ * Start a new ring holding only the main node, with no keys and no messages in flight. The main
+ * node's caches and request counts start empty, as those of a new node do.
+ * 
+ * param:  void
+ * return: void
+ **************************************************************************************************/
+static void sim_reset_ring()
+{
+    memset( nodes, 0, sizeof( nodes ) );
+    memset( last_delivery_ns, 0, sizeof( last_delivery_ns ) );
+
+    nodes[MAIN_DHT_NODE].node_id = MAIN_DHT_NODE;
+    owner_cache_init( &nodes[MAIN_DHT_NODE].owner_cache );
+    value_cache_init( &nodes[MAIN_DHT_NODE].value_cache );
+    hot_init( &nodes[MAIN_DHT_NODE].hot_tracker );
+    nodes[MAIN_DHT_NODE].successor_id = INT_MAX;
+    nodes[MAIN_DHT_NODE].predecessor_id = INT_MAX;
+
+    for( int index = 0; index < SUCCESSOR_LIST_LENGTH; index++ )
+    {
+        nodes[MAIN_DHT_NODE].successors[index] = INT_MAX;
+    }
+
+    for( int index = 0; index < FINGER_COUNT; index++ )
+    {
+        nodes[MAIN_DHT_NODE].fingers[index] = INT_MAX;
+    }
+
+    node_set = ( 1UL << MAIN_DHT_NODE );
+    ring_keys = 0;
+    for( int index = 0; index < event_count; index++ )
+    {
+        free( event_queue[index].payload );
+    }
+
+    event_count = 0;
+    now_ns = 0;
+    next_seq = 0;
+}
+
+
+/***************************************************************************************************
+ * Function: sim_measure
+ * 
+ * Measure the ring at its current size: key placement and load distribution, then the hop count
+ * and latency of a number of lookups, each run on its own.
+ * 
+ * param:  Accumulates the measurements for the current ring size
+ * param:  The number of lookups to run
+ * return: void
+ **************************************************************************************************/
+static void sim_measure( sim_row_t *row, int lookups )
+{
+    // Local variables
+    uint64_t lookup_start_ns;        // The time at which a lookup was sent
+    uint64_t owned;                  // The keys a node should own
+    double mean;                     // Mean number of keys per node
+    double variance;                 // Variance of the number of keys per node
+    int node_count;                  // The number of nodes in the ring
+    int most_keys;                   // The most keys held by a single node
+    int held;                        // Keys held by a node
+
+    // Initialization
+    node_count = __builtin_popcountll( node_set );
+    mean = (double)__builtin_popcountll( ring_keys ) / node_count;
+    variance = 0.0;
+    most_keys = 0;
+
+    for( int id = 0; id < MAX_NODE_COUNT; id++ )
+    {
+        if( node_set & ( 1UL << id ) )
+        {
+            held = __builtin_popcountll( nodes[id].key_set );
+            most_keys = ( held > most_keys ) ? held : most_keys;
+            variance += ( held - mean ) * ( held - mean );
+
+            // Check that the node holds exactly the keys it owns
+            owned = 0;
+
+            for( int key = 0; key < MAX_KEY_VALUE; key++ )
+            {
+                if( ( ring_keys & ( 1UL << key ) ) && ( sim_key_owner( key ) == id ) )
+                {
+                    owned |= ( 1UL << key );
+                }
+            }
+
+            row->misplaced_keys += __builtin_popcountll( owned & ~nodes[id].key_set );
+        }
+    }
+
+    row->load_ratio += ( mean > 0.0 ) ? most_keys / mean : 0.0;
+    row->load_stddev += sqrt( variance / node_count );
+    row->samples++;
+
+    for( int lookup = 0; lookup < lookups; lookup++ )
+    {
+        lookup_hops = 0;
+        lookup_answered = false;
+        lookup_start_ns = now_ns;
+
+        sim_inject( LOOKUP, sim_random() % MAX_KEY_VALUE, lookup + 1 );
+        sim_run_until_idle();
+
+        if( ( lookup_answered == false ) || ( lookup_correct == false ) )
+        {
+            row->wrong_answers++;
+        }
+        else
+        {
+            // The first delivery is from the menu process to the main node, not a hop
+            row->lookups++;
+            row->lookup_hops += lookup_hops - 1;
+            row->max_hops = ( lookup_hops - 1 > row->max_hops ) ? lookup_hops - 1 : row->max_hops;
+            row->lookup_ns += lookup_answer_ns - lookup_start_ns;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: sim_key_owner
+ * 
+ * Determine the node that should own a key: the first node with an ID greater than or equal to
+ * the key. The main node (63) is always present, so every key has an owner.
+ * 
+ * param:  The key in question
+ * return: The ID of the owning node
+ **************************************************************************************************/
+static int sim_key_owner( int key )
+{
+    // Local variables
+    int owner = key;                 // Candidate owner of the key
+
+    while( ( owner < MAIN_DHT_NODE ) && ( ( node_set & ( 1UL << owner ) ) == 0 ) )
+    {
+        owner++;
+    }
+
+    return( owner );
+}
+
+
+/***************************************************************************************************
+ * Function: sim_random
+ * 
+ * Deterministic pseudo-random number generator (xorshift64), so that runs with the same seed
+ * produce the same results.
+ * 
+ * param:  void
+ * return: A pseudo-random number
+ **************************************************************************************************/
+static uint64_t sim_random()
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 7;
+    random_state ^= random_state << 17;
+
+    return( random_state );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
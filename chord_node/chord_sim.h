@@ -1,17 +1,20 @@
 //**************************************************************************************************
-// File:   chord_debug.h
-// Author: James Williamson
-// Date:   9/21/2016
+// File:   chord_sim.h
+// Author: agent
+// Date:   10/19/2026
 // 
-// CIS620 Assignment 1 - Fall 2016
+// Single-process, deterministic discrete-event simulator of the DHT. The state of every node is
+// held in memory and swapped in before the node processes a message, so the simulation runs the
+// same message handlers as the node processes do. Message delivery is modeled by a priority queue
+// ordered by virtual time, with a configurable latency; node creation does not fork.
 // 
-// Provides debug print capability for the Chord simulation. Debug prints may be turned on or off
-// during program runtime.
+// Note: The size of the simulated ring is bounded by the node ID space (MAX_NODE_COUNT), since
+//       the handlers and key set assume it.
 // 
 //**************************************************************************************************
 
-#ifndef CHORD_DEBUG_H
-#define CHORD_DEBUG_H
+#ifndef CHORD_SIM_H
+#define CHORD_SIM_H
 
 
 //**************************************************************************************************
@@ -33,37 +36,16 @@
 //**************************************************************************************************
 
 /***************************************************************************************************
- * Function: debug_enable_prints
+ * Function: sim_main
  * 
- * Enables debug print output to the standard output stream.
+ * Run the simulator with the given command line options, printing hop counts, message volume,
+ * key load distribution and join convergence as functions of ring size to the standard output.
  * 
- * param:  void
- * return: void
+ * param:  The number of command line options
+ * param:  The command line options (following "--sim")
+ * return: The program exit status
  **************************************************************************************************/
-void debug_enable_prints();
-
-
-/***************************************************************************************************
- * Function: debug_disable_prints
- * 
- * Disables debug print output to the standard output stream.
- * 
- * param:  void
- * return: void
- **************************************************************************************************/
-void debug_disable_prints();
-
-
-/***************************************************************************************************
- * Function: debug_printf
- * 
- * Write a line of debug output to the standard output stream. If prints are disabled, this 
- * function will simply return without taking any action.
- * 
- * param:  A formatted debug string to print
- * return: void
- **************************************************************************************************/
-void debug_printf( const char *format, ... );
+int sim_main( int argc, char **argv );
 
 
 #endif
@@ -0,0 +1,492 @@
+//**************************************************************************************************
+// File:   chord_supervisor.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Supervisor process that watches the node processes and repairs the ring when one fails. The
+// supervisor learns of nodes from their heartbeats, so it needs no part in creating them; the node
+// that places a new node in the ring only reports the join, so that the new node is counted as
+// part of the ring until its first heartbeat arrives.
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <poll.h>
+#include <signal.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <sys/syscall.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+#include "chord_message.h"
+#include "chord_supervisor.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The most messages read from the heartbeat pipe at once
+#define SUPERVISOR_READ_BATCH           64
+
+// What the supervisor knows of a node
+typedef struct
+{
+    pid_t pid;                       // The process of the node (zero until it is heard from)
+    int pidfd;                       // A pidfd for the process (-1 if unavailable)
+    bool alive;                      // Flag: "the node is alive"
+    bool joining;                    // Flag: "the node has joined, but is yet to be heard from"
+    double joined_ms;                // The time at which the join was reported
+    double last_heartbeat_ms;        // The time of the latest heartbeat
+    uint64_t snapshot;               // The key set carried by the latest heartbeat
+    double detected_ms;              // The time at which the node's failure was detected
+    const char *cause;               // How the failure was detected
+    int successor_id;                // The node taking over from the failed node
+    uint64_t acks_pending;           // Nodes yet to acknowledge the repair, as a bitmap
+    uint64_t restored;               // The keys the successor took over
+    bool from_replica;               // Flag: "the keys were restored from a replica"
+} supervised_node_t;
+
+// Local prototypes
+static void supervisor_note_heartbeat( const chord_msg_t *msg );
+static void supervisor_note_join( const chord_msg_t *msg );
+static void supervisor_note_ack( const chord_msg_t *msg );
+static void supervisor_note_departure( const chord_msg_t *msg );
+static void supervisor_node_failed( int id, const char *cause );
+static void supervisor_repair( int id );
+static int supervisor_open_pidfd( pid_t pid );
+static double supervisor_now_ms();
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// What the supervisor knows of each node
+static supervised_node_t nodes[MAX_NODE_COUNT];
+
+// Pipe descriptors for communication between DHT nodes
+static int (*node_pipes)[2];
+
+// The pipe descriptor for sending repair reports to the menu process
+static int pipe_to_menu;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: supervisor_run
+ * 
+ * Run the supervisor. This function does not return.
+ * 
+ * param:  The pipe descriptor for receiving heartbeats and repair acknowledgements from nodes
+ * param:  Pipe descriptors for communication between DHT nodes
+ * param:  The pipe descriptor for sending repair reports to the menu process
+ * return: void
+ **************************************************************************************************/
+void supervisor_run( int heartbeat_handle, int dht_pipes[MAX_NODE_COUNT][2], 
+                     int menu_reply_handle )
+{
+    // Local variables
+    struct pollfd polls[MAX_NODE_COUNT + 1];     // The heartbeat pipe, then node pidfds
+    int poll_ids[MAX_NODE_COUNT + 1];            // The node watched by each pidfd
+    chord_msg_t batch[SUPERVISOR_READ_BATCH];    // Messages read from the heartbeat pipe
+    ssize_t bytes_read;                          // The number of bytes read
+    int poll_count;                              // The number of descriptors polled
+    double now_ms;                               // The current time
+
+    // Initialization
+    node_pipes = dht_pipes;
+    pipe_to_menu = menu_reply_handle;
+
+    for( int id = 0; id < MAX_NODE_COUNT; id++ )
+    {
+        nodes[id].pid = 0;
+        nodes[id].pidfd = -1;
+        nodes[id].alive = false;
+        nodes[id].joining = false;
+    }
+
+    while( true )
+    {
+        // Wait for heartbeats, or for a node process to exit
+        polls[0].fd = heartbeat_handle;
+        polls[0].events = POLLIN;
+        poll_count = 1;
+
+        for( int id = 0; id < MAX_NODE_COUNT; id++ )
+        {
+            if( ( nodes[id].alive == true ) && ( nodes[id].pidfd >= 0 ) )
+            {
+                polls[poll_count].fd = nodes[id].pidfd;
+                polls[poll_count].events = POLLIN;
+                poll_ids[poll_count++] = id;
+            }
+        }
+
+        if( poll( polls, poll_count, HEARTBEAT_INTERVAL_MS ) > 0 )
+        {
+            if( polls[0].revents & POLLIN )
+            {
+                // Messages are smaller than PIPE_BUF, so the pipe only ever holds whole messages
+                bytes_read = read( heartbeat_handle, batch, sizeof( batch ) );
+
+                for( int index = 0; index < bytes_read / (ssize_t)sizeof( chord_msg_t ); index++ )
+                {
+                    if( batch[index].cmd == HEARTBEAT )
+                    {
+                        supervisor_note_heartbeat( &batch[index] );
+                    }
+                    else if( batch[index].cmd == ADD_NODE )
+                    {
+                        supervisor_note_join( &batch[index] );
+                    }
+                    else if( batch[index].cmd == REPAIR )
+                    {
+                        supervisor_note_ack( &batch[index] );
+                    }
+                    else if( batch[index].cmd == LEAVE )
+                    {
+                        supervisor_note_departure( &batch[index] );
+                    }
+                }
+            }
+
+            for( int index = 1; index < poll_count; index++ )
+            {
+                if( polls[index].revents & POLLIN )
+                {
+                    supervisor_node_failed( poll_ids[index], "process exited" );
+                }
+            }
+        }
+
+        // Nodes that have stopped sending heartbeats are hung (or without a pidfd, dead)
+        now_ms = supervisor_now_ms();
+
+        for( int id = 0; id < MAX_NODE_COUNT; id++ )
+        {
+            if( ( nodes[id].alive == true ) &&
+                ( now_ms - nodes[id].last_heartbeat_ms > HEARTBEAT_TIMEOUT_MS ) )
+            {
+                // Make sure a hung node cannot come back and act on stale state
+                kill( nodes[id].pid, SIGKILL );
+                supervisor_node_failed( id, "heartbeats stopped" );
+            }
+            else if( ( nodes[id].joining == true ) &&
+                     ( now_ms - nodes[id].joined_ms > HEARTBEAT_TIMEOUT_MS ) )
+            {
+                // The process is not known, so there is nothing to kill
+                supervisor_node_failed( id, "never heard from" );
+            }
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_note_heartbeat
+ * 
+ * Record a heartbeat. A heartbeat from a new process (a node that joined, or rejoined after
+ * failing) starts watching that process.
+ * 
+ * param:  The heartbeat (the ID is the process ID of the node, the payload its key set)
+ * return: void
+ **************************************************************************************************/
+static void supervisor_note_heartbeat( const chord_msg_t *msg )
+{
+    // Local variables
+    supervised_node_t *node = &nodes[msg->sender];   // The node that sent the heartbeat
+
+    if( node->pid != msg->id )
+    {
+        if( node->pidfd >= 0 )
+        {
+            close( node->pidfd );
+        }
+
+        node->pid = msg->id;
+        node->pidfd = supervisor_open_pidfd( node->pid );
+        node->alive = true;
+        node->joining = false;
+    }
+    else if( node->alive == false )
+    {
+        // A heartbeat sent just before the node failed
+        return;
+    }
+
+    node->last_heartbeat_ms = supervisor_now_ms();
+    node->snapshot = msg->data;
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_note_join
+ * 
+ * Record that a node has joined the ring. Until its first heartbeat arrives, the node is neither
+ * watched nor taken for failed: it stays in the ring, so that a repair around a neighbouring node
+ * does not pass over it.
+ * 
+ * param:  The report of the join (the sender is the node that joined)
+ * return: void
+ **************************************************************************************************/
+static void supervisor_note_join( const chord_msg_t *msg )
+{
+    // Local variables
+    supervised_node_t *node = &nodes[msg->sender];   // The node that joined
+
+    // The node's first heartbeat may have overtaken the report
+    if( node->alive == false )
+    {
+        node->joining = true;
+        node->joined_ms = supervisor_now_ms();
+        node->snapshot = 0;
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_note_ack
+ * 
+ * Record a node's acknowledgement of a repair. Once every node involved has acknowledged it, the
+ * repair is reported.
+ * 
+ * param:  The acknowledgement (the ID is the failed node; the successor that took over also
+ *         sends the keys it restored, and whether they came from a replica)
+ * return: void
+ **************************************************************************************************/
+static void supervisor_note_ack( const chord_msg_t *msg )
+{
+    // Local variables
+    supervised_node_t *node = &nodes[msg->id];       // The failed node
+    chord_msg_t report;                              // Report to the menu process
+    double repair_ms;                                // Time taken to repair the ring
+
+    if( ( node->acks_pending & ( 1UL << msg->sender ) ) == 0 )
+    {
+        return;
+    }
+
+    node->acks_pending &= ~( 1UL << msg->sender );
+
+    if( msg->sender == node->successor_id )
+    {
+        node->restored = msg->data;
+        node->from_replica = ( msg->hops != 0 );
+    }
+
+    if( node->acks_pending != 0 )
+    {
+        return;
+    }
+
+    repair_ms = supervisor_now_ms() - node->detected_ms;
+
+    printf( "Supervisor: node %i (PID %i) failed (%s); ring repaired in %.3f ms, node %i took "
+            "over %i keys from %s\n", msg->id, node->pid, node->cause, repair_ms,
+            node->successor_id, __builtin_popcountll( node->restored ),
+            ( node->from_replica == true ) ? "its replica" : "the last heartbeat snapshot" );
+    fflush( stdout );
+
+    // Let the menu process know the node is gone
+    report.cmd = REPAIR;
+    report.id = msg->id;
+    report.sender = node->successor_id;
+    report.tag = 0;
+    report.hops = 0;
+    report.data = (uint64_t)( repair_ms * 1000.0 );
+    write( pipe_to_menu, (const void *)&report, sizeof( report ) );
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_note_departure
+ * 
+ * Record that a node has left the ring, so that its exit is not taken for a failure.
+ * 
+ * param:  The notice of departure (the ID is the process ID of the node)
+ * return: void
+ **************************************************************************************************/
+static void supervisor_note_departure( const chord_msg_t *msg )
+{
+    // Local variables
+    supervised_node_t *node = &nodes[msg->sender];   // The node that left
+    
+    if( ( ( node->pid == msg->id ) && ( node->alive == true ) ) || ( node->joining == true ) )
+    {
+        // The process may host the node again (as a virtual node), so it is forgotten
+        node->pid = 0;
+        node->alive = false;
+        node->joining = false;
+        
+        if( node->pidfd >= 0 )
+        {
+            close( node->pidfd );
+            node->pidfd = -1;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_node_failed
+ * 
+ * Handle the failure of a node, and of any other nodes its process hosts (virtual nodes fail with
+ * their process). Every one of them is marked failed before any is repaired, so that none is 
+ * chosen to take over from another.
+ * 
+ * param:  The ID of the failed node
+ * param:  How the failure was detected
+ * return: void
+ **************************************************************************************************/
+static void supervisor_node_failed( int id, const char *cause )
+{
+    // Local variables
+    pid_t pid = nodes[id].pid;               // The process of the failed node
+    uint64_t failed = 0;                     // The nodes that failed, as a bitmap
+
+    for( int other = 0; other < MAX_NODE_COUNT; other++ )
+    {
+        if( ( other == id ) || ( ( nodes[other].alive == true ) && ( nodes[other].pid == pid ) ) )
+        {
+            nodes[other].alive = false;
+            nodes[other].joining = false;
+            nodes[other].detected_ms = supervisor_now_ms();
+            nodes[other].cause = cause;
+
+            if( nodes[other].pidfd >= 0 )
+            {
+                close( nodes[other].pidfd );
+                nodes[other].pidfd = -1;
+            }
+
+            failed |= ( 1UL << other );
+        }
+    }
+
+    for( int other = 0; other < MAX_NODE_COUNT; other++ )
+    {
+        if( failed & ( 1UL << other ) )
+        {
+            supervisor_repair( other );
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_repair
+ * 
+ * Repair the ring around a failed node: its successor is told to take over its keys and pipe, and
+ * its predecessor to link to the successor.
+ * 
+ * param:  The ID of the failed node
+ * return: void
+ **************************************************************************************************/
+static void supervisor_repair( int id )
+{
+    // Local variables
+    supervised_node_t *node = &nodes[id];    // The failed node
+    chord_msg_t repair;                      // The repair message
+    int predecessor_id;                      // The live node before the failed node
+    int successor_id;                        // The live node after the failed node
+
+    if( id == MAIN_DHT_NODE )
+    {
+        printf( "Supervisor: main node %i (PID %i) failed (%s); the ring cannot be repaired\n",
+                id, node->pid, node->cause );
+        fflush( stdout );
+        return;
+    }
+
+    /*
+     * The main node is always the last node in the ring (and the first node's predecessor). Nodes 
+     * that have joined but not yet sent a heartbeat are in the ring, so they are not passed over.
+     */
+    successor_id = id + 1;
+
+    while( ( successor_id < MAIN_DHT_NODE ) && ( nodes[successor_id].alive == false ) &&
+           ( nodes[successor_id].joining == false ) )
+    {
+        successor_id++;
+    }
+
+    predecessor_id = id - 1;
+
+    while( ( predecessor_id >= 0 ) && ( nodes[predecessor_id].alive == false ) &&
+           ( nodes[predecessor_id].joining == false ) )
+    {
+        predecessor_id--;
+    }
+
+    predecessor_id = ( predecessor_id < 0 ) ? MAIN_DHT_NODE : predecessor_id;
+
+    node->successor_id = successor_id;
+    node->acks_pending = ( 1UL << successor_id ) | ( 1UL << predecessor_id );
+    node->restored = 0;
+    node->from_replica = false;
+
+    repair.cmd = REPAIR;
+    repair.id = id;
+    repair.sender = successor_id;
+    repair.tag = predecessor_id;
+    repair.hops = 0;
+    repair.data = node->snapshot;
+
+    write( node_pipes[successor_id][1], (const void *)&repair, sizeof( repair ) );
+
+    if( predecessor_id != successor_id )
+    {
+        write( node_pipes[predecessor_id][1], (const void *)&repair, sizeof( repair ) );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_open_pidfd
+ * 
+ * Open a pidfd for a node process, which becomes readable when the process exits.
+ * 
+ * param:  The process ID
+ * return: The pidfd, or -1 if pidfds are unavailable (failures are then found by heartbeats)
+ **************************************************************************************************/
+static int supervisor_open_pidfd( pid_t pid )
+{
+#ifdef SYS_pidfd_open
+    return( (int)syscall( SYS_pidfd_open, pid, 0 ) );
+#else
+    return( -1 );
+#endif
+}
+
+
+/***************************************************************************************************
+ * Function: supervisor_now_ms
+ * 
+ * Read the monotonic clock.
+ * 
+ * param:  void
+ * return: The current time, in milliseconds
+ **************************************************************************************************/
+static double supervisor_now_ms()
+{
+    // Local variables
+    struct timespec now;             // The current time
+
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return( now.tv_sec * 1000.0 + now.tv_nsec / 1.0e6 );
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,67 @@
+//**************************************************************************************************
+// File:   chord_supervisor.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Supervisor process that watches the node processes and repairs the ring when one fails. Nodes
+// send heartbeats (carrying a snapshot of their key set) through a pipe of their own; the
+// supervisor also holds a pidfd for each node, so that a node that exits is noticed at once,
+// while one that hangs is noticed when its heartbeats stop. A node that leaves the ring on 
+// purpose tells the supervisor before it exits, and the node that places a new node in the ring
+// reports the join, so that the new node is not passed over before its first heartbeat arrives.
+// The virtual nodes a process hosts fail with it.
+// 
+// When a node fails, its successor takes over its keys (from its replica, if keys are replicated,
+// or else from the latest snapshot) and the messages left in its pipe, and its predecessor links
+// to the successor. The time taken to repair the ring is reported on the standard output and to
+// the menu process.
+// 
+// Note: The main node (63) cannot be repaired, since the menu process reaches the DHT through it.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_SUPERVISOR_H
+#define CHORD_SUPERVISOR_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include "chord_config.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The interval between heartbeats from each node, in milliseconds
+#define HEARTBEAT_INTERVAL_MS           100
+
+// A node that has not sent a heartbeat for this long is considered failed, in milliseconds
+#define HEARTBEAT_TIMEOUT_MS            500
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: supervisor_run
+ * 
+ * Run the supervisor. This function does not return.
+ * 
+ * param:  The pipe descriptor for receiving heartbeats and repair acknowledgements from nodes
+ * param:  Pipe descriptors for communication between DHT nodes
+ * param:  The pipe descriptor for sending repair reports to the menu process
+ * return: void
+ **************************************************************************************************/
+void supervisor_run( int heartbeat_handle, int dht_pipes[MAX_NODE_COUNT][2], 
+                     int menu_reply_handle );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
@@ -0,0 +1,197 @@
+//**************************************************************************************************
+// File:   chord_value_cache.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// A small read-through cache of the values of hot keys (see chord_value_cache.h).
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include <string.h>
+#include "chord_value_cache.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: value_cache_init
+ * 
+ * Empty a cache, and clear its counters.
+ * 
+ * param:  The cache
+ * return: void
+ **************************************************************************************************/
+void value_cache_init( value_cache_t *cache )
+{
+    for( int index = 0; index < VALUE_CACHE_SIZE; index++ )
+    {
+        cache->entries[index].key = -1;
+    }
+
+    memset( cache->versions, 0, sizeof( cache->versions ) );
+    cache->clock = 0;
+    cache->lookups = 0;
+    cache->hits = 0;
+}
+
+
+/***************************************************************************************************
+ * Function: value_cache_find
+ * 
+ * Find a copy of the value of a key whose lease has not ended, counting the lookup (and the hit,
+ * if any).
+ * 
+ * param:  The cache
+ * param:  The key
+ * param:  The current time (monotonic milliseconds)
+ * param:  Set to the value, if found
+ * param:  Set to the node that owned the key when the copy was taken, if found
+ * return: The length of the value, or -1 if it is not in the cache
+ **************************************************************************************************/
+int value_cache_find( value_cache_t *cache, int key, double now_ms, const char **value,
+                      int *owner_id )
+{
+    // Local variables
+    int length = -1;              // The length of the value
+    value_cache_entry_t *entry;   // An entry of the cache
+
+    cache->lookups++;
+
+    for( int index = 0; index < VALUE_CACHE_SIZE; index++ )
+    {
+        entry = &cache->entries[index];
+
+        if( ( entry->key == key ) && ( now_ms >= entry->expires_ms ) )
+        {
+            // The lease has ended, so the value is fetched again
+            entry->key = -1;
+        }
+        else if( entry->key == key )
+        {
+            length = entry->length;
+            *value = entry->value;
+            *owner_id = entry->owner_id;
+            entry->last_used = ++cache->clock;
+            cache->hits++;
+        }
+    }
+
+    return( length );
+}
+
+
+/***************************************************************************************************
+ * Function: value_cache_version
+ * 
+ * Get the version a copy of the value of a key is to be asked for at, along with a read of it.
+ * 
+ * param:  The cache
+ * param:  The key
+ * return: The version of the key plus one (never zero, which asks for no copy)
+ **************************************************************************************************/
+uint32_t value_cache_version( const value_cache_t *cache, int key )
+{
+    return( cache->versions[key] + 1 );
+}
+
+
+/***************************************************************************************************
+ * Function: value_cache_store
+ * 
+ * Keep a copy of the value of a key, if it was asked for at the current version of the key, in
+ * place of any copy already kept or else the entry used least recently.
+ * 
+ * param:  The cache
+ * param:  The key
+ * param:  The version the copy was asked for at, plus one (see value_cache_version)
+ * param:  The node that owns the key
+ * param:  The value
+ * param:  The length of the value, in bytes
+ * param:  The current time (monotonic milliseconds)
+ * return: void
+ **************************************************************************************************/
+void value_cache_store( value_cache_t *cache, int key, uint32_t version, int owner_id,
+                        const char *value, int length, double now_ms )
+{
+    // Local variables
+    int victim = 0;               // The entry to replace
+
+    if( ( key >= 0 ) && ( key < MAX_KEY_VALUE ) && ( version == cache->versions[key] + 1 ) &&
+        ( length >= 0 ) && ( length <= MAX_VALUE_SIZE ) )
+    {
+        for( int index = 0; index < VALUE_CACHE_SIZE; index++ )
+        {
+            if( ( cache->entries[victim].key != key ) &&
+                ( ( cache->entries[index].key == key ) || ( cache->entries[index].key < 0 ) ||
+                  ( ( cache->entries[victim].key >= 0 ) &&
+                    ( cache->entries[index].last_used < cache->entries[victim].last_used ) ) ) )
+            {
+                victim = index;
+            }
+        }
+
+        cache->entries[victim].key = key;
+        cache->entries[victim].owner_id = owner_id;
+        cache->entries[victim].length = length;
+        cache->entries[victim].expires_ms = now_ms + VALUE_CACHE_LEASE_MS;
+        cache->entries[victim].last_used = ++cache->clock;
+        memcpy( cache->entries[victim].value, value, length );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: value_cache_invalidate
+ * 
+ * Move a set of keys on to a new version, as they are about to change, dropping any copies of
+ * their values.
+ * 
+ * param:  The cache
+ * param:  The keys, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void value_cache_invalidate( value_cache_t *cache, uint64_t keys )
+{
+    for( int key = 0; key < MAX_KEY_VALUE; key++ )
+    {
+        if( ( keys & ( 1UL << key ) ) != 0 )
+        {
+            cache->versions[key]++;
+        }
+    }
+
+    for( int index = 0; index < VALUE_CACHE_SIZE; index++ )
+    {
+        if( ( cache->entries[index].key >= 0 ) &&
+            ( ( keys & ( 1UL << cache->entries[index].key ) ) != 0 ) )
+        {
+            cache->entries[index].key = -1;
+        }
+    }
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
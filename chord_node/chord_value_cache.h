@@ -0,0 +1,154 @@
+//**************************************************************************************************
+// File:   chord_value_cache.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// A small read-through cache of the values of hot keys, kept by the main node (where every request
+// enters the ring) so that it can answer repeated "get" requests for them itself, rather than have
+// each one routed to the same owner. The main node asks for a copy of the value with every "get"
+// it passes on, and the owner sends one along with the answer if the key is among the hot keys it
+// tracks (see chord_hot_keys.h), having been read at least VALUE_CACHE_HOT_READS times lately.
+// 
+// Every change to a key enters the ring at the main node too, and moves the key on to a new
+// version, dropping any copy of its value. A copy is taken only if it was asked for at the current
+// version, so a copy fetched before a change cannot replace one made after it. A change the main
+// node does not see (e.g. a value lost with a failed node) is covered by a lease: a copy is used
+// for a limited time, and then fetched again.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_VALUE_CACHE_H
+#define CHORD_VALUE_CACHE_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdint.h>
+#include "chord_config.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The number of values a cache holds
+#define VALUE_CACHE_SIZE                8
+
+// The time a copy of a value is used for, in milliseconds
+#define VALUE_CACHE_LEASE_MS            2000
+
+// The recent reads of a key (in its owner's hot keys) after which its value is cached
+#define VALUE_CACHE_HOT_READS           2
+
+// A copy of the value of a key
+typedef struct
+{
+    int key;                         // The key (-1 if the entry is unused)
+    int owner_id;                    // The node that owned the key when the copy was taken
+    int length;                      // The length of the value, in bytes
+    double expires_ms;               // When the lease on the copy ends (monotonic milliseconds)
+    uint32_t last_used;              // When the entry was last used (by the cache's clock)
+    char value[MAX_VALUE_SIZE];      // The value
+} value_cache_entry_t;
+
+// A cache of the values of hot keys
+typedef struct
+{
+    value_cache_entry_t entries[VALUE_CACHE_SIZE];   // The cached values
+    uint32_t versions[MAX_KEY_VALUE];                // The version of each key (its changes)
+    uint32_t clock;                  // Counts the uses of the cache, to order the entries by
+    uint64_t lookups;                // The number of keys looked up
+    uint64_t hits;                   // The number of keys whose value was found
+} value_cache_t;
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: value_cache_init
+ * 
+ * Empty a cache, and clear its counters.
+ * 
+ * param:  The cache
+ * return: void
+ **************************************************************************************************/
+void value_cache_init( value_cache_t *cache );
+
+
+/***************************************************************************************************
+ * Function: value_cache_find
+ * 
+ * Find a copy of the value of a key whose lease has not ended, counting the lookup (and the hit,
+ * if any).
+ * 
+ * param:  The cache
+ * param:  The key
+ * param:  The current time (monotonic milliseconds)
+ * param:  Set to the value, if found
+ * param:  Set to the node that owned the key when the copy was taken, if found
+ * return: The length of the value, or -1 if it is not in the cache
+ **************************************************************************************************/
+int value_cache_find( value_cache_t *cache, int key, double now_ms, const char **value,
+                      int *owner_id );
+
+
+/***************************************************************************************************
+ * Function: value_cache_version
+ * 
+ * Get the version a copy of the value of a key is to be asked for at, along with a read of it.
+ * 
+ * param:  The cache
+ * param:  The key
+ * return: The version of the key plus one (never zero, which asks for no copy)
+ **************************************************************************************************/
+uint32_t value_cache_version( const value_cache_t *cache, int key );
+
+
+/***************************************************************************************************
+ * Function: value_cache_store
+ * 
+ * Keep a copy of the value of a key, if it was asked for at the current version of the key, in
+ * place of any copy already kept or else the entry used least recently.
+ * 
+ * param:  The cache
+ * param:  The key
+ * param:  The version the copy was asked for at, plus one (see value_cache_version)
+ * param:  The node that owns the key
+ * param:  The value
+ * param:  The length of the value, in bytes
+ * param:  The current time (monotonic milliseconds)
+ * return: void
+ **************************************************************************************************/
+void value_cache_store( value_cache_t *cache, int key, uint32_t version, int owner_id,
+                        const char *value, int length, double now_ms );
+
+
+/***************************************************************************************************
+ * Function: value_cache_invalidate
+ * 
+ * Move a set of keys on to a new version, as they are about to change, dropping any copies of
+ * their values.
+ * 
+ * param:  The cache
+ * param:  The keys, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void value_cache_invalidate( value_cache_t *cache, uint64_t keys );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
@@ -0,0 +1,1137 @@
+//**************************************************************************************************
+// File:   chord_value_store.c
+// Author: agent
+// Date:   10/19/2026
+// 
+// Holds the values a node stores under its keys, as records in a log of memory-mapped segment
+// files found through an open-addressing index (see chord_value_store.h).
+// 
+//**************************************************************************************************
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+// vmsplice() is a Linux extension
+#define _GNU_SOURCE
+
+#include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <poll.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/uio.h>
+#include <time.h>
+#include <unistd.h>
+#include "chord_config.h"
+#include "chord_shared_store.h"
+#include "chord_value_store.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The number of times store_bench moves every record, unless told otherwise
+#define STORE_BENCH_ROUNDS              2000
+
+// The capacity of the pipe store_bench moves records through, in bytes (as that of a bulk pipe)
+#define STORE_BENCH_PIPE_SIZE           1048576
+
+// Local prototypes
+static int store_record_size( int length );
+static store_record_t *store_record( const value_store_t *store, int location );
+static int store_find( const value_store_t *store, int key );
+static void store_index( value_store_t *store, int location );
+static void store_index_run( value_store_t *store, int length );
+static double store_now_ns();
+static bool store_reserve( value_store_t *store, int bytes, bool compacting );
+static int store_free_segments( const value_store_t *store );
+static int store_open_segment( value_store_t *store );
+static void store_drop_segment( value_store_t *store, int segment );
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// The shared store, if values are kept in it (NULL otherwise)
+static chord_shared_store_t *shared_store = NULL;
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: store_init
+ * 
+ * Empty a store. Segments mapped by another process (inherited by fork from the node that created
+ * this one) are unmapped, as nothing in this process uses them; the segment files go once no
+ * process maps them any more. Segments mapped by this process are not dropped (e.g. those 
+ * inherited from the node a virtual node was created by, which still uses them).
+ * 
+ * param:  The store (as left by another store function, or all zeroes)
+ * return: void
+ **************************************************************************************************/
+void store_init( value_store_t *store )
+{
+    if( store->process_id != getpid() )
+    {
+        for( int segment = 0; segment < STORE_MAX_SEGMENTS; segment++ )
+        {
+            store_drop_segment( store, segment );
+        }
+    }
+
+    memset( store, 0, sizeof( *store ) );
+}
+
+
+/***************************************************************************************************
+ * Function: store_free
+ * 
+ * Empty a store, dropping its segments. The segment files are removed when created, so they go
+ * once no process maps them any more.
+ * 
+ * param:  The store
+ * return: void
+ **************************************************************************************************/
+void store_free( value_store_t *store )
+{
+    for( int segment = 0; segment < STORE_MAX_SEGMENTS; segment++ )
+    {
+        store_drop_segment( store, segment );
+    }
+
+    store_init( store );
+}
+
+
+/***************************************************************************************************
+ * Function: store_put
+ * 
+ * Store a value under a key, replacing any value stored under it before. The new record is
+ * appended to the head of the log; the old one is left behind until its segment is compacted. In
+ * the shared store, the value is written over the old one.
+ * 
+ * param:  The store
+ * param:  The key
+ * param:  The value
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * return: True if the value was stored; false if it is too long, or no segment could be created
+ **************************************************************************************************/
+bool store_put( value_store_t *store, int key, const char *value, int length )
+{
+    // Local variables
+    store_segment_t *head;        // The head of the log
+    store_record_t *record;       // The new record
+    bool stored = false;          // Flag: "the value was stored"
+
+    // A value in the shared store is overwritten in place, by the owner of its key alone
+    if( ( shared_store != NULL ) && ( key >= 0 ) && ( key < MAX_KEY_VALUE ) && ( length >= 0 ) && 
+        ( length <= MAX_VALUE_SIZE ) )
+    {
+        memcpy( shared_store->values[key].value, value, length );
+        shared_store->values[key].length = length;
+        shared_store->values[key].present = true;
+
+        store->stats.value_bytes_written += length;
+        store->stats.segment_bytes_written += length;
+        stored = true;
+    }
+    else if( ( shared_store == NULL ) && ( key >= 0 ) && ( key < MAX_KEY_VALUE ) && 
+             ( length >= 0 ) && ( length <= MAX_VALUE_SIZE ) &&
+             ( store_reserve( store, store_record_size( length ), false ) == true ) )
+    {
+        head = &store->segments[store->head];
+        record = (store_record_t *)( head->base + head->used );
+        record->key = key;
+        record->length = length;
+        memcpy( record + 1, value, length );
+
+        store_index( store, store->head * STORE_SEGMENT_SIZE + head->used );
+        head->used += store_record_size( length );
+
+        store->stats.value_bytes_written += store_record_size( length );
+        store->stats.segment_bytes_written += store_record_size( length );
+        stored = true;
+    }
+
+    return( stored );
+}
+
+
+/***************************************************************************************************
+ * Function: store_get
+ * 
+ * Find the value stored under a key. The value stays valid until the store is next changed.
+ * 
+ * param:  The store
+ * param:  The key
+ * param:  Holds the value, if there is one
+ * return: The length of the value, in bytes, or -1 if there is no value stored under the key
+ **************************************************************************************************/
+int store_get( value_store_t *store, int key, const char **value )
+{
+    // Local variables
+    const store_record_t *record;     // The key's record
+    int slot;                         // The key's slot in the index
+    int length = -1;                  // The length of the value
+
+    slot = ( shared_store == NULL ) ? store_find( store, key ) : -1;
+
+    if( ( shared_store != NULL ) && ( key >= 0 ) && ( key < MAX_KEY_VALUE ) &&
+        ( shared_store->values[key].present == true ) )
+    {
+        *value = shared_store->values[key].value;
+        length = shared_store->values[key].length;
+
+        store->stats.value_bytes_read += length;
+        store->stats.segment_bytes_read += length;
+    }
+    else if( slot >= 0 )
+    {
+        record = store_record( store, store->index[slot] - 1 );
+        *value = (const char *)( record + 1 );
+        length = record->length;
+
+        store->stats.value_bytes_read += store_record_size( length );
+        store->stats.segment_bytes_read += store_record_size( length );
+    }
+
+    return( length );
+}
+
+
+/***************************************************************************************************
+ * Function: store_delete
+ * 
+ * Delete the values stored under a set of keys (if any). Their records are left behind until
+ * their segments are compacted.
+ * 
+ * param:  The store
+ * param:  The keys, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void store_delete( value_store_t *store, uint64_t keys )
+{
+    // Local variables
+    int slot;                         // A key's slot in the index
+    int location;                     // The location of its record
+
+    for( int key = 0; ( key < MAX_KEY_VALUE ) && ( keys != 0 ); key++ )
+    {
+        if( ( shared_store != NULL ) && ( keys & ( 1UL << key ) ) )
+        {
+            shared_store->values[key].present = false;
+        }
+
+        slot = ( keys & ( 1UL << key ) ) ? store_find( store, key ) : -1;
+
+        if( slot >= 0 )
+        {
+            location = store->index[slot] - 1;
+            store->segments[location / STORE_SEGMENT_SIZE].live_bytes -=
+                store_record_size( store_record( store, location )->length );
+            store->index[slot] = -1;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: store_pack
+ * 
+ * Copy the records of a set of keys, in ascending order of key, into a run of records, as far as
+ * they fit. The keys whose records were copied (and those with no value) are taken out of the set,
+ * so that the rest can be packed into further runs.
+ * 
+ * param:  The store
+ * param:  The keys to pack, as a bitmap; holds the keys left to pack
+ * param:  Holds the run
+ * param:  The size of the run buffer, in bytes
+ * return: The length of the run, in bytes
+ **************************************************************************************************/
+int store_pack( value_store_t *store, uint64_t *keys, char *run, int size )
+{
+    // Local variables
+    const store_record_t *record;     // A key's record
+    int record_size;                  // The size of the record
+    int slot;                         // A key's slot in the index
+    int length = 0;                   // The length of the run
+    bool full = false;                // Flag: "the next record does not fit"
+
+    for( int key = 0; ( key < MAX_KEY_VALUE ) && ( full == false ); key++ )
+    {
+        if( *keys & ( 1UL << key ) )
+        {
+            slot = store_find( store, key );
+            record = ( slot >= 0 ) ? store_record( store, store->index[slot] - 1 ) : NULL;
+            record_size = ( record != NULL ) ? store_record_size( record->length ) : 0;
+
+            if( length + record_size > size )
+            {
+                full = true;
+            }
+            else
+            {
+                if( record != NULL )
+                {
+                    memcpy( run + length, record, record_size );
+                    length += record_size;
+                }
+
+                *keys &= ~( 1UL << key );
+            }
+        }
+    }
+
+    store->stats.value_bytes_read += length;
+    store->stats.segment_bytes_read += length;
+
+    return( length );
+}
+
+
+/***************************************************************************************************
+ * Function: store_unpack
+ * 
+ * Append a run of records made by store_pack to a store, in one piece, and index its records. A
+ * record that runs past the end of the run is ignored.
+ * 
+ * param:  The store
+ * param:  The run
+ * param:  The length of the run, in bytes (at most STORE_SEGMENT_SIZE)
+ * return: True if the run was stored; false if no segment could be created
+ **************************************************************************************************/
+bool store_unpack( value_store_t *store, const char *run, int length )
+{
+    // Local variables
+    store_segment_t *head;            // The head of the log
+    bool stored = false;              // Flag: "the run was stored"
+
+    if( ( length >= 0 ) && ( length <= STORE_SEGMENT_SIZE ) &&
+        ( store_reserve( store, length, false ) == true ) )
+    {
+        head = &store->segments[store->head];
+        memcpy( head->base + head->used, run, length );
+        store_index_run( store, length );
+        stored = true;
+    }
+
+    return( stored );
+}
+
+
+/***************************************************************************************************
+ * Function: store_send
+ * 
+ * Send the records of a set of keys, in ascending order of key, through a pipe as far as 
+ * STORE_SEND_SIZE and STORE_SEND_SPANS allow: a message header, then the records, spliced from
+ * the segments into the pipe rather than copied. Records that lie next to each other in a segment
+ * are spliced as one piece. The header is written rather than spliced, as it does not outlive the
+ * call (a spliced page is read by the receiving process later, as it is then). On a non-blocking
+ * pipe, a transfer is only started if the pipe has room for its header (which, being smaller than
+ * PIPE_BUF, is written whole or not at all); once started, it waits for the reader to make room
+ * for the records, as they must follow the header.
+ * 
+ * param:  The store
+ * param:  The keys to send, as a bitmap; holds the keys left to send
+ * param:  The message header; its length and data are set to those of the records sent
+ * param:  The pipe handle to write to
+ * return: True if the header and records were written in full (if the pipe had no room for the
+ *         header, nothing was written and the keys are left as they were)
+ **************************************************************************************************/
+bool store_send( value_store_t *store, uint64_t *keys, chord_msg_t *header, int handle )
+{
+    // Local variables
+    struct iovec spans[STORE_SEND_SPANS];    // The pieces of segments the records lie in
+    int span_count = 0;               // The number of pieces
+    int first = 0;                    // The first piece not yet written in full
+    const store_record_t *record;     // A key's record
+    int record_size;                  // The size of the record
+    int slot;                         // A key's slot in the index
+    int length = 0;                   // The length of the records
+    bool full = false;                // Flag: "the next record does not fit"
+    ssize_t written;                  // The bytes written by a splice
+    double start_ns;                  // When the transfer started
+    bool sent;                        // Flag: "the header and records were written in full"
+    uint64_t keys_given = *keys;      // The keys to send, as given
+    struct pollfd pipe_poll;          // Used to wait for room in the pipe
+
+    header->data = 0;
+
+    for( int key = 0; ( key < MAX_KEY_VALUE ) && ( full == false ); key++ )
+    {
+        if( *keys & ( 1UL << key ) )
+        {
+            slot = store_find( store, key );
+            record = ( slot >= 0 ) ? store_record( store, store->index[slot] - 1 ) : NULL;
+            record_size = ( record != NULL ) ? store_record_size( record->length ) : 0;
+
+            // A record that follows the last piece extends it; any other starts a piece of its own
+            if( ( record != NULL ) && ( span_count > 0 ) && 
+                ( (const char *)spans[span_count - 1].iov_base + spans[span_count - 1].iov_len ==
+                  (const char *)record ) && ( length + record_size <= STORE_SEND_SIZE ) )
+            {
+                spans[span_count - 1].iov_len += record_size;
+                length += record_size;
+            }
+            else if( ( record != NULL ) && 
+                     ( ( span_count == STORE_SEND_SPANS ) || 
+                       ( length + record_size > STORE_SEND_SIZE ) ) )
+            {
+                full = true;
+            }
+            else if( record != NULL )
+            {
+                spans[span_count].iov_base = (void *)record;
+                spans[span_count++].iov_len = record_size;
+                length += record_size;
+            }
+
+            if( full == false )
+            {
+                *keys &= ~( 1UL << key );
+                header->data |= 1UL << key;
+            }
+        }
+    }
+
+    header->length = length;
+
+    start_ns = store_now_ns();
+    sent = ( write( handle, (const void *)header, sizeof( *header ) ) == sizeof( *header ) );
+
+    if( sent == false )
+    {
+        *keys = keys_given;
+        length = 0;
+    }
+
+    pipe_poll.fd = handle;
+    pipe_poll.events = POLLOUT;
+
+    // The pipe may take the pieces in several goes, if the receiving node is behind
+    while( ( sent == true ) && ( first < span_count ) )
+    {
+        written = vmsplice( handle, &spans[first], span_count - first, SPLICE_F_NONBLOCK );
+
+        if( ( written < 0 ) && ( errno == EAGAIN ) )
+        {
+            written = 0;
+            poll( &pipe_poll, 1, -1 );
+        }
+
+        sent = ( written >= 0 );
+
+        while( ( sent == true ) && ( first < span_count ) && 
+               ( written >= (ssize_t)spans[first].iov_len ) )
+        {
+            written -= spans[first++].iov_len;
+        }
+
+        if( ( sent == true ) && ( first < span_count ) )
+        {
+            spans[first].iov_base = (char *)spans[first].iov_base + written;
+            spans[first].iov_len -= written;
+        }
+    }
+
+    store->stats.value_bytes_read += length;
+    store->stats.segment_bytes_read += length;
+    store->stats.transfer_ns += (uint64_t)( store_now_ns() - start_ns );
+
+    return( sent );
+}
+
+
+/***************************************************************************************************
+ * Function: store_receive
+ * 
+ * Read a run of records sent by store_send from a pipe straight into the head of a store, and
+ * index its records. The records are copied once, from the pages spliced into the pipe to the
+ * segment; a run that cannot be read in full is left out of the index, to be overwritten.
+ * 
+ * param:  The store
+ * param:  The pipe handle to read from (the message header has been read already)
+ * param:  The length of the run, in bytes (at most STORE_SEGMENT_SIZE)
+ * return: True if the run was stored; false if it could not be read in full, or no segment could
+ *         be created
+ **************************************************************************************************/
+bool store_receive( value_store_t *store, int handle, int length )
+{
+    // Local variables
+    store_segment_t *head;            // The head of the log
+    int received = 0;                 // The bytes of the run read so far
+    ssize_t count = 1;                // The bytes read by a read
+    double start_ns;                  // When the transfer started
+    bool stored = false;              // Flag: "the run was stored"
+
+    if( ( length >= 0 ) && ( length <= STORE_SEGMENT_SIZE ) &&
+        ( store_reserve( store, length, false ) == true ) )
+    {
+        head = &store->segments[store->head];
+        start_ns = store_now_ns();
+
+        while( ( received < length ) && ( count > 0 ) )
+        {
+            count = read( handle, head->base + head->used + received, length - received );
+            received += ( count > 0 ) ? count : 0;
+        }
+
+        if( received == length )
+        {
+            store_index_run( store, length );
+            store->stats.transfer_bytes += length;
+            store->stats.transfer_ns += (uint64_t)( store_now_ns() - start_ns );
+            stored = true;
+        }
+    }
+
+    return( stored );
+}
+
+
+/***************************************************************************************************
+ * Function: store_compact
+ * 
+ * Take one step of compaction: go through up to STORE_COMPACT_STEP bytes of the segment being
+ * compacted, copying its live records to the head of the log. If no segment is being compacted,
+ * the sealed segment (one other than the head) with the smallest share of live records is chosen,
+ * if less than STORE_COMPACT_THRESHOLD percent of it is live. A segment that has been gone through
+ * is dropped.
+ * 
+ * param:  The store
+ * return: True if there is more compaction to do
+ **************************************************************************************************/
+bool store_compact( value_store_t *store )
+{
+    // Local variables
+    store_segment_t *victim;          // The segment being compacted
+    store_segment_t *head;            // The head of the log
+    const store_record_t *record;     // A record of the segment being compacted
+    int record_size;                  // The size of the record
+    int location;                     // The location of the record
+    int slot;                         // The slot of the record's key in the index
+    int chosen = -1;                  // The segment chosen for compaction
+    int budget = STORE_COMPACT_STEP;  // The bytes left to go through in this step
+
+    // Choose the segment to compact, if need be
+    for( int segment = 0; ( segment < STORE_MAX_SEGMENTS ) && ( store->compacting == false );
+         segment++ )
+    {
+        victim = &store->segments[segment];
+
+        if( ( victim->base != NULL ) && ( segment != store->head ) &&
+            ( victim->live_bytes * 100 < victim->used * STORE_COMPACT_THRESHOLD ) &&
+            ( ( chosen < 0 ) || ( (int64_t)victim->live_bytes * store->segments[chosen].used <
+                                  (int64_t)store->segments[chosen].live_bytes * victim->used ) ) )
+        {
+            chosen = segment;
+        }
+    }
+
+    if( chosen >= 0 )
+    {
+        store->compacting = true;
+        store->compact_segment = chosen;
+        store->compact_offset = 0;
+    }
+
+    while( ( store->compacting == true ) && ( budget > 0 ) )
+    {
+        victim = &store->segments[store->compact_segment];
+
+        if( store->compact_offset >= victim->used )
+        {
+            // Every live record has been copied, so the segment can go
+            store_drop_segment( store, store->compact_segment );
+            store->compacting = false;
+        }
+        else
+        {
+            location = store->compact_segment * STORE_SEGMENT_SIZE + store->compact_offset;
+            record = store_record( store, location );
+            record_size = store_record_size( record->length );
+            slot = store_find( store, record->key );
+
+            // A record is live if the index still points at it
+            if( ( slot >= 0 ) && ( store->index[slot] == location + 1 ) )
+            {
+                if( store_reserve( store, record_size, true ) == false )
+                {
+                    // There is no room to copy the record to; try again later
+                    store->compacting = false;
+                    budget = 0;
+                }
+                else
+                {
+                    head = &store->segments[store->head];
+                    memcpy( head->base + head->used, record, record_size );
+                    store_index( store, store->head * STORE_SEGMENT_SIZE + head->used );
+                    head->used += record_size;
+
+                    store->stats.segment_bytes_written += record_size;
+                }
+            }
+
+            if( store->compacting == true )
+            {
+                store->compact_offset += record_size;
+                store->stats.segment_bytes_read += record_size;
+                budget -= record_size;
+            }
+        }
+    }
+
+    return( store->compacting );
+}
+
+
+/***************************************************************************************************
+ * Function: store_attach_shared
+ * 
+ * Keep the values of every node of this process (and of the processes it creates) in the shared 
+ * store, rather than in segments of their own. The store is mapped once, before any node process
+ * is created, so that every node inherits the mapping.
+ * 
+ * param:  The file descriptor of the shared store
+ * return: True if the shared store is in use
+ **************************************************************************************************/
+bool store_attach_shared( int handle )
+{
+    // Local variables
+    void *region;                 // The shared store, as mapped
+
+    region = mmap( NULL, SHARED_STORE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, handle, 0 );
+
+    if( region != MAP_FAILED )
+    {
+        shared_store = (chord_shared_store_t *)region;
+    }
+
+    return( shared_store != NULL );
+}
+
+
+/***************************************************************************************************
+ * Function: store_is_shared
+ * 
+ * Tell whether values are kept in the shared store.
+ * 
+ * param:  void
+ * return: True if values are kept in the shared store
+ **************************************************************************************************/
+bool store_is_shared()
+{
+    return( shared_store != NULL );
+}
+
+
+/***************************************************************************************************
+ * Function: store_set_owner
+ * 
+ * Publish a node's key set in the shared store, as a node in the ring (no effect if values are not
+ * kept in the shared store). Nodes in different processes join and leave at once, so the bitmap of
+ * nodes is updated atomically.
+ * 
+ * param:  The ID of the node
+ * param:  Its key set, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void store_set_owner( int node_id, uint64_t keys )
+{
+    if( ( shared_store != NULL ) && ( node_id >= 0 ) && ( node_id < MAX_NODE_COUNT ) )
+    {
+        __atomic_store_n( &shared_store->key_sets[node_id], keys, __ATOMIC_RELEASE );
+        __atomic_fetch_or( &shared_store->nodes, 1UL << node_id, __ATOMIC_RELEASE );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: store_drop_owner
+ * 
+ * Remove a node that has left the ring (or failed) from the shared store (no effect if values are
+ * not kept in the shared store).
+ * 
+ * param:  The ID of the node
+ * return: void
+ **************************************************************************************************/
+void store_drop_owner( int node_id )
+{
+    if( ( shared_store != NULL ) && ( node_id >= 0 ) && ( node_id < MAX_NODE_COUNT ) )
+    {
+        __atomic_fetch_and( &shared_store->nodes, ~( 1UL << node_id ), __ATOMIC_RELEASE );
+        __atomic_store_n( &shared_store->key_sets[node_id], 0, __ATOMIC_RELEASE );
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: store_get_stats
+ * 
+ * Get the bytes a store has written and read so far, with the bytes of its live records and of
+ * its segments.
+ * 
+ * param:  The store
+ * param:  Holds the counters
+ * return: void
+ **************************************************************************************************/
+void store_get_stats( const value_store_t *store, chord_store_stats_t *stats )
+{
+    *stats = store->stats;
+    stats->live_bytes = 0;
+    stats->segment_bytes = 0;
+
+    for( int segment = 0; segment < STORE_MAX_SEGMENTS; segment++ )
+    {
+        if( store->segments[segment].base != NULL )
+        {
+            stats->live_bytes += store->segments[segment].live_bytes;
+            stats->segment_bytes += STORE_SEGMENT_SIZE;
+        }
+    }
+}
+
+
+/***************************************************************************************************
+ * Function: store_bench
+ * 
+ * Measure how fast records move between two stores: in bulk, spliced into a pipe by store_send
+ * and read from it by store_receive, and in VALUES messages, packed by store_pack and unpacked by
+ * store_unpack (as where values cannot be moved in bulk). Each round moves the records of every
+ * key, each with a value of MAX_VALUE_SIZE bytes, both ways; the records moved are then deleted
+ * and compacted away, outside the time measured. The rates are printed to the standard output.
+ * 
+ * param:  The number of command line options
+ * param:  The command line options (following "--bench-bulk": the number of rounds, if given)
+ * return: The program exit status
+ **************************************************************************************************/
+int store_bench( int argc, char **argv )
+{
+    // Local variables
+    value_store_t source;             // The store the records are moved from
+    value_store_t target;             // The store the records are moved to
+    chord_payload_msg_t msg;          // A VALUES message (or its header), with its records
+    char value[MAX_VALUE_SIZE];       // The value stored under every key
+    int handles[2];                   // The pipe the records are moved through
+    int rounds;                       // The number of times every record is moved each way
+    int size;                         // The size of a message, with its records
+    uint64_t keys;                    // The keys left to move in a round
+    uint64_t bytes[2] = { 0, 0 };     // The bytes of records moved in bulk, and in messages
+    double elapsed_ns[2] = { 0.0, 0.0 };    // The time spent moving them
+    double start_ns;                  // When a round started
+    bool moved = true;                // Flag: "every record was moved"
+
+    rounds = ( argc > 0 ) ? atoi( argv[0] ) : STORE_BENCH_ROUNDS;
+    memset( &source, 0, sizeof( source ) );
+    memset( &target, 0, sizeof( target ) );
+    memset( value, 'v', sizeof( value ) );
+    memset( &msg, 0, sizeof( msg ) );
+    msg.msg.cmd = VALUES;
+
+    for( int key = 0; ( key < MAX_KEY_VALUE ) && ( moved == true ); key++ )
+    {
+        moved = store_put( &source, key, value, MAX_VALUE_SIZE );
+    }
+
+    if( ( pipe( handles ) != 0 ) ||
+        ( fcntl( handles[1], F_SETPIPE_SZ, STORE_BENCH_PIPE_SIZE ) < STORE_BENCH_PIPE_SIZE ) )
+    {
+        printf( "Unable to create a pipe of %i bytes\n", STORE_BENCH_PIPE_SIZE );
+        moved = false;
+    }
+
+    for( int round = 0; ( round < rounds ) && ( moved == true ); round++ )
+    {
+        for( int bulk = 1; ( bulk >= 0 ) && ( moved == true ); bulk-- )
+        {
+            keys = UINT64_MAX;
+            start_ns = store_now_ns();
+
+            while( ( keys != 0 ) && ( moved == true ) )
+            {
+                if( bulk == 1 )
+                {
+                    moved = ( store_send( &source, &keys, &msg.msg, handles[1] ) == true ) &&
+                            ( read( handles[0], &msg.msg, sizeof( msg.msg ) ) == 
+                              sizeof( msg.msg ) ) &&
+                            ( store_receive( &target, handles[0], msg.msg.length ) == true );
+                }
+                else
+                {
+                    msg.msg.length = store_pack( &source, &keys, msg.payload, MAX_PAYLOAD_SIZE );
+                    size = sizeof( msg.msg ) + msg.msg.length;
+                    moved = ( write( handles[1], &msg, size ) == size ) &&
+                            ( read( handles[0], &msg, size ) == size ) &&
+                            ( store_unpack( &target, msg.payload, msg.msg.length ) == true );
+                }
+
+                bytes[bulk] += msg.msg.length;
+            }
+
+            elapsed_ns[bulk] += store_now_ns() - start_ns;
+
+            // Drop the records moved, so that the target store does not run out of segments
+            store_delete( &target, UINT64_MAX );
+
+            while( store_compact( &target ) == true )
+            {
+            }
+        }
+    }
+
+    if( moved == true )
+    {
+        printf( "Moved the records of %i keys (values of %i bytes) %i times each way:\n",
+                MAX_KEY_VALUE, MAX_VALUE_SIZE, rounds );
+        printf( "  In bulk (spliced):    %10.1f MB in %9.3f ms, %7.3f GB/s\n", bytes[1] / 1.0e6,
+                elapsed_ns[1] / 1.0e6, ( elapsed_ns[1] > 0.0 ) ? bytes[1] / elapsed_ns[1] : 0.0 );
+        printf( "  In messages (copied): %10.1f MB in %9.3f ms, %7.3f GB/s\n", bytes[0] / 1.0e6,
+                elapsed_ns[0] / 1.0e6, ( elapsed_ns[0] > 0.0 ) ? bytes[0] / elapsed_ns[0] : 0.0 );
+    }
+    else
+    {
+        printf( "Unable to move the records\n" );
+    }
+
+    store_free( &source );
+    store_free( &target );
+
+    return( ( moved == true ) ? EXIT_SUCCESS : EXIT_FAILURE );
+}
+
+
+/***************************************************************************************************
+ * Function: store_record_size
+ * 
+ * Get the size of the record of a value, including its header and padding.
+ * 
+ * param:  The length of the value, in bytes
+ * return: The size of the record, in bytes
+ **************************************************************************************************/
+static int store_record_size( int length )
+{
+    return( ( (int)sizeof( store_record_t ) + length + 3 ) & ~3 );
+}
+
+
+/***************************************************************************************************
+ * Function: store_record
+ * 
+ * Get the record at a location in the log.
+ * 
+ * param:  The store
+ * param:  The location of the record (its segment times STORE_SEGMENT_SIZE, plus its offset)
+ * return: The record
+ **************************************************************************************************/
+static store_record_t *store_record( const value_store_t *store, int location )
+{
+    return( (store_record_t *)( store->segments[location / STORE_SEGMENT_SIZE].base +
+                                location % STORE_SEGMENT_SIZE ) );
+}
+
+
+/***************************************************************************************************
+ * Function: store_find
+ * 
+ * Find the slot of a key in the index. Slots are probed in turn from the one the key hashes to,
+ * passing over those of deleted keys, until the key or an unused slot is found.
+ * 
+ * param:  The store
+ * param:  The key
+ * return: The slot, or -1 if there is no value stored under the key
+ **************************************************************************************************/
+static int store_find( const value_store_t *store, int key )
+{
+    // Local variables
+    int slot;                         // The slot being probed
+    int found = -1;                   // The key's slot
+
+    slot = ( ( (uint32_t)key * 2654435761u ) >> 16 ) % STORE_INDEX_SIZE;
+
+    for( int probe = 0; ( probe < STORE_INDEX_SIZE ) && ( found < 0 ) &&
+                        ( store->index[slot] != 0 ); probe++ )
+    {
+        if( ( store->index[slot] > 0 ) &&
+            ( store_record( store, store->index[slot] - 1 )->key == key ) )
+        {
+            found = slot;
+        }
+
+        slot = ( slot + 1 ) % STORE_INDEX_SIZE;
+    }
+
+    return( found );
+}
+
+
+/***************************************************************************************************
+ * Function: store_index
+ * 
+ * Point the index at a record in the log, in place of any older record of the same key (which
+ * becomes garbage).
+ * 
+ * param:  The store
+ * param:  The location of the record
+ * return: void
+ **************************************************************************************************/
+static void store_index( value_store_t *store, int location )
+{
+    // Local variables
+    const store_record_t *record;     // The record
+    int old_location;                 // The location of the key's older record
+    int slot;                         // The slot for the record
+
+    record = store_record( store, location );
+    slot = store_find( store, record->key );
+
+    if( slot >= 0 )
+    {
+        old_location = store->index[slot] - 1;
+        store->segments[old_location / STORE_SEGMENT_SIZE].live_bytes -=
+            store_record_size( store_record( store, old_location )->length );
+    }
+    else
+    {
+        // Take the first slot that is unused, or was a deleted key's
+        slot = ( ( (uint32_t)record->key * 2654435761u ) >> 16 ) % STORE_INDEX_SIZE;
+
+        while( store->index[slot] > 0 )
+        {
+            slot = ( slot + 1 ) % STORE_INDEX_SIZE;
+        }
+    }
+
+    store->index[slot] = location + 1;
+    store->segments[location / STORE_SEGMENT_SIZE].live_bytes +=
+        store_record_size( record->length );
+}
+
+
+/***************************************************************************************************
+ * Function: store_index_run
+ * 
+ * Index the records of a run that has just been placed at the head of the log, and add the run to
+ * the head. A record that runs past the end of the run is ignored.
+ * 
+ * param:  The store
+ * param:  The length of the run, in bytes
+ * return: void
+ **************************************************************************************************/
+static void store_index_run( value_store_t *store, int length )
+{
+    // Local variables
+    store_segment_t *head;            // The head of the log
+    const store_record_t *record;     // A record of the run
+    int offset = 0;                   // The offset of the record in the run
+
+    head = &store->segments[store->head];
+
+    while( offset + (int)sizeof( store_record_t ) <= length )
+    {
+        record = (const store_record_t *)( head->base + head->used + offset );
+
+        if( ( offset + store_record_size( record->length ) <= length ) &&
+            ( record->key < MAX_KEY_VALUE ) )
+        {
+            store_index( store, store->head * STORE_SEGMENT_SIZE + head->used + offset );
+        }
+
+        offset += store_record_size( record->length );
+    }
+
+    head->used += length;
+
+    store->stats.value_bytes_written += length;
+    store->stats.segment_bytes_written += length;
+}
+
+
+/***************************************************************************************************
+ * Function: store_now_ns
+ * 
+ * Get the time, for timing transfers.
+ * 
+ * param:  void
+ * return: The time, in nanoseconds (on the monotonic clock)
+ **************************************************************************************************/
+static double store_now_ns()
+{
+    // Local variables
+    struct timespec now;          // The current time
+    
+    clock_gettime( CLOCK_MONOTONIC, &now );
+    
+    return( now.tv_sec * 1.0e9 + now.tv_nsec );
+}
+
+
+/***************************************************************************************************
+ * Function: store_reserve
+ * 
+ * Make room at the head of the log, starting a new segment if the head is full. Requests leave the
+ * last free segment to compaction, compacting first if it comes to that, so that compaction always
+ * has somewhere to copy live records to.
+ * 
+ * param:  The store
+ * param:  The number of bytes needed
+ * param:  True if the room is for compaction
+ * return: True if there is room; false if no segment could be created
+ **************************************************************************************************/
+static bool store_reserve( value_store_t *store, int bytes, bool compacting )
+{
+    // Local variables
+    int segment;                      // A new segment
+    bool reserved = true;             // Flag: "there is room"
+
+    while( ( compacting == false ) && ( store_free_segments( store ) < 2 ) &&
+           ( ( store->segments[store->head].base == NULL ) ||
+             ( store->segments[store->head].used + bytes > STORE_SEGMENT_SIZE ) ) &&
+           ( store_compact( store ) == true ) )
+    {
+        // Compact until two segments are free (or the head has room), or nothing is left to do
+    }
+
+    if( ( store->segments[store->head].base == NULL ) ||
+        ( store->segments[store->head].used + bytes > STORE_SEGMENT_SIZE ) )
+    {
+        segment = store_open_segment( store );
+
+        if( segment < 0 )
+        {
+            reserved = false;
+        }
+        else
+        {
+            store->head = segment;
+        }
+    }
+
+    return( reserved );
+}
+
+
+/***************************************************************************************************
+ * Function: store_free_segments
+ * 
+ * Count the free segment slots of a store.
+ * 
+ * param:  The store
+ * return: The number of free slots
+ **************************************************************************************************/
+static int store_free_segments( const value_store_t *store )
+{
+    // Local variables
+    int count = 0;                    // The number of free slots
+
+    for( int segment = 0; segment < STORE_MAX_SEGMENTS; segment++ )
+    {
+        count += ( store->segments[segment].base == NULL ) ? 1 : 0;
+    }
+
+    return( count );
+}
+
+
+/***************************************************************************************************
+ * Function: store_open_segment
+ * 
+ * Create a segment in a free slot: a file of STORE_SEGMENT_SIZE bytes in the directory named by
+ * STORE_DIR_ENV_VAR (or STORE_DEFAULT_DIR), mapped into memory. The file is removed at once, so it
+ * goes when the segment is dropped (or the process exits). If no file can be created, the segment
+ * is kept in memory instead.
+ * 
+ * param:  The store
+ * return: The slot of the segment, or -1 if there is no free slot or no memory
+ **************************************************************************************************/
+static int store_open_segment( value_store_t *store )
+{
+    // Local variables
+    char path[PATH_MAX];              // The path of the segment file
+    const char *directory;            // The directory it is created in
+    int handle;                       // The segment file
+    char *base = MAP_FAILED;          // The segment, as mapped
+    int segment = -1;                 // The slot of the segment
+
+    for( int index = 0; ( index < STORE_MAX_SEGMENTS ) && ( segment < 0 ); index++ )
+    {
+        segment = ( store->segments[index].base == NULL ) ? index : -1;
+    }
+
+    if( segment >= 0 )
+    {
+        directory = getenv( STORE_DIR_ENV_VAR );
+        snprintf( path, sizeof( path ), "%s/chord_segment_XXXXXX",
+                  ( directory != NULL ) ? directory : STORE_DEFAULT_DIR );
+        handle = mkstemp( path );
+
+        if( handle >= 0 )
+        {
+            unlink( path );
+
+            if( ftruncate( handle, STORE_SEGMENT_SIZE ) == 0 )
+            {
+                base = mmap( NULL, STORE_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, handle,
+                             0 );
+            }
+
+            close( handle );
+        }
+
+        if( base == MAP_FAILED )
+        {
+            base = mmap( NULL, STORE_SEGMENT_SIZE, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        }
+
+        if( base == MAP_FAILED )
+        {
+            segment = -1;
+        }
+        else
+        {
+            store->segments[segment].base = base;
+            store->segments[segment].used = 0;
+            store->segments[segment].live_bytes = 0;
+            store->process_id = getpid();
+        }
+    }
+
+    return( segment );
+}
+
+
+/***************************************************************************************************
+ * Function: store_drop_segment
+ * 
+ * Drop a segment, freeing its slot.
+ * 
+ * param:  The store
+ * param:  The slot of the segment
+ * return: void
+ **************************************************************************************************/
+static void store_drop_segment( value_store_t *store, int segment )
+{
+    if( store->segments[segment].base != NULL )
+    {
+        munmap( store->segments[segment].base, STORE_SEGMENT_SIZE );
+    }
+
+    store->segments[segment].base = NULL;
+    store->segments[segment].used = 0;
+    store->segments[segment].live_bytes = 0;
+}
+
+
+//**************************************************************************************************
+// End of file.
+//**************************************************************************************************
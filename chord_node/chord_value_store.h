@@ -0,0 +1,343 @@
+//**************************************************************************************************
+// File:   chord_value_store.h
+// Author: agent
+// Date:   10/19/2026
+// 
+// Holds the values a node stores under its keys. The key set (see chord_key_set.h) still tells
+// which keys a node holds; the value store keeps the bytes stored under them, if any.
+// 
+// Values are kept as records (a small header followed by the value) appended to a log of segments:
+// files of a fixed size, mapped into memory, so that the values a node holds are backed by disk
+// rather than by memory alone. Storing a value costs no allocation of its own. An update appends a
+// new record and leaves the old one behind as garbage. Keys are found through an open-addressing
+// hash index, kept in memory, that holds the location of each key's record.
+// 
+// Garbage is reclaimed by compaction, which copies the live records of a mostly dead segment to
+// the head of the log and then drops the segment. The node does this a step at a time between
+// messages (see store_compact), so that compaction never holds up the message loop for long.
+// 
+// The store counts the bytes of records written and read on behalf of requests, and the bytes
+// written to and read from segments in all, compaction included; the ratios of the two are the
+// write and read amplification of the store.
+// 
+// Records are moved between nodes as they are laid out in the segments: a run of records is
+// copied out of one store and appended to another as it is, without being taken apart. Where the
+// nodes are linked by a pipe, the records need not be copied out at all: the pages of the segments
+// they lie in are spliced into the pipe (records are never changed once written, so the pages can
+// be handed over as they are), and read straight from it into the head of the receiving store.
+// 
+// Alternatively, the values of every node may be kept in the shared store (see 
+// chord_shared_store.h), where the value of each key has a fixed place. Values are then never 
+// moved between nodes: a node takes over keys by taking them into its key set.
+// 
+//**************************************************************************************************
+
+#ifndef CHORD_VALUE_STORE_H
+#define CHORD_VALUE_STORE_H
+
+
+//**************************************************************************************************
+// Includes
+//**************************************************************************************************
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include "chord_config.h"
+#include "chord_message.h"
+
+
+//**************************************************************************************************
+// Module definitions
+//**************************************************************************************************
+
+// The environment variable naming the directory segment files are created in
+#define STORE_DIR_ENV_VAR               "CHORD_STORE_DIR"
+
+// The directory segment files are created in by default (one on disk rather than in memory)
+#define STORE_DEFAULT_DIR               "/var/tmp"
+
+// The size of a segment, in bytes
+#define STORE_SEGMENT_SIZE              65536
+
+// The number of segments a store can have at once
+#define STORE_MAX_SEGMENTS              16
+
+// The number of slots in the index (a power of two, well above the number of keys)
+#define STORE_INDEX_SIZE                128
+
+// A segment is compacted once less than this percentage of it is live
+#define STORE_COMPACT_THRESHOLD         50
+
+// The bytes of records compaction goes through in one step
+#define STORE_COMPACT_STEP              4096
+
+// The most bytes of records sent through a pipe at once, and the most separate pieces of segments
+// they may lie in (so that a transfer takes a bounded number of the pipe's buffers)
+#define STORE_SEND_SIZE                 32768
+#define STORE_SEND_SPANS                16
+
+// The header of a record; the value follows it, and the record is padded to a multiple of four
+// bytes
+typedef struct
+{
+    uint16_t key;                    // The key the value is stored under
+    uint16_t length;                 // The length of the value, in bytes
+} store_record_t;
+
+// A segment of the log
+typedef struct
+{
+    char *base;                      // The segment, as mapped (NULL if the slot is free)
+    int used;                        // The bytes of the segment filled with records
+    int live_bytes;                  // The bytes of the records still in use
+} store_segment_t;
+
+// The values stored by a node. A store that is all zeroes is empty, and creates its first segment
+// when the first value is stored.
+typedef struct
+{
+    store_segment_t segments[STORE_MAX_SEGMENTS];    // The segments, by slot
+    int head;                        // The segment records are appended to
+    bool compacting;                 // Flag: "a segment is being compacted"
+    int compact_segment;             // The segment being compacted
+    int compact_offset;              // The offset of the next record compaction goes through
+    int index[STORE_INDEX_SIZE];     // The location of each key's record (its segment times
+                                     // STORE_SEGMENT_SIZE, plus its offset), plus one; zero for an
+                                     // unused slot, -1 for the slot of a deleted key
+    chord_store_stats_t stats;       // The bytes written and read so far
+    pid_t process_id;                // The process that mapped the segments (zero if none has)
+} value_store_t;
+
+
+//**************************************************************************************************
+// Module variables
+//**************************************************************************************************
+
+// (none)
+
+
+//**************************************************************************************************
+// Module functions
+//**************************************************************************************************
+
+/***************************************************************************************************
+ * Function: store_init
+ * 
+ * Empty a store. Segments mapped by another process (inherited by fork from the node that created
+ * this one) are unmapped; segments mapped by this process are not dropped (e.g. those inherited
+ * from the node a virtual node was created by, which still uses them).
+ * 
+ * param:  The store
+ * return: void
+ **************************************************************************************************/
+void store_init( value_store_t *store );
+
+
+/***************************************************************************************************
+ * Function: store_free
+ * 
+ * Empty a store, dropping its segments. The segment files are removed when created, so they go
+ * once no process maps them any more.
+ * 
+ * param:  The store
+ * return: void
+ **************************************************************************************************/
+void store_free( value_store_t *store );
+
+
+/***************************************************************************************************
+ * Function: store_put
+ * 
+ * Store a value under a key, replacing any value stored under it before.
+ * 
+ * param:  The store
+ * param:  The key
+ * param:  The value
+ * param:  The length of the value, in bytes (at most MAX_VALUE_SIZE)
+ * return: True if the value was stored; false if it is too long, or no segment could be created
+ **************************************************************************************************/
+bool store_put( value_store_t *store, int key, const char *value, int length );
+
+
+/***************************************************************************************************
+ * Function: store_get
+ * 
+ * Find the value stored under a key. The value stays valid until the store is next changed.
+ * 
+ * param:  The store
+ * param:  The key
+ * param:  Holds the value, if there is one
+ * return: The length of the value, in bytes, or -1 if there is no value stored under the key
+ **************************************************************************************************/
+int store_get( value_store_t *store, int key, const char **value );
+
+
+/***************************************************************************************************
+ * Function: store_delete
+ * 
+ * Delete the values stored under a set of keys (if any).
+ * 
+ * param:  The store
+ * param:  The keys, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void store_delete( value_store_t *store, uint64_t keys );
+
+
+/***************************************************************************************************
+ * Function: store_pack
+ * 
+ * Copy the records of a set of keys, in ascending order of key, into a run of records, as far as
+ * they fit. The keys whose records were copied (and those with no value) are taken out of the set,
+ * so that the rest can be packed into further runs.
+ * 
+ * param:  The store
+ * param:  The keys to pack, as a bitmap; holds the keys left to pack
+ * param:  Holds the run
+ * param:  The size of the run buffer, in bytes
+ * return: The length of the run, in bytes
+ **************************************************************************************************/
+int store_pack( value_store_t *store, uint64_t *keys, char *run, int size );
+
+
+/***************************************************************************************************
+ * Function: store_unpack
+ * 
+ * Append a run of records made by store_pack to a store, in one piece, and index its records.
+ * 
+ * param:  The store
+ * param:  The run
+ * param:  The length of the run, in bytes (at most STORE_SEGMENT_SIZE)
+ * return: True if the run was stored; false if no segment could be created
+ **************************************************************************************************/
+bool store_unpack( value_store_t *store, const char *run, int length );
+
+
+/***************************************************************************************************
+ * Function: store_send
+ * 
+ * Send the records of a set of keys, in ascending order of key, through a pipe as far as 
+ * STORE_SEND_SIZE and STORE_SEND_SPANS allow: a message header, then the records, spliced from
+ * the segments into the pipe rather than copied. The keys whose records were sent (and those with
+ * no value) are taken out of the set, so that the rest can be sent in further transfers. On a
+ * non-blocking pipe, a transfer is only started if the pipe has room for its header; once started,
+ * it waits for the reader to make room for the records.
+ * 
+ * param:  The store
+ * param:  The keys to send, as a bitmap; holds the keys left to send
+ * param:  The message header; its length and data are set to those of the records sent
+ * param:  The pipe handle to write to
+ * return: True if the header and records were written in full (if the pipe had no room for the
+ *         header, nothing was written and the keys are left as they were)
+ **************************************************************************************************/
+bool store_send( value_store_t *store, uint64_t *keys, chord_msg_t *header, int handle );
+
+
+/***************************************************************************************************
+ * Function: store_receive
+ * 
+ * Read a run of records sent by store_send from a pipe straight into the head of a store, and
+ * index its records.
+ * 
+ * param:  The store
+ * param:  The pipe handle to read from (the message header has been read already)
+ * param:  The length of the run, in bytes (at most STORE_SEGMENT_SIZE)
+ * return: True if the run was stored; false if it could not be read in full, or no segment could
+ *         be created
+ **************************************************************************************************/
+bool store_receive( value_store_t *store, int handle, int length );
+
+
+/***************************************************************************************************
+ * Function: store_compact
+ * 
+ * Take one step of compaction: go through up to STORE_COMPACT_STEP bytes of the segment being
+ * compacted (choosing one first, if need be), copying its live records to the head of the log. A
+ * segment that has been gone through is dropped.
+ * 
+ * param:  The store
+ * return: True if there is more compaction to do
+ **************************************************************************************************/
+bool store_compact( value_store_t *store );
+
+
+/***************************************************************************************************
+ * Function: store_attach_shared
+ * 
+ * Keep the values of every node of this process (and of the processes it creates) in the shared 
+ * store, rather than in segments of their own.
+ * 
+ * param:  The file descriptor of the shared store
+ * return: True if the shared store is in use
+ **************************************************************************************************/
+bool store_attach_shared( int handle );
+
+
+/***************************************************************************************************
+ * Function: store_is_shared
+ * 
+ * Tell whether values are kept in the shared store.
+ * 
+ * param:  void
+ * return: True if values are kept in the shared store
+ **************************************************************************************************/
+bool store_is_shared();
+
+
+/***************************************************************************************************
+ * Function: store_set_owner
+ * 
+ * Publish a node's key set in the shared store, as a node in the ring (no effect if values are not
+ * kept in the shared store).
+ * 
+ * param:  The ID of the node
+ * param:  Its key set, as a bitmap
+ * return: void
+ **************************************************************************************************/
+void store_set_owner( int node_id, uint64_t keys );
+
+
+/***************************************************************************************************
+ * Function: store_drop_owner
+ * 
+ * Remove a node that has left the ring (or failed) from the shared store (no effect if values are
+ * not kept in the shared store).
+ * 
+ * param:  The ID of the node
+ * return: void
+ **************************************************************************************************/
+void store_drop_owner( int node_id );
+
+
+/***************************************************************************************************
+ * Function: store_get_stats
+ * 
+ * Get the bytes a store has written and read so far, with the bytes of its live records and of
+ * its segments.
+ * 
+ * param:  The store
+ * param:  Holds the counters
+ * return: void
+ **************************************************************************************************/
+void store_get_stats( const value_store_t *store, chord_store_stats_t *stats );
+
+
+/***************************************************************************************************
+ * Function: store_bench
+ * 
+ * Measure how fast records move between two stores, in bulk (see store_send) and in VALUES
+ * messages (see store_pack), printing the rates to the standard output.
+ * 
+ * param:  The number of command line options
+ * param:  The command line options (following "--bench-bulk": the number of rounds, if given)
+ * return: The program exit status
+ **************************************************************************************************/
+int store_bench( int argc, char **argv );
+
+
+#endif
+
+//**************************************************************************************************
+// End of file
+//**************************************************************************************************
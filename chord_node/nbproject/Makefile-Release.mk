@@ -35,10 +35,19 @@ OBJECTDIR=${CND_BUILDDIR}/${CND_CONF}/${CND_PLATFORM}
 
 # Object Files
 OBJECTFILES= \
-	${OBJECTDIR}/chord_debug.o \
+	${OBJECTDIR}/chord_broadcast.o \
+	${OBJECTDIR}/chord_hot_keys.o \
 	${OBJECTDIR}/chord_key_set.o \
+	${OBJECTDIR}/chord_log.o \
+	${OBJECTDIR}/chord_netem.o \
 	${OBJECTDIR}/chord_node.o \
-	${OBJECTDIR}/chord_node_main.o
+	${OBJECTDIR}/chord_node_main.o \
+	${OBJECTDIR}/chord_owner_cache.o \
+	${OBJECTDIR}/chord_pool.o \
+	${OBJECTDIR}/chord_sim.o \
+	${OBJECTDIR}/chord_supervisor.o \
+	${OBJECTDIR}/chord_value_cache.o \
+	${OBJECTDIR}/chord_value_store.o
 
 
 # C Compiler Flags
@@ -55,7 +64,7 @@ FFLAGS=
 ASFLAGS=
 
 # Link Libraries and Options
-LDLIBSOPTIONS=
+LDLIBSOPTIONS=-lm -lpthread
 
 # Build Targets
 .build-conf: ${BUILD_SUBPROJECTS}
@@ -65,16 +74,31 @@ ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/chord_node: ${OBJECTFILES}
 	${MKDIR} -p ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}
 	${LINK.c} -o ${CND_DISTDIR}/${CND_CONF}/${CND_PLATFORM}/chord_node ${OBJECTFILES} ${LDLIBSOPTIONS}
 
-${OBJECTDIR}/chord_debug.o: chord_debug.c 
+${OBJECTDIR}/chord_broadcast.o: chord_broadcast.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
-	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_debug.o chord_debug.c
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_broadcast.o chord_broadcast.c
+
+${OBJECTDIR}/chord_hot_keys.o: chord_hot_keys.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_hot_keys.o chord_hot_keys.c
 
 ${OBJECTDIR}/chord_key_set.o: chord_key_set.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_key_set.o chord_key_set.c
 
+${OBJECTDIR}/chord_log.o: chord_log.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_log.o chord_log.c
+
+${OBJECTDIR}/chord_netem.o: chord_netem.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_netem.o chord_netem.c
+
 ${OBJECTDIR}/chord_node.o: chord_node.c 
 	${MKDIR} -p ${OBJECTDIR}
 	${RM} "$@.d"
@@ -85,6 +109,36 @@ ${OBJECTDIR}/chord_node_main.o: chord_node_main.c
 	${RM} "$@.d"
 	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_node_main.o chord_node_main.c
 
+${OBJECTDIR}/chord_owner_cache.o: chord_owner_cache.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_owner_cache.o chord_owner_cache.c
+
+${OBJECTDIR}/chord_pool.o: chord_pool.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_pool.o chord_pool.c
+
+${OBJECTDIR}/chord_sim.o: chord_sim.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_sim.o chord_sim.c
+
+${OBJECTDIR}/chord_supervisor.o: chord_supervisor.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_supervisor.o chord_supervisor.c
+
+${OBJECTDIR}/chord_value_cache.o: chord_value_cache.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_value_cache.o chord_value_cache.c
+
+${OBJECTDIR}/chord_value_store.o: chord_value_store.c 
+	${MKDIR} -p ${OBJECTDIR}
+	${RM} "$@.d"
+	$(COMPILE.c) -O2 -MMD -MP -MF "$@.d" -o ${OBJECTDIR}/chord_value_store.o chord_value_store.c
+
 # Subprojects
 .build-subprojects:
 